@@ -0,0 +1,93 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2020                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "texture_cache.h"
+
+#include <QMutexLocker>
+
+TextureCache::TextureCache()
+{
+}
+
+TextureCache::~TextureCache()
+{
+	clear();
+}
+
+/**
+ * @brief Looks for the texture stored at the given canonical path.
+ * Returns false if the texture is not in the cache, or if the cached copy
+ * is older than the file.
+ */
+bool TextureCache::find(const QString& canonicalPath, const QDateTime& lastModified, QImage& img) const
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _entries.find(canonicalPath);
+	if (it == _entries.end() || it->second.lastModified != lastModified)
+		return false;
+	img = it->second.image;
+	return true;
+}
+
+/**
+ * @brief Inserts a decoded texture in the cache and returns the image that
+ * must be used by the caller: if another thread already inserted the same
+ * texture, the cached image is returned and the given one can be discarded.
+ */
+QImage TextureCache::insert(const QString& canonicalPath, const QDateTime& lastModified, const QImage& img)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _entries.find(canonicalPath);
+	if (it != _entries.end() && it->second.lastModified == lastModified)
+		return it->second.image;
+	Entry& e = _entries[canonicalPath];
+	e.image = img;
+	e.lastModified = lastModified;
+	return e.image;
+}
+
+/**
+ * @brief Drops all the textures that are not used anymore by any MeshModel.
+ */
+void TextureCache::purge()
+{
+	QMutexLocker locker(&_mutex);
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (it->second.image.isDetached())
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+}
+
+void TextureCache::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_entries.clear();
+}
+
+unsigned int TextureCache::size() const
+{
+	QMutexLocker locker(&_mutex);
+	return _entries.size();
+}
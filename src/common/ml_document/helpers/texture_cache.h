@@ -0,0 +1,66 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2020                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef MESHLAB_TEXTURE_CACHE_H
+#define MESHLAB_TEXTURE_CACHE_H
+
+#include <map>
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @brief The TextureCache class stores the decoded textures of a MeshDocument,
+ * keyed by the canonical path of their file, so that a texture referred by
+ * several layers is decoded and stored only once.
+ *
+ * The cache relies on the reference counting of the implicitly shared QImage:
+ * MeshModels keep copies of the cached images, and an entry is dropped by
+ * purge() when the cache holds the only reference to it.
+ * All the member functions can be called concurrently.
+ */
+class TextureCache
+{
+public:
+	TextureCache();
+	~TextureCache();
+
+	bool find(const QString& canonicalPath, const QDateTime& lastModified, QImage& img) const;
+	QImage insert(const QString& canonicalPath, const QDateTime& lastModified, const QImage& img);
+	void purge();
+	void clear();
+	unsigned int size() const;
+
+private:
+	struct Entry
+	{
+		QImage image;
+		QDateTime lastModified;
+	};
+
+	mutable QMutex _mutex;
+	std::map<QString, Entry> _entries;
+};
+
+#endif // MESHLAB_TEXTURE_CACHE_H
@@ -84,6 +84,7 @@ void MeshDocument::clear()
 {
 	meshList.clear();
 	rasterList.clear();
+	texCache.clear();
 
 	meshIdCounter=0;
 	rasterIdCounter=0;
@@ -307,6 +308,7 @@ MeshModel* MeshDocument::addNewMesh(
 
 	meshList.push_back(MeshModel(newMeshId(), fullPath,newlabel));
 	MeshModel& newMesh = meshList.back();
+	newMesh.setTextureCache(&texCache);
 
 	if(setAsCurrent)
 		this->setCurrentMesh(newMesh.id());
@@ -392,6 +394,7 @@ MeshDocument::MeshIterator MeshDocument::eraseMesh(MeshIterator it)
 		}
 
 		it = meshList.erase(it);
+		texCache.purge();
 
 		emit meshSetChanged();
 		emit meshRemoved(id);
@@ -471,6 +474,46 @@ bool MeshDocument::hasBeenModified() const
 	return false;
 }
 
+/**
+ * @brief Compacts the vcg containers of all the meshes of the document that
+ * have some deleted elements. Layers without holes are skipped, and the
+ * remaining ones are compacted in parallel, since each one touches only its
+ * own containers.
+ *
+ * Returns the number of meshes that have been compacted.
+ */
+unsigned int MeshDocument::compactMeshes()
+{
+	std::vector<MeshModel*> toCompact;
+	for(MeshModel& m : meshList)
+		if (m.hasDeletedElements())
+			toCompact.push_back(&m);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) toCompact.size(); ++i)
+		toCompact[i]->compact();
+
+	return toCompact.size();
+}
+
+/**
+ * @brief Bumps the topology epoch of the meshes whose connectivity could have
+ * been changed by a filter having the given postCondition mask.
+ * Meshes whose number of vertices or faces differs from the one stored in
+ * meshDocStateData() before the filter are invalidated anyway, to be robust
+ * against filters that do not declare properly their postCondition.
+ */
+void MeshDocument::updateTopologyAfterFilter(int postConditionMask)
+{
+	bool topologyChanged = MeshModel::changesTopology(postConditionMask);
+	for(MeshModel& m : meshList) {
+		auto it = mdstate.find(m.id());
+		if (topologyChanged || it == mdstate.end() ||
+			it->_nvert != (size_t) m.cm.VN() || it->_nface != (size_t) m.cm.FN())
+			m.invalidateTopology();
+	}
+}
+
 MeshDocument::MeshIterator MeshDocument::meshBegin()
 {
 	return meshList.begin();
@@ -28,6 +28,7 @@
 #include "raster_model.h"
 
 #include "helpers/mesh_document_state_data.h"
+#include "helpers/texture_cache.h"
 
 class MeshDocument : public QObject
 {
@@ -163,6 +164,12 @@ public:
 
 	bool hasBeenModified() const;
 
+	/// compacts (in parallel) the meshes that have deleted elements
+	unsigned int compactMeshes();
+
+	/// invalidates the topology of the meshes that could have been changed by a filter
+	void updateTopologyAfterFilter(int postConditionMask);
+
 	//iterator member functions
 	MeshIterator meshBegin();
 	MeshIterator meshEnd();
@@ -202,6 +209,9 @@ private:
 
 	MeshDocumentStateData mdstate;
 
+	/// textures shared among the meshes of the document
+	TextureCache texCache;
+
 	bool busy;
 
 	MeshModel* currentMesh;
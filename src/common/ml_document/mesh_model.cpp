@@ -27,6 +27,10 @@
 
 #include "mesh_model.h"
 #include "../utilities/load_save.h"
+#include "../utilities/parallel_topology.h"
+#include "../plugins/plugin_manager.h"
+#include "../globals.h"
+#include "helpers/texture_cache.h"
 
 #include <wrap/gl/math.h>
 
@@ -53,6 +57,8 @@ void MeshModel::clear()
 	currentDataMask |= MM_VERTCOORD | MM_VERTNORMAL | MM_VERTFLAG ;
 	currentDataMask |= MM_FACEVERT  | MM_FACENORMAL | MM_FACEFLAG ;
 
+	invalidateTopology();
+
 	visible=true;
 	cm.Tr.SetIdentity();
 	cm.sfn=0;
@@ -79,6 +85,55 @@ QString MeshModel::relativePathName(const QString& path) const
 	return relPath;
 }
 
+void MeshModel::setTextureCache(TextureCache* cache)
+{
+	textureCache = cache;
+}
+
+namespace {
+
+/**
+ * @brief Decodes the texture stored in the given file, looking first in the
+ * given cache (if any). Returns a null image if the file cannot be loaded.
+ * When concurrent is true, the image is decoded without touching the log of
+ * the plugin, and the function can be called from several threads.
+ */
+QImage decodeTexture(
+		const QString& fileName,
+		TextureCache* cache,
+		bool concurrent,
+		GLLogStream* log,
+		vcg::CallBackPos* cb)
+{
+	QFileInfo fi(fileName);
+	if (!fi.exists())
+		return QImage();
+	QString key = fi.canonicalFilePath();
+	QImage img;
+	if (cache != nullptr && cache->find(key, fi.lastModified(), img))
+		return img;
+	try {
+		if (concurrent) {
+			IOPlugin* plugin = meshlab::pluginManagerInstance().inputImagePlugin(fi.suffix());
+			if (plugin != nullptr)
+				img = plugin->openImage(fi.suffix(), fi.absoluteFilePath(), nullptr);
+			else
+				img.load(fi.absoluteFilePath());
+		}
+		else {
+			img = meshlab::loadImage(fi.absoluteFilePath(), log, cb);
+		}
+	}
+	catch (const MLException&) {
+		return QImage();
+	}
+	if (cache != nullptr)
+		img = cache->insert(key, fi.lastModified(), img);
+	return img;
+}
+
+}
+
 /**
  * @brief Starting from the (still unloaded) textures contained in the contained
  * CMeshO, loads the textures in the map of QImages contained in the MeshModel.
@@ -89,6 +144,10 @@ QString MeshModel::relativePathName(const QString& path) const
  *
  * When a texture is not found, a dummy texture will be used (":/img/dummy.png").
  *
+ * Textures are decoded concurrently (except the ones handled by an IOPlugin
+ * that does not support concurrent decoding), and shared through the TextureCache of the document with
+ * the other meshes that refer to the same files.
+ *
  * Returns the list of non-loaded textures that have been modified with
  * ":/img/dummy.png" in the contained mesh.
  */
@@ -96,35 +155,83 @@ std::list<std::string> MeshModel::loadTextures(
 		GLLogStream* log,
 		vcg::CallBackPos* cb)
 {
+	struct TextureJob {
+		std::string name;
+		QString absoluteFile;  // the name as it is, relative to the current dir
+		QString meshRelativeFile; // the name relative to the dir of the mesh
+		bool serial; // must be decoded by a plugin that is not thread safe
+		bool relative = false;
+		QImage img;
+	};
+
 	std::list<std::string> unloadedTextures;
-	for (std::string& textName : cm.textures){
-		if (textures.find(textName) == textures.end()){
-			QImage img(":/img/dummy.png");
+	std::vector<TextureJob> jobs;
+	std::map<std::string, unsigned int> jobIndex;
+	QFileInfo mfi(fullName());
+	PluginManager& pm = meshlab::pluginManagerInstance();
+	for (const std::string& textName : cm.textures){
+		if (textures.find(textName) == textures.end() && jobIndex.find(textName) == jobIndex.end()){
 			QFileInfo finfo(QString::fromStdString(textName));
-			try {
-				img = meshlab::loadImage(finfo.absoluteFilePath(), log, cb);
+			TextureJob job;
+			job.name = textName;
+			job.absoluteFile = finfo.absoluteFilePath();
+			job.meshRelativeFile = mfi.absolutePath() + "/" + finfo.filePath();
+			IOPlugin* plugin = pm.inputImagePlugin(finfo.suffix());
+			job.serial = plugin != nullptr && !plugin->supportsConcurrentOpenImage(finfo.suffix());
+			jobIndex[textName] = jobs.size();
+			jobs.push_back(job);
+		}
+	}
+
+	// images decoded by plugins that are not thread safe are loaded here, serially
+	for (TextureJob& job : jobs) {
+		if (job.serial) {
+			job.img = decodeTexture(job.absoluteFile, textureCache, false, log, cb);
+			if (job.img.isNull()) {
+				job.img = decodeTexture(job.meshRelativeFile, textureCache, false, log, cb);
+				job.relative = true;
+			}
+		}
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) jobs.size(); ++i) {
+		TextureJob& job = jobs[i];
+		if (!job.serial) {
+			job.img = decodeTexture(job.absoluteFile, textureCache, true, nullptr, nullptr);
+			if (job.img.isNull()) {
+				job.img = decodeTexture(job.meshRelativeFile, textureCache, true, nullptr, nullptr);
+				job.relative = true;
+			}
+		}
+	}
+
+	for (std::string& textName : cm.textures){
+		auto it = jobIndex.find(textName);
+		if (it == jobIndex.end())
+			continue;
+		const TextureJob& job = jobs[it->second];
+		QFileInfo finfo(QString::fromStdString(textName));
+		if (!job.img.isNull()) {
+			if (job.relative)
+				textName = finfo.filePath().toStdString();
+			else
 				textName = finfo.fileName().toStdString();
-			} catch (const MLException& e) {
-				try { //could be relative to the meshmodel
-					QFileInfo mfi(fullName());
-					QString fn2 = mfi.absolutePath() + "/" + finfo.filePath();
-					img = meshlab::loadImage(fn2, log, cb);
-					textName = finfo.filePath().toStdString();
-				} catch (const MLException& e) {
-					if (log){
-						log->log(
-							GLLogStream::WARNING, "Failed loading " + textName +
-							"; using a dummy texture");
-					}
-					else {
-						std::cerr <<
-							"Failed loading " + textName + "; using a dummy texture\n";
-					}
-					unloadedTextures.push_back(textName);
-					textName = "dummy.png";
-				}
+			textures[textName] = job.img;
+		}
+		else {
+			if (log){
+				log->log(
+					GLLogStream::WARNING, "Failed loading " + textName +
+					"; using a dummy texture");
 			}
-			textures[textName] = img;
+			else {
+				std::cerr <<
+					"Failed loading " + textName + "; using a dummy texture\n";
+			}
+			unloadedTextures.push_back(textName);
+			textName = "dummy.png";
+			textures[textName] = QImage(":/img/dummy.png");
 		}
 	}
 	return unloadedTextures;
@@ -161,6 +268,8 @@ void MeshModel::clearTextures()
 {
 	textures.clear();
 	cm.textures.clear();
+	if (textureCache != nullptr)
+		textureCache->purge();
 }
 
 void MeshModel::addTexture(std::string name, const QImage& txt)
@@ -310,13 +419,15 @@ void MeshModel::updateDataMask(int neededDataMask)
 	if((neededDataMask & MM_FACEFACETOPO)!=0)
 	{
 		cm.face.EnableFFAdjacency();
-		tri::UpdateTopology<CMeshO>::FaceFace(cm);
+		meshlab::updateFaceFaceTopology(cm);
+		ffTopoEpoch = topoEpoch;
 	}
 	if((neededDataMask & MM_VERTFACETOPO)!=0)
 	{
 		cm.vert.EnableVFAdjacency();
 		cm.face.EnableVFAdjacency();
-		tri::UpdateTopology<CMeshO>::VertexFace(cm);
+		meshlab::updateVertexFaceTopology(cm);
+		vfTopoEpoch = topoEpoch;
 	}
 
 	if((neededDataMask & MM_WEDGTEXCOORD)!=0)
@@ -341,11 +452,38 @@ void MeshModel::updateDataMask(int neededDataMask)
 	currentDataMask |= neededDataMask;
 }
 
+/**
+ * @brief Same as updateDataMask, but the FF and VF adjacency are rebuilt only
+ * if they are disabled or have been computed in an older topology epoch.
+ *
+ * Must be used only where the epoch is known to be consistent with the mesh,
+ * i.e. when the preconditions of a filter are satisfied before running it:
+ * code that changes the connectivity without invalidating the topology
+ * (e.g. the body of a filter) must call updateDataMask instead.
+ */
+void MeshModel::requireDataMask(int neededDataMask)
+{
+	if ((neededDataMask & MM_FACEFACETOPO) != 0 && isFaceFaceTopologyUpToDate()) {
+		neededDataMask &= ~MM_FACEFACETOPO;
+		currentDataMask |= MM_FACEFACETOPO;
+		++avoidedTopoUpdates;
+	}
+	if ((neededDataMask & MM_VERTFACETOPO) != 0 && cm.vert.IsVFAdjacencyEnabled() &&
+		cm.face.IsVFAdjacencyEnabled() && vfTopoEpoch == (int) topoEpoch) {
+		neededDataMask &= ~MM_VERTFACETOPO;
+		currentDataMask |= MM_VERTFACETOPO;
+		++avoidedTopoUpdates;
+	}
+	updateDataMask(neededDataMask);
+}
+
 void MeshModel::clearDataMask(int unneededDataMask)
 {
 	if( ( (unneededDataMask & MM_VERTFACETOPO)!=0)	&& hasDataMask(MM_VERTFACETOPO)) {cm.face.DisableVFAdjacency();
 	cm.vert.DisableVFAdjacency(); }
 	if( ( (unneededDataMask & MM_FACEFACETOPO)!=0)	&& hasDataMask(MM_FACEFACETOPO))	cm.face.DisableFFAdjacency();
+	if ((unneededDataMask & MM_VERTFACETOPO)!=0) vfTopoEpoch = -1;
+	if ((unneededDataMask & MM_FACEFACETOPO)!=0) ffTopoEpoch = -1;
 
 	if( ( (unneededDataMask & MM_WEDGTEXCOORD)!=0)	&& hasDataMask(MM_WEDGTEXCOORD)) 	cm.face.DisableWedgeTexCoord();
 	if( ( (unneededDataMask & MM_FACECOLOR)!=0)			&& hasDataMask(MM_FACECOLOR))			cm.face.DisableColor();
@@ -392,6 +530,96 @@ void MeshModel::setMeshModified(bool b)
 	modified = b;
 }
 
+unsigned int MeshModel::deletedVertexNumber() const
+{
+	return cm.vert.size() - cm.vn;
+}
+
+unsigned int MeshModel::deletedEdgeNumber() const
+{
+	return cm.edge.size() - cm.en;
+}
+
+unsigned int MeshModel::deletedFaceNumber() const
+{
+	return cm.face.size() - cm.fn;
+}
+
+bool MeshModel::hasDeletedElements() const
+{
+	return deletedVertexNumber() > 0 || deletedEdgeNumber() > 0 || deletedFaceNumber() > 0;
+}
+
+/**
+ * @brief Removes the deleted elements from the vcg containers of the mesh.
+ * Does nothing if the mesh has no holes.
+ *
+ * Returns true if the mesh has been actually compacted.
+ */
+bool MeshModel::compact()
+{
+	if (!hasDeletedElements())
+		return false;
+	tri::Allocator<CMeshO>::CompactEveryVector(cm);
+	return true;
+}
+
+unsigned int MeshModel::topologyEpoch() const
+{
+	return topoEpoch;
+}
+
+/**
+ * @brief Must be called every time the connectivity of the mesh changes
+ * (faces added, deleted or with different vertex references): the FF and VF
+ * adjacency computed so far will be rebuilt on the next requireDataMask call.
+ */
+void MeshModel::invalidateTopology()
+{
+	++topoEpoch;
+}
+
+/**
+ * @brief Returns true if FF adjacency is enabled and has been computed for
+ * the current connectivity of the mesh.
+ */
+bool MeshModel::isFaceFaceTopologyUpToDate() const
+{
+	return cm.face.IsFFAdjacencyEnabled() && ffTopoEpoch == (int) topoEpoch;
+}
+
+/**
+ * @brief Declares that the FF adjacency stored in the (enabled) FF component
+ * is valid for the current connectivity, e.g. because it has been read from
+ * a file that caches it: requireDataMask will not recompute it.
+ */
+void MeshModel::setFaceFaceTopologyUpToDate()
+{
+	assert(cm.face.IsFFAdjacencyEnabled());
+	ffTopoEpoch = topoEpoch;
+	currentDataMask |= MM_FACEFACETOPO;
+}
+
+/**
+ * @brief Returns the number of FF/VF adjacency rebuilds that have been
+ * skipped by requireDataMask because the topology was already up to date.
+ */
+unsigned int MeshModel::avoidedTopologyUpdates() const
+{
+	return avoidedTopoUpdates;
+}
+
+/**
+ * @brief Returns true if a filter with the given postCondition mask may
+ * have changed the connectivity of the meshes. Filters that preserve the
+ * topology (e.g. smoothing, coloring, quality) must not declare
+ * MM_FACEVERT nor the topology bits in their postCondition.
+ */
+bool MeshModel::changesTopology(int postConditionMask)
+{
+	return (postConditionMask & (MM_FACEVERT | MM_FACEFACETOPO | MM_VERTFACETOPO)) != 0;
+}
+
 int MeshModel::dataMask() const
 {
 	return currentDataMask;
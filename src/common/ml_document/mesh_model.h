@@ -61,6 +61,7 @@ It contains a single vcg mesh object with some additional information for keepin
 */
 
 class MeshDocument;
+class TextureCache;
 
 class MeshModel
 {
@@ -167,6 +168,7 @@ public:
 	bool isVisible() const { return visible; }
 	void setVisible(bool vis = true) { visible = vis;}
 
+	void setTextureCache(TextureCache* cache);
 	std::list<std::string> loadTextures(GLLogStream* log = nullptr, vcg::CallBackPos* cb = nullptr);
 	void saveTextures(const QString& basePath, int quality = -1, GLLogStream* log = nullptr, vcg::CallBackPos* cb = nullptr);
 
@@ -193,12 +195,31 @@ public:
 	void updateDataMask();
 	void updateDataMask(const MeshModel* m);
 	void updateDataMask(int neededDataMask);
+	void requireDataMask(int neededDataMask);
 	void clearDataMask(int unneededDataMask);
 	int dataMask() const;
 
 
 	bool meshModified() const;
 	void setMeshModified(bool b = true);
+
+	// Filters usually just flag elements as deleted, leaving holes in the
+	// vcg containers; these counters tell how many of them are still stored.
+	unsigned int deletedVertexNumber() const;
+	unsigned int deletedEdgeNumber() const;
+	unsigned int deletedFaceNumber() const;
+	bool hasDeletedElements() const;
+	bool compact();
+
+	// Topology validity tracking: the epoch is bumped each time the
+	// connectivity of the mesh changes, and FF/VF adjacency are rebuilt by
+	// requireDataMask only when they have been computed in an older epoch.
+	unsigned int topologyEpoch() const;
+	void invalidateTopology();
+	bool isFaceFaceTopologyUpToDate() const;
+	void setFaceFaceTopologyUpToDate();
+	unsigned int avoidedTopologyUpdates() const;
+	static bool changesTopology(int postConditionMask);
 	static int io2mm(int single_iobit);
 
 	CMeshO cm;
@@ -218,6 +239,13 @@ private:
 
 	//textures associated to mesh
 	std::map<std::string, QImage> textures;
+	//cache of the document (if any) where the decoded textures are shared
+	TextureCache* textureCache = nullptr;
+
+	unsigned int topoEpoch = 0;
+	int ffTopoEpoch = -1; // epoch in which FF adjacency was computed, -1 if never
+	int vfTopoEpoch = -1; // epoch in which VF adjacency was computed, -1 if never
+	unsigned int avoidedTopoUpdates = 0;
 };// end class MeshModel
 
 #endif
@@ -140,6 +140,15 @@ public:
 	 */
 	virtual bool requiresGLContext(const QAction*) const {return false;}
 
+	/**
+	 * @brief This function should return false if the filter is able to work
+	 * on meshes that still contain deleted elements (e.g. it always checks
+	 * IsD() while iterating over the vcg containers).
+	 * When such a filter is the next one of a FilterScript, the framework
+	 * skips the compaction of the layers after the previous filter.
+	 */
+	virtual bool requiresCompactVectors(const QAction*) const {return true;}
+
 	/** 
 	 * @brief The FilterPrecondition mask is used to explicitate what kind of data a filter really needs to be applied.
 	 * For example algorithms that compute per face quality have as precondition the existence of faces
@@ -24,6 +24,8 @@
 #ifndef MESHLAB_IO_PLUGIN_H
 #define MESHLAB_IO_PLUGIN_H
 
+#include <QMutex>
+
 #include <wrap/callback.h>
 
 #include "meshlab_plugin_logger.h"
@@ -164,6 +166,20 @@ public:
 			const RichParameterList & par,
 			vcg::CallBackPos *cb = nullptr) = 0;
 
+	/**
+	 * @brief Re-implement this function returning true if the open function
+	 * can be called concurrently from several threads for the given format,
+	 * each call filling a different MeshModel (e.g. when the importer does
+	 * not use static data, the log, or any other state of the plugin).
+	 * In this case the framework could load several files at the same time
+	 * (e.g. the layers of a project), calling the open function with the
+	 * absolute path of the file and a null callback.
+	 */
+	virtual bool supportsConcurrentOpen(const QString& /*format*/) const
+	{
+		return false;
+	}
+
 	/***********************
 	 * Save Mesh Functions *
 	 ***********************/
@@ -256,6 +272,19 @@ public:
 		return QImage();
 	};
 
+	/**
+	 * @brief Re-implement this function returning true if the openImage
+	 * function can be called concurrently from several threads for the given
+	 * format (e.g. when it does not touch any state of the plugin and it
+	 * does not use the log). In this case the framework could decode more
+	 * images at the same time (e.g. the textures of a mesh), calling the
+	 * openImage function with a null callback.
+	 */
+	virtual bool supportsConcurrentOpenImage(const QString& /*format*/) const
+	{
+		return false;
+	}
+
 	/************************
 	 * Save Image Functions *
 	 ************************/
@@ -434,6 +463,7 @@ public:
 
 private:
 	mutable QString warnString;
+	mutable QMutex warnMutex;
 };
 
 #define IO_PLUGIN_IID "vcg.meshlab.IOPlugin/1.0"
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "live_elements.h"
+
+namespace meshlab {
+
+LiveElements::LiveElements(const CMeshO::VertContainer& vert, int liveCount) : count(liveCount)
+{
+	init(vert);
+}
+
+LiveElements::LiveElements(const CMeshO::FaceContainer& face, int liveCount) : count(liveCount)
+{
+	init(face);
+}
+
+template <typename Container>
+void LiveElements::init(const Container& c)
+{
+	if ((int) c.size() == count)
+		return;
+	remap.assign(c.size(), -1);
+	indices.reserve(count);
+	for (int i = 0; i < (int) c.size(); ++i) {
+		if (!c[i].IsD()) {
+			remap[i] = (int) indices.size();
+			indices.push_back(i);
+		}
+	}
+}
+
+} // namespace meshlab
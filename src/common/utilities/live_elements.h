@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MESHLAB_LIVE_ELEMENTS_H
+#define MESHLAB_LIVE_ELEMENTS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "../ml_document/cmesh.h"
+
+namespace meshlab {
+
+/**
+ * @brief The elements of a vcg container that are not deleted, numbered as in
+ * the compacted container: maps the position k among the live elements to the
+ * index in the container, and the index in the container to the compacted
+ * index (-1 for deleted elements).
+ *
+ * Used by the savers that write a mesh with deleted elements as if it was
+ * compacted, without modifying it. Nothing is stored for compact containers.
+ */
+class LiveElements
+{
+public:
+	LiveElements(const CMeshO::VertContainer& vert, int liveCount);
+	LiveElements(const CMeshO::FaceContainer& face, int liveCount);
+
+	// number of live elements
+	int size() const { return count; }
+	// index in the container of the k-th live element
+	int index(std::size_t k) const { return indices.empty() ? (int) k : indices[k]; }
+	// compacted index of the element with index i in the container
+	int savedIndex(std::size_t i) const { return remap.empty() ? (int) i : remap[i]; }
+
+private:
+	template <typename Container>
+	void init(const Container& c);
+
+	int              count;
+	std::vector<int> indices;
+	std::vector<int> remap;
+};
+
+} // namespace meshlab
+
+#endif // MESHLAB_LIVE_ELEMENTS_H
@@ -23,6 +23,12 @@
 
 #include "load_save.h"
 
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <QDir>
 #include <QElapsedTimer>
 
@@ -33,51 +39,206 @@
 
 namespace meshlab {
 
+namespace {
+
+int threadNumber()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+// angle weighted normal accumulated by a chunk of faces on a vertex
+struct NormalSum
+{
+	Point3m n = Point3m(0, 0, 0);
+	bool    referenced = false;
+};
+
 /**
- * @brief This function assumes that you already have the followind data:
- * - the plugin that is needed to load the mesh
- * - the number of meshes that will be loaded from the file
- * - the list of MeshModel(s) that will contain the loaded mesh(es)
- * - the open parameters that will be used to load the mesh(es)
+ * @brief Single multi-threaded sweep that replaces the sequence of
+ * PerFaceNormalized, PerVertexAngleWeighted, UpdateBounding::Box,
+ * RemoveDegenerateVertex and RemoveDegenerateFace that is run on every loaded
+ * mesh.
  *
- * The function will take care to load the mesh, load textures if needed
- * and make all the clean operations after loading the meshes.
- * If load fails, throws a MLException.
+ * Vertices with NaN coords, faces incident to them and topologically
+ * degenerate faces are just flagged as deleted (the mesh must be compacted
+ * afterwards). Per vertex normals are assigned only to vertices referenced by
+ * some face, as done by vcg; faces incident to NaN vertices do not contribute
+ * to them. The faces are split in one contiguous chunk per thread, and each
+ * chunk accumulates its angle weighted contributions in face order on a buffer
+ * that spans only the range of vertex indices it references; the buffers are
+ * then summed per vertex in chunk order, so that the result does not depend on
+ * the scheduling of the threads. When the chunks reference overlapping ranges
+ * (e.g. meshes with shuffled vertices) the buffers would take too much memory,
+ * and the faces are accumulated by a single chunk.
  *
- * @param[i] fileName: the filename
- * @param[i] ioPlugin: the plugin that supports the file format to load
- * @param[i] prePar: the pre open parameters
- * @param[i/o] meshList: the list of meshes that will be loaded from the file
- * @param[o] maskList: masks of loaded components for each loaded mesh
- * @param cb: callback
- * @return the list of texture names that could not be loaded
+ * Returns the number of removed NaN vertices and degenerate faces in
+ * delVertNum and delFaceNum.
  */
-std::list<std::string> loadMesh(
-	const QString&               fileName,
-	IOPlugin*                    ioPlugin,
-	const RichParameterList&     prePar,
-	const std::list<MeshModel*>& meshList,
-	std::list<int>&              maskList,
-	vcg::CallBackPos*            cb)
+void fusedPostLoadPass(
+	CMeshO& m,
+	bool    computeFaceNormals,
+	bool    computeVertNormals,
+	int&    delVertNum,
+	int&    delFaceNum)
 {
-	std::list<std::string> unloadedTextures;
-	QFileInfo              fi(fileName);
-	QString                extension = fi.suffix();
+	const long long nv = m.vert.size();
+	const long long nf = m.face.size();
+
+	int nanVert = 0;
+	#pragma omp parallel for schedule(static) reduction(+: nanVert)
+	for (long long i = 0; i < nv; ++i) {
+		CVertexO& v = m.vert[i];
+		if (!v.IsD() && (vcg::math::IsNAN(v.P()[0]) || vcg::math::IsNAN(v.P()[1]) ||
+						 vcg::math::IsNAN(v.P()[2]))) {
+			v.SetD();
+			++nanVert;
+		}
+	}
+	m.vn -= nanVert;
+
+	int nanFace = 0, degFace = 0;
+	#pragma omp parallel for schedule(static) reduction(+: nanFace, degFace)
+	for (long long i = 0; i < nf; ++i) {
+		CFaceO& f = m.face[i];
+		if (f.IsD())
+			continue;
+		if (f.V(0)->IsD() || f.V(1)->IsD() || f.V(2)->IsD()) {
+			f.SetD();
+			++nanFace;
+			continue;
+		}
+		if (f.V(0) == f.V(1) || f.V(1) == f.V(2) || f.V(2) == f.V(0)) {
+			f.SetD();
+			++degFace;
+			continue;
+		}
+		if (computeFaceNormals)
+			f.N() = vcg::TriangleNormal(f).Normalize();
+	}
+	m.fn -= nanFace + degFace;
+
+	// chunk c accumulates the faces [chunkFace[c], chunkFace[c+1]) on the
+	// vertices [chunkLo[c], chunkLo[c] + chunkN[c].size())
+	std::vector<std::size_t>            chunkFace;
+	std::vector<std::size_t>            chunkLo;
+	std::vector<std::vector<NormalSum>> chunkN;
+	if (computeVertNormals) {
+		int nChunks = std::max<long long>(1, std::min<long long>(threadNumber(), nf));
+		chunkFace.resize(nChunks + 1);
+		for (int c = 0; c <= nChunks; ++c)
+			chunkFace[c] = (std::size_t) nf * c / nChunks;
+		chunkLo.assign(nChunks, nv);
+		std::vector<std::size_t> chunkHi(nChunks, 0);
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int c = 0; c < nChunks; ++c) {
+			for (std::size_t i = chunkFace[c]; i < chunkFace[c + 1]; ++i) {
+				const CFaceO& f = m.face[i];
+				if (f.IsD())
+					continue;
+				for (int j = 0; j < 3; ++j) {
+					std::size_t vi = vcg::tri::Index(m, f.cV(j));
+					chunkLo[c]     = std::min(chunkLo[c], vi);
+					chunkHi[c]     = std::max(chunkHi[c], vi + 1);
+				}
+			}
+		}
+		std::size_t bufferSize = 0;
+		for (int c = 0; c < nChunks; ++c)
+			if (chunkLo[c] < chunkHi[c])
+				bufferSize += chunkHi[c] - chunkLo[c];
+		if (bufferSize > 2 * (std::size_t) nv) {
+			chunkLo   = {*std::min_element(chunkLo.begin(), chunkLo.end())};
+			chunkHi   = {*std::max_element(chunkHi.begin(), chunkHi.end())};
+			chunkFace = {0, (std::size_t) nf};
+			nChunks   = 1;
+		}
+		chunkN.resize(nChunks);
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int c = 0; c < nChunks; ++c) {
+			if (chunkLo[c] >= chunkHi[c])
+				continue;
+			std::vector<NormalSum>& buf = chunkN[c];
+			buf.resize(chunkHi[c] - chunkLo[c]);
+			for (std::size_t i = chunkFace[c]; i < chunkFace[c + 1]; ++i) {
+				const CFaceO& f = m.face[i];
+				if (f.IsD())
+					continue;
+				Point3m t  = computeFaceNormals ? f.cN() : vcg::TriangleNormal(f).Normalize();
+				Point3m e0 = (f.cV1(0)->cP() - f.cV0(0)->cP()).Normalize();
+				Point3m e1 = (f.cV1(1)->cP() - f.cV0(1)->cP()).Normalize();
+				Point3m e2 = (f.cV1(2)->cP() - f.cV0(2)->cP()).Normalize();
+
+				const Point3m cornerN[3] = {
+					t * vcg::AngleN(e0, -e2), t * vcg::AngleN(-e0, e1), t * vcg::AngleN(-e1, e2)};
+				for (int j = 0; j < 3; ++j) {
+					NormalSum& s = buf[vcg::tri::Index(m, f.cV(j)) - chunkLo[c]];
+					s.n += cornerN[j];
+					s.referenced = true;
+				}
+			}
+		}
+	}
 
-	QDir oldDir = QDir::current();
-	QDir::setCurrent(fi.absolutePath());
-	ioPlugin->open(extension, fi.fileName(), meshList, maskList, prePar, cb);
-	QDir::setCurrent(oldDir.absolutePath());
+	for (CEdgeO& e : m.edge) {
+		if (!e.IsD() && (e.V(0)->IsD() || e.V(1)->IsD()))
+			vcg::tri::Allocator<CMeshO>::DeleteEdge(m, e);
+	}
 
+	Box3m bbox;
+	#pragma omp parallel
+	{
+		Box3m localBox;
+		#pragma omp for schedule(static)
+		for (long long i = 0; i < nv; ++i) {
+			CVertexO& v = m.vert[i];
+			if (v.IsD())
+				continue;
+			if (computeVertNormals) {
+				Point3m n(0, 0, 0);
+				bool    referenced = false;
+				for (std::size_t c = 0; c < chunkN.size(); ++c) {
+					std::size_t k = (std::size_t) i - chunkLo[c];
+					if ((std::size_t) i >= chunkLo[c] && k < chunkN[c].size() &&
+						chunkN[c][k].referenced) {
+						n += chunkN[c][k].n;
+						referenced = true;
+					}
+				}
+				if (referenced)
+					v.N() = n;
+			}
+			localBox.Add(v.cP());
+		}
+		#pragma omp critical
+		bbox.Add(localBox);
+	}
+	m.bbox = bbox;
+
+	delVertNum = nanVert;
+	delFaceNum = degFace;
+}
+
+/**
+ * @brief Clean operations that are made on all the meshes loaded from a file:
+ * normals, bounding boxes, removal of NaN vertices and degenerate faces.
+ * Meshes contained in the same file are compacted concurrently at the end.
+ */
+void postProcessLoadedMeshes(
+	IOPlugin*                    ioPlugin,
+	const std::list<MeshModel*>& meshList,
+	const std::list<int>&        maskList)
+{
 	auto itmesh = meshList.begin();
 	auto itmask = maskList.begin();
 	for (unsigned int i = 0; i < meshList.size(); ++i) {
 		MeshModel* mm   = *itmesh;
 		int        mask = *itmask;
 
-		std::list<std::string> tmp = mm->loadTextures(nullptr, cb);
-		unloadedTextures.insert(unloadedTextures.end(), tmp.begin(), tmp.end());
-
+		int delVertNum = 0, delFaceNum = 0;
 		// In case of polygonal meshes the normal should be updated accordingly
 		if (mask & vcg::tri::io::Mask::IOM_BITPOLYGONAL) {
 			mm->updateDataMask(MeshModel::MM_POLYGONAL); // just to be sure. Hopefully it should be
@@ -87,62 +248,54 @@ std::list<std::string> loadMesh(
 				ioPlugin->log(
 					"Warning model contains " + std::to_string(degNum) +
 					" degenerate faces. Removed them.");
-			mm->updateDataMask(MeshModel::MM_FACEFACETOPO);
+			if (degNum)
+				mm->invalidateTopology();
+			// FF adjacency may have been read from a cache file by the plugin
+			mm->requireDataMask(MeshModel::MM_FACEFACETOPO);
 			vcg::tri::UpdateNormal<CMeshO>::PerBitQuadFaceNormalized(mm->cm);
 			vcg::tri::UpdateNormal<CMeshO>::PerVertexFromCurrentFaceNormal(mm->cm);
+			fusedPostLoadPass(mm->cm, false, false, delVertNum, delFaceNum);
 		} // standard case
 		else {
-			vcg::tri::UpdateNormal<CMeshO>::PerFaceNormalized(mm->cm);
-			if (!(mask & vcg::tri::io::Mask::IOM_VERTNORMAL))
-				vcg::tri::UpdateNormal<CMeshO>::PerVertexAngleWeighted(mm->cm);
+			fusedPostLoadPass(
+				mm->cm, true, !(mask & vcg::tri::io::Mask::IOM_VERTNORMAL), delVertNum, delFaceNum);
 		}
 
-		vcg::tri::UpdateBounding<CMeshO>::Box(mm->cm);
 		if (mm->cm.fn == 0 && mm->cm.en == 0) {
 			if (mask & vcg::tri::io::Mask::IOM_VERTNORMAL)
 				mm->updateDataMask(MeshModel::MM_VERTNORMAL);
 		}
 
-		// updateMenus();
-		int delVertNum = vcg::tri::Clean<CMeshO>::RemoveDegenerateVertex(mm->cm);
-		int delFaceNum = vcg::tri::Clean<CMeshO>::RemoveDegenerateFace(mm->cm);
-		vcg::tri::Allocator<CMeshO>::CompactEveryVector(mm->cm);
-		if (delVertNum > 0 || delFaceNum > 0)
+		if (delVertNum > 0 || delFaceNum > 0) {
+			mm->invalidateTopology();
 			ioPlugin->reportWarning(QString("Warning mesh contains %1 vertices with NAN coords and "
 											"%2 degenerated faces.\nCorrected.")
 										.arg(delVertNum)
 										.arg(delFaceNum));
+		}
 
 		// computeRenderingDataOnLoading(mm,isareload, rendOpt);
 		++itmesh;
 		++itmask;
 	}
-	return unloadedTextures;
+
+	// meshes contained in the same file are compacted concurrently
+	std::vector<MeshModel*> meshes(meshList.begin(), meshList.end());
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) meshes.size(); ++i)
+		meshes[i]->compact();
 }
 
 /**
- * @brief loads the given filename and puts the loaded mesh(es) into the
- * given MeshDocument. Returns the list of loaded meshes.
- *
- * If you already know the open parameters that could be used to load the mesh,
- * you can pass a RichParameterList containing them.
- * Note: only parameters of your RPL that are actually required by the plugin
- * will be given as input to the load function.
- * If you don't know any parameter, leave the RichParameterList parameter empty.
- *
- * The function takes care to:
- * - find the plugin that loads the format of the file
- * - create the required MeshModels into the MeshDocument
- * - load the meshes and their textures, with standard parameters
- *
- * if an error occurs, an exception will be thrown, and MeshDocument won't
- * contain new meshes.
+ * @brief Finds the plugin that opens the given file and returns it, filling
+ * openParams with the pre open parameters of the format: default values,
+ * overwritten by the values contained in prePar.
+ * Throws a MLException if there is no plugin that opens the file.
  */
-std::list<MeshModel*> loadMeshWithStandardParameters(
-	const QString&    filename,
-	MeshDocument&     md,
-	vcg::CallBackPos* cb,
-	RichParameterList prePar)
+IOPlugin* openPluginAndParameters(
+	const QString&           filename,
+	const RichParameterList& prePar,
+	RichParameterList&       openParams)
 {
 	QFileInfo      fi(filename);
 	QString        extension = fi.suffix();
@@ -156,15 +309,13 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 			"has not plugin to read " +
 			extension + " file format");
 
-	ioPlugin->setLog(&md.Log);
-
 	// get the open parameters for the given extension
-	RichParameterList openParams = ioPlugin->initPreOpenParameter(extension);
+	openParams = ioPlugin->initPreOpenParameter(extension);
 
 	// if some parameters were given in the prePar, then set their values into
 	// openParams.
 	// we need to be sure that openParams contains only parameters allowed by the plugin
-	for (RichParameter& rp : prePar) {
+	for (const RichParameter& rp : prePar) {
 		auto it = openParams.findParameter(rp.name());
 		if (it != openParams.end()) {
 			it->setValue(rp.value());
@@ -174,8 +325,21 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 	// openParams now contains:
 	// - if not specified in prePar, default parameter values
 	// - if specified in prePar, the values into prePar
+	return ioPlugin;
+}
 
-	unsigned int nMeshes = ioPlugin->numberMeshesContainedInFile(extension, filename, openParams);
+/**
+ * @brief Creates into the MeshDocument the MeshModels that will contain the
+ * meshes of the given file.
+ */
+std::list<MeshModel*> addMeshesOfFile(
+	const QString&           filename,
+	IOPlugin*                ioPlugin,
+	const RichParameterList& openParams,
+	MeshDocument&            md)
+{
+	QFileInfo fi(filename);
+	unsigned int nMeshes = ioPlugin->numberMeshesContainedInFile(fi.suffix(), filename, openParams);
 	std::list<MeshModel*> meshList;
 	for (unsigned int i = 0; i < nMeshes; i++) {
 		MeshModel* mm = md.addNewMesh(filename, fi.fileName());
@@ -186,6 +350,96 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 		}
 		meshList.push_back(mm);
 	}
+	return meshList;
+}
+
+} // namespace
+
+/**
+ * @brief This function assumes that you already have the followind data:
+ * - the plugin that is needed to load the mesh
+ * - the number of meshes that will be loaded from the file
+ * - the list of MeshModel(s) that will contain the loaded mesh(es)
+ * - the open parameters that will be used to load the mesh(es)
+ *
+ * The function will take care to load the mesh, load textures if needed
+ * and make all the clean operations after loading the meshes.
+ * If load fails, throws a MLException.
+ *
+ * @param[i] fileName: the filename
+ * @param[i] ioPlugin: the plugin that supports the file format to load
+ * @param[i] prePar: the pre open parameters
+ * @param[i/o] meshList: the list of meshes that will be loaded from the file
+ * @param[o] maskList: masks of loaded components for each loaded mesh
+ * @param cb: callback
+ * @return the list of texture names that could not be loaded
+ */
+std::list<std::string> loadMesh(
+	const QString&               fileName,
+	IOPlugin*                    ioPlugin,
+	const RichParameterList&     prePar,
+	const std::list<MeshModel*>& meshList,
+	std::list<int>&              maskList,
+	vcg::CallBackPos*            cb)
+{
+	std::list<std::string> unloadedTextures;
+	QFileInfo              fi(fileName);
+	QString                extension = fi.suffix();
+
+	QElapsedTimer t;
+	t.start();
+	QDir oldDir = QDir::current();
+	QDir::setCurrent(fi.absolutePath());
+	ioPlugin->open(extension, fi.fileName(), meshList, maskList, prePar, cb);
+	QDir::setCurrent(oldDir.absolutePath());
+	qint64 parseTime = t.restart();
+
+	for (MeshModel* mm : meshList) {
+		std::list<std::string> tmp = mm->loadTextures(nullptr, cb);
+		unloadedTextures.insert(unloadedTextures.end(), tmp.begin(), tmp.end());
+	}
+	qint64 textureTime = t.restart();
+
+	postProcessLoadedMeshes(ioPlugin, meshList, maskList);
+
+	ioPlugin->log(
+		"Loaded %s: %lld msec parsing, %lld msec post-processing, %lld msec textures",
+		qUtf8Printable(fi.fileName()),
+		(long long) parseTime,
+		(long long) t.elapsed(),
+		(long long) textureTime);
+	return unloadedTextures;
+}
+
+/**
+ * @brief loads the given filename and puts the loaded mesh(es) into the
+ * given MeshDocument. Returns the list of loaded meshes.
+ *
+ * If you already know the open parameters that could be used to load the mesh,
+ * you can pass a RichParameterList containing them.
+ * Note: only parameters of your RPL that are actually required by the plugin
+ * will be given as input to the load function.
+ * If you don't know any parameter, leave the RichParameterList parameter empty.
+ *
+ * The function takes care to:
+ * - find the plugin that loads the format of the file
+ * - create the required MeshModels into the MeshDocument
+ * - load the meshes and their textures, with standard parameters
+ *
+ * if an error occurs, an exception will be thrown, and MeshDocument won't
+ * contain new meshes.
+ */
+std::list<MeshModel*> loadMeshWithStandardParameters(
+	const QString&    filename,
+	MeshDocument&     md,
+	vcg::CallBackPos* cb,
+	RichParameterList prePar)
+{
+	RichParameterList openParams;
+	IOPlugin* ioPlugin = openPluginAndParameters(filename, prePar, openParams);
+	ioPlugin->setLog(&md.Log);
+
+	std::list<MeshModel*> meshList = addMeshesOfFile(filename, ioPlugin, openParams, md);
 
 	std::list<int> masks;
 
@@ -201,6 +455,151 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 	return meshList;
 }
 
+/**
+ * @brief loads all the given files with standard parameters and puts the
+ * loaded meshes into the given MeshDocument. Returns, for each file, the list
+ * of meshes loaded from it.
+ *
+ * The MeshModels are created in the MeshDocument before loading, following
+ * the order of the files, so the ids and the order of the layers do not
+ * depend on the loading order. Files whose format supports concurrent
+ * loading (see IOPlugin::supportsConcurrentOpen) are then parsed in parallel;
+ * the other ones are loaded serially, as done by
+ * loadMeshWithStandardParameters.
+ *
+ * if an error occurs, an exception (the one of the first file, in the given
+ * order, that failed) will be thrown, and MeshDocument won't contain any of
+ * the new meshes. If failedFile is not null, the index of that file is
+ * written in it.
+ */
+std::vector<std::list<MeshModel*>> loadMeshesWithStandardParameters(
+	const QStringList& filenames,
+	MeshDocument&      md,
+	vcg::CallBackPos*  cb,
+	int*               failedFile)
+{
+	struct LoadJob {
+		QString               filename;
+		IOPlugin*             ioPlugin;
+		RichParameterList     openParams;
+		std::list<MeshModel*> meshList;
+		std::list<int>        masks;
+		bool                  concurrent;
+		bool                  failed = false;
+		QString               error;
+	};
+
+	std::vector<LoadJob> jobs(filenames.size());
+	auto removeCreatedMeshes = [&]() {
+		for (const LoadJob& job : jobs)
+			for (const MeshModel* mm : job.meshList)
+				md.delMesh(mm->id());
+	};
+
+	for (int i = 0; i < filenames.size(); ++i) {
+		LoadJob& job = jobs[i];
+		job.filename = QFileInfo(filenames[i]).absoluteFilePath();
+		try {
+			job.ioPlugin = openPluginAndParameters(job.filename, RichParameterList(), job.openParams);
+			job.concurrent = job.ioPlugin->supportsConcurrentOpen(QFileInfo(job.filename).suffix());
+			job.meshList = addMeshesOfFile(job.filename, job.ioPlugin, job.openParams, md);
+		}
+		catch (const MLException&) {
+			removeCreatedMeshes();
+			if (failedFile != nullptr)
+				*failedFile = i;
+			throw;
+		}
+	}
+
+	std::vector<std::list<MeshModel*>> loadedMeshes;
+	for (LoadJob& job : jobs)
+		loadedMeshes.push_back(job.meshList);
+
+	QElapsedTimer t;
+	t.start();
+	for (LoadJob& job : jobs) {
+		if (!job.concurrent) {
+			job.ioPlugin->setLog(&md.Log);
+			try {
+				loadMesh(job.filename, job.ioPlugin, job.openParams, job.meshList, job.masks, cb);
+			}
+			catch (const std::exception& e) {
+				job.failed = true;
+				job.error = QString::fromLocal8Bit(e.what());
+				break;
+			}
+		}
+	}
+
+	auto firstFailed = std::find_if(
+		jobs.begin(), jobs.end(), [](const LoadJob& job) { return job.failed; });
+	unsigned int nConcurrent = 0;
+	if (firstFailed == jobs.end()) {
+		// plugins used concurrently must not write on the log
+		for (LoadJob& job : jobs) {
+			if (job.concurrent) {
+				job.ioPlugin->setLog(nullptr);
+				++nConcurrent;
+			}
+		}
+
+		#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < (int) jobs.size(); ++i) {
+			LoadJob& job = jobs[i];
+			if (job.concurrent) {
+				try {
+					job.ioPlugin->open(
+						QFileInfo(job.filename).suffix(),
+						job.filename,
+						job.meshList,
+						job.masks,
+						job.openParams,
+						nullptr);
+					postProcessLoadedMeshes(job.ioPlugin, job.meshList, job.masks);
+				}
+				catch (const std::exception& e) {
+					job.failed = true;
+					job.error = QString::fromLocal8Bit(e.what());
+				}
+			}
+		}
+
+		for (LoadJob& job : jobs) {
+			if (job.concurrent)
+				job.ioPlugin->setLog(&md.Log);
+		}
+		firstFailed = std::find_if(
+			jobs.begin(), jobs.end(), [](const LoadJob& job) { return job.failed; });
+	}
+
+	if (firstFailed != jobs.end()) {
+		removeCreatedMeshes();
+		if (failedFile != nullptr)
+			*failedFile = firstFailed - jobs.begin();
+		throw MLException(firstFailed->error);
+	}
+
+	// textures are decoded after the meshes (each mesh decodes its textures
+	// concurrently), since some image plugins cannot be used by more threads
+	for (const LoadJob& job : jobs) {
+		if (job.concurrent) {
+			for (MeshModel* mm : job.meshList)
+				mm->loadTextures(&md.Log, cb);
+		}
+	}
+
+	if (nConcurrent > 0) {
+		md.Log.logf(
+			GLLogStream::SYSTEM,
+			"Loaded %d files in %lld msec (%u of them concurrently)",
+			(int) jobs.size(),
+			(long long) t.elapsed(),
+			nConcurrent);
+	}
+	return loadedMeshes;
+}
+
 void reloadMesh(
 	const QString&               filename,
 	const std::list<MeshModel*>& meshList,
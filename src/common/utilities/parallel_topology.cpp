@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "parallel_topology.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <vcg/complex/algorithms/update/topology.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace meshlab {
+
+namespace {
+
+// below this number of faces, the vcg serial functions are faster
+const size_t PARALLEL_TOPOLOGY_MIN_FACES = 100000;
+
+// A (face, wedge) incidence: the key is the one to be sorted, the value
+// encodes the face index and the wedge as 3*faceIndex + wedge
+struct KeyedWedge
+{
+	uint64_t key;
+	uint64_t fz;
+};
+
+int threadNumber()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+unsigned int bitsNeeded(uint64_t maxValue)
+{
+	unsigned int bits = 1;
+	while (bits < 64 && (maxValue >> bits) != 0)
+		++bits;
+	return bits;
+}
+
+/**
+ * @brief Stable parallel LSD radix sort, 8 bits per pass, that sorts only the
+ * first keyBits bits of the keys. Each thread histograms and scatters its own
+ * contiguous chunk, so the relative order of equal keys is preserved.
+ */
+void radixSort(std::vector<KeyedWedge>& v, unsigned int keyBits)
+{
+	const int nThreads = threadNumber();
+	const size_t n = v.size();
+	const size_t chunk = (n + nThreads - 1) / nThreads;
+	std::vector<KeyedWedge> tmp(n);
+	std::vector<std::array<size_t, 256>> offsets(nThreads);
+
+	for (unsigned int shift = 0; shift < keyBits; shift += 8) {
+		#pragma omp parallel for schedule(static)
+		for (int t = 0; t < nThreads; ++t) {
+			offsets[t].fill(0);
+			const size_t end = std::min(n, (t + 1) * chunk);
+			for (size_t i = t * chunk; i < end; ++i)
+				++offsets[t][(v[i].key >> shift) & 0xFF];
+		}
+
+		// exclusive prefix sum over (bucket, thread)
+		size_t sum = 0;
+		for (unsigned int b = 0; b < 256; ++b) {
+			for (int t = 0; t < nThreads; ++t) {
+				size_t c = offsets[t][b];
+				offsets[t][b] = sum;
+				sum += c;
+			}
+		}
+
+		#pragma omp parallel for schedule(static)
+		for (int t = 0; t < nThreads; ++t) {
+			const size_t end = std::min(n, (t + 1) * chunk);
+			for (size_t i = t * chunk; i < end; ++i)
+				tmp[offsets[t][(v[i].key >> shift) & 0xFF]++] = v[i];
+		}
+		v.swap(tmp);
+	}
+}
+
+std::vector<size_t> liveFaceIndices(const CMeshO& m)
+{
+	std::vector<size_t> live;
+	live.reserve(m.fn);
+	for (size_t i = 0; i < m.face.size(); ++i)
+		if (!m.face[i].IsD())
+			live.push_back(i);
+	return live;
+}
+
+} // namespace
+
+/**
+ * @brief Computes the Face-Face adjacency of the mesh.
+ * The FF adjacency must be already enabled on the mesh.
+ */
+void updateFaceFaceTopology(CMeshO& m)
+{
+	vcg::tri::RequireFFAdjacency(m);
+	if (m.fn == 0)
+		return;
+	if ((size_t) m.fn < PARALLEL_TOPOLOGY_MIN_FACES) {
+		vcg::tri::UpdateTopology<CMeshO>::FaceFace(m);
+		return;
+	}
+
+	const std::vector<size_t> live = liveFaceIndices(m);
+	const unsigned int vBits = bitsNeeded(m.vert.size());
+	std::vector<KeyedWedge> e(live.size() * 3);
+
+	// edge key: (min vertex index, max vertex index)
+	#pragma omp parallel for schedule(static)
+	for (long long k = 0; k < (long long) live.size(); ++k) {
+		const CFaceO& f = m.face[live[k]];
+		for (int j = 0; j < 3; ++j) {
+			uint64_t v0 = vcg::tri::Index(m, f.cV0(j));
+			uint64_t v1 = vcg::tri::Index(m, f.cV1(j));
+			if (v0 > v1)
+				std::swap(v0, v1);
+			e[k * 3 + j].key = (v0 << vBits) | v1;
+			e[k * 3 + j].fz  = live[k] * 3 + j;
+		}
+	}
+
+	radixSort(e, 2 * vBits);
+
+	// each run of equal keys is linked in a ring, as done by vcg: every entry
+	// points to the next one, and the last one points to the first
+	const long long n = e.size();
+	#pragma omp parallel for schedule(static)
+	for (long long k = 0; k < n; ++k) {
+		long long next = k + 1;
+		if (next == n || e[next].key != e[k].key) {
+			next = k;
+			while (next > 0 && e[next - 1].key == e[k].key)
+				--next;
+		}
+		CFaceO& f = m.face[e[k].fz / 3];
+		const int z = e[k].fz % 3;
+		f.FFp(z) = &m.face[e[next].fz / 3];
+		f.FFi(z) = e[next].fz % 3;
+	}
+}
+
+/**
+ * @brief Computes the Vertex-Face adjacency of the mesh.
+ * The VF adjacency must be already enabled on vertices and faces.
+ */
+void updateVertexFaceTopology(CMeshO& m)
+{
+	vcg::tri::RequireVFAdjacency(m);
+	if ((size_t) m.fn < PARALLEL_TOPOLOGY_MIN_FACES) {
+		vcg::tri::UpdateTopology<CMeshO>::VertexFace(m);
+		return;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for (long long i = 0; i < (long long) m.vert.size(); ++i) {
+		m.vert[i].VFp() = nullptr;
+		m.vert[i].VFi() = 0;
+	}
+
+	const std::vector<size_t> live = liveFaceIndices(m);
+	std::vector<KeyedWedge> e(live.size() * 3);
+
+	#pragma omp parallel for schedule(static)
+	for (long long k = 0; k < (long long) live.size(); ++k) {
+		const CFaceO& f = m.face[live[k]];
+		for (int j = 0; j < 3; ++j) {
+			e[k * 3 + j].key = vcg::tri::Index(m, f.cV(j));
+			e[k * 3 + j].fz  = live[k] * 3 + j;
+		}
+	}
+
+	// the sort is stable, so the wedges of each vertex stay in face order
+	radixSort(e, bitsNeeded(m.vert.size()));
+
+	// vcg pushes the faces at the head of the per-vertex list while scanning
+	// them in order: each wedge points to the previous one of the same vertex,
+	// and the vertex points to the last one
+	const long long n = e.size();
+	#pragma omp parallel for schedule(static)
+	for (long long k = 0; k < n; ++k) {
+		CFaceO& f = m.face[e[k].fz / 3];
+		const int z = e[k].fz % 3;
+		if (k > 0 && e[k - 1].key == e[k].key) {
+			f.VFp(z) = &m.face[e[k - 1].fz / 3];
+			f.VFi(z) = e[k - 1].fz % 3;
+		}
+		else {
+			f.VFp(z) = nullptr;
+			f.VFi(z) = 0;
+		}
+		if (k + 1 == n || e[k + 1].key != e[k].key) {
+			CVertexO& v = m.vert[e[k].key];
+			v.VFp() = &f;
+			v.VFi() = z;
+		}
+	}
+}
+
+} // namespace meshlab
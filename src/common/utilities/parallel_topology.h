@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MESHLAB_PARALLEL_TOPOLOGY_H
+#define MESHLAB_PARALLEL_TOPOLOGY_H
+
+#include "../ml_document/cmesh.h"
+
+/**
+ * Multi-threaded replacements of vcg::tri::UpdateTopology<CMeshO>::FaceFace
+ * and vcg::tri::UpdateTopology<CMeshO>::VertexFace.
+ *
+ * Instead of sorting a vector of pointer based edges, the (face, vertex)
+ * incidences are packed into integer keys and sorted with a parallel LSD
+ * radix sort; the adjacency is then filled in parallel, each entry of the
+ * sorted vector writing only its own face/wedge.
+ * The VF adjacency produced is identical to the one of the vcg function,
+ * while the FF adjacency differs only in the order of the faces around
+ * non-manifold edges (that is unspecified also in vcg).
+ *
+ * Small meshes are handled by the vcg functions.
+ */
+
+namespace meshlab {
+
+void updateFaceFaceTopology(CMeshO& m);
+void updateVertexFaceTopology(CMeshO& m);
+
+}
+
+#endif // MESHLAB_PARALLEL_TOPOLOGY_H
@@ -0,0 +1,363 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "sparse_volume.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+#include <vcg/complex/algorithms/create/marching_cubes.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace meshlab {
+
+namespace {
+
+const int B = IsosurfaceField::BLOCK_SIZE;
+
+// key of the vertices that are not on an edge of the grid (created by the
+// marching cubes inside the ambiguous cells)
+const std::uint64_t NO_KEY = std::numeric_limits<std::uint64_t>::max();
+
+int threadNumber()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+/**
+ * @brief the part of the surface inside a slab of blocks, with the vertices
+ * in grid coordinates and the grid edge on which each of them lies
+ */
+struct SlabSurface
+{
+	CMeshO                     mesh;
+	std::vector<std::uint64_t> keys;
+};
+
+/**
+ * @brief The key of the edge between two adjacent grid points: index of the
+ * lower point and direction of the edge.
+ */
+std::uint64_t edgeKey(vcg::Point3i p1, vcg::Point3i p2, const vcg::Point3i& siz)
+{
+	if (p2 < p1)
+		std::swap(p1, p2);
+	const int axis = p2[0] != p1[0] ? 0 : (p2[1] != p1[1] ? 1 : 2);
+	const std::uint64_t point = ((std::uint64_t) p1[2] * siz[1] + p1[1]) * siz[0] + p1[0];
+	return point * 3 + axis;
+}
+
+/**
+ * Walker for vcg::tri::MarchingCubes, visiting one block at a time of a slab.
+ * The samples of the current block (and of the first layer of the following
+ * blocks) are kept in a local buffer; the vertices are shared between the
+ * cells of the slab through a map indexed by the key of their edge.
+ */
+class BlockWalker
+{
+public:
+	typedef CMeshO::VertexPointer VertexPointer;
+
+	BlockWalker(const IsosurfaceField& field, float threshold, SlabSurface& surface) :
+			field(field),
+			siz(field.size()),
+			threshold(threshold),
+			surface(surface),
+			values((B + 1) * (B + 1) * (B + 1))
+	{
+	}
+
+	/**
+	 * @brief samples the block; returns false if the surface does not cross it
+	 */
+	bool loadBlock(const vcg::Point3i& block)
+	{
+		for (int c = 0; c < 3; ++c) {
+			origin[c] = block[c] * B;
+			count[c] = std::min(B + 1, siz[c] - origin[c]);
+		}
+		field.sampleBox(origin, count, values.data());
+		const int n = count[0] * count[1] * count[2];
+		bool below = false, above = false;
+		unknown = false;
+		for (int i = 0; i < n; ++i) {
+			below = below || values[i] <= threshold;
+			above = above || values[i] >= threshold;
+			unknown = unknown || std::isnan(values[i]);
+		}
+		return below && above;
+	}
+
+	const vcg::Point3i& blockOrigin() const { return origin; }
+	const vcg::Point3i& blockCount() const { return count; }
+
+	/**
+	 * @brief false if some corner of the cell with the lower corner p is
+	 * unknown
+	 */
+	bool isKnownCell(const vcg::Point3i& p) const
+	{
+		if (!unknown)
+			return true;
+		for (int k = 0; k < 2; ++k)
+			for (int j = 0; j < 2; ++j)
+				for (int i = 0; i < 2; ++i)
+					if (std::isnan(V(p[0] + i, p[1] + j, p[2] + k)))
+						return false;
+		return true;
+	}
+
+	float V(int i, int j, int k) const
+	{
+		i -= origin[0];
+		j -= origin[1];
+		k -= origin[2];
+		return values[(k * count[1] + j) * count[0] + i] - threshold;
+	}
+
+	bool Exist(const vcg::Point3i& p1, const vcg::Point3i& p2, VertexPointer& v)
+	{
+		auto it = vertexMap.find(edgeKey(p1, p2, siz));
+		v = it != vertexMap.end() ? &surface.mesh.vert[it->second] : nullptr;
+		return v != nullptr;
+	}
+
+	void GetXIntercept(const vcg::Point3i& p1, const vcg::Point3i& p2, VertexPointer& v)
+	{
+		getIntercept(p1, p2, v);
+	}
+	void GetYIntercept(const vcg::Point3i& p1, const vcg::Point3i& p2, VertexPointer& v)
+	{
+		getIntercept(p1, p2, v);
+	}
+	void GetZIntercept(const vcg::Point3i& p1, const vcg::Point3i& p2, VertexPointer& v)
+	{
+		getIntercept(p1, p2, v);
+	}
+
+private:
+	void getIntercept(const vcg::Point3i& p1, const vcg::Point3i& p2, VertexPointer& v)
+	{
+		const std::uint64_t key = edgeKey(p1, p2, siz);
+		auto it = vertexMap.find(key);
+		if (it != vertexMap.end()) {
+			v = &surface.mesh.vert[it->second];
+			return;
+		}
+		const int vi = (int) surface.mesh.vert.size();
+		vcg::tri::Allocator<CMeshO>::AddVertices(surface.mesh, 1);
+		surface.keys.resize(vi + 1, NO_KEY);
+		surface.keys[vi] = key;
+		vertexMap[key] = vi;
+		v = &surface.mesh.vert[vi];
+
+		const float f1 = V(p1[0], p1[1], p1[2]);
+		const float f2 = V(p2[0], p2[1], p2[2]);
+		const float u = f1 != f2 ? f1 / (f1 - f2) : 0.5f;
+		for (int c = 0; c < 3; ++c)
+			v->P()[c] = p1[c] * (1 - u) + p2[c] * u;
+	}
+
+	const IsosurfaceField& field;
+	vcg::Point3i           siz;
+	float                  threshold;
+	SlabSurface&           surface;
+	std::vector<float>     values;
+	vcg::Point3i           origin;
+	vcg::Point3i           count;
+	bool                   unknown = false; // the block has some unknown samples
+	std::unordered_map<std::uint64_t, int> vertexMap;
+};
+
+/**
+ * @brief runs the marching cubes on the cells of the blocks of the slab bz
+ */
+void extractSlab(const IsosurfaceField& field, float threshold, int bz, SlabSurface& surface)
+{
+	typedef vcg::tri::MarchingCubes<CMeshO, BlockWalker> MarchingCubes;
+	const vcg::Point3i siz = field.size();
+	BlockWalker   walker(field, threshold, surface);
+	MarchingCubes mc(surface.mesh, walker);
+
+	mc.Initialize();
+	for (int by = 0; by * B < siz[1] - 1; ++by) {
+		for (int bx = 0; bx * B < siz[0] - 1; ++bx) {
+			const vcg::Point3i block(bx, by, bz);
+			if (field.isUniformBlock(block) || !walker.loadBlock(block))
+				continue;
+			const vcg::Point3i& o = walker.blockOrigin();
+			const vcg::Point3i& n = walker.blockCount();
+			for (int k = o[2]; k < o[2] + n[2] - 1; ++k)
+				for (int j = o[1]; j < o[1] + n[1] - 1; ++j)
+					for (int i = o[0]; i < o[0] + n[0] - 1; ++i) {
+						vcg::Point3i p(i, j, k);
+						if (walker.isKnownCell(p))
+							mc.ProcessCell(p, p + vcg::Point3i(1, 1, 1));
+					}
+		}
+	}
+	mc.Finalize();
+	surface.keys.resize(surface.mesh.vert.size(), NO_KEY);
+}
+
+/**
+ * @brief Appends the surface of the slab bz to m. The vertices on the edges
+ * of the bottom plane of the slab have been created also by the previous
+ * slab: they are found in seam, that is then replaced by the vertices on the
+ * top plane.
+ */
+void appendSlab(
+	CMeshO&                                  m,
+	const SlabSurface&                       surface,
+	int                                      bz,
+	const vcg::Point3i&                      siz,
+	const Point3m&                           origin,
+	const Point3m&                           voxelSize,
+	std::unordered_map<std::uint64_t, int>& seam)
+{
+	const std::uint64_t planeSize = (std::uint64_t) siz[0] * siz[1];
+	const int bottom = bz * B;
+	const int top = bottom + B;
+
+	std::unordered_map<std::uint64_t, int> nextSeam;
+	std::vector<int> remap(surface.mesh.vert.size());
+	int vn = (int) m.vert.size();
+	for (size_t vi = 0; vi < surface.mesh.vert.size(); ++vi) {
+		const std::uint64_t key = surface.keys[vi];
+		const int z = key == NO_KEY ? -1 : (int) (key / 3 / planeSize);
+		const bool onPlane = key != NO_KEY && key % 3 != 2;
+		auto it = onPlane && z == bottom ? seam.find(key) : seam.end();
+		remap[vi] = it != seam.end() ? it->second : vn++;
+		if (onPlane && z == top)
+			nextSeam[key] = remap[vi];
+	}
+	seam.swap(nextSeam);
+
+	const int firstVert = (int) m.vert.size();
+	if (vn > firstVert)
+		vcg::tri::Allocator<CMeshO>::AddVertices(m, vn - firstVert);
+	for (size_t vi = 0; vi < surface.mesh.vert.size(); ++vi) {
+		if (remap[vi] < firstVert)
+			continue;
+		const Point3m& p = surface.mesh.vert[vi].cP();
+		m.vert[remap[vi]].P() = Point3m(
+			origin[0] + p[0] * voxelSize[0],
+			origin[1] + p[1] * voxelSize[1],
+			origin[2] + p[2] * voxelSize[2]);
+	}
+
+	const int firstFace = (int) m.face.size();
+	if (!surface.mesh.face.empty())
+		vcg::tri::Allocator<CMeshO>::AddFaces(m, surface.mesh.face.size());
+	for (size_t fi = 0; fi < surface.mesh.face.size(); ++fi) {
+		const CFaceO& f = surface.mesh.face[fi];
+		for (int k = 0; k < 3; ++k)
+			m.face[firstFace + fi].V(k) = &m.vert[remap[vcg::tri::Index(surface.mesh, f.cV(k))]];
+	}
+}
+
+} // namespace
+
+SparseVolume::SparseVolume(const vcg::Point3i& size, float background) :
+		siz(size),
+		bg(background),
+		nBlocks(
+			(std::max(size[0], 0) + BLOCK_SIZE - 1) / BLOCK_SIZE,
+			(std::max(size[1], 0) + BLOCK_SIZE - 1) / BLOCK_SIZE,
+			(std::max(size[2], 0) + BLOCK_SIZE - 1) / BLOCK_SIZE),
+		blocks((std::size_t) nBlocks[0] * nBlocks[1] * nBlocks[2])
+{
+}
+
+std::size_t SparseVolume::allocatedBlockCount() const
+{
+	return std::count_if(blocks.begin(), blocks.end(), [](const std::unique_ptr<float[]>& b) {
+		return b != nullptr;
+	});
+}
+
+void SparseVolume::sampleBox(const vcg::Point3i& origin, const vcg::Point3i& count, float* values) const
+{
+	for (int k = origin[2]; k < origin[2] + count[2]; ++k)
+		for (int j = origin[1]; j < origin[1] + count[1]; ++j)
+			for (int i = origin[0]; i < origin[0] + count[0]; ++i)
+				*values++ = value(i, j, k);
+}
+
+/**
+ * The cells of a block have corners in the block itself and in the
+ * following ones along the three axes: if none of them is allocated, all the
+ * corners have the background value.
+ */
+bool SparseVolume::isUniformBlock(const vcg::Point3i& block) const
+{
+	for (int z = block[2]; z <= std::min(block[2] + 1, nBlocks[2] - 1); ++z)
+		for (int y = block[1]; y <= std::min(block[1] + 1, nBlocks[1] - 1); ++y)
+			for (int x = block[0]; x <= std::min(block[0] + 1, nBlocks[0] - 1); ++x)
+				if (blocks[blockIndex(x, y, z)] != nullptr)
+					return false;
+	return true;
+}
+
+void extractIsosurface(
+	CMeshO&                m,
+	const IsosurfaceField& field,
+	float                  threshold,
+	const Point3m&         origin,
+	const Point3m&         voxelSize,
+	vcg::CallBackPos*      cb)
+{
+	const vcg::Point3i siz = field.size();
+	if (siz[0] < 2 || siz[1] < 2 || siz[2] < 2)
+		return;
+	const int nSlabs = (siz[2] - 2) / B + 1;
+
+	// slabs are extracted in parallel in batches, and appended in order
+	std::vector<SlabSurface> batch(std::min(nSlabs, 2 * threadNumber()));
+	std::unordered_map<std::uint64_t, int> seam;
+	for (int first = 0; first < nSlabs; first += (int) batch.size()) {
+		const int n = std::min((int) batch.size(), nSlabs - first);
+		#pragma omp parallel for schedule(dynamic)
+		for (int s = 0; s < n; ++s)
+			extractSlab(field, threshold, first + s, batch[s]);
+
+		for (int s = 0; s < n; ++s) {
+			appendSlab(m, batch[s], first + s, siz, origin, voxelSize, seam);
+			batch[s].mesh.Clear();
+			batch[s].keys.clear();
+		}
+		if (cb != nullptr)
+			cb(100 * (first + n) / nSlabs, "Marching cubes...");
+	}
+}
+
+} // namespace meshlab
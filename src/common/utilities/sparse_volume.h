@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MESHLAB_SPARSE_VOLUME_H
+#define MESHLAB_SPARSE_VOLUME_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "../ml_document/cmesh.h"
+
+/**
+ * Isosurface extraction on large grids, a replacement of the dense
+ * vcg::SimpleVolume + vcg::tri::TrivialWalker pair.
+ *
+ * The field is read through the IsosurfaceField interface, one block of
+ * BLOCK_SIZE^3 cells at a time: it can be a SparseVolume, that stores only the
+ * blocks that have been written, or a FunctionField, that evaluates a function
+ * on the fly without storing anything. extractIsosurface runs the vcg marching
+ * cubes in parallel on slabs of blocks along z and appends each batch of slabs
+ * to the mesh as soon as it is done, welding the vertices on the seams between
+ * slabs, so the memory used besides the output mesh does not depend on the
+ * size of the grid.
+ */
+
+namespace meshlab {
+
+/**
+ * @brief A scalar field sampled on a regular grid of size()[0] x size()[1] x
+ * size()[2] points.
+ */
+class IsosurfaceField
+{
+public:
+	static const int BLOCK_SIZE = 16;
+
+	virtual ~IsosurfaceField() {}
+
+	virtual vcg::Point3i size() const = 0;
+
+	/**
+	 * @brief Writes in values the samples of the box of count[0] x count[1] x
+	 * count[2] points starting at origin, x varying fastest. Called
+	 * concurrently by different threads, on different boxes.
+	 */
+	virtual void sampleBox(const vcg::Point3i& origin, const vcg::Point3i& count, float* values) const = 0;
+
+	/**
+	 * @brief true if the field is known to have the same value on all the
+	 * corners of the cells of the block, so that no surface can cross it and
+	 * the block is not even sampled
+	 */
+	virtual bool isUniformBlock(const vcg::Point3i& /*block*/) const { return false; }
+};
+
+/**
+ * @brief A field given by a function f(i, j, k) of the grid indices, evaluated
+ * when needed. f must be thread safe. The samples on the borders of the
+ * blocks are evaluated by both the blocks.
+ */
+template <typename Function>
+class FunctionField : public IsosurfaceField
+{
+public:
+	FunctionField(const vcg::Point3i& size, Function f) : siz(size), f(f) {}
+
+	vcg::Point3i size() const { return siz; }
+
+	void sampleBox(const vcg::Point3i& origin, const vcg::Point3i& count, float* values) const
+	{
+		for (int k = origin[2]; k < origin[2] + count[2]; ++k)
+			for (int j = origin[1]; j < origin[1] + count[1]; ++j)
+				for (int i = origin[0]; i < origin[0] + count[0]; ++i)
+					*values++ = f(i, j, k);
+	}
+
+private:
+	vcg::Point3i siz;
+	Function     f;
+};
+
+template <typename Function>
+FunctionField<Function> makeFunctionField(const vcg::Point3i& size, Function f)
+{
+	return FunctionField<Function>(size, f);
+}
+
+/**
+ * @brief A volume made of blocks of BLOCK_SIZE^3 samples, allocated when a
+ * sample is written for the first time; all the samples of the blocks never
+ * written have the background value.
+ */
+class SparseVolume : public IsosurfaceField
+{
+public:
+	SparseVolume(const vcg::Point3i& size, float background);
+
+	vcg::Point3i size() const { return siz; }
+	const vcg::Point3i& blockCount() const { return nBlocks; }
+	float background() const { return bg; }
+	std::size_t allocatedBlockCount() const;
+
+	bool isAllocated(const vcg::Point3i& block) const
+	{
+		return blocks[blockIndex(block[0], block[1], block[2])] != nullptr;
+	}
+
+	float value(int x, int y, int z) const
+	{
+		const float* b =
+			blocks[blockIndex(x / BLOCK_SIZE, y / BLOCK_SIZE, z / BLOCK_SIZE)].get();
+		return b != nullptr ? b[voxelIndex(x, y, z)] : bg;
+	}
+
+	/**
+	 * @brief the sample, allocating its block if needed. Different threads can
+	 * safely call it as long as they access different blocks.
+	 */
+	float& value(int x, int y, int z)
+	{
+		std::unique_ptr<float[]>& b =
+			blocks[blockIndex(x / BLOCK_SIZE, y / BLOCK_SIZE, z / BLOCK_SIZE)];
+		if (b == nullptr) {
+			b.reset(new float[BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE]);
+			std::fill(b.get(), b.get() + BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE, bg);
+		}
+		return b[voxelIndex(x, y, z)];
+	}
+
+	void sampleBox(const vcg::Point3i& origin, const vcg::Point3i& count, float* values) const;
+	bool isUniformBlock(const vcg::Point3i& block) const;
+
+private:
+	std::size_t blockIndex(int bx, int by, int bz) const
+	{
+		return ((std::size_t) bz * nBlocks[1] + by) * nBlocks[0] + bx;
+	}
+
+	static int voxelIndex(int x, int y, int z)
+	{
+		return ((z % BLOCK_SIZE) * BLOCK_SIZE + (y % BLOCK_SIZE)) * BLOCK_SIZE + (x % BLOCK_SIZE);
+	}
+
+	vcg::Point3i siz;
+	float        bg;
+	vcg::Point3i nBlocks;
+	std::vector<std::unique_ptr<float[]>> blocks;
+};
+
+/**
+ * @brief Appends to m the isosurface of the field at the given threshold,
+ * extracted with the vcg marching cubes. The grid point (i, j, k) is placed at
+ * origin + (i * voxelSize[0], j * voxelSize[1], k * voxelSize[2]).
+ *
+ * The surface is the same that vcg::tri::TrivialWalker would extract from a
+ * dense volume with the same samples, with the same orientation of the
+ * faces, up to the order of the elements. Only the vertex coordinates are
+ * set.
+ *
+ * Samples that are NaN are unknown: the cells with an unknown corner are
+ * skipped, so a narrow band field can leave all the samples far from the
+ * surface unknown (e.g. a SparseVolume with a NaN background).
+ */
+void extractIsosurface(
+	CMeshO&                m,
+	const IsosurfaceField& field,
+	float                  threshold,
+	const Point3m&         origin,
+	const Point3m&         voxelSize,
+	vcg::CallBackPos*      cb = nullptr);
+
+} // namespace meshlab
+
+#endif // MESHLAB_SPARSE_VOLUME_H
@@ -0,0 +1,295 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "text_formatting.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace meshlab {
+
+namespace {
+
+const double POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+const unsigned long long POW10_INT[] = {
+	1ull,
+	10ull,
+	100ull,
+	1000ull,
+	10000ull,
+	100000ull,
+	1000000ull,
+	10000000ull,
+	100000000ull,
+	1000000000ull,
+	10000000000ull,
+	100000000000ull,
+	1000000000000ull,
+	10000000000000ull,
+	100000000000000ull,
+	1000000000000000ull,
+	10000000000000000ull,
+	100000000000000000ull};
+
+// integers below this value are exactly representable as doubles
+const double MAX_EXACT_INTEGER = 9007199254740992.0; // 2^53
+
+/**
+ * @brief writes the decimal digits of v, right aligned in [p, p + width),
+ * padding with zeros; returns p + width
+ */
+char* writeDigits(char* p, unsigned long long v, int width)
+{
+	for (int i = width - 1; i >= 0; --i) {
+		p[i] = '0' + (char) (v % 10);
+		v /= 10;
+	}
+	return p + width;
+}
+
+int countDigits(unsigned long long v)
+{
+	int n = 1;
+	while (v >= 10) {
+		v /= 10;
+		++n;
+	}
+	return n;
+}
+
+/**
+ * @brief the value of mantissa * 10^exp10 correctly rounded to double, when
+ * the conversion is exact (Clinger's fast path); returns false otherwise.
+ */
+bool decimalToDouble(unsigned long long mantissa, int exp10, double& value)
+{
+	if (mantissa >= (unsigned long long) MAX_EXACT_INTEGER || exp10 < -22 || exp10 > 22)
+		return false;
+	value = (double) mantissa;
+	if (exp10 < 0)
+		value /= POW10[-exp10];
+	else
+		value *= POW10[exp10];
+	return true;
+}
+
+/**
+ * @brief Finds the shortest mantissa * 10^exp10 that is converted back to
+ * value by convert(double). Candidates are built with a few floating point
+ * operations and accepted only if they round-trip, so the result is always
+ * correct; in rare cases near ties it may have one digit more than needed.
+ * Returns false if the value cannot be handled this way.
+ */
+template <typename Convert>
+bool shortestDecimal(
+	double             value,
+	int                maxDigits,
+	Convert            convert,
+	unsigned long long& mantissa,
+	int&               exp10)
+{
+	const int e = (int) std::floor(std::log10(value));
+	for (int digits = 1; digits <= maxDigits; ++digits) {
+		const int k = e - digits + 1;
+		if (k < -22 || k > 22)
+			return false;
+		const double scaled = k >= 0 ? value / POW10[k] : value * POW10[-k];
+		const double m = std::nearbyint(scaled);
+		if (m <= 0 || m >= MAX_EXACT_INTEGER)
+			return false;
+		double candidate;
+		if (decimalToDouble((unsigned long long) m, k, candidate) && convert(candidate) == convert(value)) {
+			mantissa = (unsigned long long) m;
+			exp10 = k;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+void TextBuffer::appendInt(long long value)
+{
+	reserve(24);
+	char* p = buffer.data() + used;
+	unsigned long long v = (unsigned long long) value;
+	if (value < 0) {
+		*p++ = '-';
+		v = 0ull - v;
+	}
+	char tmp[24];
+	char* t = tmp + sizeof(tmp);
+	do {
+		*--t = '0' + (char) (v % 10);
+		v /= 10;
+	} while (v != 0);
+	const std::size_t n = tmp + sizeof(tmp) - t;
+	std::memcpy(p, t, n);
+	used = (p + n) - buffer.data();
+}
+
+void TextBuffer::appendFixed(double value, int decimals)
+{
+	decimals = std::max(0, std::min(decimals, 17));
+	const double a = std::fabs(value);
+	const double x = a * POW10[decimals];
+	if (!std::isfinite(x) || x >= MAX_EXACT_INTEGER) {
+		appendPrintf("%.*f", decimals, value);
+		return;
+	}
+	// x is within half ulp of the exact product, so the rounding to integer
+	// is the same of printf unless x is too close to a tie
+	const double r = std::floor(x);
+	const double frac = x - r;
+	if (std::fabs(frac - 0.5) <= x * 4.440892098500626e-16 + 1e-18) {
+		appendPrintf("%.*f", decimals, value);
+		return;
+	}
+	const unsigned long long m = (unsigned long long) r + (frac > 0.5 ? 1 : 0);
+	const unsigned long long intPart = m / POW10_INT[decimals];
+	const unsigned long long fracPart = m % POW10_INT[decimals];
+
+	reserve(24 + decimals);
+	char* p = buffer.data() + used;
+	if (std::signbit(value))
+		*p++ = '-';
+	p = writeDigits(p, intPart, countDigits(intPart));
+	if (decimals > 0) {
+		*p++ = '.';
+		p = writeDigits(p, fracPart, decimals);
+	}
+	used = p - buffer.data();
+}
+
+void TextBuffer::appendShortest(double value)
+{
+	unsigned long long mantissa;
+	int exp10;
+	if (value == 0) {
+		std::signbit(value) ? append("-0") : append('0');
+	}
+	else if (
+		std::isfinite(value) &&
+		shortestDecimal(std::fabs(value), 17, [](double v) { return v; }, mantissa, exp10)) {
+		appendDigits(mantissa, exp10, value < 0);
+	}
+	else {
+		appendPrintf("%.*g", 17, value);
+	}
+}
+
+void TextBuffer::appendShortest(float value)
+{
+	unsigned long long mantissa;
+	int exp10;
+	if (value == 0) {
+		std::signbit(value) ? append("-0") : append('0');
+	}
+	else if (
+		std::isfinite(value) &&
+		shortestDecimal(std::fabs(value), 9, [](double v) { return (float) v; }, mantissa, exp10)) {
+		appendDigits(mantissa, exp10, value < 0);
+	}
+	else {
+		appendPrintf("%.*g", 9, value);
+	}
+}
+
+/**
+ * @brief appends mantissa * 10^exp10, without exponent if the decimal
+ * exponent of the first digit is in [-5, 16]
+ */
+void TextBuffer::appendDigits(unsigned long long mantissa, int exp10, bool negative)
+{
+	while (mantissa % 10 == 0) {
+		mantissa /= 10;
+		++exp10;
+	}
+	char digits[24];
+	const int n = countDigits(mantissa);
+	writeDigits(digits, mantissa, n);
+	const int first = exp10 + n - 1; // exponent of the first digit
+
+	reserve(48);
+	char* p = buffer.data() + used;
+	if (negative)
+		*p++ = '-';
+	if (first >= -5 && first <= 16) {
+		if (exp10 >= 0) {
+			std::memcpy(p, digits, n);
+			p += n;
+			std::memset(p, '0', exp10);
+			p += exp10;
+		}
+		else if (first >= 0) {
+			std::memcpy(p, digits, first + 1);
+			p += first + 1;
+			*p++ = '.';
+			std::memcpy(p, digits + first + 1, n - first - 1);
+			p += n - first - 1;
+		}
+		else {
+			*p++ = '0';
+			*p++ = '.';
+			std::memset(p, '0', -first - 1);
+			p += -first - 1;
+			std::memcpy(p, digits, n);
+			p += n;
+		}
+	}
+	else {
+		*p++ = digits[0];
+		if (n > 1) {
+			*p++ = '.';
+			std::memcpy(p, digits + 1, n - 1);
+			p += n - 1;
+		}
+		*p++ = 'e';
+		*p++ = first < 0 ? '-' : '+';
+		const int e = std::abs(first);
+		p = writeDigits(p, e, e < 10 ? 2 : countDigits(e));
+	}
+	used = p - buffer.data();
+}
+
+/**
+ * @brief slow path: formats with snprintf, replacing the decimal separator
+ * of the current locale with '.'
+ */
+void TextBuffer::appendPrintf(const char* format, int precision, double value)
+{
+	char tmp[512];
+	int n = std::snprintf(tmp, sizeof(tmp), format, precision, value);
+	n = std::max(0, std::min(n, (int) sizeof(tmp) - 1));
+	for (int i = 0; i < n; ++i)
+		if (tmp[i] == ',')
+			tmp[i] = '.';
+	append(tmp, n);
+}
+
+} // namespace meshlab
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MESHLAB_TEXT_FORMATTING_H
+#define MESHLAB_TEXT_FORMATTING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Fast number to text conversion for the ascii exporters, the counterpart of
+ * text_parsing.h. Numbers are appended to a TextBuffer without going through
+ * printf or streams, and the rows of a file can be formatted in parallel with
+ * formatRowsInParallel. The decimal separator is always '.', whatever the
+ * current locale.
+ */
+
+namespace meshlab {
+
+class TextBuffer
+{
+public:
+	const char* data() const { return buffer.data(); }
+	std::size_t size() const { return used; }
+	void clear() { used = 0; }
+
+	void append(char c)
+	{
+		reserve(1);
+		buffer[used++] = c;
+	}
+
+	void append(const char* s, std::size_t n)
+	{
+		reserve(n);
+		std::copy(s, s + n, buffer.data() + used);
+		used += n;
+	}
+
+	template <std::size_t N>
+	void append(const char (&s)[N])
+	{
+		append(s, N - 1);
+	}
+
+	void appendInt(long long value);
+
+	/**
+	 * @brief Appends the value with the given number of decimals (at most
+	 * 17): the result is exactly the same of printf("%.*f", decimals, value),
+	 * including the rounding of ties.
+	 */
+	void appendFixed(double value, int decimals);
+
+	/**
+	 * @brief Appends the shortest decimal representation that is read back
+	 * (e.g. by strtod) as the same value. Values with a decimal exponent in
+	 * [-5, 16] are written without exponent.
+	 */
+	void appendShortest(double value);
+
+	/**
+	 * @brief Same as appendShortest(double), for the values that will be read
+	 * back as floats: usually a lot shorter than the double version.
+	 */
+	void appendShortest(float value);
+
+private:
+	void reserve(std::size_t n)
+	{
+		if (used + n > buffer.size())
+			buffer.resize(std::max(2 * buffer.size(), used + n + 256));
+	}
+
+	void appendDigits(unsigned long long mantissa, int exp10, bool negative);
+	void appendPrintf(const char* format, int precision, double value);
+
+	std::vector<char> buffer;
+	std::size_t used = 0;
+};
+
+/**
+ * @brief Formats rowCount rows of text, calling format(row, buffer) for each
+ * row, and passes the result, in the same order of the rows, to
+ * write(const char* data, std::size_t size).
+ *
+ * Rows are formatted in parallel, in chunks of rowsPerChunk rows; a batch of
+ * a few chunks per thread is formatted before being written, so that the
+ * memory used does not depend on the number of rows. format must be thread
+ * safe; write is called only by the calling thread.
+ */
+template <typename Format, typename Write>
+void formatRowsInParallel(
+	std::size_t rowCount,
+	Format      format,
+	Write       write,
+	std::size_t rowsPerChunk = 4096)
+{
+#ifdef _OPENMP
+	const std::size_t nThreads = omp_get_max_threads();
+#else
+	const std::size_t nThreads = 1;
+#endif
+	const std::size_t nChunks = (rowCount + rowsPerChunk - 1) / rowsPerChunk;
+	std::vector<TextBuffer> buffers(std::min(nChunks, nThreads * 4));
+
+	for (std::size_t first = 0; first < nChunks; first += buffers.size()) {
+		const int n = (int) std::min(buffers.size(), nChunks - first);
+		#pragma omp parallel for schedule(dynamic)
+		for (int c = 0; c < n; ++c) {
+			TextBuffer& buffer = buffers[c];
+			buffer.clear();
+			const std::size_t begin = (first + c) * rowsPerChunk;
+			const std::size_t end = std::min(begin + rowsPerChunk, rowCount);
+			for (std::size_t row = begin; row < end; ++row)
+				format(row, buffer);
+		}
+		for (int c = 0; c < n; ++c)
+			write(buffers[c].data(), buffers[c].size());
+	}
+}
+
+} // namespace meshlab
+
+#endif // MESHLAB_TEXT_FORMATTING_H
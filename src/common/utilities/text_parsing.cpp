@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "text_parsing.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace meshlab {
+
+std::vector<TextChunk> splitTextInChunks(
+	const char* begin,
+	const char* end,
+	std::size_t minChunkSize)
+{
+#ifdef _OPENMP
+	std::size_t nThreads = omp_get_max_threads();
+#else
+	std::size_t nThreads = 1;
+#endif
+	const std::size_t size = end - begin;
+	// a few chunks per thread, to balance lines of different lengths
+	std::size_t nChunks = std::max<std::size_t>(
+		1, std::min(nThreads * 4, size / std::max<std::size_t>(minChunkSize, 1)));
+	const std::size_t chunkSize = size / nChunks;
+
+	std::vector<TextChunk> chunks;
+	const char* p = begin;
+	for (std::size_t i = 0; i < nChunks && p < end; ++i) {
+		const char* e = (i == nChunks - 1) ? end : nextLine(std::max(p, begin + (i + 1) * chunkSize - 1), end);
+		chunks.push_back({p, e});
+		p = e;
+	}
+	if (chunks.empty())
+		chunks.push_back({begin, end});
+	return chunks;
+}
+
+bool parseDoubleSlow(const char*& p, const char* end, double& value)
+{
+	// strtod needs a null terminated string: copy the token
+	const char* s = skipBlanks(p, end);
+	char buf[128];
+	std::size_t n = 0;
+	while (s + n < end && n < sizeof(buf) - 1 && !isBlank(s[n]) && s[n] != '\n' && s[n] != '/')
+	{
+		buf[n] = s[n];
+		++n;
+	}
+	buf[n] = '\0';
+	char* parsedEnd = nullptr;
+	value = std::strtod(buf, &parsedEnd);
+	if (parsedEnd == buf)
+		return false;
+	p = s + (parsedEnd - buf);
+	return true;
+}
+
+} // namespace meshlab
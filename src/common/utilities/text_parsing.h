@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MESHLAB_TEXT_PARSING_H
+#define MESHLAB_TEXT_PARSING_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Allocation free helpers for parsing large text files (usually memory
+ * mapped) in parallel: the buffer is split in chunks at line boundaries, and
+ * each chunk is scanned with the functions below, that work on [p, end)
+ * ranges that are not required to be null terminated.
+ */
+
+namespace meshlab {
+
+struct TextChunk
+{
+	const char* begin;
+	const char* end;
+};
+
+/**
+ * @brief Splits [begin, end) in chunks that start at the beginning of a line.
+ * The number of chunks depends on the number of threads and on the size of
+ * the buffer (chunks are never smaller than minChunkSize bytes, except the
+ * last one).
+ */
+std::vector<TextChunk> splitTextInChunks(
+	const char* begin,
+	const char* end,
+	std::size_t minChunkSize = 1 << 20);
+
+inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p))
+		++p;
+	return p;
+}
+
+/**
+ * @brief returns the pointer to the first character of the next line
+ * (or end).
+ */
+inline const char* nextLine(const char* p, const char* end)
+{
+	while (p < end && *p != '\n')
+		++p;
+	return p < end ? p + 1 : end;
+}
+
+/**
+ * @brief returns true if p is at the end of the line (or of the buffer),
+ * ignoring blanks
+ */
+inline bool isEndOfLine(const char* p, const char* end)
+{
+	p = skipBlanks(p, end);
+	return p == end || *p == '\n';
+}
+
+bool parseDoubleSlow(const char*& p, const char* end, double& value);
+
+/**
+ * @brief Parses a floating point number starting at p (leading blanks are
+ * skipped), advancing p after it. Returns false if there is no number at p.
+ *
+ * Numbers with at most 15 significant digits and a small exponent are
+ * converted exactly with a single multiplication or division (Clinger's fast
+ * path); the other ones fall back to strtod, so the result is always the same
+ * of atof.
+ */
+inline bool parseDouble(const char*& p, const char* end, double& value)
+{
+	static const double pow10[] = {
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	const char* s = skipBlanks(p, end);
+	const char* start = s;
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+')) {
+		negative = *s == '-';
+		++s;
+	}
+	uint64_t mantissa = 0;
+	int significantDigits = 0;
+	int exp10 = 0;
+	bool anyDigit = false;
+	while (s < end && *s >= '0' && *s <= '9') {
+		mantissa = mantissa * 10 + (*s - '0');
+		if (mantissa != 0)
+			++significantDigits;
+		anyDigit = true;
+		if (significantDigits > 15) {
+			p = start;
+			return parseDoubleSlow(p, end, value);
+		}
+		++s;
+	}
+	if (s < end && *s == '.') {
+		++s;
+		while (s < end && *s >= '0' && *s <= '9') {
+			mantissa = mantissa * 10 + (*s - '0');
+			if (mantissa != 0)
+				++significantDigits;
+			--exp10;
+			anyDigit = true;
+			if (significantDigits > 15) {
+				p = start;
+				return parseDoubleSlow(p, end, value);
+			}
+			++s;
+		}
+	}
+	if (!anyDigit) {
+		// e.g. nan, inf
+		p = start;
+		return parseDoubleSlow(p, end, value);
+	}
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		++s;
+		bool negativeExp = false;
+		if (s < end && (*s == '-' || *s == '+')) {
+			negativeExp = *s == '-';
+			++s;
+		}
+		if (s == end || *s < '0' || *s > '9') {
+			p = start;
+			return parseDoubleSlow(p, end, value);
+		}
+		int e = 0;
+		while (s < end && *s >= '0' && *s <= '9') {
+			if (e < 10000)
+				e = e * 10 + (*s - '0');
+			++s;
+		}
+		exp10 += negativeExp ? -e : e;
+	}
+	if (exp10 < -22 || exp10 > 22) {
+		p = start;
+		return parseDoubleSlow(p, end, value);
+	}
+	value = (double) mantissa;
+	if (exp10 < 0)
+		value /= pow10[-exp10];
+	else
+		value *= pow10[exp10];
+	if (negative)
+		value = -value;
+	p = s;
+	return true;
+}
+
+/**
+ * @brief Parses an integer starting at p (leading blanks are skipped),
+ * advancing p after it. Returns false if there is no integer at p.
+ */
+inline bool parseInt(const char*& p, const char* end, long long& value)
+{
+	const char* s = skipBlanks(p, end);
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+')) {
+		negative = *s == '-';
+		++s;
+	}
+	if (s == end || *s < '0' || *s > '9')
+		return false;
+	long long v = 0;
+	while (s < end && *s >= '0' && *s <= '9') {
+		v = v * 10 + (*s - '0');
+		++s;
+	}
+	value = negative ? -v : v;
+	p = s;
+	return true;
+}
+
+} // namespace meshlab
+
+#endif // MESHLAB_TEXT_PARSING_H
@@ -75,6 +75,7 @@ namespace U3D_IDTF
 		/**
 		*/
 		const Texture& GetResource( U32 index ) const;
+		Texture& GetResource( U32 index );
 		U32 GetResourceCount() const;
 
 	private:
@@ -96,6 +97,11 @@ namespace U3D_IDTF
 		return m_resourceList.GetElementConst( index );
 	}
 
+	IFXFORCEINLINE Texture& TextureResourceList::GetResource( U32 index )
+	{
+		return m_resourceList.GetElement( index );
+	}
+
 	IFXFORCEINLINE U32 TextureResourceList::GetResourceCount() const
 	{
 		return m_resourceList.GetNumberElements();
@@ -33,6 +33,7 @@
 
 #include <wchar.h>
 #include <string>
+#include <vector>
 #ifdef WIN32
 #include <windows.h>
 #endif
@@ -64,8 +65,18 @@ FILE *stdmsg = stdout;
 
 namespace IDTFConverter {
 
-bool IDTFToU3d(
+namespace {
+
+/**
+ * Converts the IDTF file inputFileName, or the sceneSize characters of IDTF
+ * text pScene if it is not NULL. The decoded images pTextures, if not NULL,
+ * are used instead of loading the TGA files of the textures.
+ */
+bool convert(
 		const std::string& inputFileName,
+		const char* pScene,
+		size_t sceneSize,
+		const std::vector<TextureImage>* pTextures,
 		const std::string& outputFileName,
 		int& resCode,
 		int positionQuality)
@@ -174,7 +185,36 @@ bool IDTFToU3d(
 			SceneUtilities sceneUtils;
 			FileParser fileParser;
 
-			result = fileParser.Initialize( fileOptions.inFile.Raw() );
+			IFXArray< U3D_IDTF::TextureImage > textureImages;
+
+			if( NULL == pScene )
+				result = fileParser.Initialize( fileOptions.inFile.Raw() );
+			else if( sceneSize >= (size_t)(U32)-1 )
+				result = IFX_E_INVALID_RANGE;
+			else
+				result = fileParser.InitializeFromMemory(
+											pScene, (U32)sceneSize );
+
+			if( IFXSUCCESS(result) && NULL != pTextures )
+			{
+				for( const TextureImage& texture : *pTextures )
+				{
+					U3D_IDTF::TextureImage& rImage = textureImages.CreateNewElement();
+					const size_t size = (size_t)texture.width * texture.height * texture.channels;
+
+					result = rImage.m_path.Assign( (const U8*)texture.path.c_str() );
+					if( IFXSUCCESS(result) && texture.pixels.size() != size )
+						result = IFX_E_INVALID_RANGE;
+					if( IFXSUCCESS(result) )
+						result = rImage.m_image.Initialize(
+											texture.width, texture.height,
+											texture.channels );
+					if( IFXSUCCESS(result) )
+						rImage.m_image.SetData( texture.pixels.data() );
+					else
+						break;
+				}
+			}
 
 			if( IFXSUCCESS(result) )
 				result = sceneUtils.InitializeScene(
@@ -186,6 +226,8 @@ bool IDTFToU3d(
 				SceneConverter converter(
 									&fileParser, &sceneUtils,
 									&converterOptions );
+				if( NULL != pTextures )
+					converter.SetTextureImages( &textureImages );
 				result = converter.Convert();
 			}
 
@@ -226,6 +268,33 @@ bool IDTFToU3d(
 	return result == IFX_OK;
 }
 
+} // namespace
+
+bool IDTFToU3d(
+		const std::string& inputFileName,
+		const std::string& outputFileName,
+		int& resCode,
+		int positionQuality)
+{
+	return convert(
+			inputFileName, NULL, 0, NULL, outputFileName, resCode,
+			positionQuality);
+}
+
+bool IDTFSceneToU3d(
+		const char* idtfScene,
+		size_t size,
+		const std::vector<TextureImage>& textures,
+		const std::string& outputFileName,
+		int& resCode,
+		int positionQuality)
+{
+	// the input file name is only printed in the log
+	return convert(
+			"<memory>", idtfScene, size, &textures, outputFileName, resCode,
+			positionQuality);
+}
+
 } //namespace IDTFConverter
 
 //***************************************************************************
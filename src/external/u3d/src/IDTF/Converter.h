@@ -18,15 +18,45 @@
 #ifndef IDTF_CONVERTER_H
 #define IDTF_CONVERTER_H
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace IDTFConverter {
 
+/**
+ * A decoded texture image of an IDTF scene converted with IDTFSceneToU3d,
+ * used for the texture resources whose TEXTURE_PATH is path.
+ * pixels are width * height RGB or RGBA values (channels is 3 or 4), the
+ * rows going from the bottom to the top of the image, as in a TGA file.
+ */
+struct TextureImage
+{
+	std::string path;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int channels = 3;
+	std::vector<unsigned char> pixels;
+};
+
 bool IDTFToU3d(const std::string &inputFileName,
 		const std::string &outputFileName,
 		int &resCode,
 		int positionQuality = 500);
 
+/**
+ * Same as IDTFToU3d, but the IDTF scene is read from the size characters of
+ * idtfScene instead of a file, and the images of the textures are taken from
+ * textures instead of loading TGA files: nothing is written on disk except
+ * the output U3D file.
+ */
+bool IDTFSceneToU3d(const char *idtfScene,
+		std::size_t size,
+		const std::vector<TextureImage> &textures,
+		const std::string &outputFileName,
+		int &resCode,
+		int positionQuality = 500);
+
 }
 
 #endif // IDTF_CONVERTER_H
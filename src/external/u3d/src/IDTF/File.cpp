@@ -80,6 +80,10 @@ File::File()
 	IFXTRACE_GENERIC(L"File construct\n");
 	m_pFile = NULL;
 	m_pFileName = NULL;
+	m_pData = NULL;
+	m_size = 0;
+	m_position = 0;
+	m_endOfData = FALSE;
 }
 
 File::~File()
@@ -104,19 +108,54 @@ IFXRESULT File::Initialize( const IFXCHAR* pFileName )
 	return result;
 }
 
+IFXRESULT File::InitializeFromMemory( const char* pData, U32 size )
+{
+	IFXRESULT result = IFX_OK;
+
+	if( NULL != pData )
+	{
+		Close();
+		m_pData = pData;
+		m_size = size;
+		m_position = 0;
+		m_endOfData = FALSE;
+	}
+	else 
+		result = IFX_E_INVALID_POINTER;
+
+	return result;
+}
+
 BOOL File::IsEndOfFile()
 {
+	if( NULL == m_pFile )
+		return m_endOfData;
+
 	return feof( m_pFile );
 }
 
 U8 File::ReadCharacter()
 {
+	if( NULL == m_pFile )
+	{
+		// like fgetc, the end is detected only reading past the data
+		if( m_position < m_size )
+			return static_cast<U8>( m_pData[m_position++] );
+		m_endOfData = TRUE;
+		return static_cast<U8>( EOF );
+	}
+
 	return static_cast<U8>( fgetc( m_pFile ) ); 
 }
 
 IFXRESULT File::GetPosition( U32* pFilePos )
 {
 	IFXRESULT result = IFX_E_ABORTED;
+	if( NULL == m_pFile )
+	{
+		*pFilePos = m_position;
+		return IFX_OK;
+	}
 #if defined(STDIO_HACK) && !defined(LIBIDTF)
 	if (m_pFile==stdin) {
 		*pFilePos = 0;
@@ -133,6 +172,16 @@ IFXRESULT File::GetPosition( U32* pFilePos )
 IFXRESULT File::SetPosition( U32 filePos )
 {
 	IFXRESULT result = IFX_E_ABORTED;
+	if( NULL == m_pFile )
+	{
+		if( filePos <= m_size )
+		{
+			m_position = filePos;
+			m_endOfData = FALSE;
+			result = IFX_OK;
+		}
+		return result;
+	}
 	if( !fseek( m_pFile, filePos, SEEK_SET ) ) result = IFX_OK;
 	return result;
 }
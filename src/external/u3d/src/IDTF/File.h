@@ -59,6 +59,9 @@ const U32 MAXIMUM_FILENAME_LENGTH = 512;
 	This is the implementation of a class that is used to:
 	- load file
 	- creates and initializes scanner
+
+	The content can also be read from a memory buffer, with the same
+	semantic of the stdio functions used for the files.
 */
 class File
 {
@@ -67,6 +70,7 @@ public:
 	virtual ~File();
 
 	IFXRESULT Initialize( const IFXCHAR* pFileName );
+	IFXRESULT InitializeFromMemory( const char* pData, U32 size );
 	IFXRESULT Open();
 	IFXRESULT Close();
 	BOOL IsEndOfFile();
@@ -77,6 +81,12 @@ public:
 private:
 	const IFXCHAR* m_pFileName;
 	FILE* m_pFile;
+
+	// memory buffer, not owned; used when m_pFile is NULL
+	const char* m_pData;
+	U32 m_size;
+	U32 m_position;
+	BOOL m_endOfData;
 };
 
 //***************************************************************************
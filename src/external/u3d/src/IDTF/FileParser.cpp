@@ -118,6 +118,11 @@ IFXRESULT FileParser::Initialize( const IFXCHAR* pFileName )
 	return m_scanner.Initialize( pFileName );
 }
 
+IFXRESULT FileParser::InitializeFromMemory( const char* pData, U32 size )
+{
+	return m_scanner.InitializeFromMemory( pData, size );
+}
+
 IFXRESULT FileParser::ParseFileHeader( IFXString* pFormatName, 
 									   I32* pVersionNumber)
 {
@@ -84,6 +84,12 @@ public:
 	*/
 	IFXRESULT Initialize( const IFXCHAR* pFileName );
 
+	/**
+	Initialize file scanner to read the IDTF text in the given buffer,
+	that must be valid until the parsing is done
+	*/
+	IFXRESULT InitializeFromMemory( const char* pData, U32 size );
+
 	/**
 	Parse file format name and format vertion
 	*/
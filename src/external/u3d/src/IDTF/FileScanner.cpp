@@ -105,6 +105,18 @@ IFXRESULT FileScanner::Initialize( const IFXCHAR* pFileName )
 	return result;
 }
 
+IFXRESULT FileScanner::InitializeFromMemory( const char* pData, U32 size )
+{
+	IFXRESULT result = IFX_OK;
+
+	result = m_file.InitializeFromMemory( pData, size );
+
+	if( IFXSUCCESS( result ) )
+		m_currentCharacter[0] = m_file.ReadCharacter();
+
+	return result;
+}
+
 IFXRESULT FileScanner::Scan( IFXString* pToken, U32 scanLine )
 {
 	// try to use fscanf
@@ -85,6 +85,7 @@ public:
 	virtual ~FileScanner();
 
 	IFXRESULT Initialize( const IFXCHAR* pFileName );
+	IFXRESULT InitializeFromMemory( const char* pData, U32 size );
 
 	IFXRESULT ScanStringToken( const IFXCHAR* token, IFXString* value );
 	IFXRESULT ScanIntegerToken( const IFXCHAR* token, I32* value );
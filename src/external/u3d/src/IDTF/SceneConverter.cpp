@@ -92,7 +92,8 @@ SceneConverter::SceneConverter( FileParser* pParser,
 								ConverterOptions* pConverterOptions )
 : m_pSceneUtils( pSceneUtils ),
   m_pParser( pParser ), 
-  m_pOptions( pConverterOptions )
+  m_pOptions( pConverterOptions ),
+  m_pTextureImages( NULL )
 {
 	IFXCHECKX_RESULT( NULL != pParser, IFX_E_INVALID_POINTER );
 	IFXCHECKX_RESULT( NULL != pSceneUtils, IFX_E_INVALID_POINTER );
@@ -121,6 +122,12 @@ IFXRESULT SceneConverter::Convert()
 	return result;
 }
 
+void SceneConverter::SetTextureImages( 
+						const IFXArray< TextureImage >* pTextureImages )
+{
+	m_pTextureImages = pTextureImages;
+}
+
 //***************************************************************************
 //  Protected methods
 //***************************************************************************
@@ -207,6 +214,9 @@ IFXRESULT SceneConverter::ConvertScene()
 	if( IFXSUCCESS( result ) )
 		result = m_pParser->ParseResources( &m_sceneResources );
 
+	if( IFXSUCCESS( result ) && NULL != m_pTextureImages )
+		AssignTextureImages();
+
 	if( IFXSUCCESS( result ) )
 		result = m_pParser->ParseModifiers( &m_modifierList );
 
@@ -237,6 +247,34 @@ IFXRESULT SceneConverter::ConvertScene()
 	return result;
 }
 
+void SceneConverter::AssignTextureImages()
+{
+	TextureResourceList* pTextureList = static_cast< TextureResourceList* >(
+		m_sceneResources.GetResourceList( IFXString( IDTF_TEXTURE ) ) );
+
+	if( NULL != pTextureList )
+	{
+		const U32 textureCount = pTextureList->GetResourceCount();
+		const U32 imageCount = m_pTextureImages->GetNumberElements();
+
+		for( U32 i = 0; i < textureCount; ++i )
+		{
+			Texture& rTexture = pTextureList->GetResource( i );
+
+			for( U32 j = 0; j < imageCount; ++j )
+			{
+				const TextureImage& rImage = m_pTextureImages->GetElementConst( j );
+
+				if( rTexture.GetPath() == rImage.m_path )
+				{
+					rTexture.m_textureImage = rImage.m_image;
+					break;
+				}
+			}
+		}
+	}
+}
+
 //***************************************************************************
 //  Private methods
 //***************************************************************************
@@ -38,6 +38,8 @@ This header defines the ... functionality.
 #include "NodeList.h"
 #include "SceneResources.h"
 #include "ModifierList.h"
+#include "TGAImage.h"
+#include "IFXArray.h"
 
 namespace U3D_IDTF
 {
@@ -64,6 +66,16 @@ class FileParser;
 class SceneUtilities;
 struct ConverterOptions;
 
+/**
+	A decoded texture image, used instead of loading the TGA file of the
+	texture resources with the same path.
+*/
+struct TextureImage
+{
+	IFXString m_path;
+	TGAImage m_image;
+};
+
 /**
 This is the implementation of a class that is used to @todo: usage.
 
@@ -80,11 +92,18 @@ public:
 	*/
 	virtual IFXRESULT  Convert();
 
+	/**
+	Set the texture images that are already decoded; the array must be
+	valid until the conversion is done
+	*/
+	void SetTextureImages( const IFXArray< TextureImage >* pTextureImages );
+
 protected:
 	IFXRESULT CheckFileHeader();
 	IFXRESULT ConvertSceneData();
 	IFXRESULT ConvertFileReference();
 	IFXRESULT ConvertScene();
+	void AssignTextureImages();
 
 private:
 	NodeList m_nodeList;
@@ -94,6 +113,7 @@ private:
 	SceneUtilities* m_pSceneUtils;
 	FileParser* m_pParser;
 	ConverterOptions* m_pOptions;
+	const IFXArray< TextureImage >* m_pTextureImages;
 };
 
 //***************************************************************************
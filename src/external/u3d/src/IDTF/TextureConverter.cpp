@@ -182,8 +182,11 @@ IFXRESULT TextureConverter::Convert()
 				result = IFX_E_INVALID_FILE;
 			}
 #else
+			// the image may have been provided already decoded
+			if ( m_pTexture->m_textureImage.IsSet() )
+				textureImage = m_pTexture->m_textureImage;
 			// Load the TGA Texture file
-			if( IFXFAILURE( textureImage.Read( file ) ) )
+			else if( IFXFAILURE( textureImage.Read( file ) ) )
 			{
 				fwprintf(stdmsg, L" -- Error - could not load %ls\n", file );
 				result = IFX_E_INVALID_FILE;
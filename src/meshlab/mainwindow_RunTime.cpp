@@ -728,8 +728,10 @@ void MainWindow::endEdit()
 		return;
 	
 	
-	for (const MeshModel& mm : meshDoc()->meshIterator()) {
+	for (MeshModel& mm : meshDoc()->meshIterator()) {
 		addRenderingDataIfNewlyGeneratedMesh(mm.id());
+		// edit tools do not declare what they change
+		mm.invalidateTopology();
 	}
 	meshDoc()->meshDocStateData().clear();
 	
@@ -762,8 +764,10 @@ void MainWindow::runFilterScript()
 		return;
 	QString filterName;
 	try {
-		for (FilterNameParameterValuesPair& pair : meshDoc()->filterHistory)
+		FilterScript& script = meshDoc()->filterHistory;
+		for (int i = 0; i < script.size(); ++i)
 		{
+			FilterNameParameterValuesPair& pair = script[i];
 			filterName = pair.filterName();
 			int classes = 0;
 			unsigned int postCondMask = MeshModel::MM_UNKNOWN;
@@ -772,7 +776,7 @@ void MainWindow::runFilterScript()
 
 			int req=iFilter->getRequirements(action);
 			if (meshDoc()->mm() != NULL)
-				meshDoc()->mm()->updateDataMask(req);
+				meshDoc()->mm()->requireDataMask(req);
 			iFilter->setLog(&meshDoc()->Log);
 
 			bool created = false;
@@ -813,11 +817,21 @@ void MainWindow::runFilterScript()
 			if ((!created) || (!iFilter->glContext->isValid()))
 				throw MLException("A valid GLContext is required by the filter to work.\n");
 			meshDoc()->setBusy(true);
+			meshDoc()->meshDocStateData().create(*meshDoc());
 			iFilter->applyFilter(action, pair.second, *meshDoc(), postCondMask, QCallBack);
 			if (postCondMask == MeshModel::MM_UNKNOWN)
 				postCondMask = iFilter->postCondition(action);
-			for (MeshModel* mm = meshDoc()->nextMesh(); mm != NULL; mm = meshDoc()->nextMesh(mm))
-				vcg::tri::Allocator<CMeshO>::CompactEveryVector(mm->cm);
+			meshDoc()->updateTopologyAfterFilter(postCondMask);
+			// compaction can be postponed if the next filter of the script
+			// is able to work on meshes with deleted elements
+			bool compactNow = true;
+			if (i + 1 < script.size()) {
+				QAction* nextAction = PM.filterAction(script[i + 1].filterName());
+				FilterPlugin* nextFilter = qobject_cast<FilterPlugin*>(nextAction->parent());
+				compactNow = nextFilter->requiresCompactVectors(nextAction);
+			}
+			if (compactNow)
+				meshDoc()->compactMeshes();
 			meshDoc()->setBusy(false);
 			if (shar != NULL)
 				shar->removeView(iFilter->glContext);
@@ -860,6 +874,8 @@ void MainWindow::runFilterScript()
 		}
 	}
 	catch(const MLException& exc){
+		// the script could have been interrupted with some postponed compactions
+		meshDoc()->compactMeshes();
 		QMessageBox::warning(
 				this,
 				tr("Filter Failure"),
@@ -1123,8 +1139,12 @@ void MainWindow::executeFilter(
 	qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
 	MainWindow::globalStatusBar()->showMessage("Starting Filter...",5000);
 	int req=iFilter->getRequirements(action);
-	if (!(meshDoc()->meshNumber() == 0))
-		meshDoc()->mm()->updateDataMask(req);
+	unsigned int avoidedTopoUpdates = 0;
+	if (!(meshDoc()->meshNumber() == 0)) {
+		avoidedTopoUpdates = meshDoc()->mm()->avoidedTopologyUpdates();
+		meshDoc()->mm()->requireDataMask(req);
+		avoidedTopoUpdates = meshDoc()->mm()->avoidedTopologyUpdates() - avoidedTopoUpdates;
+	}
 	qApp->restoreOverrideCursor();
 	
 	// (3) save the current filter and its parameters in the history
@@ -1180,8 +1200,8 @@ void MainWindow::executeFilter(
 		iFilter->applyFilter(action, mergedenvironment, *(meshDoc()), postCondMask, QCallBack);
 		if (postCondMask == MeshModel::MM_UNKNOWN)
 			postCondMask = iFilter->postCondition(action);
-		for (MeshModel& mm : meshDoc()->meshIterator())
-			vcg::tri::Allocator<CMeshO>::CompactEveryVector(mm.cm);
+		meshDoc()->updateTopologyAfterFilter(postCondMask);
+		meshDoc()->compactMeshes();
 		
 		if (shar != NULL) {
 			shar->removeView(iFilter->glContext);
@@ -1195,6 +1215,11 @@ void MainWindow::executeFilter(
 		// (5) Apply post filter actions (e.g. recompute non updated stuff if needed)
 		
 		meshDoc()->Log.logf(GLLogStream::SYSTEM,"Applied filter %s in %i msec",qUtf8Printable(action->text()),tt.elapsed());
+		if (avoidedTopoUpdates > 0 && meshDoc()->mm() != NULL)
+			meshDoc()->Log.logf(
+				GLLogStream::SYSTEM,
+				"Topology already up to date: %u adjacency rebuilds avoided (%u on this layer so far)",
+				avoidedTopoUpdates, meshDoc()->mm()->avoidedTopologyUpdates());
 		if (meshDoc()->mm() != NULL)
 			meshDoc()->mm()->setMeshModified();
 		MainWindow::globalStatusBar()->showMessage("Filter successfully completed...",2000);
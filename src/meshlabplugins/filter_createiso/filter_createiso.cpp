@@ -33,8 +33,7 @@ Added the new sample filter plugin that removes border faces
 #include "filter_createiso.h"
 
 #include <vcg/math/perlin_noise.h>
-#include <vcg/complex/algorithms/create/marching_cubes.h>
-#include <vcg/complex/algorithms/create/mc_trivial_walker.h>
+#include <common/utilities/sparse_volume.h>
 
 using namespace std;
 using namespace vcg;
@@ -106,23 +105,16 @@ std::map<std::string, QVariant> FilterCreateIso::applyFilter(const QAction *filt
 	if (ID(filter) == FP_CREATEISO) {
 		md.addNewMesh("",this->filterName(ID(filter)));
 		MeshModel &m=*(md.mm());
-		SimpleVolume<SimpleVoxel<Scalarm> > volume;
-
-		typedef vcg::tri::TrivialWalker<CMeshO, SimpleVolume<SimpleVoxel<Scalarm> >	> MyWalker;
-		typedef vcg::tri::MarchingCubes<CMeshO, MyWalker>	MyMarchingCubes;
-		MyWalker walker;
-
 		const int gridSize=par.getInt("Resolution");
-		// Simple initialization of the volume with some cool perlin noise
-		volume.Init(Point3i(gridSize,gridSize,gridSize), Box3m(Point3m(0,0,0),Point3m(1,1,1)));
-		for(int i=0;i<gridSize;i++)
-			for(int j=0;j<gridSize;j++)
-				for(int k=0;k<gridSize;k++)
-					volume.Val(i,j,k)=(j-gridSize/2)*(j-gridSize/2)+(k-gridSize/2)*(k-gridSize/2) + i*gridSize/5*(float)math::Perlin::Noise(i*.2,j*.2,k*.2);
+		// Simple volume with some cool perlin noise, evaluated while the
+		// surface is extracted: no grid is stored, whatever the resolution
+		auto field = meshlab::makeFunctionField(Point3i(gridSize,gridSize,gridSize), [gridSize](int i, int j, int k) {
+			return float((j-gridSize/2)*(j-gridSize/2)+(k-gridSize/2)*(k-gridSize/2) + i*gridSize/5*(float)math::Perlin::Noise(i*.2,j*.2,k*.2));
+		});
 
 		printf("[MARCHING CUBES] Building mesh...");
-		MyMarchingCubes mc(m.cm, walker);
-		walker.BuildMesh<MyMarchingCubes>(m.cm, volume, mc, (gridSize*gridSize)/10,cb);
+		Scalarm voxel = Scalarm(1) / gridSize;
+		meshlab::extractIsosurface(m.cm, field, (gridSize*gridSize)/10, Point3m(0,0,0), Point3m(voxel,voxel,voxel), cb);
 		m.updateBoxAndNormals();
 	}
 	else {
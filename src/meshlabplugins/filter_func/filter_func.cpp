@@ -24,12 +24,18 @@
 #include "filter_func.h"
 #include <vcg/complex/algorithms/create/platonic.h>
 
-#include <vcg/complex/algorithms/create/marching_cubes.h>
-#include <vcg/complex/algorithms/create/mc_trivial_walker.h>
+#include <common/utilities/sparse_volume.h>
+
+#include <QElapsedTimer>
 
 #include "muParser.h"
+#include "parallel_parser.h"
 #include "string_conversion.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace mu;
 using namespace vcg;
 
@@ -656,6 +662,200 @@ RichParameterList FilterFunctionPlugin::initParameterList(const QAction* action,
 	return parlst;
 }
 
+namespace {
+
+/**
+ * @brief The per-vertex variables of the parser: x, y, z for the coords, nx,
+ * ny, nz for the normal, r, g, b, a for the color, q for the quality, vi for
+ * the index, rad, vtu, vtv, ti, vsel, and one variable for each custom
+ * attribute (three for the Point3m ones, with suffixes _x, _y, _z).
+ */
+class VertexVariables
+{
+public:
+	VertexVariables(CMeshO& m, bool onlySelected = false) :
+			m(m),
+			onlySelected(onlySelected),
+			hasRadius(tri::HasPerVertexRadius(m)),
+			hasTexCoord(tri::HasPerVertexTexCoord(m))
+	{
+		varNames = {
+			"x", "y", "z", "nx", "ny", "nz", "r", "g", "b", "a", "q", "vi", "rad", "vtu", "vtv",
+			"ti", "vsel"};
+
+		std::vector<std::string> attribNames;
+		tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Scalarm>(m, attribNames);
+		for (const std::string& name : attribNames) {
+			scalarHandles.push_back(
+				tri::Allocator<CMeshO>::GetPerVertexAttribute<Scalarm>(m, name));
+			varNames.push_back(name);
+			qDebug("Adding custom per vertex float variable %s", name.c_str());
+		}
+		attribNames.clear();
+		tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Point3m>(m, attribNames);
+		for (const std::string& name : attribNames) {
+			pointHandles.push_back(
+				tri::Allocator<CMeshO>::GetPerVertexAttribute<Point3m>(m, name));
+			varNames.push_back(name + "_x");
+			varNames.push_back(name + "_y");
+			varNames.push_back(name + "_z");
+			qDebug("Adding custom per vertex Point3f variable %s", name.c_str());
+		}
+	}
+
+	const std::vector<std::string>& names() const { return varNames; }
+
+	/**
+	 * @brief sets the variables of the i-th vertex; returns false if the
+	 * vertex is deleted or, when working only on the selection, not selected
+	 */
+	bool fill(std::size_t i, ParallelParser::Slot s)
+	{
+		const CVertexO& v = m.vert[i];
+		if (v.IsD() || (onlySelected && !v.IsS()))
+			return false;
+
+		int k = 0;
+		for (int c = 0; c < 3; ++c)
+			s[k++] = v.cP()[c];
+		for (int c = 0; c < 3; ++c)
+			s[k++] = v.cN()[c];
+		for (int c = 0; c < 4; ++c)
+			s[k++] = v.cC()[c];
+		s[k++] = v.cQ();
+		s[k++] = i;
+		s[k++] = hasRadius ? v.cR() : 0;
+		s[k++] = hasTexCoord ? v.cT().U() : 0;
+		s[k++] = hasTexCoord ? v.cT().V() : 0;
+		s[k++] = hasTexCoord ? v.cT().N() : 0;
+		s[k++] = v.IsS() ? 1.0 : 0.0;
+
+		for (auto& h : scalarHandles)
+			s[k++] = h[i];
+		for (auto& h : pointHandles)
+			for (int c = 0; c < 3; ++c)
+				s[k++] = h[i][c];
+		return true;
+	}
+
+private:
+	CMeshO&                                                m;
+	bool                                                   onlySelected;
+	bool                                                   hasRadius;
+	bool                                                   hasTexCoord;
+	std::vector<std::string>                               varNames;
+	std::vector<CMeshO::PerVertexAttributeHandle<Scalarm>> scalarHandles;
+	std::vector<CMeshO::PerVertexAttributeHandle<Point3m>> pointHandles;
+};
+
+/**
+ * @brief The per-face variables of the parser: x0, y0, z0, nx0, ny0, nz0, r0,
+ * g0, b0, a0, q0 for the first vertex (and the same for the other two), fr,
+ * fg, fb, fa, fnx, fny, fnz, fq for the face, the indices fi, vi0, vi1, vi2,
+ * the wedge texture coords wtu0, wtv0, ..., ti, the selection vsel0, vsel1,
+ * vsel2, fsel, and one variable for each custom scalar attribute.
+ */
+class FaceVariables
+{
+public:
+	FaceVariables(CMeshO& m, bool onlySelected = false) :
+			m(m),
+			onlySelected(onlySelected),
+			hasQuality(tri::HasPerFaceQuality(m)),
+			hasColor(tri::HasPerFaceColor(m)),
+			hasWedgeTexCoord(tri::HasPerWedgeTexCoord(m))
+	{
+		const std::string idx[] = {"0", "1", "2"};
+		for (int j = 0; j < 3; ++j)
+			for (const char* n : {"x", "y", "z"})
+				varNames.push_back(n + idx[j]);
+		for (int j = 0; j < 3; ++j)
+			for (const char* n : {"nx", "ny", "nz"})
+				varNames.push_back(n + idx[j]);
+		for (int j = 0; j < 3; ++j)
+			for (const char* n : {"r", "g", "b", "a"})
+				varNames.push_back(n + idx[j]);
+		for (int j = 0; j < 3; ++j)
+			varNames.push_back("q" + idx[j]);
+		for (const char* n : {"fr", "fg", "fb", "fa", "fnx", "fny", "fnz", "fq", "fi"})
+			varNames.push_back(n);
+		for (int j = 0; j < 3; ++j)
+			varNames.push_back("vi" + idx[j]);
+		for (int j = 0; j < 3; ++j) {
+			varNames.push_back("wtu" + idx[j]);
+			varNames.push_back("wtv" + idx[j]);
+		}
+		varNames.push_back("ti");
+		for (int j = 0; j < 3; ++j)
+			varNames.push_back("vsel" + idx[j]);
+		varNames.push_back("fsel");
+
+		std::vector<std::string> attribNames;
+		tri::Allocator<CMeshO>::GetAllPerFaceAttribute<Scalarm>(m, attribNames);
+		for (const std::string& name : attribNames) {
+			scalarHandles.push_back(tri::Allocator<CMeshO>::GetPerFaceAttribute<Scalarm>(m, name));
+			varNames.push_back(name);
+		}
+	}
+
+	const std::vector<std::string>& names() const { return varNames; }
+
+	/**
+	 * @brief sets the variables of the i-th face; returns false if the face is
+	 * deleted or, when working only on the selection, not selected
+	 */
+	bool fill(std::size_t i, ParallelParser::Slot s)
+	{
+		const CFaceO& f = m.face[i];
+		if (f.IsD() || (onlySelected && !f.IsS()))
+			return false;
+
+		int k = 0;
+		for (int j = 0; j < 3; ++j)
+			for (int c = 0; c < 3; ++c)
+				s[k++] = f.cV(j)->cP()[c];
+		for (int j = 0; j < 3; ++j)
+			for (int c = 0; c < 3; ++c)
+				s[k++] = f.cV(j)->cN()[c];
+		for (int j = 0; j < 3; ++j)
+			for (int c = 0; c < 4; ++c)
+				s[k++] = f.cV(j)->cC()[c];
+		for (int j = 0; j < 3; ++j)
+			s[k++] = f.cV(j)->cQ();
+		for (int c = 0; c < 4; ++c)
+			s[k++] = hasColor ? f.cC()[c] : 255;
+		for (int c = 0; c < 3; ++c)
+			s[k++] = f.cN()[c];
+		s[k++] = hasQuality ? f.cQ() : 0;
+		s[k++] = i;
+		for (int j = 0; j < 3; ++j)
+			s[k++] = f.cV(j) - &m.vert[0];
+		for (int j = 0; j < 3; ++j) {
+			s[k++] = hasWedgeTexCoord ? f.cWT(j).U() : 0;
+			s[k++] = hasWedgeTexCoord ? f.cWT(j).V() : 0;
+		}
+		s[k++] = hasWedgeTexCoord ? f.cWT(0).N() : 0;
+		for (int j = 0; j < 3; ++j)
+			s[k++] = f.cV(j)->IsS() ? 1.0 : 0.0;
+		s[k++] = f.IsS() ? 1.0 : 0.0;
+
+		for (auto& h : scalarHandles)
+			s[k++] = h[i];
+		return true;
+	}
+
+private:
+	CMeshO&                                              m;
+	bool                                                 onlySelected;
+	bool                                                 hasQuality;
+	bool                                                 hasColor;
+	bool                                                 hasWedgeTexCoord;
+	std::vector<std::string>                             varNames;
+	std::vector<CMeshO::PerFaceAttributeHandle<Scalarm>> scalarHandles;
+};
+
+} // namespace
+
 // The Real Core Function doing the actual mesh processing.
 std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 	const QAction*           filter,
@@ -664,113 +864,73 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 	unsigned int& /*postConditionMask*/,
 	vcg::CallBackPos* cb)
 {
-	errorMsg = "";
 	if (this->getClass(filter) == FilterPlugin::MeshCreation)
 		md.addNewMesh("", this->filterName(ID(filter)));
 	MeshModel& m = *(md.mm());
 	Q_UNUSED(cb);
 	switch (ID(filter)) {
 	case FF_VERT_SELECTION: {
-		std::string expr  = par.getString("condSelect").toStdString();
-		auto        wexpr = conversion::fromStringToWString(expr);
-
-		// muparser initialization and explicitly define parser variables
-		Parser p;
-		setPerVertexVariables(p, m.cm);
-
-		// set expression inserted by user as string (required by muparser)
-		p.SetExpr(wexpr);
+		std::string expr = par.getString("condSelect").toStdString();
 
-		int    numvert = 0;
-		time_t start   = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to vertex coord and attributes.
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD()) {
-				setAttributes(vi, m.cm);
-
-				bool selected = false;
-
-				// use parser to evaluate boolean function specified above
-				// in case of fail, error dialog contains details of parser's error
-				try {
-					selected = p.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-
+		VertexVariables vars(m.cm);
+		ParallelParser  parser(vars.names(), {expr});
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
 				// set vertex as selected or clear selection
-				if (selected) {
-					(*vi).SetS();
-					numvert++;
-				}
+				if (res[0] != 0)
+					m.cm.vert[i].SetS();
 				else
-					(*vi).ClearS();
-			}
+					m.cm.vert[i].ClearS();
+			});
+		int numvert = (int) tri::UpdateSelection<CMeshO>::VertexCount(m.cm);
 
 		// if succeeded log stream contains number of vertices and time elapsed
-		log("selected %d vertices in %.2f sec.",
-			numvert,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		log("selected %d vertices in %.2f sec.", numvert, timer.elapsed() / 1000.0);
 	} break;
 
 	case FF_FACE_SELECTION: {
-		QString select = par.getString("condSelect");
-
-		// muparser initialization and explicitly define parser variables
-		Parser p;
-		setPerFaceVariables(p, m.cm);
+		std::string expr = par.getString("condSelect").toStdString();
 
-		// set expression inserted by user as string (required by muparser)
-		p.SetExpr(conversion::fromStringToWString(select.toStdString()));
-
-		int    numface = 0;
-		time_t start   = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to face attributes.
-		CMeshO::FaceIterator fi;
-		for (fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD()) {
-				setAttributes(fi, m.cm);
-
-				bool selected = false;
-
-				// use parser to evaluate boolean function specified above
-				// in case of fail, error dialog contains details of parser's error
-				try {
-					selected = p.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-
+		FaceVariables  vars(m.cm);
+		ParallelParser parser(vars.names(), {expr});
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
 				// set face as selected or clear selection
-				if (selected) {
-					(*fi).SetS();
-					numface++;
-				}
+				if (res[0] != 0)
+					m.cm.face[i].SetS();
 				else
-					(*fi).ClearS();
-			}
+					m.cm.face[i].ClearS();
+			});
+		int numface = (int) tri::UpdateSelection<CMeshO>::FaceCount(m.cm);
 
 		// if succeeded log stream contains number of vertices and time elapsed
-		log("selected %d faces in %.2f sec.", numface, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("selected %d faces in %.2f sec.", numface, timer.elapsed() / 1000.0);
 
 	} break;
 
 	case FF_GEOM_FUNC:
 	case FF_VERT_COLOR:
 	case FF_VERT_NORMAL: {
-		std::string func_x, func_y, func_z, func_a;
 		// FF_VERT_COLOR : x = r, y = g, z = b
 		// FF_VERT_NORMAL : x = r, y = g, z = b
-		func_x = par.getString("x").toStdString();
-		func_y = par.getString("y").toStdString();
-		func_z = par.getString("z").toStdString();
+		std::vector<std::string> exprs = {
+			par.getString("x").toStdString(),
+			par.getString("y").toStdString(),
+			par.getString("z").toStdString()};
 		if (ID(filter) == FF_VERT_COLOR)
-			func_a = par.getString("a").toStdString();
+			exprs.push_back(par.getString("a").toStdString());
 
 		bool onSelected = par.getBool("onselected");
 
@@ -787,73 +947,29 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 			tri::UpdateSelection<CMeshO>::VertexFromFaceLoose(m.cm);
 		}
 
-		// muparser initialization and explicitly define parser variables
-		// function for x,y and z must use different parser and variables
-		Parser p1, p2, p3, p4;
-
-		setPerVertexVariables(p1, m.cm);
-		setPerVertexVariables(p2, m.cm);
-		setPerVertexVariables(p3, m.cm);
-		setPerVertexVariables(p4, m.cm);
-
-		p1.SetExpr(conversion::fromStringToWString(func_x));
-		p2.SetExpr(conversion::fromStringToWString(func_y));
-		p3.SetExpr(conversion::fromStringToWString(func_z));
-		p4.SetExpr(conversion::fromStringToWString(func_a));
-
-		double  newx = 0, newy = 0, newz = 0, newa = 255;
-		QString errorMsg = "";
-
-		time_t start = clock();
+		if (ID(filter) == FF_VERT_COLOR)
+			m.updateDataMask(MeshModel::MM_VERTCOLOR);
 
-		// every parser variables is related to vertex coord and attributes.
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD())
-				if ((!onSelected) || ((*vi).IsS())) {
-					setAttributes(vi, m.cm);
-
-					// every function is evaluated by different parser.
-					// errorMessage dialog contains errors for func x, func y and func z
-					try {
-						newx = p1.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("1st func : ", e);
-					}
-					try {
-						newy = p2.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("2nd func : ", e);
-					}
-					try {
-						newz = p3.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("3rd func : ", e);
-					}
-					if (ID(filter) == FF_VERT_COLOR) {
-						try {
-							newa = p4.Eval();
-						}
-						catch (Parser::exception_type& e) {
-							showParserError("4th func : ", e);
-						}
-					}
-					if (errorMsg != "")
-						throw MLException(errorMsg);
-
-					if (ID(filter) == FF_GEOM_FUNC) // set new vertex coord for this iteration
-						(*vi).P() = Point3m(newx, newy, newz);
-					if (ID(filter) == FF_VERT_NORMAL) // set new color for this iteration
-						(*vi).N() = Point3m(newx, newy, newz);
-					if (ID(filter) == FF_VERT_COLOR) // set new color for this iteration
-					{
-						(*vi).C() = Color4b(newx, newy, newz, newa);
-						m.updateDataMask(MeshModel::MM_VERTCOLOR);
-					}
-				}
+		QElapsedTimer timer;
+		timer.start();
+
+		// every function is evaluated by a different parser;
+		// the error message contains the errors of all of them
+		VertexVariables vars(m.cm, onSelected);
+		ParallelParser  parser(
+			vars.names(), exprs, {"1st func : ", "2nd func : ", "3rd func : ", "4th func : "});
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				CVertexO& v = m.cm.vert[i];
+				if (ID(filter) == FF_GEOM_FUNC) // set new vertex coord
+					v.P() = Point3m(res[0], res[1], res[2]);
+				if (ID(filter) == FF_VERT_NORMAL) // set new normal
+					v.N() = Point3m(res[0], res[1], res[2]);
+				if (ID(filter) == FF_VERT_COLOR) // set new color
+					v.C() = Color4b(res[0], res[1], res[2], res[3]);
+			});
 
 		if (ID(filter) == FF_GEOM_FUNC) {
 			// update bounding box, normalize normals
@@ -863,9 +979,7 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		}
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d vertices processed in %.2f sec.",
-			m.cm.vn,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d vertices processed in %.2f sec.", m.cm.vn, timer.elapsed() / 1000.0);
 	} break;
 
 	case FF_VERT_QUALITY: {
@@ -887,30 +1001,16 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 
 		m.updateDataMask(MeshModel::MM_VERTQUALITY);
 
-		// muparser initialization and define custom variables
-		Parser p;
-		setPerVertexVariables(p, m.cm);
-
-		// set expression to calc with parser
-		p.SetExpr(conversion::fromStringToWString(func_q));
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to vertex coord and attributes.
-		time_t                 start = clock();
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD())
-				if ((!onSelected) || ((*vi).IsS())) {
-					setAttributes(vi, m.cm);
-
-					// use parser to evaluate function specified above
-					// in case of fail, errorMessage dialog contains details of parser's error
-					try {
-						(*vi).Q() = p.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-					}
-				}
+		VertexVariables vars(m.cm, onSelected);
+		ParallelParser  parser(vars.names(), {func_q});
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) { m.cm.vert[i].Q() = res[0]; });
 
 		// normalize quality with values in [0..1]
 		if (par.getBool("normalize"))
@@ -922,9 +1022,7 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 			m.updateDataMask(MeshModel::MM_VERTCOLOR);
 		}
 		// if succeeded log stream contains number of vertices and time elapsed
-		log("%d vertices processed in %.2f sec.",
-			m.cm.vn,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d vertices processed in %.2f sec.", m.cm.vn, timer.elapsed() / 1000.0);
 	} break;
 	case FF_VERT_TEXTURE_FUNC: {
 		std::string func_u     = par.getString("u").toStdString();
@@ -946,51 +1044,31 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 
 		m.updateDataMask(MeshModel::MM_VERTTEXCOORD);
 
-		// muparser initialization and define custom variables
-		Parser pu, pv;
-		setPerVertexVariables(pu, m.cm);
-		setPerVertexVariables(pv, m.cm);
-
-		// set expression to calc with parser
-#ifdef _UNICODE
-		pu.SetExpr(conversion::fromStringToWString(func_u));
-		pv.SetExpr(conversion::fromStringToWString(func_v));
-#else
-		pu.SetExpr(func_u);
-		pv.SetExpr(func_v);
-#endif
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to vertex coord and attributes.
-		time_t                 start = clock();
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD())
-				if ((!onSelected) || ((*vi).IsS())) {
-					setAttributes(vi, m.cm);
-
-					// use parser to evaluate function specified above
-					// in case of fail, errorMessage dialog contains details of parser's error
-					try {
-						(*vi).T().U() = pu.Eval();
-						(*vi).T().V() = pv.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-					}
-				}
-
-		log("%d vertices processed in %.2f sec.",
-			m.cm.vn,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		VertexVariables vars(m.cm, onSelected);
+		ParallelParser  parser(vars.names(), {func_u, func_v});
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				m.cm.vert[i].T().U() = res[0];
+				m.cm.vert[i].T().V() = res[1];
+			});
+
+		log("%d vertices processed in %.2f sec.", m.cm.vn, timer.elapsed() / 1000.0);
 	} break;
 	case FF_WEDGE_TEXTURE_FUNC: {
-		std::string func_u0    = par.getString("u0").toStdString();
-		std::string func_v0    = par.getString("v0").toStdString();
-		std::string func_u1    = par.getString("u1").toStdString();
-		std::string func_v1    = par.getString("v1").toStdString();
-		std::string func_u2    = par.getString("u2").toStdString();
-		std::string func_v2    = par.getString("v2").toStdString();
-		bool        onSelected = par.getBool("onselected");
+		std::vector<std::string> exprs = {
+			par.getString("u0").toStdString(),
+			par.getString("v0").toStdString(),
+			par.getString("u1").toStdString(),
+			par.getString("v1").toStdString(),
+			par.getString("u2").toStdString(),
+			par.getString("v2").toStdString()};
+		bool onSelected = par.getBool("onselected");
 
 		if (onSelected && m.cm.sfn == 0) // if no selection, fail
 		{
@@ -1000,53 +1078,31 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 
 		m.updateDataMask(MeshModel::MM_VERTTEXCOORD);
 
-		// muparser initialization and define custom variables
-		Parser pu0, pv0, pu1, pv1, pu2, pv2;
-		setPerFaceVariables(pu0, m.cm);
-		setPerFaceVariables(pv0, m.cm);
-		setPerFaceVariables(pu1, m.cm);
-		setPerFaceVariables(pv1, m.cm);
-		setPerFaceVariables(pu2, m.cm);
-		setPerFaceVariables(pv2, m.cm);
-
-		// set expression to calc with parser
-		pu0.SetExpr(conversion::fromStringToWString(func_u0));
-		pv0.SetExpr(conversion::fromStringToWString(func_v0));
-		pu1.SetExpr(conversion::fromStringToWString(func_u1));
-		pv1.SetExpr(conversion::fromStringToWString(func_v1));
-		pu2.SetExpr(conversion::fromStringToWString(func_u2));
-		pv2.SetExpr(conversion::fromStringToWString(func_v2));
+		QElapsedTimer timer;
+		timer.start();
 
-		// every parser variables is related to vertex coord and attributes.
-		time_t start = clock();
-		for (CMeshO::FaceIterator fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD())
-				if ((!onSelected) || ((*fi).IsS())) {
-					setAttributes(fi, m.cm);
-
-					// use parser to evaluate function specified above
-					// in case of fail, errorMessage dialog contains details of parser's error
-					try {
-						(*fi).WT(0).U() = pu0.Eval();
-						(*fi).WT(0).V() = pv0.Eval();
-						(*fi).WT(1).U() = pu1.Eval();
-						(*fi).WT(1).V() = pv1.Eval();
-						(*fi).WT(2).U() = pu2.Eval();
-						(*fi).WT(2).V() = pv2.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-					}
+		// every parser variables is related to face attributes.
+		FaceVariables  vars(m.cm, onSelected);
+		ParallelParser parser(vars.names(), exprs);
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				for (int j = 0; j < 3; ++j) {
+					m.cm.face[i].WT(j).U() = res[2 * j];
+					m.cm.face[i].WT(j).V() = res[2 * j + 1];
 				}
+			});
 
-		log("%d faces processed in %.2f sec.", m.cm.fn, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d faces processed in %.2f sec.", m.cm.fn, timer.elapsed() / 1000.0);
 	} break;
 	case FF_FACE_COLOR: {
-		std::string func_r     = par.getString("r").toStdString();
-		std::string func_g     = par.getString("g").toStdString();
-		std::string func_b     = par.getString("b").toStdString();
-		std::string func_a     = par.getString("a").toStdString();
-		bool        onSelected = par.getBool("onselected");
+		std::vector<std::string> exprs = {
+			par.getString("r").toStdString(),
+			par.getString("g").toStdString(),
+			par.getString("b").toStdString(),
+			par.getString("a").toStdString()};
+		bool onSelected = par.getBool("onselected");
 
 		if (onSelected && m.cm.sfn == 0) // if no selection, fail
 		{
@@ -1056,69 +1112,22 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 
 		m.updateDataMask(MeshModel::MM_FACECOLOR);
 
-		// muparser initialization and explicitly define parser variables
-		// every function must uses own parser and variables
-		Parser p1, p2, p3, p4;
-
-		setPerFaceVariables(p1, m.cm);
-		setPerFaceVariables(p2, m.cm);
-		setPerFaceVariables(p3, m.cm);
-		setPerFaceVariables(p4, m.cm);
+		QElapsedTimer timer;
+		timer.start();
 
-		p1.SetExpr(conversion::fromStringToWString(func_r));
-		p2.SetExpr(conversion::fromStringToWString(func_g));
-		p3.SetExpr(conversion::fromStringToWString(func_b));
-		p4.SetExpr(conversion::fromStringToWString(func_a));
-
-		// RGB is related to every face
-		CMeshO::FaceIterator fi;
-		double               newr = 0, newg = 0, newb = 0, newa = 255;
-		errorMsg = "";
-
-		time_t start = clock();
-
-		// every parser variables is related to face attributes.
-		for (fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD())
-				if ((!onSelected) || ((*fi).IsS())) {
-					setAttributes(fi, m.cm);
-
-					// evaluate functions to generate new color
-					// in case of fail, error dialog contains details of parser's error
-					try {
-						newr = p1.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("func r: ", e);
-					}
-					try {
-						newg = p2.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("func g: ", e);
-					}
-					try {
-						newb = p3.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("func b: ", e);
-					}
-					try {
-						newa = p4.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("func a: ", e);
-					}
-
-					if (errorMsg != "")
-						throw MLException(errorMsg);
-
-					// set new color for this iteration
-					(*fi).C() = Color4b(newr, newg, newb, newa);
-				}
+		// every function is evaluated by a different parser;
+		// the error message contains the errors of all of them
+		FaceVariables  vars(m.cm, onSelected);
+		ParallelParser parser(vars.names(), exprs, {"func r: ", "func g: ", "func b: ", "func a: "});
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				m.cm.face[i].C() = Color4b(res[0], res[1], res[2], res[3]);
+			});
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d faces processed in %.2f sec.", m.cm.fn, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d faces processed in %.2f sec.", m.cm.fn, timer.elapsed() / 1000.0);
 
 	} break;
 
@@ -1134,34 +1143,16 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 
 		m.updateDataMask(MeshModel::MM_FACEQUALITY);
 
-		// muparser initialization and define custom variables
-		Parser pf;
-		setPerFaceVariables(pf, m.cm);
-
-		// set expression to calc with parser
-		pf.SetExpr(conversion::fromStringToWString(func_q));
-
-		time_t start = clock();
-		errorMsg     = "";
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to face attributes.
-		CMeshO::FaceIterator fi;
-		for (fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD())
-				if ((!onSelected) || ((*fi).IsS())) {
-					setAttributes(fi, m.cm);
-
-					// evaluate functions to generate new quality
-					// in case of fail, error dialog contains details of parser's error
-					try {
-						(*fi).Q() = pf.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						showParserError("func q: ", e);
-					}
-					if (errorMsg != "")
-						throw MLException(errorMsg);
-				}
+		FaceVariables  vars(m.cm, onSelected);
+		ParallelParser parser(vars.names(), {func_q}, {"func q: "});
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) { m.cm.face[i].Q() = res[0]; });
 
 		// normalize quality with values in [0..1]
 		if (par.getBool("normalize"))
@@ -1174,7 +1165,7 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		}
 
 		// if succeeded log stream contains number of faces processed and time elapsed
-		log("%d faces processed in %.2f sec.", m.cm.fn, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d faces processed in %.2f sec.", m.cm.fn, timer.elapsed() / 1000.0);
 
 	} break;
 
@@ -1193,38 +1184,19 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		else
 			h = tri::Allocator<CMeshO>::AddPerVertexAttribute<Scalarm>(m.cm, name);
 
-		Parser p;
-		setPerVertexVariables(p, m.cm);
-		p.SetExpr(conversion::fromStringToWString(expr));
-
-		time_t start = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// perform calculation of attribute's value with function specified by user
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD()) {
-				setAttributes(vi, m.cm);
-
-				// add new user-defined attribute
-				try {
-					h[vi] = p.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-			}
-
-		// add string, double and handler to vector.
-		// vectors keep tracks of new attributes and let muparser use explicit variables
-		// it's possible to use custom attributes in other filters
-		v_attrNames.push_back(name);
-		v_attrValue.push_back(0);
-		v_handlers.push_back(h);
+		VertexVariables vars(m.cm);
+		ParallelParser  parser(vars.names(), {expr});
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) { h[i] = res[0]; });
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d vertices processed in %.2f sec.",
-			m.cm.vn,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d vertices processed in %.2f sec.", m.cm.vn, timer.elapsed() / 1000.0);
 
 	} break;
 
@@ -1233,7 +1205,6 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		std::string expr = par.getString("expr").toStdString();
 
 		// add per-face attribute with type float and name specified by user
-		// add per-vertex attribute with type float and name specified by user
 		CMeshO::PerFaceAttributeHandle<Scalarm> h;
 		if (tri::HasPerFaceAttribute(m.cm, name)) {
 			h = tri::Allocator<CMeshO>::FindPerFaceAttribute<Scalarm>(m.cm, name);
@@ -1243,37 +1214,29 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		}
 		else
 			h = tri::Allocator<CMeshO>::AddPerFaceAttribute<Scalarm>(m.cm, name);
-		Parser p;
-		setPerFaceVariables(p, m.cm);
-		p.SetExpr(conversion::fromStringToWString(expr));
 
-		time_t start = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to face attributes.
-		CMeshO::FaceIterator fi;
-		for (fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD()) {
-				setAttributes(fi, m.cm);
-
-				// add new user-defined attribute
-				try {
-					h[fi] = p.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-			}
+		FaceVariables  vars(m.cm);
+		ParallelParser parser(vars.names(), {expr});
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) { h[i] = res[0]; });
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d faces processed in %.2f sec.", m.cm.fn, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d faces processed in %.2f sec.", m.cm.fn, timer.elapsed() / 1000.0);
 
 	} break;
 
 	case FF_DEF_VERT_POINT_ATTRIB: {
 		std::string name = par.getString("name").toStdString();
-		std::string x_expr = par.getString("x_expr").toStdString();
-		std::string y_expr = par.getString("y_expr").toStdString();
-		std::string z_expr = par.getString("z_expr").toStdString();
+		std::vector<std::string> exprs = {
+			par.getString("x_expr").toStdString(),
+			par.getString("y_expr").toStdString(),
+			par.getString("z_expr").toStdString()};
 
 		// add per-vertex attribute with type float and name specified by user
 		CMeshO::PerVertexAttributeHandle<Point3m> h;
@@ -1286,55 +1249,32 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		else
 			h = tri::Allocator<CMeshO>::AddPerVertexAttribute<Point3m>(m.cm, name);
 
-		Parser p_x, p_y, p_z;
-		setPerVertexVariables(p_x, m.cm);
-		setPerVertexVariables(p_y, m.cm);
-		setPerVertexVariables(p_z, m.cm);
-		p_x.SetExpr(conversion::fromStringToWString(x_expr));
-		p_y.SetExpr(conversion::fromStringToWString(y_expr));
-		p_z.SetExpr(conversion::fromStringToWString(z_expr));
-
-		time_t start = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// perform calculation of attribute's value with function specified by user
-		CMeshO::VertexIterator vi;
-		for (vi = m.cm.vert.begin(); vi != m.cm.vert.end(); ++vi)
-			if (!(*vi).IsD()) {
-				setAttributes(vi, m.cm);
-
-				try {
-					h[vi][0] = p_x.Eval();
-					h[vi][1] = p_y.Eval();
-					h[vi][2] = p_z.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-			}
-
-		// add string, double and handler to vector.
-		// vectors keep tracks of new attributes and let muparser use explicit variables
-		// it's possible to use custom attributes in other filters
-
-		//v_attrNames.push_back(name);
-		//v_attrValue.push_back(0);
-		//v_handlers.push_back(h);
+		VertexVariables vars(m.cm);
+		ParallelParser  parser(vars.names(), exprs);
+		parser.evaluate(
+			m.cm.vert.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				h[i] = Point3m(res[0], res[1], res[2]);
+			});
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d vertices processed in %.2f sec.",
-			m.cm.vn,
-			(clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d vertices processed in %.2f sec.", m.cm.vn, timer.elapsed() / 1000.0);
 
 	} break;
 
 	case FF_DEF_FACE_POINT_ATTRIB: {
 		std::string name = par.getString("name").toStdString();
-		std::string x_expr = par.getString("x_expr").toStdString();
-		std::string y_expr = par.getString("y_expr").toStdString();
-		std::string z_expr = par.getString("z_expr").toStdString();
+		std::vector<std::string> exprs = {
+			par.getString("x_expr").toStdString(),
+			par.getString("y_expr").toStdString(),
+			par.getString("z_expr").toStdString()};
 
 		// add per-face attribute with type float and name specified by user
-		// add per-vertex attribute with type float and name specified by user
 		CMeshO::PerFaceAttributeHandle<Point3m> h;
 		if (tri::HasPerFaceAttribute(m.cm, name)) {
 			h = tri::Allocator<CMeshO>::FindPerFaceAttribute<Point3m>(m.cm, name);
@@ -1344,35 +1284,22 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		}
 		else
 			h = tri::Allocator<CMeshO>::AddPerFaceAttribute<Point3m>(m.cm, name);
-		Parser p_x, p_y, p_z;
-		setPerFaceVariables(p_x, m.cm);
-		setPerFaceVariables(p_y, m.cm);
-		setPerFaceVariables(p_z, m.cm);
-		p_x.SetExpr(conversion::fromStringToWString(x_expr));
-		p_y.SetExpr(conversion::fromStringToWString(y_expr));
-		p_z.SetExpr(conversion::fromStringToWString(z_expr));
 
-		time_t start = clock();
+		QElapsedTimer timer;
+		timer.start();
 
 		// every parser variables is related to face attributes.
-		CMeshO::FaceIterator fi;
-		for (fi = m.cm.face.begin(); fi != m.cm.face.end(); ++fi)
-			if (!(*fi).IsD()) {
-				setAttributes(fi, m.cm);
-
-				// add new user-defined attribute
-				try {
-					h[fi][0] = p_x.Eval();
-					h[fi][1] = p_y.Eval();
-					h[fi][2] = p_z.Eval();
-				}
-				catch (Parser::exception_type& e) {
-					throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-				}
-			}
+		FaceVariables  vars(m.cm);
+		ParallelParser parser(vars.names(), exprs);
+		parser.evaluate(
+			m.cm.face.size(),
+			[&](std::size_t i, ParallelParser::Slot s) { return vars.fill(i, s); },
+			[&](std::size_t i, ParallelParser::Slot res) {
+				h[i] = Point3m(res[0], res[1], res[2]);
+			});
 
 		// if succeeded log stream contains number of vertices processed and time elapsed
-		log("%d faces processed in %.2f sec.", m.cm.fn, (clock() - start) / (float) CLOCKS_PER_SEC);
+		log("%d faces processed in %.2f sec.", m.cm.fn, timer.elapsed() / 1000.0);
 
 	} break;
 
@@ -1411,12 +1338,6 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		m.updateBoxAndNormals();
 	} break;
 	case FF_ISOSURFACE: {
-		SimpleVolume<SimpleVoxel<float>> volume;
-
-		typedef vcg::tri::TrivialWalker<CMeshO, SimpleVolume<SimpleVoxel<float>>> MyWalker;
-		typedef vcg::tri::MarchingCubes<CMeshO, MyWalker>                         MyMarchingCubes;
-		MyWalker                                                                  walker;
-
 		Box3f RangeBBox;
 		RangeBBox.min[0] = par.getFloat("minX");
 		RangeBBox.min[1] = par.getFloat("minY");
@@ -1427,38 +1348,59 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		double  step     = par.getFloat("voxelSize");
 		Point3i siz      = Point3i::Construct((RangeBBox.max - RangeBBox.min) * (1.0 / step));
 
-		Parser p;
-		double x, y, z;
-		p.DefineVar(conversion::fromStringToWString("x"), &x);
-		p.DefineVar(conversion::fromStringToWString("y"), &y);
-		p.DefineVar(conversion::fromStringToWString("z"), &z);
+		// the field is evaluated while the surface is extracted, in parallel:
+		// each thread has its own parser and variables
+		struct IsoParser
+		{
+			Parser p;
+			double x, y, z;
+		};
+#ifdef _OPENMP
+		std::vector<IsoParser> parsers(omp_get_max_threads());
+#else
+		std::vector<IsoParser> parsers(1);
+#endif
 		std::string expr = par.getString("expr").toStdString();
-		p.SetExpr(conversion::fromStringToWString(expr));
-		log("Filling a Volume of %i %i %i", siz[0], siz[1], siz[2]);
-		volume.Init(siz, RangeBBox);
-		for (double i = 0; i < siz[0]; i++)
-			for (double j = 0; j < siz[1]; j++)
-				for (double k = 0; k < siz[2]; k++) {
-					x = RangeBBox.min[0] + step * i;
-					y = RangeBBox.min[1] + step * j;
-					z = RangeBBox.min[2] + step * k;
-					try {
-						volume.Val(i, j, k) = p.Eval();
-					}
-					catch (Parser::exception_type& e) {
-						throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
-					}
-				}
+		for (IsoParser& ip : parsers) {
+			ip.p.DefineVar(conversion::fromStringToWString("x"), &ip.x);
+			ip.p.DefineVar(conversion::fromStringToWString("y"), &ip.y);
+			ip.p.DefineVar(conversion::fromStringToWString("z"), &ip.z);
+			ip.p.SetExpr(conversion::fromStringToWString(expr));
+		}
+		// syntax errors are reported before starting
+		try {
+			parsers[0].x = parsers[0].y = parsers[0].z = 0;
+			parsers[0].p.Eval();
+		}
+		catch (Parser::exception_type& e) {
+			throw MLException(conversion::fromWStringToString(e.GetMsg()).c_str());
+		}
+		std::string evalError;
+		auto field = meshlab::makeFunctionField(siz, [&](int i, int j, int k) {
+#ifdef _OPENMP
+			IsoParser& ip = parsers[omp_get_thread_num()];
+#else
+			IsoParser& ip = parsers[0];
+#endif
+			ip.x = RangeBBox.min[0] + step * i;
+			ip.y = RangeBBox.min[1] + step * j;
+			ip.z = RangeBBox.min[2] + step * k;
+			try {
+				return float(ip.p.Eval());
+			}
+			catch (Parser::exception_type& e) {
+				#pragma omp critical(isosurface_error)
+				evalError = conversion::fromWStringToString(e.GetMsg());
+				return 0.0f;
+			}
+		});
 
 		// MARCHING CUBES
-		log("[MARCHING CUBES] Building mesh...");
-		MyMarchingCubes mc(m.cm, walker);
-		walker.BuildMesh<MyMarchingCubes>(m.cm, volume, mc, 0);
-		//    Matrix44m tr; tr.SetIdentity(); tr.SetTranslate(rbb.min[0],rbb.min[1],rbb.min[2]);
-		//    Matrix44m sc; sc.SetIdentity(); sc.SetScale(step,step,step);
-		//    tr=tr*sc;
-
-		//    tri::UpdatePosition<CMeshO>::Matrix(m.cm,tr);
+		log("[MARCHING CUBES] Building mesh on a grid of %i %i %i...", siz[0], siz[1], siz[2]);
+		meshlab::extractIsosurface(
+			m.cm, field, 0, Point3m::Construct(RangeBBox.min), Point3m(step, step, step), cb);
+		if (!evalError.empty())
+			throw MLException(evalError.c_str());
 		tri::UpdateNormal<CMeshO>::PerVertexNormalizedPerFace(m.cm);
 		tri::UpdateBounding<CMeshO>::Box(m.cm); // updates bounding box
 
@@ -1499,336 +1441,6 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 	return std::map<std::string, QVariant>();
 }
 
-// display parsing error in dialog
-void FilterFunctionPlugin::showParserError(const QString& s, Parser::exception_type& e)
-{
-	errorMsg += s;
-	errorMsg += conversion::fromWStringToString(e.GetMsg()).c_str();
-	errorMsg += "\n";
-}
-
-// set per-vertex attributes associated to parser variables
-void FilterFunctionPlugin::setAttributes(CMeshO::VertexIterator& vi, CMeshO& m)
-{
-	x = (*vi).P()[0]; // coord x
-	y = (*vi).P()[1]; // coord y
-	z = (*vi).P()[2]; // coord z
-
-	nx = (*vi).N()[0]; // normal coord x
-	ny = (*vi).N()[1]; // normal coord y
-	nz = (*vi).N()[2]; // normal coord z
-
-	r = (*vi).C()[0]; // color R
-	g = (*vi).C()[1]; // color G
-	b = (*vi).C()[2]; // color B
-	a = (*vi).C()[3]; // color ALPHA
-
-	q = (*vi).Q(); // quality
-
-	vsel = ((*vi).IsS()) ? 1.0 : 0.0; // selection
-
-	if (tri::HasPerVertexRadius(m))
-		rad = (*vi).R();
-	else
-		rad = 0;
-
-	v = vi - m.vert.begin(); // zero based index of current vertex
-
-	if (tri::HasPerVertexTexCoord(m)) {
-		vtu = (*vi).T().U();
-		vtv = (*vi).T().V();
-		ti  = (*vi).T().N();
-	}
-	else {
-		vtu = vtv = ti = 0;
-	}
-
-	// if user-defined attributes exist (vector is not empty)
-	//  set variables to explicit value obtained through attribute's handler
-	for (int i = 0; i < (int) v_attrValue.size(); i++)
-		v_attrValue[i] = v_handlers[i][vi];
-
-	for (int i = 0; i < (int) v3_handlers.size(); i++) {
-		v3_attrValue[i * 3 + 0] = v3_handlers[i][vi].X();
-		v3_attrValue[i * 3 + 1] = v3_handlers[i][vi].Y();
-		v3_attrValue[i * 3 + 2] = v3_handlers[i][vi].Z();
-	}
-}
-
-// set per-face attributes associated to parser variables
-void FilterFunctionPlugin::setAttributes(CMeshO::FaceIterator& fi, CMeshO& m)
-{
-	// set attributes for First vertex
-	// coords, normal coords, quality
-	x0 = (*fi).V(0)->P()[0];
-	y0 = (*fi).V(0)->P()[1];
-	z0 = (*fi).V(0)->P()[2];
-
-	nx0 = (*fi).V(0)->N()[0];
-	ny0 = (*fi).V(0)->N()[1];
-	nz0 = (*fi).V(0)->N()[2];
-
-	r0 = (*fi).V(0)->C()[0];
-	g0 = (*fi).V(0)->C()[1];
-	b0 = (*fi).V(0)->C()[2];
-	a0 = (*fi).V(0)->C()[3];
-
-	q0 = (*fi).V(0)->Q();
-
-	// set attributes for Second vertex
-	// coords, normal coords, quality
-	x1 = (*fi).V(1)->P()[0];
-	y1 = (*fi).V(1)->P()[1];
-	z1 = (*fi).V(1)->P()[2];
-
-	nx1 = (*fi).V(1)->N()[0];
-	ny1 = (*fi).V(1)->N()[1];
-	nz1 = (*fi).V(1)->N()[2];
-
-	r1 = (*fi).V(1)->C()[0];
-	g1 = (*fi).V(1)->C()[1];
-	b1 = (*fi).V(1)->C()[2];
-	a1 = (*fi).V(1)->C()[3];
-
-	q1 = (*fi).V(1)->Q();
-
-	// set attributes for Third vertex
-	// coords, normal coords, quality
-	x2 = (*fi).V(2)->P()[0];
-	y2 = (*fi).V(2)->P()[1];
-	z2 = (*fi).V(2)->P()[2];
-
-	nx2 = (*fi).V(2)->N()[0];
-	ny2 = (*fi).V(2)->N()[1];
-	nz2 = (*fi).V(2)->N()[2];
-
-	r2 = (*fi).V(2)->C()[0];
-	g2 = (*fi).V(2)->C()[1];
-	b2 = (*fi).V(2)->C()[2];
-	a2 = (*fi).V(2)->C()[3];
-
-	q2 = (*fi).V(2)->Q();
-
-	if (HasPerFaceQuality(m))
-		fq = (*fi).Q();
-	else
-		fq = 0;
-
-	// set face color attributes
-	if (HasPerFaceColor(m)) {
-		fr = (*fi).C()[0];
-		fg = (*fi).C()[1];
-		fb = (*fi).C()[2];
-		fa = (*fi).C()[3];
-	}
-	else {
-		fr = fg = fb = fa = 255;
-	}
-
-	// face normal
-	fnx = (*fi).N()[0];
-	fny = (*fi).N()[1];
-	fnz = (*fi).N()[2];
-
-	// zero based index of face
-	f = fi - m.face.begin();
-
-	// zero based index of its vertices
-	v0i = ((*fi).V(0) - &m.vert[0]);
-	v1i = ((*fi).V(1) - &m.vert[0]);
-	v2i = ((*fi).V(2) - &m.vert[0]);
-
-	if (tri::HasPerWedgeTexCoord(m)) {
-		wtu0 = (*fi).WT(0).U();
-		wtv0 = (*fi).WT(0).V();
-		wtu1 = (*fi).WT(1).U();
-		wtv1 = (*fi).WT(1).V();
-		wtu2 = (*fi).WT(2).U();
-		wtv2 = (*fi).WT(2).V();
-		ti   = (*fi).WT(0).N();
-	}
-	else {
-		wtu0 = wtv0 = wtu1 = wtv1 = wtu2 = wtv2 = ti = 0;
-	}
-
-	// selection
-	vsel0 = ((*fi).V(0)->IsS()) ? 1.0 : 0.0;
-	vsel1 = ((*fi).V(1)->IsS()) ? 1.0 : 0.0;
-	vsel2 = ((*fi).V(2)->IsS()) ? 1.0 : 0.0;
-	fsel  = ((*fi).IsS()) ? 1.0 : 0.0;
-
-	// if user-defined attributes exist (vector is not empty)
-	//  set variables to explicit value obtained through attribute's handler
-	for (int i = 0; i < (int) f_attrValue.size(); i++)
-		f_attrValue[i] = f_handlers[i][fi];
-}
-
-// Function explicitly define parser variables to perform per-vertex filter action
-// x, y, z for vertex coord, nx, ny, nz for normal coord, r, g ,b for color
-// and q for quality
-void FilterFunctionPlugin::setPerVertexVariables(Parser& p, CMeshO& m)
-{
-	p.DefineVar(conversion::fromStringToWString("x"), &x);
-	p.DefineVar(conversion::fromStringToWString("y"), &y);
-	p.DefineVar(conversion::fromStringToWString("z"), &z);
-	p.DefineVar(conversion::fromStringToWString("nx"), &nx);
-	p.DefineVar(conversion::fromStringToWString("ny"), &ny);
-	p.DefineVar(conversion::fromStringToWString("nz"), &nz);
-	p.DefineVar(conversion::fromStringToWString("r"), &r);
-	p.DefineVar(conversion::fromStringToWString("g"), &g);
-	p.DefineVar(conversion::fromStringToWString("b"), &b);
-	p.DefineVar(conversion::fromStringToWString("a"), &a);
-	p.DefineVar(conversion::fromStringToWString("q"), &q);
-	p.DefineVar(conversion::fromStringToWString("vi"), &v);
-	p.DefineVar(conversion::fromStringToWString("rad"), &rad);
-	p.DefineVar(conversion::fromStringToWString("vtu"), &vtu);
-	p.DefineVar(conversion::fromStringToWString("vtv"), &vtv);
-	p.DefineVar(conversion::fromStringToWString("ti"), &ti);
-	p.DefineVar(conversion::fromStringToWString("vsel"), &vsel);
-
-	// define var for user-defined attributes (if any exists)
-	// if vector is empty, code won't be executed
-	v_handlers.clear();
-	v_attrNames.clear();
-	v_attrValue.clear();
-	v3_handlers.clear();
-	v3_attrNames.clear();
-	v3_attrValue.clear();
-	std::vector<std::string> AllVertexAttribName;
-	tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Scalarm>(m, AllVertexAttribName);
-	for (int i = 0; i < (int) AllVertexAttribName.size(); i++) {
-		CMeshO::PerVertexAttributeHandle<Scalarm> hh =
-			tri::Allocator<CMeshO>::GetPerVertexAttribute<Scalarm>(m, AllVertexAttribName[i]);
-		v_handlers.push_back(hh);
-		v_attrNames.push_back(AllVertexAttribName[i]);
-		v_attrValue.push_back(0);
-		p.DefineVar(conversion::fromStringToWString(v_attrNames.back()), &v_attrValue.back());
-		qDebug("Adding custom per vertex float variable %s", v_attrNames.back().c_str());
-	}
-	AllVertexAttribName.clear();
-	tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Point3m>(m, AllVertexAttribName);
-	for (int i = 0; i < (int) AllVertexAttribName.size(); i++) {
-		CMeshO::PerVertexAttributeHandle<Point3m> hh3 =
-			tri::Allocator<CMeshO>::GetPerVertexAttribute<Point3m>(m, AllVertexAttribName[i]);
-
-		v3_handlers.push_back(hh3);
-
-		v3_attrValue.push_back(0);
-		v3_attrNames.push_back(AllVertexAttribName[i] + "_x");
-		p.DefineVar(conversion::fromStringToWString(v3_attrNames.back()), &v3_attrValue.back());
-
-		v3_attrValue.push_back(0);
-		v3_attrNames.push_back(AllVertexAttribName[i] + "_y");
-		p.DefineVar(conversion::fromStringToWString(v3_attrNames.back()), &v3_attrValue.back());
-
-		v3_attrValue.push_back(0);
-		v3_attrNames.push_back(AllVertexAttribName[i] + "_z");
-		p.DefineVar(conversion::fromStringToWString(v3_attrNames.back()), &v3_attrValue.back());
-		qDebug("Adding custom per vertex Point3f variable %s", v3_attrNames.back().c_str());
-	}
-}
-
-// Function explicitly define parser variables to perform Per-Face filter action
-void FilterFunctionPlugin::setPerFaceVariables(Parser& p, CMeshO& m)
-{
-	// coord of the three vertices within a face
-	p.DefineVar(conversion::fromStringToWString("x0"), &x0);
-	p.DefineVar(conversion::fromStringToWString("y0"), &y0);
-	p.DefineVar(conversion::fromStringToWString("z0"), &z0);
-	p.DefineVar(conversion::fromStringToWString("x1"), &x1);
-	p.DefineVar(conversion::fromStringToWString("y1"), &y1);
-	p.DefineVar(conversion::fromStringToWString("z1"), &z1);
-	p.DefineVar(conversion::fromStringToWString("x2"), &x2);
-	p.DefineVar(conversion::fromStringToWString("y2"), &y2);
-	p.DefineVar(conversion::fromStringToWString("z2"), &z2);
-
-	// attributes of the vertices
-	// normals:
-	p.DefineVar(conversion::fromStringToWString("nx0"), &nx0);
-	p.DefineVar(conversion::fromStringToWString("ny0"), &ny0);
-	p.DefineVar(conversion::fromStringToWString("nz0"), &nz0);
-
-	p.DefineVar(conversion::fromStringToWString("nx1"), &nx1);
-	p.DefineVar(conversion::fromStringToWString("ny1"), &ny1);
-	p.DefineVar(conversion::fromStringToWString("nz1"), &nz1);
-
-	p.DefineVar(conversion::fromStringToWString("nx2"), &nx2);
-	p.DefineVar(conversion::fromStringToWString("ny2"), &ny2);
-	p.DefineVar(conversion::fromStringToWString("nz2"), &nz2);
-
-	// colors:
-	p.DefineVar(conversion::fromStringToWString("r0"), &r0);
-	p.DefineVar(conversion::fromStringToWString("g0"), &g0);
-	p.DefineVar(conversion::fromStringToWString("b0"), &b0);
-	p.DefineVar(conversion::fromStringToWString("a0"), &a0);
-
-	p.DefineVar(conversion::fromStringToWString("r1"), &r1);
-	p.DefineVar(conversion::fromStringToWString("g1"), &g1);
-	p.DefineVar(conversion::fromStringToWString("b1"), &b1);
-	p.DefineVar(conversion::fromStringToWString("a1"), &a1);
-
-	p.DefineVar(conversion::fromStringToWString("r2"), &r2);
-	p.DefineVar(conversion::fromStringToWString("g2"), &g2);
-	p.DefineVar(conversion::fromStringToWString("b2"), &b2);
-	p.DefineVar(conversion::fromStringToWString("a2"), &a2);
-
-	// quality
-	p.DefineVar(conversion::fromStringToWString("q0"), &q0);
-	p.DefineVar(conversion::fromStringToWString("q1"), &q1);
-	p.DefineVar(conversion::fromStringToWString("q2"), &q2);
-
-	// face color
-	p.DefineVar(conversion::fromStringToWString("fr"), &fr);
-	p.DefineVar(conversion::fromStringToWString("fg"), &fg);
-	p.DefineVar(conversion::fromStringToWString("fb"), &fb);
-	p.DefineVar(conversion::fromStringToWString("fa"), &fa);
-
-	// face normal
-	p.DefineVar(conversion::fromStringToWString("fnx"), &fnx);
-	p.DefineVar(conversion::fromStringToWString("fny"), &fny);
-	p.DefineVar(conversion::fromStringToWString("fnz"), &fnz);
-
-	// face quality
-	p.DefineVar(conversion::fromStringToWString("fq"), &fq);
-
-	// index
-	p.DefineVar(conversion::fromStringToWString("fi"), &f);
-	p.DefineVar(conversion::fromStringToWString("vi0"), &v0i);
-	p.DefineVar(conversion::fromStringToWString("vi1"), &v1i);
-	p.DefineVar(conversion::fromStringToWString("vi2"), &v2i);
-
-	// texture
-	p.DefineVar(conversion::fromStringToWString("wtu0"), &wtu0);
-	p.DefineVar(conversion::fromStringToWString("wtv0"), &wtv0);
-	p.DefineVar(conversion::fromStringToWString("wtu1"), &wtu1);
-	p.DefineVar(conversion::fromStringToWString("wtv1"), &wtv1);
-	p.DefineVar(conversion::fromStringToWString("wtu2"), &wtu2);
-	p.DefineVar(conversion::fromStringToWString("wtv2"), &wtv2);
-	p.DefineVar(conversion::fromStringToWString("ti"), &ti);
-
-	// selection
-	p.DefineVar(conversion::fromStringToWString("vsel0"), &vsel0);
-	p.DefineVar(conversion::fromStringToWString("vsel1"), &vsel1);
-	p.DefineVar(conversion::fromStringToWString("vsel2"), &vsel2);
-	p.DefineVar(conversion::fromStringToWString("fsel"), &fsel);
-
-	// define var for user-defined attributes (if any exists)
-	// if vector is empty, code won't be executed
-	std::vector<std::string> AllFaceAttribName;
-	tri::Allocator<CMeshO>::GetAllPerFaceAttribute<Scalarm>(m, AllFaceAttribName);
-	f_handlers.clear();
-	f_attrNames.clear();
-	f_attrValue.clear();
-	for (int i = 0; i < (int) AllFaceAttribName.size(); i++) {
-		CMeshO::PerFaceAttributeHandle<Scalarm> hh =
-			tri::Allocator<CMeshO>::GetPerFaceAttribute<Scalarm>(m, AllFaceAttribName[i]);
-		f_handlers.push_back(hh);
-		f_attrNames.push_back(AllFaceAttribName[i]);
-		f_attrValue.push_back(0);
-		p.DefineVar(conversion::fromStringToWString(f_attrNames.back()), &f_attrValue.back());
-	}
-}
-
 FilterPlugin::FilterArity FilterFunctionPlugin::filterArity(const QAction* filter) const
 {
 	switch (ID(filter)) {
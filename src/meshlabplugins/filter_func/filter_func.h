@@ -36,26 +36,6 @@ class FilterFunctionPlugin : public QObject, public FilterPlugin
 	MESHLAB_PLUGIN_IID_EXPORTER(FILTER_PLUGIN_IID)
 	Q_INTERFACES(FilterPlugin)
 
-protected:
-	double x, y, z, nx, ny, nz, r, g, b, a, q, rad, vtu, vtv, vsel;
-	double x0, y0, z0, x1, y1, z1, x2, y2, z2, nx0, ny0, nz0, nx1, ny1, nz1, nx2, ny2, nz2, r0, g0,
-		b0, a0, r1, g1, b1, a1, r2, g2, b2, a2, q0, q1, q2, wtu0, wtv0, wtu1, wtv1, wtu2, wtv2,
-		vsel0, vsel1, vsel2;
-	double                   fr, fg, fb, fa, fnx, fny, fnz, fq, fsel;
-	double                   v, f, v0i, v1i, v2i, ti;
-	std::vector<std::string> v_attrNames;  // names of the <float> per vertex attributes
-	std::vector<double>      v_attrValue;  // values of the <Scalarm> per vertex attributes
-	std::vector<std::string> v3_attrNames; // names of the <Point3f> per vertex attributes There are
-										   // 3x (one foreach coord _x, _y, _z)
-	std::vector<double> v3_attrValue; // values of the <Point3m> per vertex attributes. There are 3x
-									  // (one foreach coord _x, _y, _z)
-	std::vector<std::string>                               f_attrNames;
-	std::vector<double>                                    f_attrValue;
-	std::vector<CMeshO::PerVertexAttributeHandle<Scalarm>> v_handlers;
-	std::vector<CMeshO::PerVertexAttributeHandle<Point3m>> v3_handlers;
-	std::vector<CMeshO::PerFaceAttributeHandle<Scalarm>>   f_handlers;
-	QString                                                errorMsg;
-
 public:
 	enum {
 		FF_VERT_SELECTION,
@@ -96,12 +76,6 @@ public:
 		unsigned int&            postConditionMask,
 		vcg::CallBackPos*        cb);
 	FilterArity filterArity(const QAction* filter) const;
-
-	void showParserError(const QString& s, mu::Parser::exception_type& e);
-	void setAttributes(CMeshO::VertexIterator& vi, CMeshO& m);
-	void setAttributes(CMeshO::FaceIterator& fi, CMeshO& m);
-	void setPerVertexVariables(mu::Parser& p, CMeshO& m);
-	void setPerFaceVariables(mu::Parser& p, CMeshO& m);
 };
 
 #endif
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005-2021                                           \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+
+#include "parallel_parser.h"
+
+ParallelParser::ParallelParser(
+	const std::vector<std::string>& variables,
+	const std::vector<std::string>& expressions,
+	const std::vector<std::string>& labels)
+{
+#ifdef _OPENMP
+	const int nThreads = omp_get_max_threads();
+#else
+	const int nThreads = 1;
+#endif
+	for (int t = 0; t < nThreads; ++t) {
+		states.emplace_back(new ThreadState);
+		ThreadState& s = *states.back();
+		s.variables.assign(variables.size() * BATCH_SIZE, 0);
+		s.results.assign(expressions.size() * BATCH_SIZE, 0);
+		s.elements.resize(BATCH_SIZE);
+		s.parsers.resize(expressions.size());
+
+		std::string error;
+		for (std::size_t e = 0; e < expressions.size(); ++e) {
+			mu::Parser& p = s.parsers[e];
+			try {
+				for (std::size_t v = 0; v < variables.size(); ++v)
+					p.DefineVar(
+						conversion::fromStringToWString(variables[v]), &s.variables[v * BATCH_SIZE]);
+				p.SetExpr(conversion::fromStringToWString(expressions[e]));
+				// the errors are the same for all the threads
+				if (t == 0)
+					p.Eval();
+			}
+			catch (mu::Parser::exception_type& ex) {
+				if (e < labels.size())
+					error += labels[e];
+				error += conversion::fromWStringToString(ex.GetMsg());
+				if (!labels.empty())
+					error += "\n";
+			}
+		}
+		if (!error.empty())
+			throw MLException(error.c_str());
+	}
+}
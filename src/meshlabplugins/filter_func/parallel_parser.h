@@ -0,0 +1,154 @@
+/****************************************************************************
+ * MeshLab                                                           o o     *
+ * A versatile mesh processing toolbox                             o     o   *
+ *                                                                _   O  _   *
+ * Copyright(C) 2005                                                \/)\/    *
+ * Visual Computing Lab                                            /\/|      *
+ * ISTI - Italian National Research Council                           |      *
+ *                                                                    \      *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation; either version 2 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+ * for more details.                                                         *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef FILTER_FUNC_PARALLEL_PARSER_H
+#define FILTER_FUNC_PARALLEL_PARSER_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <common/mlexception.h>
+
+#include "muParser.h"
+#include "string_conversion.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Evaluates a set of muparser expressions on many elements (vertices or
+ * faces) in parallel.
+ *
+ * Every thread has its own parsers, one for each expression, bound to its own
+ * block of variables: each variable is an array of BATCH_SIZE values, so
+ * that the expressions are evaluated on a whole batch of elements at a time
+ * with the muparser bulk mode.
+ */
+class ParallelParser
+{
+public:
+	static const int BATCH_SIZE = 1024;
+
+	/**
+	 * @brief the values of the variables, or of the results, of an element
+	 * of the batch
+	 */
+	class Slot
+	{
+	public:
+		explicit Slot(double* p) : p(p) {}
+		double& operator[](int i) const { return p[(std::size_t) i * BATCH_SIZE]; }
+
+	private:
+		double* p;
+	};
+
+	/**
+	 * @brief Prepares the parsers of all the threads. The expressions are
+	 * checked by evaluating them once: if some of them are not valid, throws
+	 * an MLException with the errors of all of them, each one preceded by
+	 * the label of its expression (if labels are given).
+	 */
+	ParallelParser(
+		const std::vector<std::string>& variables,
+		const std::vector<std::string>& expressions,
+		const std::vector<std::string>& labels = std::vector<std::string>());
+
+	/**
+	 * @brief For each element i in [0, n) calls fill(i, variables), that sets
+	 * the variables of the element in the order given to the constructor, or
+	 * returns false if the element must be skipped; then calls store(i,
+	 * results) with the values of the expressions. fill and store are called
+	 * concurrently on different elements, and all the elements of a batch are
+	 * filled before any of them is stored.
+	 */
+	template <typename Fill, typename Store>
+	void evaluate(std::size_t n, Fill fill, Store store);
+
+private:
+	struct ThreadState
+	{
+		std::vector<double>      variables;
+		std::vector<double>      results;
+		std::vector<std::size_t> elements;
+		std::vector<mu::Parser>  parsers;
+	};
+
+	ThreadState& threadState()
+	{
+#ifdef _OPENMP
+		return *states[omp_get_thread_num()];
+#else
+		return *states[0];
+#endif
+	}
+
+	std::vector<std::unique_ptr<ThreadState>> states;
+};
+
+template <typename Fill, typename Store>
+void ParallelParser::evaluate(std::size_t n, Fill fill, Store store)
+{
+	const int nBatches = (int) ((n + BATCH_SIZE - 1) / BATCH_SIZE);
+	std::atomic<bool> failed(false);
+	std::string error;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int batch = 0; batch < nBatches; ++batch) {
+		if (failed)
+			continue;
+		ThreadState& s = threadState();
+		const std::size_t begin = (std::size_t) batch * BATCH_SIZE;
+		const std::size_t end = std::min(begin + BATCH_SIZE, n);
+		int count = 0;
+		for (std::size_t i = begin; i < end; ++i) {
+			if (fill(i, Slot(&s.variables[count])))
+				s.elements[count++] = i;
+		}
+		if (count == 0)
+			continue;
+		try {
+			for (std::size_t e = 0; e < s.parsers.size(); ++e)
+				s.parsers[e].Eval(&s.results[e * BATCH_SIZE], count);
+		}
+		catch (mu::Parser::exception_type& e) {
+			#pragma omp critical(parallel_parser_error)
+			{
+				if (!failed)
+					error = conversion::fromWStringToString(e.GetMsg());
+				failed = true;
+			}
+			continue;
+		}
+		for (int k = 0; k < count; ++k)
+			store(s.elements[k], Slot(&s.results[k]));
+	}
+	if (failed)
+		throw MLException(error.c_str());
+}
+
+#endif // FILTER_FUNC_PARALLEL_PARSER_H
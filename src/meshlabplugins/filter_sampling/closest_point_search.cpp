@@ -0,0 +1,126 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "closest_point_search.h"
+
+#include <cstdint>
+
+#include <vcg/complex/algorithms/closest.h>
+#include <vcg/simplex/face/distance.h>
+
+ClosestPointSearch::Marker::Marker() :
+		faces(64, nullptr), stamps(64, 0), stamp(1), count(0), bits(6)
+{
+}
+
+void ClosestPointSearch::Marker::UnMarkAll()
+{
+	++stamp;
+	count = 0;
+	if (stamp == 0) { // wrapped around: clear the old stamps
+		std::fill(stamps.begin(), stamps.end(), 0);
+		stamp = 1;
+	}
+}
+
+bool ClosestPointSearch::Marker::IsMarked(const CFaceO* f) const
+{
+	const std::size_t mask = faces.size() - 1;
+	for (std::size_t i = slot(f); stamps[i] == stamp; i = (i + 1) & mask)
+		if (faces[i] == f)
+			return true;
+	return false;
+}
+
+void ClosestPointSearch::Marker::Mark(const CFaceO* f)
+{
+	if ((count + 1) * 2 > faces.size())
+		grow();
+	const std::size_t mask = faces.size() - 1;
+	std::size_t       i    = slot(f);
+	while (stamps[i] == stamp) {
+		if (faces[i] == f)
+			return;
+		i = (i + 1) & mask;
+	}
+	faces[i]  = f;
+	stamps[i] = stamp;
+	++count;
+}
+
+std::size_t ClosestPointSearch::Marker::slot(const CFaceO* f) const
+{
+	const std::uint64_t h = (std::uint64_t) (reinterpret_cast<std::uintptr_t>(f) / sizeof(CFaceO));
+	return (std::size_t) ((h * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+void ClosestPointSearch::Marker::grow()
+{
+	std::vector<const CFaceO*> marked;
+	marked.reserve(count);
+	for (std::size_t i = 0; i < faces.size(); ++i)
+		if (stamps[i] == stamp)
+			marked.push_back(faces[i]);
+
+	++bits;
+	faces.assign(faces.size() * 2, nullptr);
+	stamps.assign(stamps.size() * 2, 0);
+	stamp = 1;
+	count = 0;
+	for (const CFaceO* f : marked)
+		Mark(f);
+}
+
+ClosestPointSearch::ClosestPointSearch(CMeshO& m, IndexType index) : m(m), vertexSearch(m.fn == 0)
+{
+	if (vertexSearch)
+		vertGrid.Set(m.vert.begin(), m.vert.end());
+	else if (index == BVH)
+		bvh.reset(new FaceBVH(m));
+	else
+		faceGrid.Set(m.face.begin(), m.face.end());
+}
+
+ClosestPointSearch::Result
+ClosestPointSearch::closest(const Point3m& p, Scalarm maxDist, Marker& marker)
+{
+	Result r;
+	r.dist = maxDist;
+	if (vertexSearch) {
+		// vertices are in a single cell of the grid, they need no marker
+		r.vert = vcg::tri::GetClosestVertex<CMeshO, vcg::GridStaticPtr<CVertexO, Scalarm>>(
+			m, vertGrid, p, maxDist, r.dist);
+		if (r.vert != nullptr)
+			r.point = r.vert->cP();
+	}
+	else if (bvh) {
+		r.face = bvh->closest(p, maxDist, r.dist, r.point);
+	}
+	else {
+		vcg::face::PointDistanceBaseFunctor<Scalarm> pDistFunct;
+		r.face = faceGrid.GetClosest(pDistFunct, marker, p, maxDist, r.dist, r.point);
+	}
+	if (!r.found())
+		r.dist = maxDist;
+	return r;
+}
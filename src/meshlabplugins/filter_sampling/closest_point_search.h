@@ -0,0 +1,116 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef FILTER_SAMPLING_CLOSEST_POINT_SEARCH_H
+#define FILTER_SAMPLING_CLOSEST_POINT_SEARCH_H
+
+#include <memory>
+#include <vector>
+
+#include <QStringList>
+
+#include <common/ml_document/cmesh.h>
+#include <vcg/space/index/grid_static_ptr.h>
+
+#include "face_bvh.h"
+
+/**
+ * Closest point queries on a mesh (on its faces, or on its vertices if it has
+ * no faces) that can be run concurrently by many threads.
+ *
+ * The uniform grid queries of vcg need a marker to skip the faces already
+ * visited; tri::FaceTmark writes the marks in the faces, so it cannot be
+ * shared among threads. Here each thread passes its own Marker instead.
+ *
+ * The faces can be indexed by the vcg uniform grid or by a FaceBVH, that
+ * gives the same results and is faster on meshes with faces of very
+ * different sizes.
+ */
+class ClosestPointSearch
+{
+public:
+	/**
+	 * @brief The spatial index of the faces, in the order of indexNames()
+	 */
+	enum IndexType { UNIFORM_GRID, BVH };
+
+	static QStringList indexNames() { return {"Uniform Grid", "BVH"}; }
+
+	/**
+	 * @brief The faces visited by the current query of a thread, kept in a
+	 * small hash set that is emptied in constant time by UnMarkAll.
+	 */
+	class Marker
+	{
+	public:
+		Marker();
+
+		void UnMarkAll();
+		bool IsMarked(const CFaceO* f) const;
+		void Mark(const CFaceO* f);
+
+	private:
+		std::size_t slot(const CFaceO* f) const;
+		void        grow();
+
+		std::vector<const CFaceO*> faces;
+		std::vector<unsigned int>  stamps; // a slot is used if its stamp is the current one
+		unsigned int               stamp;
+		std::size_t                count;
+		int                        bits;
+	};
+
+	struct Result
+	{
+		CFaceO*   face = nullptr; // the closest face, if the search is on faces
+		CVertexO* vert = nullptr; // the closest vertex, if the search is on vertices
+		Point3m   point;
+		Scalarm   dist = 0;
+
+		bool found() const { return face != nullptr || vert != nullptr; }
+	};
+
+	/**
+	 * @brief Builds the spatial index of m, that must not change while the
+	 * search is in use. The face normals must be up to date.
+	 */
+	ClosestPointSearch(CMeshO& m, IndexType index = UNIFORM_GRID);
+
+	bool usesVertices() const { return vertexSearch; }
+
+	/**
+	 * @brief The closest point of the mesh to p, within maxDist. If nothing is
+	 * found, result.dist is maxDist. Can be called concurrently, each thread
+	 * with its own marker.
+	 */
+	Result closest(const Point3m& p, Scalarm maxDist, Marker& marker);
+
+private:
+	CMeshO&                               m;
+	bool                                  vertexSearch;
+	vcg::GridStaticPtr<CFaceO, Scalarm>   faceGrid;
+	vcg::GridStaticPtr<CVertexO, Scalarm> vertGrid;
+	std::unique_ptr<FaceBVH>              bvh;
+};
+
+#endif // FILTER_SAMPLING_CLOSEST_POINT_SEARCH_H
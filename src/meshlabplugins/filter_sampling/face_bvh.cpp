@@ -0,0 +1,324 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "face_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <vcg/simplex/face/distance.h>
+
+namespace {
+
+const int SAH_BINS = 16;
+
+Scalarm halfArea(const Box3m& b)
+{
+	if (b.IsNull())
+		return 0;
+	const Point3m d = b.Dim();
+	return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+}
+
+template <typename Node>
+Scalarm boxSquaredDistance(const Node& n, const Point3m& p)
+{
+	Scalarm d2 = 0;
+	for (int k = 0; k < 3; ++k) {
+		const Scalarm d = std::max(std::max(n.bmin[k] - p[k], p[k] - n.bmax[k]), Scalarm(0));
+		d2 += d * d;
+	}
+	return d2;
+}
+
+} // namespace
+
+FaceBVH::FaceBVH(CMeshO& m)
+{
+	std::vector<int>     ids;
+	std::vector<Box3m>   boxes(m.face.size());
+	std::vector<Point3m> centroids(m.face.size());
+	for (std::size_t i = 0; i < m.face.size(); ++i) {
+		const CFaceO& f = m.face[i];
+		if (f.IsD())
+			continue;
+		ids.push_back((int) i);
+		for (int j = 0; j < 3; ++j)
+			boxes[i].Add(f.cP(j));
+		centroids[i] = boxes[i].Center();
+	}
+	if (ids.empty())
+		return;
+
+	struct Task
+	{
+		int node, begin, end, depth;
+	};
+	std::vector<Task> tasks = {{0, 0, (int) ids.size(), 0}};
+	nodes.emplace_back();
+	while (!tasks.empty()) {
+		const Task t = tasks.back();
+		tasks.pop_back();
+		const int n = t.end - t.begin;
+
+		Box3m box, cbox;
+		for (int i = t.begin; i < t.end; ++i) {
+			box.Add(boxes[ids[i]]);
+			cbox.Add(centroids[ids[i]]);
+		}
+		for (int k = 0; k < 3; ++k) {
+			nodes[t.node].bmin[k] = box.min[k];
+			nodes[t.node].bmax[k] = box.max[k];
+		}
+
+		const int     axis   = cbox.MaxDim();
+		const Scalarm extent = cbox.max[axis] - cbox.min[axis];
+		if (n <= LEAF_SIZE || t.depth >= MAX_DEPTH || extent <= 0) {
+			makeLeaf(nodes[t.node], m, &ids[t.begin], n);
+			continue;
+		}
+
+		// surface area heuristic on SAH_BINS bins of the centroids
+		auto binOf = [&](int id) {
+			const int b = int((centroids[id][axis] - cbox.min[axis]) * SAH_BINS / extent);
+			return std::min(b, SAH_BINS - 1);
+		};
+		int   binCount[SAH_BINS] = {};
+		Box3m binBox[SAH_BINS];
+		for (int i = t.begin; i < t.end; ++i) {
+			const int b = binOf(ids[i]);
+			++binCount[b];
+			binBox[b].Add(boxes[ids[i]]);
+		}
+		Scalarm rightCost[SAH_BINS];
+		Box3m   acc;
+		int     cnt = 0;
+		for (int b = SAH_BINS - 1; b > 0; --b) {
+			acc.Add(binBox[b]);
+			cnt += binCount[b];
+			rightCost[b] = halfArea(acc) * cnt;
+		}
+		int     bestSplit = -1; // the last bin on the left side
+		Scalarm bestCost  = halfArea(box) * n;
+		acc.SetNull();
+		cnt = 0;
+		for (int b = 0; b < SAH_BINS - 1; ++b) {
+			acc.Add(binBox[b]);
+			cnt += binCount[b];
+			const Scalarm cost = halfArea(acc) * cnt + rightCost[b + 1];
+			if (cost < bestCost) {
+				bestCost  = cost;
+				bestSplit = b;
+			}
+		}
+
+		int* first = ids.data() + t.begin;
+		int* last  = ids.data() + t.end;
+		int* mid   = first;
+		if (bestSplit >= 0)
+			mid = std::partition(first, last, [&](int id) { return binOf(id) <= bestSplit; });
+		if (mid == first || mid == last) {
+			// no useful split: split at the median
+			mid = first + n / 2;
+			std::nth_element(first, mid, last, [&](int a, int b) {
+				return centroids[a][axis] < centroids[b][axis];
+			});
+		}
+
+		const int left = (int) nodes.size();
+		nodes.emplace_back();
+		nodes.emplace_back();
+		nodes[t.node].first = left;
+		nodes[t.node].count = 0;
+		const int split = (int) (mid - ids.data());
+		tasks.push_back({left, t.begin, split, t.depth + 1});
+		tasks.push_back({left + 1, split, t.end, t.depth + 1});
+	}
+
+	// the magnitude of the coordinates and of the edges of the triangles
+	Scalarm diag2 = 0;
+	for (int k = 0; k < 3; ++k) {
+		const Scalarm d = nodes[0].bmax[k] - nodes[0].bmin[k];
+		coordScale      = std::max(coordScale, std::max(std::abs(nodes[0].bmin[k]), std::abs(nodes[0].bmax[k])));
+		diag2 += d * d;
+	}
+	coordScale += std::sqrt(diag2);
+}
+
+void FaceBVH::makeLeaf(Node& node, CMeshO& m, const int* faceIds, int count)
+{
+	node.first = (int) faces.size();
+	node.count = count;
+	const int padded = (count + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE;
+	for (int i = 0; i < padded; ++i) {
+		// the padding repeats the last triangle
+		CFaceO&       f  = m.face[faceIds[std::min(i, count - 1)]];
+		const Point3m a  = f.cP(0);
+		const Point3m ab = f.cP(1) - a;
+		const Point3m ac = f.cP(2) - a;
+		faces.push_back(&f);
+		ax.push_back(a[0]);
+		ay.push_back(a[1]);
+		az.push_back(a[2]);
+		abx.push_back(ab[0]);
+		aby.push_back(ab[1]);
+		abz.push_back(ab[2]);
+		acx.push_back(ac[0]);
+		acy.push_back(ac[1]);
+		acz.push_back(ac[2]);
+	}
+}
+
+/**
+ * @brief the squared distances of p from the GROUP_SIZE triangles starting at
+ * first: the distance from the plane if p projects inside the triangle,
+ * otherwise the distance from the closest edge
+ */
+void FaceBVH::squaredDistances(int first, const Point3m& p, Scalarm* d2) const
+{
+	const Scalarm tiny = std::numeric_limits<Scalarm>::min();
+	const Scalarm* ax  = this->ax.data() + first;
+	const Scalarm* ay  = this->ay.data() + first;
+	const Scalarm* az  = this->az.data() + first;
+	const Scalarm* abx = this->abx.data() + first;
+	const Scalarm* aby = this->aby.data() + first;
+	const Scalarm* abz = this->abz.data() + first;
+	const Scalarm* acx = this->acx.data() + first;
+	const Scalarm* acy = this->acy.data() + first;
+	const Scalarm* acz = this->acz.data() + first;
+	const Scalarm  px = p[0], py = p[1], pz = p[2];
+
+	#pragma omp simd
+	for (int i = 0; i < GROUP_SIZE; ++i) {
+		// p - a, p - b, p - c, and the edges b - a, c - b, a - c
+		const Scalarm apx = px - ax[i], apy = py - ay[i], apz = pz - az[i];
+		const Scalarm bpx = apx - abx[i], bpy = apy - aby[i], bpz = apz - abz[i];
+		const Scalarm cpx = apx - acx[i], cpy = apy - acy[i], cpz = apz - acz[i];
+		const Scalarm e0x = abx[i], e0y = aby[i], e0z = abz[i];
+		const Scalarm e1x = acx[i] - abx[i], e1y = acy[i] - aby[i], e1z = acz[i] - abz[i];
+		const Scalarm e2x = -acx[i], e2y = -acy[i], e2z = -acz[i];
+
+		// normal (not normalized)
+		const Scalarm nx = e0y * acz[i] - e0z * acy[i];
+		const Scalarm ny = e0z * acx[i] - e0x * acz[i];
+		const Scalarm nz = e0x * acy[i] - e0y * acx[i];
+		const Scalarm nn = nx * nx + ny * ny + nz * nz;
+
+		// p projects inside if it is on the inner side of the three edges
+		const Scalarm s0 = nx * (e0y * apz - e0z * apy) + ny * (e0z * apx - e0x * apz) +
+						   nz * (e0x * apy - e0y * apx);
+		const Scalarm s1 = nx * (e1y * bpz - e1z * bpy) + ny * (e1z * bpx - e1x * bpz) +
+						   nz * (e1x * bpy - e1y * bpx);
+		const Scalarm s2 = nx * (e2y * cpz - e2z * cpy) + ny * (e2z * cpx - e2x * cpz) +
+						   nz * (e2x * cpy - e2y * cpx);
+		const Scalarm dn    = apx * nx + apy * ny + apz * nz;
+		const Scalarm plane = dn * dn / std::max(nn, tiny);
+
+		// distances from the three edges
+		Scalarm t, dx, dy, dz;
+		t  = (apx * e0x + apy * e0y + apz * e0z) / std::max(e0x * e0x + e0y * e0y + e0z * e0z, tiny);
+		t  = std::min(std::max(t, Scalarm(0)), Scalarm(1));
+		dx = apx - t * e0x, dy = apy - t * e0y, dz = apz - t * e0z;
+		const Scalarm de0 = dx * dx + dy * dy + dz * dz;
+		t  = (bpx * e1x + bpy * e1y + bpz * e1z) / std::max(e1x * e1x + e1y * e1y + e1z * e1z, tiny);
+		t  = std::min(std::max(t, Scalarm(0)), Scalarm(1));
+		dx = bpx - t * e1x, dy = bpy - t * e1y, dz = bpz - t * e1z;
+		const Scalarm de1 = dx * dx + dy * dy + dz * dz;
+		t  = (cpx * e2x + cpy * e2y + cpz * e2z) / std::max(e2x * e2x + e2y * e2y + e2z * e2z, tiny);
+		t  = std::min(std::max(t, Scalarm(0)), Scalarm(1));
+		dx = cpx - t * e2x, dy = cpy - t * e2y, dz = cpz - t * e2z;
+		const Scalarm de2 = dx * dx + dy * dy + dz * dz;
+
+		const bool inside = nn > tiny && s0 >= 0 && s1 >= 0 && s2 >= 0;
+		d2[i] = inside ? plane : std::min(de0, std::min(de1, de2));
+	}
+}
+
+CFaceO* FaceBVH::closest(const Point3m& p, Scalarm maxDist, Scalarm& dist, Point3m& closestPt) const
+{
+	if (nodes.empty())
+		return nullptr;
+
+	// the rounding errors of the kernel and of the boxes are absolute, and
+	// grow with the magnitude of the coordinates: the faces and the nodes are
+	// skipped only when they are farther than the current best distance by
+	// more than this slack, so that rounding cannot discard the closest face
+	const Scalarm eps   = std::numeric_limits<Scalarm>::epsilon();
+	const Scalarm pMax  = std::max(std::abs(p[0]), std::max(std::abs(p[1]), std::abs(p[2])));
+	const Scalarm slack = 4 * eps * (coordScale + pMax);
+
+	CFaceO* best     = nullptr;
+	Scalarm bestDist = maxDist;
+	// the squared distance beyond which a face cannot be the closest one
+	auto limitOf = [&](Scalarm d) {
+		const Scalarm l = d * (1 + 4 * eps) + slack;
+		return l * l;
+	};
+	Scalarm limit2 = limitOf(bestDist);
+
+	int stack[MAX_DEPTH + 2];
+	int top = 0;
+	stack[top++] = 0;
+	Scalarm d2[GROUP_SIZE];
+	while (top > 0) {
+		const Node& node = nodes[stack[--top]];
+		if (boxSquaredDistance(node, p) > limit2)
+			continue;
+		if (node.count > 0) {
+			for (int g = node.first; g < node.first + node.count; g += GROUP_SIZE) {
+				squaredDistances(g, p, d2);
+				const int n = std::min(GROUP_SIZE, node.first + node.count - g);
+				for (int i = 0; i < n; ++i) {
+					if (d2[i] > limit2)
+						continue;
+					Scalarm d = bestDist;
+					Point3m q;
+					if (vcg::face::PointDistanceBase(*faces[g + i], p, d, q) && d < bestDist) {
+						best      = faces[g + i];
+						bestDist  = d;
+						limit2    = limitOf(d);
+						closestPt = q;
+					}
+				}
+			}
+		}
+		else {
+			// the closest child is visited first
+			int     l  = node.first, r = node.first + 1;
+			Scalarm dl = boxSquaredDistance(nodes[l], p);
+			Scalarm dr = boxSquaredDistance(nodes[r], p);
+			if (dl > dr) {
+				std::swap(l, r);
+				std::swap(dl, dr);
+			}
+			if (dr <= limit2)
+				stack[top++] = r;
+			if (dl <= limit2)
+				stack[top++] = l;
+		}
+	}
+	if (best != nullptr)
+		dist = bestDist;
+	return best;
+}
@@ -0,0 +1,88 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef FILTER_SAMPLING_FACE_BVH_H
+#define FILTER_SAMPLING_FACE_BVH_H
+
+#include <vector>
+
+#include <common/ml_document/cmesh.h>
+
+/**
+ * A bounding volume hierarchy on the faces of a mesh, for closest point
+ * queries. Unlike a uniform grid, its cells adapt to the size of the faces, so
+ * it works well also on meshes that mix very large and very small faces.
+ *
+ * The tree is built with the surface area heuristic on binned centroids. The
+ * triangles of each leaf are stored as structure of arrays, in groups of
+ * GROUP_SIZE, and their distances from the query point are computed by a
+ * branch-free loop that the compiler vectorizes. Only the faces that can be
+ * the closest one, up to an absolute slack that covers the rounding errors of
+ * the kernel, are then checked with face::PointDistanceBase, that gives the
+ * returned distance and point.
+ */
+class FaceBVH
+{
+public:
+	static const int GROUP_SIZE = 8; // triangles tested together
+	static const int LEAF_SIZE  = 8; // max triangles in a leaf (unless too deep)
+
+	/**
+	 * @brief Builds the tree on the non deleted faces of m; the mesh must not
+	 * change while the tree is in use. The face normals must be up to date.
+	 */
+	explicit FaceBVH(CMeshO& m);
+
+	std::size_t nodeCount() const { return nodes.size(); }
+
+	/**
+	 * @brief The closest face to p with distance lower than maxDist, or
+	 * nullptr; dist and closestPt are set only if a face is found. Can be
+	 * called concurrently.
+	 */
+	CFaceO* closest(const Point3m& p, Scalarm maxDist, Scalarm& dist, Point3m& closestPt) const;
+
+private:
+	static const int MAX_DEPTH = 64;
+
+	struct Node
+	{
+		Scalarm bmin[3];
+		Scalarm bmax[3];
+		int     first; // leaf: first triangle; inner node: left child (the right one is first + 1)
+		int     count; // leaf: number of triangles; inner node: 0
+	};
+
+	void makeLeaf(Node& node, CMeshO& m, const int* faceIds, int count);
+	void squaredDistances(int first, const Point3m& p, Scalarm* d2) const;
+
+	std::vector<Node>    nodes;
+	std::vector<CFaceO*> faces;          // the face of each triangle slot
+	Scalarm              coordScale = 0; // max abs coordinate plus the diagonal of the bbox
+	// the triangles, as a, b - a, c - a, padded to multiples of GROUP_SIZE
+	std::vector<Scalarm> ax, ay, az;
+	std::vector<Scalarm> abx, aby, abz;
+	std::vector<Scalarm> acx, acy, acz;
+};
+
+#endif // FILTER_SAMPLING_FACE_BVH_H
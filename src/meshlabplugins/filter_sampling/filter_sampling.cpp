@@ -29,8 +29,13 @@ $Log: samplefilter.cpp,v $
 #include <stdlib.h>
 #include <time.h>
 #include <limits>
+#include <memory>
 
 #include "filter_sampling.h"
+#include "closest_point_search.h"
+#include "narrow_band_resampler.h"
+#include "parallel_poisson_disk.h"
+#include "parallel_sampling.h"
 
 #include <vcg/complex/algorithms/clean.h>
 #include <vcg/complex/algorithms/point_sampling.h>
@@ -89,12 +94,19 @@ public:
   void AddFace(const CMeshO::FaceType &f, CMeshO::CoordType p)
   {
     tri::Allocator<CMeshO>::AddVertices(*m,1);
-    m->vert.back().P() = f.cP(0)*p[0] + f.cP(1)*p[1] +f.cP(2)*p[2];
+    SetFaceSample(m->vert.back(),f,p);
+  }
+
+  // Sets v as the sample of barycentric coords p on f; used by the parallel
+  // samplings, that write their samples in vertices allocated in advance.
+  void SetFaceSample(CMeshO::VertexType &v, const CMeshO::FaceType &f, const CMeshO::CoordType &p) const
+  {
+    v.P() = f.cP(0)*p[0] + f.cP(1)*p[1] +f.cP(2)*p[2];
 
-    if(perFaceNormal) m->vert.back().N() = f.cN();
-       else m->vert.back().N() = f.cV(0)->N()*p[0] + f.cV(1)->N()*p[1] + f.cV(2)->N()*p[2];
+    if(perFaceNormal) v.N() = f.cN();
+       else v.N() = f.cV(0)->cN()*p[0] + f.cV(1)->cN()*p[1] + f.cV(2)->cN()*p[2];
     if (qualitySampling)
-      m->vert.back().Q() = f.cV(0)->Q()*p[0] + f.cV(1)->Q()*p[1] + f.cV(2)->Q()*p[2];
+      v.Q() = f.cV(0)->cQ()*p[0] + f.cV(1)->cQ()*p[1] + f.cV(2)->cQ()*p[2];
   }
   void AddTextureSample(const CMeshO::FaceType &f, const CMeshO::CoordType &p, const Point2i &tp, float edgeDist)
   {
@@ -125,14 +137,20 @@ public:
 
 
 
+/* The distance samplers below do not query the closest point as soon as a
+ * sample is added: they keep the samples in a buffer and, when it is full,
+ * run its queries in parallel, each thread with its own marker. The results
+ * are then merged in the order in which the samples were added, so that the
+ * statistics are exactly the same of a serial run. flush() must be called
+ * after the sampling to process the last samples.
+ */
+static const std::size_t SAMPLER_BUFFER_SIZE = 1 << 16;
+
 /* This sampler is used to transfer the detail of a mesh onto another one.
  * It keep internally the spatial indexing structure used to find the closest point
  */
 class LocalRedetailSampler
 {
-  typedef GridStaticPtr<CMeshO::FaceType, CMeshO::ScalarType > MetroMeshGrid;
-  typedef GridStaticPtr<CMeshO::VertexType, CMeshO::ScalarType > VertexMeshGrid;
-
 public:
 
   LocalRedetailSampler():m(0) {}
@@ -141,13 +159,8 @@ public:
   CallBackPos *cb;
   int sampleNum;  // the expected number of samples. Used only for the callback
   int sampleCnt;
-  MetroMeshGrid   unifGridFace;
-  VertexMeshGrid   unifGridVert;
-  bool useVertexSampling;
-
-  // Parameters
-  typedef tri::FaceTmark<CMeshO> MarkerFace;
-  MarkerFace markerFunctor;
+  std::unique_ptr<ClosestPointSearch> search;
+  std::vector<CMeshO::VertexType*> pending;
 
   bool coordFlag;
   bool colorFlag;
@@ -156,7 +169,7 @@ public:
   bool selectionFlag;
   bool storeDistanceAsQualityFlag;
   float dist_upper_bound;
-  void init(CMeshO *_m, CallBackPos *_cb=0, int targetSz=0)
+  void init(CMeshO *_m, CallBackPos *_cb=0, int targetSz=0, ClosestPointSearch::IndexType index=ClosestPointSearch::UNIFORM_GRID)
   {
     coordFlag=false;
     colorFlag=false;
@@ -165,35 +178,46 @@ public:
     storeDistanceAsQualityFlag=false;
     m=_m;
     tri::UpdateNormal<CMeshO>::PerFaceNormalized(*m);
-    if(m->fn==0) useVertexSampling = true;
-    else useVertexSampling = false;
-
-    if(useVertexSampling) unifGridVert.Set(m->vert.begin(),m->vert.end());
-    else  unifGridFace.Set(m->face.begin(),m->face.end());
-    markerFunctor.SetMesh(m);
+    search.reset(new ClosestPointSearch(*m, index));
     // sampleNum and sampleCnt are used only for the progress callback.
     cb=_cb;
     sampleNum = targetSz;
     sampleCnt = 0;
   }
 
-  // this function is called for each vertex of the target mesh.
-  // and retrieve the closest point on the source mesh.
+  // this function is called for each vertex of the target mesh;
+  // the closest point on the source mesh is retrieved by flush().
   void AddVert(CMeshO::VertexType &p)
   {
     assert(m);
-    // the results
-    Point3m       closestPt,      normf, bestq, ip;
-    CMeshO::ScalarType dist = dist_upper_bound;
-    const CMeshO::CoordType &startPt= p.cP();
+    pending.push_back(&p);
+    if (pending.size() == SAMPLER_BUFFER_SIZE)
+      flush();
+  }
+
+  void flush()
+  {
+#pragma omp parallel
+    {
+      ClosestPointSearch::Marker marker;
+#pragma omp for schedule(dynamic, 256)
+      for (int i = 0; i < (int) pending.size(); ++i)
+        transfer(*pending[i], marker);
+    }
+    sampleCnt += (int) pending.size();
+    if(cb && sampleNum > 0) cb(sampleCnt*100/sampleNum,"Resampling Vertex attributes");
+    pending.clear();
+  }
+
+  void transfer(CMeshO::VertexType &p, ClosestPointSearch::Marker &marker)
+  {
     // compute distance between startPt and the mesh S2
-    if(useVertexSampling)
+    ClosestPointSearch::Result res = search->closest(p.cP(), dist_upper_bound, marker);
+    if(search->usesVertices())
     {
-      CMeshO::VertexType   *nearestV=0;
-      nearestV =  tri::GetClosestVertex<CMeshO,VertexMeshGrid>(*m,unifGridVert,startPt,dist_upper_bound,dist); //(PDistFunct,markerFunctor,startPt,dist_upper_bound,dist,closestPt);
-      if(cb) cb(sampleCnt++*100/sampleNum,"Resampling Vertex attributes");
-      if(storeDistanceAsQualityFlag)  p.Q() = dist;
-      if(dist == dist_upper_bound) return ;
+      CMeshO::VertexType *nearestV = res.vert;
+      if(storeDistanceAsQualityFlag)  p.Q() = res.dist;
+      if(!res.found()) return ;
 
       if(coordFlag) p.P()=nearestV->P();
       if(colorFlag) p.C() = nearestV->C();
@@ -203,12 +227,9 @@ public:
     }
     else
     {
-      CMeshO::FaceType   *nearestF=0;
-      vcg::face::PointDistanceBaseFunctor<CMeshO::ScalarType> PDistFunct;
-      dist=dist_upper_bound;
-      if(cb) cb(sampleCnt++*100/sampleNum,"Resampling Vertex attributes");
-      nearestF =  unifGridFace.GetClosest(PDistFunct,markerFunctor,startPt,dist_upper_bound,dist,closestPt);
-      if(dist == dist_upper_bound) return ;
+      CMeshO::FaceType *nearestF = res.face;
+      const Point3m &closestPt = res.point;
+      if(!res.found()) return ;
 
       Point3m interp;
       InterpolationParameters(*nearestF,(*nearestF).cN(),closestPt, interp);
@@ -232,27 +253,21 @@ public:
 // it is very similar to the hausdorff sampler, but more immediate to use
 class SimpleDistanceSampler
 {
-	typedef GridStaticPtr<CMeshO::FaceType, CMeshO::ScalarType > MetroMeshFaceGrid;
-	typedef GridStaticPtr<CMeshO::VertexType, CMeshO::ScalarType > MetroMeshVertexGrid;
-
 public:
 
-	SimpleDistanceSampler(CMeshO* _m, bool signedDist, double maxd) :markerFunctor(_m)
+	SimpleDistanceSampler(CMeshO* _m, bool signedDist, double maxd, ClosestPointSearch::IndexType index = ClosestPointSearch::UNIFORM_GRID)
 	{
 		m = _m;
 		useSigned = signedDist;
 		maxDistABS = maxd;
-		init();
+		init(index);
 	}
 
 	CMeshO *m;           /// the reference mesh
 
-	MetroMeshVertexGrid   unifGridVert;
-	MetroMeshFaceGrid     unifGridFace;
-
-	bool useVertexSampling;
-	CMeshO::ScalarType dist_upper_bound;  // samples that have a distance beyond this threshold distance are not considered.
-	tri::FaceTmark<CMeshO> markerFunctor;
+	std::unique_ptr<ClosestPointSearch> search;
+	std::vector<CMeshO::VertexType*> pending;
+	std::vector<char> pendingFound;
 
 	bool useSigned;
 	double maxDistABS;
@@ -269,19 +284,10 @@ public:
 	float getMaxDist() const  { return max_dist; }
 	float getRMSDist() const  { return sqrt(RMS_dist / n_total_samples); }
 
-	void init()
+	void init(ClosestPointSearch::IndexType index)
 	{
-		if (m->fn == 0) // if no faces, we can only use points
-		{
-			useVertexSampling = true;
-			unifGridVert.Set(m->vert.begin(), m->vert.end());
-		}
-		else 
-		{
-			useVertexSampling = false;
-			unifGridFace.Set(m->face.begin(), m->face.end());
-			markerFunctor.SetMesh(m);
-		}
+		// if no faces, the search is on the vertices
+		search.reset(new ClosestPointSearch(*m, index));
 
 		min_dist = std::numeric_limits<double>::max();
 		max_dist = std::numeric_limits<double>::min();
@@ -290,55 +296,191 @@ public:
 		n_total_samples = 0;
 	}
 
+	// the distance is stored in the quality of the vertex by flush()
 	void AddVert(CMeshO::VertexType &p)
 	{
-		p.Q() = AddSample(p.cP(), p.cN());
+		pending.push_back(&p);
+		if (pending.size() == SAMPLER_BUFFER_SIZE)
+			flush();
 	}
 
-	float AddSample(const CMeshO::CoordType &startPt, const CMeshO::CoordType &startN)
+	void flush()
 	{
-		// the results
-		CMeshO::CoordType closestPt;
-		CMeshO::CoordType closestNm;
-		CMeshO::ScalarType dist = dist_upper_bound;
+		pendingFound.resize(pending.size());
+#pragma omp parallel
+		{
+			ClosestPointSearch::Marker marker;
+#pragma omp for schedule(dynamic, 256)
+			for (int i = 0; i < (int) pending.size(); ++i) {
+				bool found;
+				pending[i]->Q() = distance(pending[i]->cP(), marker, found);
+				pendingFound[i] = found;
+			}
+		}
+
+		// merged in the order of the samples
+		for (std::size_t i = 0; i < pending.size(); ++i) {
+			if (!pendingFound[i])
+				continue;
+			CMeshO::ScalarType dist = pending[i]->Q();
+			if (dist > max_dist) max_dist = dist;
+			if (dist < min_dist) min_dist = dist;
+
+			mean_dist += dist;
+			RMS_dist += dist*dist;
+			n_total_samples++;
+		}
+		pending.clear();
+	}
 
+	float distance(const CMeshO::CoordType &startPt, ClosestPointSearch::Marker &marker, bool &found)
+	{
 		// compute distance between startPt and the mesh S2
-		CMeshO::FaceType   *nearestF = 0;
-		CMeshO::VertexType *nearestV = 0;
-		vcg::face::PointDistanceBaseFunctor<CMeshO::ScalarType> PDistFunct;
+		ClosestPointSearch::Result res = search->closest(startPt, maxDistABS, marker);
+		found = res.found();
+		if (!found) return (maxDistABS*2.0);
 
-		if (useVertexSampling)
-		{
-			nearestV = tri::GetClosestVertex<CMeshO, MetroMeshVertexGrid>(*m, unifGridVert, startPt, maxDistABS, dist);
-			if (nearestV == NULL) return (maxDistABS*2.0);
+		CMeshO::CoordType closestNm = search->usesVertices() ? res.vert->N() : res.face->N();
+		CMeshO::ScalarType dist = res.dist;
 
-			closestPt = nearestV->P();
-			closestNm = nearestV->N();
-		}
-		else
+		// check sign of distance
+		if ((useSigned) && (((startPt - res.point).Normalize()*(closestNm)) < 0.0))
 		{
-			nearestF = unifGridFace.GetClosest(PDistFunct, markerFunctor, startPt, maxDistABS, dist, closestPt);
-			if (nearestF == NULL) return (maxDistABS*2.0);
+			dist = -dist;
+		}
+		return dist;
+	}
+};
+
+//--------------------------------------------------------------------
+// the hausdorff sampler of vcg (tri::HausdorffSampler), with the queries run in parallel
+class HausdorffDistanceSampler
+{
+public:
+
+	HausdorffDistanceSampler(CMeshO* _m, ClosestPointSearch::IndexType index = ClosestPointSearch::UNIFORM_GRID)
+	{
+		m = _m;
+		searchIndex = index;
+		init();
+	}
+
+	CMeshO *m;
+	CMeshO *samplePtMesh;
+	CMeshO *closestPtMesh;
+
+	std::unique_ptr<ClosestPointSearch> search;
+	ClosestPointSearch::IndexType searchIndex;
 
-			closestNm = nearestF->N();
+	struct Sample
+	{
+		CMeshO::CoordType p;
+		CMeshO::CoordType n;
+		CMeshO::VertexType *v;  // the sampled vertex, that gets the distance as quality
+		ClosestPointSearch::Result closest;
+	};
+	std::vector<Sample> pending;
+
+	double          min_dist;
+	double          max_dist;
+	double          mean_dist;
+	double          RMS_dist;   /// from the wikipedia definition RMS DIST is sqrt(Sum(distances^2)/n), here we store Sum(distances^2)
+	Histogramf hist;
+	int             n_total_samples;
+	CMeshO::ScalarType dist_upper_bound;  // samples that have a distance beyond this threshold distance are not considered.
+
+	float getMeanDist() const { return mean_dist / n_total_samples; }
+	float getMinDist() const  { return min_dist; }
+	float getMaxDist() const  { return max_dist; }
+	float getRMSDist() const  { return sqrt(RMS_dist / n_total_samples); }
+
+	void init(CMeshO *_sampleMesh=0, CMeshO *_closestMesh=0)
+	{
+		samplePtMesh = _sampleMesh;
+		closestPtMesh = _closestMesh;
+		if (!search)
+		{
+			tri::UpdateNormal<CMeshO>::PerFaceNormalized(*m);
+			search.reset(new ClosestPointSearch(*m, searchIndex));
+			hist.SetRange(0.0, m->bbox.Diag()/100.0, 100);
 		}
+		min_dist = std::numeric_limits<double>::max();
+		max_dist = 0;
+		mean_dist = 0;
+		RMS_dist = 0;
+		n_total_samples = 0;
+	}
 
-		// check sign of distance
-		if ((useSigned) && (((startPt - closestPt).Normalize()*(closestNm)) < 0.0))
+	void AddFace(const CMeshO::FaceType &f, CMeshO::CoordType interp)
+	{
+		CMeshO::CoordType startPt = f.cP(0)*interp[0] + f.cP(1)*interp[1] + f.cP(2)*interp[2]; // point to be sampled
+		CMeshO::CoordType startN = f.cV(0)->cN()*interp[0] + f.cV(1)->cN()*interp[1] + f.cV(2)->cN()*interp[2]; // Normal of the interpolated point
+		AddSample(startPt, startN, 0);
+	}
+
+	// the distance is stored in the quality of the vertex by flush()
+	void AddVert(CMeshO::VertexType &p)
+	{
+		AddSample(p.cP(), p.cN(), &p);
+	}
+
+	void AddSample(const CMeshO::CoordType &startPt, const CMeshO::CoordType &startN, CMeshO::VertexType *v)
+	{
+		Sample s;
+		s.p = startPt;
+		s.n = startN;
+		s.v = v;
+		pending.push_back(s);
+		if (pending.size() == SAMPLER_BUFFER_SIZE)
+			flush();
+	}
+
+	void flush()
+	{
+#pragma omp parallel
 		{
-			dist = -dist;
+			ClosestPointSearch::Marker marker;
+#pragma omp for schedule(dynamic, 256)
+			for (int i = 0; i < (int) pending.size(); ++i)
+				pending[i].closest = search->closest(pending[i].p, dist_upper_bound, marker);
 		}
 
-		if (dist > max_dist) max_dist = dist;
-		if (dist < min_dist) min_dist = dist;
+		// merged in the order of the samples
+		for (const Sample &s : pending)
+		{
+			CMeshO::ScalarType dist = s.closest.dist;
+			if (s.v) s.v->Q() = dist;
 
-		mean_dist += dist;	       
-		RMS_dist += dist*dist;     
-		n_total_samples++;
+			// update distance measures
+			if (!s.closest.found())
+				continue;
 
-		return dist;
+			if (dist > max_dist) max_dist = dist;        // L_inf
+			if (dist < min_dist) min_dist = dist;        // L_inf
+
+			mean_dist += dist;          // L_1
+			RMS_dist  += dist*dist;     // L_2
+			n_total_samples++;
+
+			hist.Add((float)fabs(dist));
+			if (samplePtMesh)
+			{
+				tri::Allocator<CMeshO>::AddVertices(*samplePtMesh,1);
+				samplePtMesh->vert.back().P() = s.p;
+				samplePtMesh->vert.back().Q() = dist;
+				samplePtMesh->vert.back().N() = s.n;
+			}
+			if (closestPtMesh)
+			{
+				tri::Allocator<CMeshO>::AddVertices(*closestPtMesh,1);
+				closestPtMesh->vert.back().P() = s.closest.point;
+				closestPtMesh->vert.back().Q() = dist;
+				closestPtMesh->vert.back().N() = s.n;
+			}
+		}
+		pending.clear();
 	}
-}; 
+};
 
 //--------------------------------------------------------------------
 
@@ -530,6 +672,27 @@ int FilterDocSampling::getRequirements(const QAction *action)
   return 0;
 }
 
+// the parameter that selects the spatial index of the closest point searches
+static RichEnum spatialIndexParameter()
+{
+	return RichEnum("SpatialIndex", 0, ClosestPointSearch::indexNames(), QObject::tr("Spatial Index"),
+		QObject::tr("The spatial index used to search the closest points. The <b>BVH</b> adapts to the size of the faces: "
+		"it gives the same results of the <b>Uniform Grid</b>, and it is usually faster on meshes with faces of very different sizes "
+		"(e.g. scans compared against CAD models). The build and search times are written in the log."));
+}
+
+static int randomSeed(int seed)
+{
+	return seed != 0 ? seed : (int) time(NULL);
+}
+
+static RichInt randomSeedParameter()
+{
+	return RichInt("RandomSeed", 0, "Random Seed",
+		"The seed of the random numbers used by the sampling: with the same seed the samples are always the same, "
+		"whatever the number of threads. If 0 the seed is tied to the current clock; the seed used is written in the log.");
+}
+
 // This function define the needed parameters for each filter. Return true if the filter has some parameters
 // it is called every time, so you can set the default value of parameters according to the mesh
 // For each parameter you need to define,
@@ -559,6 +722,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
     parlst.addParam(RichBool("EdgeSampling",  false,
                                  "Sample CreaseEdge Only",
                                  "Restrict the sampling process to the crease edges only. Useful to sample in a more accurate way the feature edges of a mechanical mesh."));
+    parlst.addParam(randomSeedParameter());
     break;
   case FP_STRATIFIED_SAMPLING :
     parlst.addParam(RichInt ("SampleNum",  std::max(100000,md.mm()->cm.vn),
@@ -577,6 +741,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
     parlst.addParam(RichBool("Random", false,
                                  "Random Sampling",
                                  "if true, for each (virtual) face we draw a random point, otherwise we pick the face midpoint."));
+    parlst.addParam(randomSeedParameter());
     break;
   case FP_CLUSTERED_SAMPLING :{
     float maxVal = md.mm()->cm.bbox.Diag();
@@ -622,6 +787,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
     parlst.addParam(RichInt("BestSamplePool", 10, "Best Sample Pool Size", "Used only if the Best Sample Flag is true. It control the number of attempt that it makes to get the best sample. It is reasonable that it is smaller than the Montecarlo oversampling factor."));
     parlst.addParam(RichBool("ExactNumFlag", false, "Exact number of samples", "If requested it will try to do a dicotomic search for the best poisson disk radius that will generate the requested number of samples with a tolerance of the 0.5%. Obviously it takes much longer."));
     parlst.addParam(RichFloat("RadiusVariance", 1, "Radius Variance", "The radius of the disk is allowed to vary between r and r*var. If this parameter is 1 the sampling is the same of the Poisson Disk Sampling"));
+    parlst.addParam(randomSeedParameter());
     break;
 
   case FP_TEXEL_SAMPLING :
@@ -664,6 +830,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
 			"The desired number of samples. It can be smaller or larger than the mesh size, and according to the chosen sampling strategy it will try to adapt."));
 		parlst.addParam(RichAbsPerc("MaxDist", md.mm()->cm.bbox.Diag() / 2.0, 0.0f, md.bbox().Diag(),
 			tr("Max Distance"), tr("Sample points for which we do not find anything within this distance are rejected and not considered neither for averaging nor for max.")));
+		parlst.addParam(spatialIndexParameter());
 	} break;
 
 	case FP_DISTANCE_REFERENCE:
@@ -686,6 +853,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
 
 		parlst.addParam(RichAbsPerc("MaxDist", md.mm()->cm.bbox.Diag(), 0.0f, md.bbox().Diag(),
 			tr("Max Distance [abs]"), tr("Search is interrupted when nothing is found within this distance range [+maxDistance -maxDistance].")));
+		parlst.addParam(spatialIndexParameter());
   } break;
 
 	case FP_VERTEX_RESAMPLING:
@@ -716,6 +884,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
     parlst.addParam(RichAbsPerc("UpperBound", md.mm()->cm.bbox.Diag()/50.0, 0.0f, md.mm()->cm.bbox.Diag(),
                                     tr("Max Dist Search"), tr("Sample points for which we do not find anything within this distance are rejected and not considered for recovering attributes.")));
     parlst.addParam(RichBool ("onSelected", false, "Only on selection",	"If checked, only transfer to selected vertices on TARGET mesh"));
+    parlst.addParam(spatialIndexParameter());
 
   } break;
   case FP_UNIFORM_MESH_RESAMPLING :
@@ -742,6 +911,7 @@ RichParameterList FilterDocSampling::initParameterList(const QAction *action, co
                                   "If true a <b> not</b> signed distance field is computed. "
                                   "In this case you have to choose a not zero Offset and a double surface is built around the original surface, inside and outside. "
                                   "Is useful to convert thin floating surfaces into <i> solid, thick meshes.</i>. t"));
+    parlst.addParam(spatialIndexParameter());
   } break;
 
 	case FP_VORONOI_COLORING :
@@ -865,20 +1035,40 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 			log("Montecarlo Sampling requires a mesh with faces, it does not work on Point Clouds");
 			throw MLException("Montecarlo Sampling requires a mesh with faces,<br> it does not work on Point Clouds");
 		}
-		if (par.getInt("SampleNum") == 0) {
-			log("Montecarlo Sampling: Number of Samples is 0, cannot do anything");
-			throw MLException("Number of Samples is 0, cannot do anything");
+		if (par.getInt("SampleNum") <= 0) {
+			log("Montecarlo Sampling: Number of Samples must be greater than 0, cannot do anything");
+			throw MLException("Number of Samples must be greater than 0, cannot do anything");
 		}
 		if (par.getBool("Weighted") && !curMM->hasDataMask(MeshModel::MM_VERTQUALITY)) {
 			log("Montecarlo Sampling: cannot do weighted samplimg, layer has no Vertex Quality value");
 			throw MLException("Cannot do weighted samplimg, layer has no Vertex Quality value");
 		}
+		const std::size_t sampleNum = par.getInt("SampleNum");
+
+		QElapsedTimer timer;
+		timer.start();
+		// the face weights are computed before creating the layer, to refuse
+		// meshes where no face can be sampled
+		std::vector<double> cdf;
+		if (!par.getBool("EdgeSampling")) {
+			if (par.getBool("Weighted"))
+				cdf = ParallelSampling::weightedAreaCDF(curMM->cm, par.getFloat("RadiusVariance"));
+			else
+				cdf = ParallelSampling::areaCDF(curMM->cm);
+			if (!(cdf.back() > 0)) {
+				log("Montecarlo Sampling: the faces of the mesh have zero area, cannot do anything");
+				throw MLException("The faces of the mesh have zero area, cannot do anything");
+			}
+		}
 		
 		MeshModel *mm= md.addNewMesh("","Montecarlo Samples", true); // The new mesh is the current one
 		mm->updateDataMask(curMM);
 		BaseSampler mps(&(mm->cm));
 		
 		mps.perFaceNormal = par.getBool("PerFaceNormal");
+		const int seed = randomSeed(par.getInt("RandomSeed"));
+		if(!par.getBool("EdgeSampling"))
+			log("Random seed: %i", seed);
 		
 		if(par.getBool("EdgeSampling"))
 		{
@@ -886,16 +1076,32 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		}
 		else
 		{
+			// the samples are generated in parallel and written in vertices
+			// allocated in advance, in the order of their index
+			auto store = [&](std::size_t i, const CFaceO& f, const Point3m& p) {
+				mps.SetFaceSample(mm->cm.vert[i], f, p);
+			};
 			if(par.getBool("Weighted"))
-				tri::SurfaceSampling<CMeshO,BaseSampler>::WeightedMontecarlo(curMM->cm,mps,par.getInt("SampleNum"),par.getFloat("RadiusVariance"));
-			else if(par.getBool("ExactNum")) 
-				tri::SurfaceSampling<CMeshO,BaseSampler>::Montecarlo(curMM->cm,mps,par.getInt("SampleNum"));
-			else 
-				tri::SurfaceSampling<CMeshO,BaseSampler>::MontecarloPoisson(curMM->cm,mps,par.getInt("SampleNum"));
+			{
+				std::vector<std::size_t> offsets = ParallelSampling::proportionalOffsets(cdf, sampleNum);
+				tri::Allocator<CMeshO>::AddVertices(mm->cm, offsets.back());
+				ParallelSampling::faceMontecarlo(curMM->cm, offsets, seed, store);
+			}
+			else if(par.getBool("ExactNum"))
+			{
+				tri::Allocator<CMeshO>::AddVertices(mm->cm, sampleNum);
+				ParallelSampling::montecarlo(curMM->cm, cdf, sampleNum, seed, store);
+			}
+			else
+			{
+				std::vector<std::size_t> offsets = ParallelSampling::poissonOffsets(cdf, sampleNum, seed);
+				tri::Allocator<CMeshO>::AddVertices(mm->cm, offsets.back());
+				ParallelSampling::faceMontecarlo(curMM->cm, offsets, seed, store);
+			}
 		}
 		
 		vcg::tri::UpdateBounding<CMeshO>::Box(mm->cm);
-		log("Sampling created a new mesh of %i points", mm->cm.vn);
+		log("Sampling created a new mesh of %i points in %.3f sec", mm->cm.vn, timer.elapsed() / 1000.0);
 	} break;
 		
 	case FP_STRATIFIED_SAMPLING :
@@ -905,9 +1111,17 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 			log("Stratified Sampling requires a mesh with faces, it does not work on Point Clouds");
 			throw MLException("Stratified Sampling requires a mesh with faces,<br> it does not work on Point Clouds");
 		}
-		if (par.getInt("SampleNum") == 0) {
-			log("Stratified Sampling: Number of Samples is  0, cannot do anything");
-			throw MLException("Number of Samples is  0, cannot do anything");
+		if (par.getInt("SampleNum") <= 0) {
+			log("Stratified Sampling: Number of Samples must be greater than 0, cannot do anything");
+			throw MLException("Number of Samples must be greater than 0, cannot do anything");
+		}
+		std::vector<double> cdf;
+		if (par.getEnum("Sampling") <= 1) {
+			cdf = ParallelSampling::areaCDF(curMM->cm);
+			if (!(cdf.back() > 0)) {
+				log("Stratified Sampling: the faces of the mesh have zero area, cannot do anything");
+				throw MLException("The faces of the mesh have zero area, cannot do anything");
+			}
 		}
 		
 		MeshModel *mm= md.addNewMesh("","Subdiv Samples", true); // The new mesh is the current one
@@ -917,13 +1131,21 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		switch(samplingMethod)
 		{
 		case 0:
-			tri::SurfaceSampling<CMeshO,BaseSampler>::FaceSimilar(curMM->cm,mps,par.getInt("SampleNum"), false ,par.getBool("Random"));
-			log("Similar Sampling created a new mesh of %i points", mm->cm.vn);
-			break;
 		case 1:
-			tri::SurfaceSampling<CMeshO,BaseSampler>::FaceSimilar(curMM->cm,mps,par.getInt("SampleNum"), true ,par.getBool("Random"));
-			log("Dual Similar Sampling created a new mesh of %i points", mm->cm.vn);
-			break;
+		{
+			const bool dual = samplingMethod == 1;
+			const int seed = randomSeed(par.getInt("RandomSeed"));
+			if (par.getBool("Random"))
+				log("Random seed: %i", seed);
+			QElapsedTimer timer;
+			timer.start();
+			std::vector<std::size_t> offsets = ParallelSampling::similarOffsets(
+				ParallelSampling::proportionalOffsets(cdf, par.getInt("SampleNum")), dual);
+			tri::Allocator<CMeshO>::AddVertices(mm->cm, offsets.back());
+			ParallelSampling::faceSimilar(curMM->cm, offsets, dual, par.getBool("Random"), seed,
+				[&](std::size_t i, const CFaceO& f, const Point3m& p) { mps.SetFaceSample(mm->cm.vert[i], f, p); });
+			log("%s Sampling created a new mesh of %i points in %.3f sec", dual ? "Dual Similar" : "Similar", mm->cm.vn, timer.elapsed() / 1000.0);
+		} break;
 		case 2:	
 			tri::SurfaceSampling<CMeshO,BaseSampler>::FaceSubdivision(curMM->cm,mps,par.getInt("SampleNum"), par.getBool("Random"));
 			log("Subdivision Sampling created a new mesh of %i points", mm->cm.vn);
@@ -1024,8 +1246,8 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		MeshModel *curMM= md.mm();
 		CMeshO::ScalarType radius = par.getAbsPerc("Radius");
 		int sampleNum = par.getInt("SampleNum");
-		tri::SurfaceSampling<CMeshO, BaseSampler>::PoissonDiskParam pp;
-		pp.radiusVariance = par.getFloat("RadiusVariance");
+		ParallelPoissonDisk::Param pdp;
+		pdp.radiusVariance = par.getFloat("RadiusVariance");
 		bool subsampleFlag = par.getBool("Subsample");
 		
 		if ((radius == 0.0) && (sampleNum == 0)){
@@ -1038,14 +1260,14 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		else
 			sampleNum = tri::SurfaceSampling<CMeshO, BaseSampler>::ComputePoissonSampleNum(curMM->cm, radius);
 		
-		if (pp.radiusVariance != 1.0)
+		if (pdp.radiusVariance != 1.0)
 		{
 			if (!curMM->hasDataMask(MeshModel::MM_VERTQUALITY)) {
 				log("Poisson disk Sampling: Variable radius requires per-Vertex quality for biasing the distribution");
 				throw MLException("Variable radius requires per-Vertex Quality for biasing the distribution");
 			}
-			pp.adaptiveRadiusFlag = true;
-			log("Variable Density variance is %f, radius can vary from %f to %f", pp.radiusVariance, radius / pp.radiusVariance, radius*pp.radiusVariance);
+			pdp.adaptiveRadiusFlag = true;
+			log("Variable Density variance is %f, radius can vary from %f to %f", pdp.radiusVariance, radius / pdp.radiusVariance, radius*pdp.radiusVariance);
 		}
 		
 		if (curMM->cm.fn == 0 && subsampleFlag == false)
@@ -1079,33 +1301,69 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 			QElapsedTimer tt;tt.start();
 			BaseSampler sampler(presampledMesh);
 			sampler.qualitySampling=true;
-			if(pp.adaptiveRadiusFlag)
-				tri::SurfaceSampling<CMeshO,BaseSampler>::WeightedMontecarlo(curMM->cm, sampler, sampleNum*par.getInt("MontecarloRate"),pp.radiusVariance);
+			const int seed = randomSeed(par.getInt("RandomSeed"));
+			log("Random seed: %i", seed);
+			const std::size_t montecarloNum = (std::size_t) sampleNum * par.getInt("MontecarloRate");
+			auto store = [&](std::size_t i, const CFaceO& f, const Point3m& p) {
+				sampler.SetFaceSample(presampledMesh->vert[i], f, p);
+			};
+			if(pdp.adaptiveRadiusFlag)
+			{
+				std::vector<std::size_t> offsets = ParallelSampling::proportionalOffsets(
+					ParallelSampling::weightedAreaCDF(curMM->cm, pdp.radiusVariance), montecarloNum);
+				tri::Allocator<CMeshO>::AddVertices(*presampledMesh, offsets.back());
+				ParallelSampling::faceMontecarlo(curMM->cm, offsets, seed, store);
+			}
 			else
-				tri::SurfaceSampling<CMeshO,BaseSampler>::Montecarlo(curMM->cm, sampler, sampleNum*par.getInt("MontecarloRate"));
+			{
+				// no sample is drawn when all the faces have zero area
+				std::vector<double> cdf = ParallelSampling::areaCDF(curMM->cm);
+				if (cdf.back() > 0)
+					tri::Allocator<CMeshO>::AddVertices(*presampledMesh, montecarloNum);
+				ParallelSampling::montecarlo(curMM->cm, cdf, montecarloNum, seed, store);
+			}
 			presampledMesh->bbox = curMM->cm.bbox; // we want the same bounding box
 			log("Generated %i Montecarlo Samples (%i msec)",presampledMesh->vn,tt.elapsed());
 		}
 		
-		BaseSampler mps(&(mm->cm));
 		if(par.getBool("RefineFlag"))
-		{
-			pp.preGenFlag=true;
-			pp.preGenMesh=&(md.getMesh(par.getMeshId("RefineMesh"))->cm);
-		}
-		pp.geodesicDistanceFlag=par.getBool("ApproximateGeodesicDistance");
-		pp.bestSampleChoiceFlag=par.getBool("BestSampleFlag");
-		pp.bestSamplePoolSize =par.getInt("BestSamplePool");
+			pdp.preGenMesh=&(md.getMesh(par.getMeshId("RefineMesh"))->cm);
+		pdp.geodesicDistanceFlag=par.getBool("ApproximateGeodesicDistance");
+		pdp.bestSampleChoiceFlag=par.getBool("BestSampleFlag");
+		pdp.bestSamplePoolSize =par.getInt("BestSamplePool");
+		
+		QElapsedTimer pruningTime;
+		pruningTime.start();
+		ParallelPoissonDisk pd(*presampledMesh, pdp);
+		ParallelPoissonDisk::Stats stats;
+		std::vector<int> samples;
 		if(par.getBool("ExactNumFlag"))
-			tri::SurfaceSampling<CMeshO,BaseSampler>::PoissonDiskPruningByNumber(mps, *presampledMesh, sampleNum, radius,pp,0.005);
+			samples = pd.pruneByNumber(sampleNum, radius, 0.005, stats);
 		else
-			tri::SurfaceSampling<CMeshO,BaseSampler>::PoissonDiskPruning(mps, *presampledMesh, radius,pp);
+			samples = pd.prune(radius, stats);
+		
+		// the samples of the refined mesh come first, as they are kept
+		int preGenNum = 0;
+		if(pdp.preGenMesh != nullptr)
+		{
+			BaseSampler mps(&(mm->cm));
+			for(const CVertexO& v : pdp.preGenMesh->vert)
+				if(!v.IsD()) { mps.AddVert(v); ++preGenNum; }
+		}
+		tri::Allocator<CMeshO>::AddVertices(mm->cm, samples.size());
+		#pragma omp parallel for schedule(static)
+		for(int i = 0; i < (int) samples.size(); ++i)
+			mm->cm.vert[preGenNum + i].ImportData(presampledMesh->vert[samples[i]]);
 		
-		//tri::SurfaceSampling<CMeshO,BaseSampler>::PoissonDisk(curMM->cm, mps, *presampledMesh, radius,pp);
 		vcg::tri::UpdateBounding<CMeshO>::Box(mm->cm);
-		Point3i &g=pp.pds.gridSize;
-		log("Grid size was %i %i %i (%i allocated on %i)",g[0],g[1],g[2], pp.pds.gridCellNum, g[0]*g[1]*g[2]);
-		log("Poisson Disk Sampling created a new mesh of %i points", mm->cm.vn);
+		Point3i &g=stats.gridSize;
+		log("Grid size was %i %i %i (%i allocated on %i)",g[0],g[1],g[2], stats.cellNum, g[0]*g[1]*g[2]);
+		for(int i = 0; i < ParallelPoissonDisk::PHASE_NUM; ++i)
+		{
+			const ParallelPoissonDisk::PhaseStats &ps = stats.phases[i];
+			log("Phase %i: %i samples in %i cells (%.3f sec)", i, ps.sampleNum, ps.cellNum, ps.time);
+		}
+		log("Poisson Disk Sampling created a new mesh of %i points with radius %f (%i msec)", mm->cm.vn, radius, (int) pruningTime.elapsed());
 	} break;
 		
 	case FP_HAUSDORFF_DISTANCE :
@@ -1118,6 +1376,7 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		bool sampleFauxEdge=par.getBool("SampleFauxEdge");
 		bool sampleFace=par.getBool("SampleFace");
 		Scalarm distUpperBound = par.getAbsPerc("MaxDist");
+		ClosestPointSearch::IndexType searchIndex = ClosestPointSearch::IndexType(par.getEnum("SpatialIndex"));
 		
 		if (mm0 == mm1){
 			log("Hausdorff Distance: cannot compute, it is the same mesh");
@@ -1146,7 +1405,10 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		
 		MeshModel *samplePtMesh =0;
 		MeshModel *closestPtMesh =0;
-		vcg::tri::HausdorffSampler<CMeshO> hs(&(mm1->cm));
+		QElapsedTimer timer;
+		timer.start();
+		HausdorffDistanceSampler hs(&(mm1->cm), searchIndex);
+		qint64 buildTime = timer.restart();
 		if(saveSampleFlag)
 		{
 			closestPtMesh=md.addNewMesh("","Hausdorff Closest Points", false); // the new mesh is NOT the current one (byproduct of measurement)
@@ -1163,11 +1425,13 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		qDebug("Max sampling distance %f on a bbox diag of %f",distUpperBound,mm1->cm.bbox.Diag());
 		
 		if(sampleVert)
-			tri::SurfaceSampling<CMeshO,vcg::tri::HausdorffSampler<CMeshO> >::VertexUniform(mm0->cm,hs,par.getInt("SampleNum"));
+			tri::SurfaceSampling<CMeshO,HausdorffDistanceSampler>::VertexUniform(mm0->cm,hs,par.getInt("SampleNum"));
 		if(sampleEdge)
-			tri::SurfaceSampling<CMeshO,vcg::tri::HausdorffSampler<CMeshO> >::EdgeUniform(mm0->cm,hs,par.getInt("SampleNum"),sampleFauxEdge);
+			tri::SurfaceSampling<CMeshO,HausdorffDistanceSampler>::EdgeUniform(mm0->cm,hs,par.getInt("SampleNum"),sampleFauxEdge);
 		if(sampleFace)
-			tri::SurfaceSampling<CMeshO,vcg::tri::HausdorffSampler<CMeshO> >::Montecarlo(mm0->cm,hs,par.getInt("SampleNum"));
+			tri::SurfaceSampling<CMeshO,HausdorffDistanceSampler>::Montecarlo(mm0->cm,hs,par.getInt("SampleNum"));
+		hs.flush();
+		qint64 searchTime = timer.elapsed();
 		
 		// the meshes have to return to their original position
 		if (mm0->cm.Tr != Matrix44m::Identity())
@@ -1176,6 +1440,8 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 			tri::UpdatePosition<CMeshO>::Matrix(mm1->cm, Inverse(mm1->cm.Tr), true);
 		
 		log("Hausdorff Distance computed");
+		log("Spatial index (%s) built in %.3f sec, samples processed in %.3f sec",
+			qUtf8Printable(ClosestPointSearch::indexNames()[searchIndex]), buildTime / 1000.0, searchTime / 1000.0);
 		log("     Sampled %i pts (rng: 0) on %s searched closest on %s",hs.n_total_samples,qUtf8Printable(mm0->label()),qUtf8Printable(mm1->label()));
 		log("     min : %f   max %f   mean : %f   RMS : %f",hs.getMinDist(),hs.getMaxDist(),hs.getMeanDist(),hs.getRMSDist());
 		float d = mm0->cm.bbox.Diag();
@@ -1207,6 +1473,7 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		MeshModel* mm1 = md.getMesh(par.getMeshId("RefMesh"));      // this is the reference mesh
 		bool useSigned = par.getBool("SignedDist");
 		Scalarm maxDistABS = par.getAbsPerc("MaxDist");
+		ClosestPointSearch::IndexType searchIndex = ClosestPointSearch::IndexType(par.getEnum("SpatialIndex"));
 		
 		if (mm0 == mm1){
 			log("Distance from Reference: cannot compute, it is the same mesh");
@@ -1229,9 +1496,14 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		}
 		mm1->updateDataMask(MeshModel::MM_FACEMARK);
 		
-		SimpleDistanceSampler ds(&(mm1->cm), useSigned, maxDistABS);
+		QElapsedTimer timer;
+		timer.start();
+		SimpleDistanceSampler ds(&(mm1->cm), useSigned, maxDistABS, searchIndex);
+		qint64 buildTime = timer.restart();
 		
 		tri::SurfaceSampling<CMeshO, SimpleDistanceSampler>::AllVertex(mm0->cm, ds);
+		ds.flush();
+		qint64 searchTime = timer.elapsed();
 		
 		// the meshes have to return to their original position
 		if (mm0->cm.Tr != Matrix44m::Identity())
@@ -1240,8 +1512,10 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 			tri::UpdatePosition<CMeshO>::Matrix(mm1->cm, Inverse(mm1->cm.Tr), true);
 		
 		log("Distance from Reference Mesh computed");
+		log("Spatial index (%s) built in %.3f sec, samples processed in %.3f sec",
+			qUtf8Printable(ClosestPointSearch::indexNames()[searchIndex]), buildTime / 1000.0, searchTime / 1000.0);
 		log("     Sampled %i vertices on %s searched closest on %s", mm0->cm.vn, qUtf8Printable(mm0->label()), qUtf8Printable(mm1->label()));
-		log("     min : %f   max %f   mean : %f   RMS : %f", ds.getMaxDist(), ds.getMaxDist(), ds.getMeanDist(), ds.getRMSDist());
+		log("     min : %f   max %f   mean : %f   RMS : %f", ds.getMinDist(), ds.getMaxDist(), ds.getMeanDist(), ds.getRMSDist());
 		
 	} break;
 		
@@ -1257,6 +1531,7 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		bool qualityT = par.getBool("QualityTransfer");
 		bool selectionT = par.getBool("SelectionTransfer");
 		bool distquality = par.getBool("QualityDistance");
+		ClosestPointSearch::IndexType searchIndex = ClosestPointSearch::IndexType(par.getEnum("SpatialIndex"));
 		
 		if (srcMesh == trgMesh){
 			log("Vertex Attribute Transfer: cannot compute, it is the same mesh");
@@ -1288,8 +1563,11 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		srcMesh->updateDataMask(MeshModel::MM_FACEMARK);
 		tri::UpdateNormal<CMeshO>::PerFaceNormalized(srcMesh->cm);
 		
+		QElapsedTimer timer;
+		timer.start();
 		LocalRedetailSampler rs;
-		rs.init(&(srcMesh->cm),cb,trgMesh->cm.vn);
+		rs.init(&(srcMesh->cm),cb,trgMesh->cm.vn,searchIndex);
+		qint64 buildTime = timer.restart();
 		
 		rs.dist_upper_bound = upperbound;
 		rs.colorFlag = colorT;
@@ -1307,6 +1585,10 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		qDebug("Target  mesh has %7i vert %7i face",trgMesh->cm.vn,trgMesh->cm.fn);
 		
 		tri::SurfaceSampling<CMeshO, LocalRedetailSampler>::VertexUniform(trgMesh->cm, rs, trgMesh->cm.vn, onlySelected);
+		rs.flush();
+		qint64 searchTime = timer.elapsed();
+		log("Spatial index (%s) built in %.3f sec, samples processed in %.3f sec",
+			qUtf8Printable(ClosestPointSearch::indexNames()[searchIndex]), buildTime / 1000.0, searchTime / 1000.0);
 		
 		if(rs.coordFlag) tri::UpdateNormal<CMeshO>::PerFaceNormalized(trgMesh->cm);
 		
@@ -1345,7 +1627,17 @@ std::map<std::string, QVariant> FilterDocSampling::applyFilter(
 		log("     VoxelSize is %f, offset is %f ", voxelSize,offsetThr);
 		log("     Mesh Box is %f %f %f",baseMesh->cm.bbox.DimX(),baseMesh->cm.bbox.DimY(),baseMesh->cm.bbox.DimZ() );
 		
-		tri::Resampler<CMeshO,CMeshO>::Resample(baseMesh->cm, offsetMesh->cm, volumeBox, volumeDim, voxelSize*3.5, offsetThr,discretizeFlag,multiSampleFlag,absDistFlag, cb);
+		NarrowBandResampler::Param rp;
+		rp.offset = offsetThr;
+		rp.discretizeFlag = discretizeFlag;
+		rp.multiSampleFlag = multiSampleFlag;
+		rp.absDistFlag = absDistFlag;
+		rp.index = ClosestPointSearch::IndexType(par.getEnum("SpatialIndex"));
+		NarrowBandResampler::Stats rs;
+		tri::UpdateNormal<CMeshO>::PerVertexNormalizedPerFaceNormalized(baseMesh->cm);
+		NarrowBandResampler::resample(baseMesh->cm, offsetMesh->cm, volumeBox, volumeDim, voxelSize*3.5 + std::abs(offsetThr), rp, rs, cb);
+		log("     Distance computed on %i blocks of %i, %i allocated (%.3f sec)", (int) rs.bandBlockNum, (int) rs.blockNum, (int) rs.allocatedBlockNum, rs.distanceTime);
+		log("     Marching cubes done in %.3f sec", rs.extractionTime);
 		tri::UpdateBounding<CMeshO>::Box(offsetMesh->cm);
 		if(mergeCloseVert)
 		{
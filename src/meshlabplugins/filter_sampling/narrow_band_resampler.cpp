@@ -0,0 +1,204 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "narrow_band_resampler.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <QElapsedTimer>
+
+#include <common/utilities/sparse_volume.h>
+#include <vcg/space/triangle3.h>
+
+namespace {
+
+const int B = meshlab::IsosurfaceField::BLOCK_SIZE;
+
+// the positions of the samples of a multisampled value, in cells
+const Scalarm MULTI_SAMPLE_DELTA[7][3] = {
+	{0, 0, 0},
+	{0.2, -0.01, -0.02},
+	{-0.2, 0.01, 0.02},
+	{0.01, 0.2, 0.01},
+	{0.03, -0.2, -0.03},
+	{-0.02, -0.03, 0.2},
+	{-0.01, 0.01, -0.2}};
+
+/**
+ * @brief The distance of p from the mesh, negative if p is behind the mesh
+ * (or its absolute value if absDist is true), or NaN if it is farther than
+ * maxDist.
+ */
+float signedDistance(
+	ClosestPointSearch&         search,
+	const Point3m&              p,
+	Scalarm                     maxDist,
+	bool                        absDist,
+	ClosestPointSearch::Marker& marker)
+{
+	const ClosestPointSearch::Result r = search.closest(p, maxDist, marker);
+	if (!r.found())
+		return std::numeric_limits<float>::quiet_NaN();
+	if (absDist)
+		return r.dist;
+
+	// the face normal does not tell the side of p if the closest point is on
+	// an edge or on a vertex: the vertex normals interpolated there are used
+	const CFaceO& f = *r.face;
+	Point3m bary;
+	vcg::InterpolationParameters(f, f.cN(), r.point, bary);
+	const Scalarm eps = 0.00001;
+	Point3m n = f.cN();
+	if (bary[0] < eps || bary[1] < eps || bary[2] < eps)
+		n = f.cV(0)->cN() * bary[0] + f.cV(1)->cN() * bary[1] + f.cV(2)->cN() * bary[2];
+	return (p - r.point) * n < 0 ? -r.dist : r.dist;
+}
+
+/**
+ * @brief the average of the absolute distances of 7 points around p, with
+ * the sign of the majority of them; NaN if any of them is farther than
+ * maxDist
+ */
+float multiSampleDistance(
+	ClosestPointSearch&         search,
+	const Point3m&              p,
+	const Point3m&              voxel,
+	Scalarm                     maxDist,
+	bool                        absDist,
+	ClosestPointSearch::Marker& marker)
+{
+	float sum = 0;
+	int positive = 0;
+	for (const Scalarm* delta : MULTI_SAMPLE_DELTA) {
+		const Point3m q(p[0] + delta[0] * voxel[0], p[1] + delta[1] * voxel[1], p[2] + delta[2] * voxel[2]);
+		const float d = signedDistance(search, q, maxDist, absDist, marker);
+		if (std::isnan(d))
+			return d;
+		sum += std::fabs(d);
+		if (d > 0)
+			++positive;
+	}
+	return (positive > 3 ? sum : -sum) / 7;
+}
+
+} // namespace
+
+void NarrowBandResampler::resample(
+	CMeshO&             m,
+	CMeshO&             out,
+	const Box3m&        box,
+	const vcg::Point3i& dim,
+	Scalarm             maxDist,
+	const Param&        par,
+	Stats&              stats,
+	vcg::CallBackPos*   cb)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const vcg::Point3i size(dim[0] + 1, dim[1] + 1, dim[2] + 1);
+	const Point3m voxel(box.DimX() / dim[0], box.DimY() / dim[1], box.DimZ() / dim[2]);
+	meshlab::SparseVolume volume(size, std::numeric_limits<float>::quiet_NaN());
+	const vcg::Point3i& nBlocks = volume.blockCount();
+	auto blockIndex = [&](int x, int y, int z) {
+		return ((std::size_t) z * nBlocks[1] + y) * nBlocks[0] + x;
+	};
+
+	// the blocks with samples in the bounding box of a face grown by maxDist
+	std::vector<char> inBand((std::size_t) nBlocks[0] * nBlocks[1] * nBlocks[2], 0);
+	for (const CFaceO& f : m.face) {
+		if (f.IsD())
+			continue;
+		Box3m fb;
+		for (int k = 0; k < 3; ++k)
+			fb.Add(f.cP(k));
+		fb.Offset(maxDist);
+		vcg::Point3i lo, hi;
+		for (int c = 0; c < 3; ++c) {
+			lo[c] = std::max(0, (int) std::ceil((fb.min[c] - box.min[c]) / voxel[c])) / B;
+			hi[c] = std::min(size[c] - 1, (int) std::floor((fb.max[c] - box.min[c]) / voxel[c]));
+			hi[c] = hi[c] < 0 ? -1 : hi[c] / B;
+		}
+		for (int z = lo[2]; z <= hi[2]; ++z)
+			for (int y = lo[1]; y <= hi[1]; ++y)
+				for (int x = lo[0]; x <= hi[0]; ++x)
+					inBand[blockIndex(x, y, z)] = 1;
+	}
+	std::vector<vcg::Point3i> band;
+	for (int z = 0; z < nBlocks[2]; ++z)
+		for (int y = 0; y < nBlocks[1]; ++y)
+			for (int x = 0; x < nBlocks[0]; ++x)
+				if (inBand[blockIndex(x, y, z)])
+					band.push_back(vcg::Point3i(x, y, z));
+	stats.blockNum = inBand.size();
+	stats.bandBlockNum = band.size();
+
+	// with discretizeFlag the samples only tell the side of the surface, so
+	// that the vertices are placed in the middle of the edges
+	const Scalarm step = voxel.Norm();
+	ClosestPointSearch search(m, par.index);
+
+	#pragma omp parallel
+	{
+		ClosestPointSearch::Marker marker;
+		std::vector<float> values(B * B * B);
+		#pragma omp for schedule(dynamic)
+		for (int b = 0; b < (int) band.size(); ++b) {
+			const vcg::Point3i o(band[b][0] * B, band[b][1] * B, band[b][2] * B);
+			const vcg::Point3i n(
+				std::min(B, size[0] - o[0]), std::min(B, size[1] - o[1]), std::min(B, size[2] - o[2]));
+			bool found = false;
+			int s = 0;
+			for (int k = o[2]; k < o[2] + n[2]; ++k)
+				for (int j = o[1]; j < o[1] + n[1]; ++j)
+					for (int i = o[0]; i < o[0] + n[0]; ++i) {
+						const Point3m p(
+							box.min[0] + i * voxel[0], box.min[1] + j * voxel[1], box.min[2] + k * voxel[2]);
+						float d = par.multiSampleFlag ?
+							multiSampleDistance(search, p, voxel, maxDist, par.absDistFlag, marker) :
+							signedDistance(search, p, maxDist, par.absDistFlag, marker);
+						if (!std::isnan(d)) {
+							found = true;
+							if (par.discretizeFlag)
+								d = d < par.offset ? par.offset - step : par.offset + step;
+						}
+						values[s++] = d;
+					}
+			if (!found)
+				continue;
+			s = 0;
+			for (int k = o[2]; k < o[2] + n[2]; ++k)
+				for (int j = o[1]; j < o[1] + n[1]; ++j)
+					for (int i = o[0]; i < o[0] + n[0]; ++i)
+						volume.value(i, j, k) = values[s++];
+		}
+	}
+	stats.allocatedBlockNum = volume.allocatedBlockCount();
+	stats.distanceTime = timer.nsecsElapsed() / 1e9;
+
+	timer.restart();
+	meshlab::extractIsosurface(out, volume, par.offset, box.min, voxel, cb);
+	stats.extractionTime = timer.nsecsElapsed() / 1e9;
+}
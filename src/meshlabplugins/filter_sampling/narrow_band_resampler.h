@@ -0,0 +1,89 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef FILTER_SAMPLING_NARROW_BAND_RESAMPLER_H
+#define FILTER_SAMPLING_NARROW_BAND_RESAMPLER_H
+
+#include <common/ml_document/cmesh.h>
+
+#include "closest_point_search.h"
+
+/**
+ * Rebuilds a mesh as an isosurface of its distance field, sampled on a
+ * regular grid: a replacement of vcg::tri::Resampler that stores the field
+ * in a meshlab::SparseVolume.
+ *
+ * As in vcg::tri::Resampler, the distance is computed only on the samples
+ * closer than maxDist to the mesh and the cells with a farther corner are
+ * skipped: only the blocks of the volume that can contain such samples (the
+ * ones touched by the bounding boxes of the faces grown by maxDist) are
+ * computed, in parallel, and only the blocks with some sample within
+ * maxDist are allocated.
+ */
+class NarrowBandResampler
+{
+public:
+	struct Param
+	{
+		/// the isosurface is the one at this distance from the mesh
+		Scalarm offset = 0;
+
+		/// the vertices are placed in the middle of the edges of the grid,
+		/// instead of interpolating the field
+		bool discretizeFlag = false;
+
+		/// the value of each sample is the average of 7 distances around it
+		bool multiSampleFlag = false;
+
+		/// the field is the unsigned distance
+		bool absDistFlag = false;
+
+		ClosestPointSearch::IndexType index = ClosestPointSearch::UNIFORM_GRID;
+	};
+
+	struct Stats
+	{
+		std::size_t blockNum          = 0; // blocks of the volume
+		std::size_t bandBlockNum      = 0; // blocks computed
+		std::size_t allocatedBlockNum = 0; // blocks with some sample within maxDist
+		double      distanceTime      = 0; // seconds
+		double      extractionTime    = 0; // seconds
+	};
+
+	/**
+	 * @brief Appends to out the resampled surface of m. The grid has dim[0] x
+	 * dim[1] x dim[2] cells spanning box. The face normals and the vertex
+	 * normals of m must be up to date.
+	 */
+	static void resample(
+		CMeshO&             m,
+		CMeshO&             out,
+		const Box3m&        box,
+		const vcg::Point3i& dim,
+		Scalarm             maxDist,
+		const Param&        par,
+		Stats&              stats,
+		vcg::CallBackPos*   cb = nullptr);
+};
+
+#endif // FILTER_SAMPLING_NARROW_BAND_RESAMPLER_H
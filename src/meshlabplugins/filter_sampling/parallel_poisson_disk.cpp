@@ -0,0 +1,387 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "parallel_poisson_disk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include <QElapsedTimer>
+
+namespace {
+
+/**
+ * @brief the euclidean distance weighted by a function of the difference
+ * between the normals of the two points, never smaller than the euclidean
+ * one
+ */
+Scalarm approximateGeodesicDistance(const Point3m& p0, const Point3m& n0, const Point3m& p1, const Point3m& n1)
+{
+	const Scalarm de = vcg::Distance(p0, p1);
+	if (de == 0)
+		return 0;
+	const Point3m v = (p0 - p1) / de;
+	const Scalarm c0 = std::max(Scalarm(-1), std::min(v * n0, Scalarm(1)));
+	const Scalarm c1 = std::max(Scalarm(-1), std::min(v * n1, Scalarm(1)));
+	if (std::fabs(c0 - c1) < 0.0001)
+		return de / std::sqrt(1 - c0 * c1);
+	return de * (std::asin(c0) - std::asin(c1)) / (c0 - c1);
+}
+
+/**
+ * @brief Sorts v, whose values must be all different, in parallel: a fixed
+ * number of chunks are sorted concurrently and then merged in pairs.
+ */
+template <typename T>
+void parallelSort(std::vector<T>& v)
+{
+	const int CHUNKS = 64;
+	auto bound = [&](int c) { return v.begin() + v.size() * std::min(c, CHUNKS) / CHUNKS; };
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < CHUNKS; ++c)
+		std::sort(bound(c), bound(c + 1));
+
+	for (int width = 1; width < CHUNKS; width *= 2) {
+		#pragma omp parallel for schedule(dynamic)
+		for (int c = 0; c < CHUNKS / (2 * width); ++c) {
+			const int first = c * 2 * width;
+			std::inplace_merge(bound(first), bound(first + width), bound(first + 2 * width));
+		}
+	}
+}
+
+/**
+ * A grid of cubic cells, with a margin of one cell around the box, so that
+ * all the neighbours of the cells of the points in the box exist.
+ */
+class Grid
+{
+public:
+	Grid(const Box3m& box, Scalarm cellSize) : origin(box.min), cellSize(cellSize)
+	{
+		for (int k = 0; k < 3; ++k)
+			siz[k] = (int) std::floor(box.Dim()[k] / cellSize) + 3;
+	}
+
+	const vcg::Point3i& size() const { return siz; }
+
+	vcg::Point3i cell(const Point3m& p) const
+	{
+		vcg::Point3i c;
+		for (int k = 0; k < 3; ++k)
+			c[k] = std::max(1, std::min((int) std::floor((p[k] - origin[k]) / cellSize) + 1, siz[k] - 2));
+		return c;
+	}
+
+	std::uint64_t key(const vcg::Point3i& c) const
+	{
+		return ((std::uint64_t) c[2] * siz[1] + c[1]) * siz[0] + c[0];
+	}
+
+	vcg::Point3i cell(std::uint64_t key) const
+	{
+		return vcg::Point3i(
+			(int) (key % siz[0]), (int) (key / siz[0] % siz[1]), (int) (key / siz[0] / siz[1]));
+	}
+
+	static int phase(const vcg::Point3i& c) { return c[0] % 3 + 3 * (c[1] % 3) + 9 * (c[2] % 3); }
+
+private:
+	Point3m      origin;
+	Scalarm      cellSize;
+	vcg::Point3i siz;
+};
+
+/**
+ * Points bucketed in the cells of a grid: the points of the i-th non empty
+ * cell are points[begin[i]] ... points[begin[i + 1] - 1], in increasing order.
+ */
+class Buckets
+{
+public:
+	std::vector<std::uint64_t> keys; // of the non empty cells, sorted
+	std::vector<int>           begin;
+	std::vector<int>           points;
+
+	Buckets(const Grid& g, const std::vector<Point3m>& p)
+	{
+		std::vector<std::pair<std::uint64_t, int>> sorted(p.size());
+		#pragma omp parallel for schedule(static)
+		for (int i = 0; i < (int) p.size(); ++i)
+			sorted[i] = std::make_pair(g.key(g.cell(p[i])), i);
+		parallelSort(sorted);
+
+		points.resize(sorted.size());
+		for (int i = 0; i < (int) sorted.size(); ++i) {
+			if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+				keys.push_back(sorted[i].first);
+				begin.push_back(i);
+			}
+			points[i] = sorted[i].second;
+		}
+		begin.push_back((int) sorted.size());
+	}
+
+	int cellNum() const { return (int) keys.size(); }
+
+	/**
+	 * @brief the ranges of the points in the (up to 27) non empty cells
+	 * around c, c included; returns their number
+	 */
+	int neighbours(const Grid& g, const vcg::Point3i& c, std::pair<int, int>* ranges) const
+	{
+		int n = 0;
+		for (int dz = -1; dz <= 1; ++dz)
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dx = -1; dx <= 1; ++dx) {
+					const std::uint64_t key = g.key(c + vcg::Point3i(dx, dy, dz));
+					auto it = std::lower_bound(keys.begin(), keys.end(), key);
+					if (it != keys.end() && *it == key) {
+						const int i = (int) (it - keys.begin());
+						ranges[n++] = std::make_pair(begin[i], begin[i + 1]);
+					}
+				}
+		return n;
+	}
+};
+
+} // namespace
+
+ParallelPoissonDisk::ParallelPoissonDisk(const CMeshO& candidateMesh, const Param& par) :
+		m(candidateMesh), par(par), maxFactor(1)
+{
+	for (int i = 0; i < (int) m.vert.size(); ++i) {
+		if (!m.vert[i].IsD()) {
+			candidates.push_back(i);
+			bbox.Add(m.vert[i].cP());
+		}
+	}
+	if (par.preGenMesh != nullptr) {
+		for (const CVertexO& v : par.preGenMesh->vert)
+			if (!v.IsD())
+				bbox.Add(v.cP());
+	}
+
+	radiusFactor.assign(candidates.size(), 1);
+	if (par.adaptiveRadiusFlag && !candidates.empty()) {
+		Scalarm qMin = std::numeric_limits<Scalarm>::max();
+		Scalarm qMax = std::numeric_limits<Scalarm>::lowest();
+		for (int i : candidates) {
+			qMin = std::min(qMin, m.vert[i].cQ());
+			qMax = std::max(qMax, m.vert[i].cQ());
+		}
+		const Scalarm qRange = qMax > qMin ? qMax - qMin : Scalarm(1);
+		const Scalarm minFactor = 1 / par.radiusVariance;
+		for (std::size_t i = 0; i < candidates.size(); ++i) {
+			const Scalarm t = (m.vert[candidates[i]].cQ() - qMin) / qRange;
+			radiusFactor[i] = minFactor + (par.radiusVariance - minFactor) * t;
+		}
+		maxFactor = std::max(std::max(minFactor, par.radiusVariance), Scalarm(1));
+	}
+}
+
+std::vector<int> ParallelPoissonDisk::prune(Scalarm radius, Stats& stats) const
+{
+	const int n = (int) candidates.size();
+
+	// the cells are never smaller than the largest distance at which two
+	// samples conflict, and not so small that the cell keys overflow
+	const Scalarm cellSize = std::max(radius * maxFactor, bbox.Diag() / (1 << 20));
+	const Grid grid(bbox, cellSize);
+
+	std::vector<Point3m> pos(n);
+	for (int i = 0; i < n; ++i)
+		pos[i] = m.vert[candidates[i]].cP();
+	const Buckets buckets(grid, pos);
+
+	// the candidates in the order of the buckets
+	std::vector<Point3m> sp(n), sn(n);
+	std::vector<Scalarm> sr(n);
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < n; ++k) {
+		const int i = buckets.points[k];
+		sp[k] = pos[i];
+		sn[k] = m.vert[candidates[i]].cN();
+		sr[k] = radius * radiusFactor[i];
+	}
+	std::vector<char> removed(n, 0);
+	std::vector<char> accepted(n, 0);
+
+	// as in vcg, a sample removes the candidates within its own radius
+	auto conflict = [&](const Point3m& p, const Point3m& nrm, Scalarm r, int k) {
+		if (vcg::SquaredDistance(p, sp[k]) >= r * r)
+			return false;
+		return !par.geodesicDistanceFlag || approximateGeodesicDistance(p, nrm, sp[k], sn[k]) < r;
+	};
+
+	// the samples of preGenMesh remove the candidates around them, with the
+	// same phases used for the candidates
+	if (par.preGenMesh != nullptr) {
+		std::vector<Point3m> fp, fn;
+		for (const CVertexO& v : par.preGenMesh->vert) {
+			if (!v.IsD()) {
+				fp.push_back(v.cP());
+				fn.push_back(v.cN());
+			}
+		}
+		const Buckets forced(grid, fp);
+		std::vector<std::vector<int>> phaseCells(PHASE_NUM);
+		for (int c = 0; c < forced.cellNum(); ++c)
+			phaseCells[Grid::phase(grid.cell(forced.keys[c]))].push_back(c);
+
+		for (const std::vector<int>& cells : phaseCells) {
+			#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < (int) cells.size(); ++i) {
+				const int c = cells[i];
+				std::pair<int, int> ranges[27];
+				const int nRanges = buckets.neighbours(grid, grid.cell(forced.keys[c]), ranges);
+				for (int f = forced.begin[c]; f < forced.begin[c + 1]; ++f) {
+					const int j = forced.points[f];
+					for (int r = 0; r < nRanges; ++r)
+						for (int k = ranges[r].first; k < ranges[r].second; ++k)
+							if (!removed[k] && conflict(fp[j], fn[j], radius, k))
+								removed[k] = 1;
+				}
+			}
+		}
+	}
+
+	std::vector<std::vector<int>> phaseCells(PHASE_NUM);
+	for (int c = 0; c < buckets.cellNum(); ++c)
+		phaseCells[Grid::phase(grid.cell(buckets.keys[c]))].push_back(c);
+
+	stats.gridSize = grid.size();
+	stats.cellNum = buckets.cellNum();
+	stats.phases.assign(PHASE_NUM, PhaseStats());
+	for (int phase = 0; phase < PHASE_NUM; ++phase) {
+		QElapsedTimer timer;
+		timer.start();
+		const std::vector<int>& cells = phaseCells[phase];
+		int sampleNum = 0;
+
+		#pragma omp parallel for schedule(dynamic) reduction(+: sampleNum)
+		for (int i = 0; i < (int) cells.size(); ++i) {
+			const int c = cells[i];
+			const int end = buckets.begin[c + 1];
+			std::pair<int, int> ranges[27];
+			const int nRanges = buckets.neighbours(grid, grid.cell(buckets.keys[c]), ranges);
+
+			int next = buckets.begin[c];
+			while (true) {
+				while (next < end && removed[next])
+					++next;
+				if (next == end)
+					break;
+
+				int chosen = next;
+				if (par.bestSampleChoiceFlag) {
+					int minCount = std::numeric_limits<int>::max();
+					int pool = 0;
+					for (int s = next; s < end && pool < par.bestSamplePoolSize; ++s) {
+						if (removed[s])
+							continue;
+						++pool;
+						int count = 0;
+						for (int r = 0; r < nRanges; ++r)
+							for (int k = ranges[r].first; k < ranges[r].second; ++k)
+								if (!removed[k] && conflict(sp[s], sn[s], sr[s], k))
+									++count;
+						if (count < minCount) {
+							minCount = count;
+							chosen = s;
+						}
+					}
+				}
+
+				accepted[chosen] = 1;
+				removed[chosen] = 1;
+				++sampleNum;
+				for (int r = 0; r < nRanges; ++r)
+					for (int k = ranges[r].first; k < ranges[r].second; ++k)
+						if (!removed[k] && conflict(sp[chosen], sn[chosen], sr[chosen], k))
+							removed[k] = 1;
+			}
+		}
+		stats.phases[phase].cellNum = (int) cells.size();
+		stats.phases[phase].sampleNum = sampleNum;
+		stats.phases[phase].time = timer.nsecsElapsed() / 1e9;
+	}
+
+	std::vector<int> samples;
+	for (int k = 0; k < n; ++k)
+		if (accepted[k])
+			samples.push_back(candidates[buckets.points[k]]);
+	std::sort(samples.begin(), samples.end());
+	stats.sampleNum = (int) samples.size();
+	return samples;
+}
+
+std::vector<int> ParallelPoissonDisk::pruneByNumber(
+	int      sampleNum,
+	Scalarm& radius,
+	Scalarm  tolerance,
+	Stats&   stats,
+	int      maxIter) const
+{
+	const int minNum = (int) std::floor(sampleNum * (1 - tolerance));
+	const int maxNum = (int) std::ceil(sampleNum * (1 + tolerance));
+	std::vector<int> samples;
+	auto run = [&](Scalarm r) {
+		radius = r;
+		samples = prune(r, stats);
+		return (int) samples.size();
+	};
+
+	// a larger radius gives less samples: first find a range of radii that
+	// contains the wanted one, then bisect it
+	Scalarm minRadius = radius;
+	Scalarm maxRadius = radius;
+	int count = run(radius);
+	if (count < sampleNum) {
+		for (int i = 0; i < maxIter && count < sampleNum; ++i) {
+			maxRadius = minRadius;
+			minRadius /= 2;
+			count = run(minRadius);
+		}
+	}
+	else {
+		for (int i = 0; i < maxIter && count > sampleNum; ++i) {
+			minRadius = maxRadius;
+			maxRadius *= 2;
+			count = run(maxRadius);
+		}
+	}
+	for (int i = 0; i < maxIter && (count < minNum || count > maxNum); ++i) {
+		const Scalarm r = (minRadius + maxRadius) / 2;
+		count = run(r);
+		if (count > sampleNum)
+			minRadius = r;
+		else
+			maxRadius = r;
+	}
+	return samples;
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef FILTER_SAMPLING_PARALLEL_POISSON_DISK_H
+#define FILTER_SAMPLING_PARALLEL_POISSON_DISK_H
+
+#include <vector>
+
+#include <common/ml_document/cmesh.h>
+
+/**
+ * Poisson-disk pruning of a set of candidate points (the vertices of a mesh,
+ * usually a dense Montecarlo sampling), run in parallel.
+ *
+ * As in vcg, a sample removes the candidates whose distance from it is less
+ * than its own radius. The candidates are bucketed in a grid whose cells are
+ * as large as the largest radius, so that a sample can only conflict with the
+ * candidates of the 27 cells around its own. The cells are split in 27 phases by their
+ * coordinates modulo 3: the neighbourhoods of two cells of the same phase
+ * never overlap, so all the cells of a phase are processed in parallel, each
+ * one taking its remaining candidates in order as samples and removing the
+ * candidates that conflict with them. The phases are processed one after
+ * the other, and the result does not depend on the number of threads.
+ */
+class ParallelPoissonDisk
+{
+public:
+	static const int PHASE_NUM = 27;
+
+	struct Param
+	{
+		/// the radius of each candidate goes linearly from r / radiusVariance,
+		/// where the quality is minimum, to r * radiusVariance, where it is
+		/// maximum
+		bool    adaptiveRadiusFlag = false;
+		Scalarm radiusVariance     = 1;
+
+		/// the distances are computed with an euclidean distance weighted by
+		/// the difference between the normals of the two points
+		bool geodesicDistanceFlag = false;
+
+		/// instead of the first remaining candidate of a cell, take among the
+		/// first bestSamplePoolSize ones the one that removes less candidates
+		bool bestSampleChoiceFlag = false;
+		int  bestSamplePoolSize   = 10;
+
+		/// if not null, its vertices are samples that are always kept: the
+		/// candidates that conflict with them are removed first
+		const CMeshO* preGenMesh = nullptr;
+	};
+
+	struct PhaseStats
+	{
+		int    cellNum   = 0;
+		int    sampleNum = 0;
+		double time      = 0; // seconds
+	};
+
+	struct Stats
+	{
+		vcg::Point3i gridSize;
+		int          cellNum   = 0; // non empty cells
+		int          sampleNum = 0; // new samples, not counting the preGenMesh ones
+		std::vector<PhaseStats> phases;
+	};
+
+	ParallelPoissonDisk(const CMeshO& candidateMesh, const Param& par);
+
+	/**
+	 * @brief the indices of the vertices of the candidates mesh taken as
+	 * samples with the given radius, in increasing order
+	 */
+	std::vector<int> prune(Scalarm radius, Stats& stats) const;
+
+	/**
+	 * @brief Like prune, with the radius that gives sampleNum samples within
+	 * the given relative tolerance, searched by bisection starting from the
+	 * given radius, that is set to the one found.
+	 */
+	std::vector<int> pruneByNumber(int sampleNum, Scalarm& radius, Scalarm tolerance, Stats& stats, int maxIter = 20) const;
+
+private:
+	const CMeshO& m;
+	Param         par;
+	std::vector<int>     candidates;    // the non deleted vertices of m
+	std::vector<Scalarm> radiusFactor;  // the radius of each candidate over r
+	Scalarm              maxFactor;
+	Box3m                bbox;
+};
+
+#endif // FILTER_SAMPLING_PARALLEL_POISSON_DISK_H
@@ -0,0 +1,113 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "parallel_sampling.h"
+
+#include <limits>
+
+#include <vcg/space/triangle3.h>
+
+std::vector<double> ParallelSampling::areaCDF(const CMeshO& m)
+{
+	std::vector<double> cdf(m.face.size() + 1, 0);
+
+	#pragma omp parallel for schedule(dynamic, 4096)
+	for (int f = 0; f < (int) m.face.size(); ++f) {
+		if (!m.face[f].IsD())
+			cdf[f + 1] = vcg::DoubleArea(m.face[f]) / 2;
+	}
+	prefixSum(cdf);
+	return cdf;
+}
+
+std::vector<double> ParallelSampling::weightedAreaCDF(const CMeshO& m, Scalarm variance)
+{
+	Scalarm qMin = std::numeric_limits<Scalarm>::max();
+	Scalarm qMax = std::numeric_limits<Scalarm>::lowest();
+	for (const CVertexO& v : m.vert) {
+		if (!v.IsD()) {
+			qMin = std::min(qMin, v.cQ());
+			qMax = std::max(qMax, v.cQ());
+		}
+	}
+	const Scalarm qRange = qMax > qMin ? qMax - qMin : Scalarm(1);
+
+	std::vector<double> cdf(m.face.size() + 1, 0);
+
+	#pragma omp parallel for schedule(dynamic, 4096)
+	for (int f = 0; f < (int) m.face.size(); ++f) {
+		const CFaceO& face = m.face[f];
+		if (face.IsD())
+			continue;
+		Scalarm scale = 0;
+		for (int k = 0; k < 3; ++k)
+			scale += 1 + (variance - 1) * (qMax - face.cV(k)->cQ()) / qRange;
+		scale /= 3;
+		cdf[f + 1] = scale * scale * vcg::DoubleArea(face) / 2;
+	}
+	prefixSum(cdf);
+	return cdf;
+}
+
+std::vector<std::size_t> ParallelSampling::proportionalOffsets(const std::vector<double>& cdf, std::size_t sampleNum)
+{
+	if (!(cdf.back() > 0))
+		return std::vector<std::size_t>(cdf.size(), 0);
+	const double scale = sampleNum / cdf.back();
+	std::vector<std::size_t> offsets(cdf.size());
+
+	#pragma omp parallel for schedule(dynamic, 4096)
+	for (int f = 0; f < (int) cdf.size(); ++f)
+		offsets[f] = std::min((std::size_t) std::floor(cdf[f] * scale), sampleNum);
+	// the rounding remainder goes to the last face with weight, not to the
+	// trailing faces without weight (e.g. deleted)
+	offsets.back() = sampleNum;
+	for (std::size_t f = cdf.size() - 2; f > 0 && cdf[f] == cdf.back(); --f)
+		offsets[f] = sampleNum;
+	return offsets;
+}
+
+std::vector<std::size_t> ParallelSampling::poissonOffsets(const std::vector<double>& cdf, std::size_t sampleNum, std::uint64_t seed)
+{
+	const double scale = cdf.back() > 0 ? sampleNum / cdf.back() : 0;
+	std::vector<std::size_t> offsets(cdf.size(), 0);
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int f = 0; f < (int) cdf.size() - 1; ++f) {
+		CounterRandom rnd(seed, COUNT_STREAMS + f);
+		offsets[f + 1] = rnd.poisson((cdf[f + 1] - cdf[f]) * scale);
+	}
+	prefixSum(offsets);
+	return offsets;
+}
+
+std::vector<std::size_t> ParallelSampling::similarOffsets(const std::vector<std::size_t>& offsets, bool dual)
+{
+	std::vector<std::size_t> similar(offsets.size(), 0);
+
+	#pragma omp parallel for schedule(dynamic, 4096)
+	for (int f = 0; f < (int) offsets.size() - 1; ++f)
+		similar[f + 1] = similarSampleCount(similarDivisions(offsets[f + 1] - offsets[f], dual), dual);
+	prefixSum(similar);
+	return similar;
+}
@@ -0,0 +1,342 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef FILTER_SAMPLING_PARALLEL_SAMPLING_H
+#define FILTER_SAMPLING_PARALLEL_SAMPLING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <common/ml_document/cmesh.h>
+
+/**
+ * A counter based random generator: the n-th number of a stream is a hash of
+ * the key of the stream and of n (it is the SplitMix64 sequence starting from
+ * the key). The key depends only on the seed and on the stream id, so a
+ * stream can be used by any thread and always gives the same numbers.
+ */
+class CounterRandom
+{
+public:
+	CounterRandom(std::uint64_t seed, std::uint64_t stream) :
+			key(mix(mix(seed) + stream)), counter(0)
+	{
+	}
+
+	std::uint64_t next() { return mix(key + GOLDEN_GAMMA * ++counter); }
+
+	/**
+	 * @brief a uniform random number in [0, 1)
+	 */
+	double next01() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+	/**
+	 * @brief the barycentric coordinates of a uniform random point of a
+	 * triangle
+	 */
+	Point3m barycentric()
+	{
+		Scalarm u = next01();
+		Scalarm v = next01();
+		if (u + v > 1) {
+			u = 1 - u;
+			v = 1 - v;
+		}
+		return Point3m(u, v, 1 - (u + v));
+	}
+
+	/**
+	 * @brief a random number with Poisson distribution of the given mean
+	 */
+	int poisson(double mean)
+	{
+		// Knuth's method, on chunks of the mean small enough that exp(-mean)
+		// does not underflow
+		int n = 0;
+		while (mean > 0) {
+			const double limit = std::exp(-std::min(mean, 500.0));
+			mean -= 500.0;
+			double p = next01();
+			while (p > limit) {
+				++n;
+				p *= next01();
+			}
+		}
+		return n;
+	}
+
+private:
+	static const std::uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+	static std::uint64_t mix(std::uint64_t z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	std::uint64_t key;
+	std::uint64_t counter;
+};
+
+/**
+ * Montecarlo and stratified sampling of the faces of a mesh, run in parallel.
+ *
+ * The per face quantities (areas, weights, number of samples) are kept in
+ * arrays of fn + 1 values turned into cumulative sums by prefixSum(), so that
+ * the samples of face f are the ones in [a[f], a[f + 1]). The random numbers
+ * are drawn from CounterRandom streams tied to a block of samples or to a
+ * face, and the blocks of the parallel loops have a fixed size: given a
+ * seed, the samples are the same whatever the number of threads.
+ *
+ * The samples are passed to store(i, face, barycentricCoords), called
+ * concurrently on different i in [0, number of samples); i is the index of
+ * the sample in the output, so the store function can write it in a
+ * preallocated vertex without any synchronization.
+ */
+class ParallelSampling
+{
+public:
+	static const int BLOCK_SIZE = 1 << 16;
+
+	/**
+	 * @brief Replaces each value of v with the sum of the values up to it,
+	 * summing in parallel on blocks of BLOCK_SIZE values.
+	 */
+	template <typename T>
+	static void prefixSum(std::vector<T>& v);
+
+	/**
+	 * @brief the cumulative areas of the faces (0 for the deleted ones)
+	 */
+	static std::vector<double> areaCDF(const CMeshO& m);
+
+	/**
+	 * @brief the cumulative areas of the faces, each one scaled by the square
+	 * of the average over its vertices of a factor that goes linearly from
+	 * variance, where the quality is minimum, to 1, where it is maximum: the
+	 * density of the samples where the quality is minimum is variance^2 times
+	 * the one where it is maximum.
+	 */
+	static std::vector<double> weightedAreaCDF(const CMeshO& m, Scalarm variance);
+
+	/**
+	 * @brief the cumulative number of samples of the faces when sampleNum
+	 * samples are distributed proportionally to the given cumulative weights
+	 * (no samples at all if the total weight is 0)
+	 */
+	static std::vector<std::size_t> proportionalOffsets(const std::vector<double>& cdf, std::size_t sampleNum);
+
+	/**
+	 * @brief the cumulative number of samples of the faces, each one drawn
+	 * from a Poisson distribution whose mean is proportional to the weight of
+	 * the face, with sampleNum samples expected in total
+	 */
+	static std::vector<std::size_t> poissonOffsets(const std::vector<double>& cdf, std::size_t sampleNum, std::uint64_t seed);
+
+	/**
+	 * @brief the cumulative number of samples of the faces of faceSimilar(),
+	 * given the cumulative number of samples wanted on each face
+	 */
+	static std::vector<std::size_t> similarOffsets(const std::vector<std::size_t>& offsets, bool dual);
+
+	/**
+	 * @brief sampleNum samples on the faces, each one on a face chosen with
+	 * probability proportional to its weight; nothing is stored if the total
+	 * weight is 0
+	 */
+	template <typename Store>
+	static void montecarlo(const CMeshO& m, const std::vector<double>& cdf, std::size_t sampleNum, std::uint64_t seed, Store store);
+
+	/**
+	 * @brief offsets[f + 1] - offsets[f] random samples on each face f
+	 */
+	template <typename Store>
+	static void faceMontecarlo(const CMeshO& m, const std::vector<std::size_t>& offsets, std::uint64_t seed, Store store);
+
+	/**
+	 * @brief Subdivides each face in k^2 similar triangles, with offsets
+	 * given by similarOffsets(). The samples are the internal vertices of the
+	 * subdivision or, if dual is true, the barycenters (or random points, if
+	 * random is true) of the small triangles.
+	 */
+	template <typename Store>
+	static void faceSimilar(const CMeshO& m, const std::vector<std::size_t>& offsets, bool dual, bool random, std::uint64_t seed, Store store);
+
+private:
+	/// the random streams of the samples of face f and of its number of
+	/// samples are FACE_STREAMS + f and COUNT_STREAMS + f
+	static const std::uint64_t FACE_STREAMS = 1ull << 62;
+	static const std::uint64_t COUNT_STREAMS = 1ull << 63;
+
+	/// the number of edge subdivisions of faceSimilar that gives about n
+	/// samples (exactly n if n is one of the possible sample counts)
+	static int similarDivisions(std::size_t n, bool dual)
+	{
+		if (dual)
+			return (int) std::lround(std::sqrt((double) n));
+		return (int) std::lround((3.0 + std::sqrt(1.0 + 8.0 * n)) / 2.0);
+	}
+
+	static std::size_t similarSampleCount(int k, bool dual)
+	{
+		if (dual)
+			return (std::size_t) k * k;
+		return k > 2 ? (std::size_t) (k - 1) * (k - 2) / 2 : 0;
+	}
+};
+
+template <typename T>
+void ParallelSampling::prefixSum(std::vector<T>& v)
+{
+	const int nBlocks = (int) ((v.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	std::vector<T> blockSums(nBlocks + 1, T(0));
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int b = 0; b < nBlocks; ++b) {
+		const std::size_t begin = (std::size_t) b * BLOCK_SIZE;
+		const std::size_t end = std::min(begin + BLOCK_SIZE, v.size());
+		std::partial_sum(v.begin() + begin, v.begin() + end, v.begin() + begin);
+		blockSums[b + 1] = v[end - 1];
+	}
+	std::partial_sum(blockSums.begin(), blockSums.end(), blockSums.begin());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int b = 1; b < nBlocks; ++b) {
+		const std::size_t begin = (std::size_t) b * BLOCK_SIZE;
+		const std::size_t end = std::min(begin + BLOCK_SIZE, v.size());
+		for (std::size_t i = begin; i < end; ++i)
+			v[i] += blockSums[b];
+	}
+}
+
+template <typename Store>
+void ParallelSampling::montecarlo(
+	const CMeshO&              m,
+	const std::vector<double>& cdf,
+	std::size_t                sampleNum,
+	std::uint64_t              seed,
+	Store                      store)
+{
+	const double total = cdf.back();
+	const int nFaces = (int) m.face.size();
+	if (!(total > 0))
+		return;
+
+	// guide table: guide[g] is the face of the value g / nFaces * total, so
+	// that the face of any value is found with a short linear search instead
+	// of a binary search on the whole cdf
+	std::vector<int> guide(nFaces + 1);
+	#pragma omp parallel for schedule(dynamic, 4096)
+	for (int g = 0; g <= nFaces; ++g)
+		guide[g] = std::upper_bound(cdf.begin() + 1, cdf.end() - 1, g * (total / nFaces)) - cdf.begin() - 1;
+
+	const int nBlocks = (int) ((sampleNum + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int b = 0; b < nBlocks; ++b) {
+		CounterRandom rnd(seed, b);
+		const std::size_t begin = (std::size_t) b * BLOCK_SIZE;
+		const std::size_t end = std::min(begin + BLOCK_SIZE, sampleNum);
+		for (std::size_t i = begin; i < end; ++i) {
+			// the first face whose interval ends after u; faces with zero
+			// weight have an empty interval and are never chosen
+			const double r = rnd.next01();
+			const double u = r * total;
+			int f = guide[(int) (r * nFaces)];
+			while (f < nFaces - 1 && cdf[f + 1] <= u)
+				++f;
+			// u may round up to the total: back to the last face with weight
+			while (cdf[f + 1] == cdf[f])
+				--f;
+			store(i, m.face[f], rnd.barycentric());
+		}
+	}
+}
+
+template <typename Store>
+void ParallelSampling::faceMontecarlo(
+	const CMeshO&                   m,
+	const std::vector<std::size_t>& offsets,
+	std::uint64_t                   seed,
+	Store                           store)
+{
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int f = 0; f < (int) m.face.size(); ++f) {
+		CounterRandom rnd(seed, FACE_STREAMS + f);
+		for (std::size_t i = offsets[f]; i < offsets[f + 1]; ++i)
+			store(i, m.face[f], rnd.barycentric());
+	}
+}
+
+template <typename Store>
+void ParallelSampling::faceSimilar(
+	const CMeshO&                   m,
+	const std::vector<std::size_t>& offsets,
+	bool                            dual,
+	bool                            random,
+	std::uint64_t                   seed,
+	Store                           store)
+{
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int f = 0; f < (int) m.face.size(); ++f) {
+		const std::size_t n = offsets[f + 1] - offsets[f];
+		if (n == 0)
+			continue;
+		const int k = similarDivisions(n, dual);
+		const Scalarm len = Scalarm(1) / k;
+		const CFaceO& face = m.face[f];
+		CounterRandom rnd(seed, FACE_STREAMS + f);
+		std::size_t s = offsets[f];
+
+		auto bary = [&](int i, int j) { return Point3m(i * len, j * len, 1 - (i + j) * len); };
+		auto sampleTriangle = [&](const Point3m& v0, const Point3m& v1, const Point3m& v2) {
+			if (random) {
+				const Point3m r = rnd.barycentric();
+				store(s++, face, v0 * r[0] + v1 * r[1] + v2 * r[2]);
+			}
+			else {
+				store(s++, face, (v0 + v1 + v2) / 3);
+			}
+		};
+
+		if (dual) {
+			for (int i = 0; i < k; ++i)
+				for (int j = 0; j < k - i; ++j) {
+					sampleTriangle(bary(i, j), bary(i + 1, j), bary(i, j + 1));
+					if (j < k - i - 1)
+						sampleTriangle(bary(i + 1, j + 1), bary(i, j + 1), bary(i + 1, j));
+				}
+		}
+		else {
+			for (int i = 1; i < k - 1; ++i)
+				for (int j = 1; j < k - i; ++j)
+					store(s++, face, bary(i, j));
+		}
+	}
+}
+
+#endif // FILTER_SAMPLING_PARALLEL_SAMPLING_H
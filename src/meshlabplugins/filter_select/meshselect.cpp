@@ -960,6 +960,25 @@ int SelectionFilterPlugin::postCondition(const QAction* action) const
 	return MeshModel::MM_ALL;
 }
 
+bool SelectionFilterPlugin::requiresCompactVectors(const QAction* action) const
+{
+	// these filters always skip deleted elements
+	switch (ID(action)) {
+	case FP_SELECT_ALL:
+	case FP_SELECT_NONE:
+	case FP_SELECT_INVERT:
+	case FP_SELECT_FACE_FROM_VERT:
+	case FP_SELECT_VERT_FROM_FACE:
+	case FP_SELECT_BY_VERT_QUALITY:
+	case FP_SELECT_BY_FACE_QUALITY:
+	case FP_SELECT_DELETE_VERT:
+	case FP_SELECT_DELETE_ALL_FACE:
+	case FP_SELECT_DELETE_FACE:
+	case FP_SELECT_DELETE_FACEVERT: return false;
+	}
+	return true;
+}
+
 int SelectionFilterPlugin::getPreConditions(const QAction* action) const
 {
 	switch (ID(action)) {
@@ -74,6 +74,7 @@ public:
 	int                             getPreConditions(const QAction*) const;
 	int                             postCondition(const QAction*) const;
 	int                             getRequirements(const QAction*);
+	bool                            requiresCompactVectors(const QAction*) const;
 	std::map<std::string, QVariant> applyFilter(
 		const QAction*           action,
 		const RichParameterList& parameters,
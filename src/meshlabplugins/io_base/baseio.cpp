@@ -24,7 +24,11 @@
 #include "baseio.h"
 #include "load_project.h"
 #include "save_project.h"
+#include "load_ply_binary.h"
+#include "load_text_mesh.h"
+#include "mesh_cache.h"
 
+#include <QElapsedTimer>
 #include <QTextStream>
 
 #include <wrap/io_trimesh/import_ply.h>
@@ -110,6 +114,7 @@ std::list<FileFormat> BaseMeshIOPlugin::importFormats() const
 		FileFormat("Object File Format", tr("OFF")),
 		FileFormat("PTX File Format", tr("PTX")),
 		FileFormat("VCG Dump File Format", tr("VMI")),
+		FileFormat("MeshLab Mesh Cache", tr("MLC")),
 		FileFormat("FBX Autodesk Interchange Format", tr("FBX"))
 	};
 	return formatList;
@@ -126,7 +131,8 @@ std::list<FileFormat> BaseMeshIOPlugin::exportFormats() const
 		FileFormat("Alias Wavefront Object", tr("OBJ")),
 		FileFormat("Object File Format", tr("OFF")),
 		FileFormat("VRML File Format", tr("WRL")),
-		FileFormat("DXF File Format", tr("DXF"))
+		FileFormat("DXF File Format", tr("DXF")),
+		FileFormat("MeshLab Mesh Cache", tr("MLC"))
 	};
 	return formatList;
 }
@@ -187,6 +193,17 @@ RichParameterList BaseMeshIOPlugin::initPreOpenParameter(const QString &formatNa
 	return parlst;
 }
 
+/**
+ * @brief logs the throughput of the parallel loaders
+ */
+void BaseMeshIOPlugin::logParallelLoad(const QString& fileName, qint64 msec) const
+{
+	double mb = QFileInfo(fileName).size() / (1024.0 * 1024.0);
+	double sec = std::max(msec, (qint64) 1) / 1000.0;
+	log("%s parsed in parallel: %.1f MB in %.3f sec (%.1f MB/s)",
+		qUtf8Printable(QFileInfo(fileName).fileName()), mb, sec, mb / sec);
+}
+
 void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName, MeshModel &m, int& mask, const RichParameterList &parlst, CallBackPos *cb)
 {
 	//bool normalsUpdated = false;
@@ -198,6 +215,9 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 	// initializing mask
 	mask = 0;
 
+	QElapsedTimer t;
+	t.start();
+
 	// initializing progress bar status
 	if (cb != NULL)
 		(*cb)(0, "Loading...");
@@ -213,13 +233,17 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 		if (mask & tri::io::Mask::IOM_WEDGCOLOR) mask |= tri::io::Mask::IOM_FACECOLOR;
 		m.enable(mask);
 
-
-		int result = tri::io::ImporterPLY<CMeshO>::Open(m.cm, filename.c_str(), mask, cb);
-		if (result != 0) // all the importers return 0 on success
-		{
-			if (tri::io::ImporterPLY<CMeshO>::ErrorCritical(result))
+		if (loadBinaryPLY(fileName, m.cm, mask, cb)) {
+			logParallelLoad(fileName, t.elapsed());
+		}
+		else {
+			int result = tri::io::ImporterPLY<CMeshO>::Open(m.cm, filename.c_str(), mask, cb);
+			if (result != 0) // all the importers return 0 on success
 			{
-				throw MLException(errorMsgFormat.arg(fileName, tri::io::ImporterPLY<CMeshO>::ErrorMsg(result)));
+				if (tri::io::ImporterPLY<CMeshO>::ErrorCritical(result))
+				{
+					throw MLException(errorMsgFormat.arg(fileName, tri::io::ImporterPLY<CMeshO>::ErrorMsg(result)));
+				}
 			}
 		}
 	}
@@ -244,6 +268,12 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 		}
 
 	}
+	else if (((formatName.toUpper() == tr("OBJ")) || (formatName.toUpper() == tr("QOBJ"))) &&
+			 loadTextOBJ(fileName, m.cm, mask))
+	{
+		m.enable(mask);
+		logParallelLoad(fileName, t.elapsed());
+	}
 	else if ((formatName.toUpper() == tr("OBJ")) || (formatName.toUpper() == tr("QOBJ")))
 	{
 		tri::io::ImporterOBJ<CMeshO>::Info oi;
@@ -302,6 +332,10 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 		// update mask
 		mask = importparams.mask;
 	}
+	else if (formatName.toUpper() == tr("OFF") && loadTextOFF(fileName, m.cm, mask))
+	{
+		logParallelLoad(fileName, t.elapsed());
+	}
 	else if (formatName.toUpper() == tr("OFF"))
 	{
 		int loadMask;
@@ -331,6 +365,11 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 			throw MLException(errorMsgFormat.arg(fileName, tri::io::ImporterOFF<CMeshO>::ErrorMsg(result)));
 		}
 	}
+	else if (formatName.toUpper() == tr("MLC"))
+	{
+		mask = loadMeshCache(fileName, m, cb);
+		logParallelLoad(fileName, t.elapsed());
+	}
 	else if (formatName.toUpper() == tr("GTS"))
 	{
 		int loadMask;
@@ -388,6 +427,14 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 	if (cb != NULL)	(*cb)(99, "Done");
 }
 
+bool BaseMeshIOPlugin::supportsConcurrentOpen(const QString& formatName) const
+{
+	// the PLY, STL, OFF and MLC importers do not use any static or shared data
+	QString format = formatName.toUpper();
+	return format == tr("PLY") || format == tr("STL") || format == tr("OFF") ||
+		   format == tr("MLC");
+}
+
 void BaseMeshIOPlugin::save(const QString &formatName, const QString &fileName, MeshModel &m, const int mask, const RichParameterList & par, CallBackPos *cb)
 {
 	QString errorMsgFormat = "Error encountered while exportering file %1:\n%2";
@@ -509,6 +556,10 @@ void BaseMeshIOPlugin::save(const QString &formatName, const QString &fileName,
 			throw MLException(errorMsgFormat.arg(fileName, vcg::tri::io::ExporterGTS<CMeshO>::ErrorMsg(result)));
 		}
 	}
+	else if (formatName.toUpper() == tr("MLC"))
+	{
+		saveMeshCache(fileName, m, mask, par.getBool("compress"), cb);
+	}
 	else {
 		wrongSaveFormat(formatName);
 	}
@@ -557,6 +608,12 @@ QImage BaseMeshIOPlugin::openImage(
 	return loadedImage;
 }
 
+bool BaseMeshIOPlugin::supportsConcurrentOpenImage(const QString&) const
+{
+	// openImage does not use the log nor any member of the plugin
+	return true;
+}
+
 void BaseMeshIOPlugin::saveImage(
 		const QString& format,
 		const QString& fileName,
@@ -685,6 +742,15 @@ void BaseMeshIOPlugin::exportMaskCapability(const QString &format, int &capabili
 	if (format.toUpper() == tr("OFF")) { capability = defaultBits = tri::io::ExporterOFF<CMeshO>::GetExportMaskCapability(); }
 	if (format.toUpper() == tr("WRL")) { capability = defaultBits = tri::io::ExporterWRL<CMeshO>::GetExportMaskCapability(); }
 	if (format.toUpper() == tr("DXF")) { capability = defaultBits = tri::io::Mask::IOM_VERTCOORD | tri::io::Mask::IOM_FACEINDEX;}
+	if (format.toUpper() == tr("MLC")) {
+		capability = defaultBits =
+			tri::io::Mask::IOM_VERTCOORD | tri::io::Mask::IOM_VERTNORMAL |
+			tri::io::Mask::IOM_VERTCOLOR | tri::io::Mask::IOM_VERTQUALITY |
+			tri::io::Mask::IOM_VERTTEXCOORD | tri::io::Mask::IOM_VERTFLAGS |
+			tri::io::Mask::IOM_FACEINDEX | tri::io::Mask::IOM_FACENORMAL |
+			tri::io::Mask::IOM_FACECOLOR | tri::io::Mask::IOM_FACEQUALITY |
+			tri::io::Mask::IOM_FACEFLAGS | tri::io::Mask::IOM_WEDGTEXCOORD;
+	}
 
 }
 
@@ -707,6 +773,15 @@ RichParameterList BaseMeshIOPlugin::initSaveParameter(const QString &format, con
 			"Save the color using a binary encoding according to the Materialise's Magic style "
 			"(e.g. RGB coding instead of BGR coding)."));
 
+	if (format.toUpper() == tr("MLC"))
+		par.addParam(RichBool(
+			"compress",
+			false,
+			"Compress",
+			"Compress the data with zlib. The file will be smaller, but it will take longer "
+			"to save and load it, since uncompressed data is copied directly from the file "
+			"mapped in memory."));
+
 	if (format.toUpper() == tr("PLY")) {
 		std::vector<std::string> attribNameVector;
 		vcg::tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Scalarm>(m.cm, attribNameVector);
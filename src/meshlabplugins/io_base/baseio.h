@@ -58,6 +58,8 @@ public:
 			const RichParameterList& par,
 			vcg::CallBackPos* cb);
 
+	bool supportsConcurrentOpen(const QString& formatName) const;
+
 	void save(
 			const QString &formatName,
 			const QString &fileName,
@@ -71,6 +73,8 @@ public:
 			const QString& fileName,
 			vcg::CallBackPos* cb);
 
+	bool supportsConcurrentOpenImage(const QString& format) const;
+
 	void saveImage(
 			const QString& format,
 			const QString& fileName,
@@ -102,6 +106,7 @@ public:
 
 private:
 	QImage loadTga(const char* filePath);
+	void logParallelLoad(const QString& fileName, qint64 msec) const;
 };
 
 #endif
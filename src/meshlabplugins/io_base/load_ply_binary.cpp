@@ -0,0 +1,488 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "load_ply_binary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+#include <QFile>
+#include <QtEndian>
+
+#include <wrap/io_trimesh/io_mask.h>
+
+using namespace vcg;
+
+namespace {
+
+enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, INVALID };
+
+PlyType plyType(const QByteArray& name)
+{
+	if (name == "char" || name == "int8")
+		return PlyType::INT8;
+	if (name == "uchar" || name == "uint8")
+		return PlyType::UINT8;
+	if (name == "short" || name == "int16")
+		return PlyType::INT16;
+	if (name == "ushort" || name == "uint16")
+		return PlyType::UINT16;
+	if (name == "int" || name == "int32")
+		return PlyType::INT32;
+	if (name == "uint" || name == "uint32")
+		return PlyType::UINT32;
+	if (name == "float" || name == "float32")
+		return PlyType::FLOAT32;
+	if (name == "double" || name == "float64")
+		return PlyType::FLOAT64;
+	return PlyType::INVALID;
+}
+
+unsigned int plyTypeSize(PlyType type)
+{
+	switch (type) {
+	case PlyType::INT8:
+	case PlyType::UINT8: return 1;
+	case PlyType::INT16:
+	case PlyType::UINT16: return 2;
+	case PlyType::INT32:
+	case PlyType::UINT32:
+	case PlyType::FLOAT32: return 4;
+	case PlyType::FLOAT64: return 8;
+	default: return 0;
+	}
+}
+
+template<typename U>
+inline U readRaw(const uchar* p, bool bigEndian)
+{
+	return bigEndian ? qFromBigEndian<U>(p) : qFromLittleEndian<U>(p);
+}
+
+/**
+ * @brief reads a value of the given PLY type, converting it to T
+ */
+template<typename T>
+inline T readValue(const uchar* p, PlyType type, bool bigEndian)
+{
+	switch (type) {
+	case PlyType::INT8: return T(*reinterpret_cast<const qint8*>(p));
+	case PlyType::UINT8: return T(*p);
+	case PlyType::INT16: return T(readRaw<qint16>(p, bigEndian));
+	case PlyType::UINT16: return T(readRaw<quint16>(p, bigEndian));
+	case PlyType::INT32: return T(readRaw<qint32>(p, bigEndian));
+	case PlyType::UINT32: return T(readRaw<quint32>(p, bigEndian));
+	case PlyType::FLOAT32: {
+		quint32 bits = readRaw<quint32>(p, bigEndian);
+		float v;
+		std::memcpy(&v, &bits, sizeof(float));
+		return T(v);
+	}
+	case PlyType::FLOAT64: {
+		quint64 bits = readRaw<quint64>(p, bigEndian);
+		double v;
+		std::memcpy(&v, &bits, sizeof(double));
+		return T(v);
+	}
+	default: return T(0);
+	}
+}
+
+/**
+ * @brief reads a color channel: integer types are taken as they are, floating
+ * point types are assumed in the [0, 1] range.
+ */
+inline unsigned char readColor(const uchar* p, PlyType type, bool bigEndian)
+{
+	if (type == PlyType::FLOAT32 || type == PlyType::FLOAT64) {
+		double v = readValue<double>(p, type, bigEndian) * 255.0;
+		return (unsigned char) std::min(std::max(v, 0.0), 255.0);
+	}
+	return readValue<unsigned char>(p, type, bigEndian);
+}
+
+struct PlyProperty
+{
+	QByteArray name;
+	PlyType type = PlyType::INVALID;
+	bool isList = false;
+	PlyType countType = PlyType::INVALID; // lists only
+	unsigned int offset = 0; // byte offset in the record
+};
+
+struct PlyElement
+{
+	QByteArray name;
+	qint64 count = 0;
+	std::vector<PlyProperty> properties;
+	unsigned int stride = 0; // size of a record, in bytes
+	qint64 offset = 0; // byte offset of the first record in the file
+
+	const PlyProperty* property(const char* name) const
+	{
+		for (const PlyProperty& p : properties)
+			if (p.name == name)
+				return &p;
+		return nullptr;
+	}
+};
+
+/**
+ * @brief the color properties of the vertex (or face) element, looked up once
+ * from the header
+ */
+struct PlyColor
+{
+	const PlyProperty* r = nullptr;
+	const PlyProperty* g = nullptr;
+	const PlyProperty* b = nullptr;
+	const PlyProperty* a = nullptr;
+
+	explicit PlyColor(const PlyElement& e) :
+			r(e.property("red")), g(e.property("green")),
+			b(e.property("blue")), a(e.property("alpha"))
+	{
+	}
+
+	bool valid() const { return r && g && b; }
+
+	Color4b read(const uchar* rec, bool bigEndian) const
+	{
+		return Color4b(
+			readColor(rec + r->offset, r->type, bigEndian),
+			readColor(rec + g->offset, g->type, bigEndian),
+			readColor(rec + b->offset, b->type, bigEndian),
+			a ? readColor(rec + a->offset, a->type, bigEndian) : 255);
+	}
+};
+
+/**
+ * @brief parses the header of the PLY file. Returns false if the file is not
+ * a binary PLY whose layout can be computed from the header, that is when all
+ * the elements have fixed size records (faces are assumed to be triangles).
+ */
+bool parseHeader(
+		const uchar* data,
+		qint64 size,
+		bool& bigEndian,
+		std::vector<PlyElement>& elements,
+		std::vector<std::string>& textures,
+		qint64& dataStart)
+{
+	qint64 pos = 0;
+	bool formatFound = false;
+	while (pos < size) {
+		const uchar* eol = (const uchar*) std::memchr(data + pos, '\n', size - pos);
+		if (eol == nullptr)
+			return false;
+		QByteArray line = QByteArray((const char*) data + pos, eol - (data + pos)).trimmed();
+		pos = (eol - data) + 1;
+		if (line.isEmpty())
+			continue;
+		QList<QByteArray> tokens = line.simplified().split(' ');
+		const QByteArray& key = tokens[0];
+		if (key == "ply") {
+			continue;
+		}
+		else if (key == "format") {
+			if (tokens.size() < 2)
+				return false;
+			if (tokens[1] == "binary_little_endian")
+				bigEndian = false;
+			else if (tokens[1] == "binary_big_endian")
+				bigEndian = true;
+			else
+				return false;
+			formatFound = true;
+		}
+		else if (key == "comment") {
+			// same convention of ImporterPLY
+			if (tokens.size() > 2 && tokens[1].toLower() == "texturefile")
+				textures.push_back(line.mid(line.indexOf(tokens[1]) + tokens[1].size()).trimmed().toStdString());
+		}
+		else if (key == "obj_info") {
+			continue;
+		}
+		else if (key == "element") {
+			if (tokens.size() != 3)
+				return false;
+			PlyElement e;
+			e.name = tokens[1];
+			bool ok;
+			e.count = tokens[2].toLongLong(&ok);
+			if (!ok || e.count < 0)
+				return false;
+			elements.push_back(e);
+		}
+		else if (key == "property") {
+			if (elements.empty())
+				return false;
+			PlyProperty p;
+			if (tokens.size() == 5 && tokens[1] == "list") {
+				p.isList = true;
+				p.countType = plyType(tokens[2]);
+				p.type = plyType(tokens[3]);
+				p.name = tokens[4];
+				if (p.countType == PlyType::INVALID || p.countType == PlyType::FLOAT32 ||
+					p.countType == PlyType::FLOAT64)
+					return false;
+			}
+			else if (tokens.size() == 3) {
+				p.type = plyType(tokens[1]);
+				p.name = tokens[2];
+			}
+			else {
+				return false;
+			}
+			if (p.type == PlyType::INVALID)
+				return false;
+			elements.back().properties.push_back(p);
+		}
+		else if (key == "end_header") {
+			dataStart = pos;
+			break;
+		}
+		else {
+			return false;
+		}
+	}
+	if (!formatFound || dataStart == 0)
+		return false;
+
+	// layout of the records
+	qint64 offset = dataStart;
+	for (PlyElement& e : elements) {
+		e.offset = offset;
+		for (PlyProperty& p : e.properties) {
+			p.offset = e.stride;
+			if (p.isList) {
+				// the only list we can handle is the one of the triangles
+				if (e.name != "face" || (p.name != "vertex_indices" && p.name != "vertex_index"))
+					return false;
+				e.stride += plyTypeSize(p.countType) + 3 * plyTypeSize(p.type);
+			}
+			else {
+				e.stride += plyTypeSize(p.type);
+			}
+		}
+		offset += e.count * e.stride;
+	}
+	return offset <= size;
+}
+
+} // namespace
+
+bool loadBinaryPLY(
+		const QString& fileName,
+		CMeshO& m,
+		int mask,
+		vcg::CallBackPos* cb)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	const qint64 size = file.size();
+	const uchar* data = file.map(0, size);
+	if (data == nullptr)
+		return false;
+
+	bool bigEndian = false;
+	std::vector<PlyElement> elements;
+	std::vector<std::string> textures;
+	qint64 dataStart = 0;
+	if (!parseHeader(data, size, bigEndian, elements, textures, dataStart))
+		return false;
+
+	const PlyElement* vertElem = nullptr;
+	const PlyElement* faceElem = nullptr;
+	for (const PlyElement& e : elements) {
+		if (e.name == "vertex")
+			vertElem = &e;
+		else if (e.name == "face")
+			faceElem = &e;
+		else if (e.count > 0)
+			return false; // e.g. camera, edges, materials
+	}
+	if (vertElem == nullptr || vertElem->count > std::numeric_limits<int>::max() ||
+		(faceElem != nullptr && faceElem->count > std::numeric_limits<int>::max()))
+		return false;
+
+	// vertex properties
+	const PlyProperty* px = vertElem->property("x");
+	const PlyProperty* py = vertElem->property("y");
+	const PlyProperty* pz = vertElem->property("z");
+	const PlyProperty* pnx = vertElem->property("nx");
+	const PlyProperty* pny = vertElem->property("ny");
+	const PlyProperty* pnz = vertElem->property("nz");
+	const PlyProperty* pvq = vertElem->property("quality");
+	const PlyProperty* pvr = vertElem->property("radius");
+	const PlyProperty* pvf = vertElem->property("flags");
+	const PlyProperty* pu = vertElem->property("texture_u");
+	const PlyProperty* pv = vertElem->property("texture_v");
+	if (pu == nullptr || pv == nullptr) {
+		pu = vertElem->property("s");
+		pv = vertElem->property("t");
+	}
+	PlyColor vertColor(*vertElem);
+
+	// face properties
+	const PlyProperty* pind = nullptr;
+	const PlyProperty* pfq = nullptr;
+	const PlyProperty* pff = nullptr;
+	PlyColor faceColor = faceElem ? PlyColor(*faceElem) : PlyColor(PlyElement());
+	if (faceElem != nullptr) {
+		pind = faceElem->property("vertex_indices");
+		if (pind == nullptr)
+			pind = faceElem->property("vertex_index");
+		pfq = faceElem->property("quality");
+		pff = faceElem->property("flags");
+		if (pind == nullptr || !pind->isList)
+			return false;
+	}
+
+	// everything that LoadMask found must be decoded here
+	int decodedMask = 0;
+	if (px && py && pz)
+		decodedMask |= tri::io::Mask::IOM_VERTCOORD;
+	if (pnx && pny && pnz)
+		decodedMask |= tri::io::Mask::IOM_VERTNORMAL;
+	if (vertColor.valid())
+		decodedMask |= tri::io::Mask::IOM_VERTCOLOR;
+	if (pvq)
+		decodedMask |= tri::io::Mask::IOM_VERTQUALITY;
+	if (pvr)
+		decodedMask |= tri::io::Mask::IOM_VERTRADIUS;
+	if (pvf)
+		decodedMask |= tri::io::Mask::IOM_VERTFLAGS;
+	if (pu && pv)
+		decodedMask |= tri::io::Mask::IOM_VERTTEXCOORD;
+	if (pind)
+		decodedMask |= tri::io::Mask::IOM_FACEINDEX;
+	if (faceColor.valid())
+		decodedMask |= tri::io::Mask::IOM_FACECOLOR;
+	if (pfq)
+		decodedMask |= tri::io::Mask::IOM_FACEQUALITY;
+	if (pff)
+		decodedMask |= tri::io::Mask::IOM_FACEFLAGS;
+	if (!(decodedMask & tri::io::Mask::IOM_VERTCOORD) || (mask & ~decodedMask) != 0)
+		return false;
+
+	const bool normals   = (mask & tri::io::Mask::IOM_VERTNORMAL) && tri::HasPerVertexNormal(m);
+	const bool vColors   = (mask & tri::io::Mask::IOM_VERTCOLOR) && tri::HasPerVertexColor(m);
+	const bool vQuality  = (mask & tri::io::Mask::IOM_VERTQUALITY) && tri::HasPerVertexQuality(m);
+	const bool vRadius   = (mask & tri::io::Mask::IOM_VERTRADIUS) && tri::HasPerVertexRadius(m);
+	const bool vFlags    = (mask & tri::io::Mask::IOM_VERTFLAGS) && tri::HasPerVertexFlags(m);
+	const bool vTexCoord = (mask & tri::io::Mask::IOM_VERTTEXCOORD) && tri::HasPerVertexTexCoord(m);
+	const bool fColors   = (mask & tri::io::Mask::IOM_FACECOLOR) && tri::HasPerFaceColor(m);
+	const bool fQuality  = (mask & tri::io::Mask::IOM_FACEQUALITY) && tri::HasPerFaceQuality(m);
+	const bool fFlags    = (mask & tri::io::Mask::IOM_FACEFLAGS) && tri::HasPerFaceFlags(m);
+
+	m.Clear();
+	const int vn = (int) vertElem->count;
+	const int fn = faceElem ? (int) faceElem->count : 0;
+	if (vn > 0)
+		tri::Allocator<CMeshO>::AddVertices(m, vn);
+	if (fn > 0)
+		tri::Allocator<CMeshO>::AddFaces(m, fn);
+	m.textures = textures;
+
+	if (cb != nullptr)
+		(*cb)(10, "Decoding vertices...");
+
+	const uchar* vertData = data + vertElem->offset;
+	const unsigned int vertStride = vertElem->stride;
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < vn; ++i) {
+		const uchar* rec = vertData + (qint64) i * vertStride;
+		CVertexO& v = m.vert[i];
+		v.P() = Point3m(
+			readValue<Scalarm>(rec + px->offset, px->type, bigEndian),
+			readValue<Scalarm>(rec + py->offset, py->type, bigEndian),
+			readValue<Scalarm>(rec + pz->offset, pz->type, bigEndian));
+		if (normals) {
+			v.N() = Point3m(
+				readValue<Scalarm>(rec + pnx->offset, pnx->type, bigEndian),
+				readValue<Scalarm>(rec + pny->offset, pny->type, bigEndian),
+				readValue<Scalarm>(rec + pnz->offset, pnz->type, bigEndian));
+		}
+		if (vColors)
+			v.C() = vertColor.read(rec, bigEndian);
+		if (vQuality)
+			v.Q() = readValue<Scalarm>(rec + pvq->offset, pvq->type, bigEndian);
+		if (vRadius)
+			v.R() = readValue<Scalarm>(rec + pvr->offset, pvr->type, bigEndian);
+		if (vFlags)
+			v.Flags() = readValue<int>(rec + pvf->offset, pvf->type, bigEndian);
+		if (vTexCoord) {
+			v.T().U() = readValue<Scalarm>(rec + pu->offset, pu->type, bigEndian);
+			v.T().V() = readValue<Scalarm>(rec + pv->offset, pv->type, bigEndian);
+		}
+	}
+
+	if (cb != nullptr)
+		(*cb)(50, "Decoding faces...");
+
+	std::atomic<bool> invalid(false);
+	if (fn > 0) {
+		const uchar* faceData = data + faceElem->offset;
+		const unsigned int faceStride = faceElem->stride;
+		const unsigned int countSize = plyTypeSize(pind->countType);
+		const unsigned int indexSize = plyTypeSize(pind->type);
+		#pragma omp parallel for schedule(static)
+		for (int i = 0; i < fn; ++i) {
+			const uchar* rec = faceData + (qint64) i * faceStride;
+			const uchar* list = rec + pind->offset;
+			if (readValue<int>(list, pind->countType, bigEndian) != 3) {
+				invalid = true;
+				continue;
+			}
+			CFaceO& f = m.face[i];
+			for (int k = 0; k < 3; ++k) {
+				qint64 ind = readValue<qint64>(list + countSize + k * indexSize, pind->type, bigEndian);
+				if (ind < 0 || ind >= vn) {
+					invalid = true;
+					ind = 0;
+				}
+				f.V(k) = vn > 0 ? &m.vert[ind] : nullptr;
+			}
+			if (fColors)
+				f.C() = faceColor.read(rec, bigEndian);
+			if (fQuality)
+				f.Q() = readValue<Scalarm>(rec + pfq->offset, pfq->type, bigEndian);
+			if (fFlags)
+				f.Flags() = readValue<int>(rec + pff->offset, pff->type, bigEndian);
+		}
+	}
+
+	if (invalid) {
+		// polygonal faces or wrong indices: let ImporterPLY deal with them
+		m.Clear();
+		return false;
+	}
+
+	if (cb != nullptr)
+		(*cb)(99, "Done");
+	return true;
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef LOAD_PLY_BINARY_H
+#define LOAD_PLY_BINARY_H
+
+#include <common/ml_document/cmesh.h>
+#include <wrap/callback.h>
+
+/**
+ * @brief Fast path for binary triangle PLY files: the file is memory mapped,
+ * the offsets of the elements are computed from the header, and the vertex
+ * and face blocks are decoded in parallel directly into the (preallocated)
+ * vectors of the mesh.
+ *
+ * The mask must be the one returned by ImporterPLY::LoadMask, and the
+ * corresponding optional components must already be enabled in the mesh.
+ *
+ * Returns false, leaving the mesh empty, if the file cannot be handled by the
+ * fast path (ascii files, polygonal faces, elements or properties that are
+ * not listed in the mask, invalid indices...): in this case the file should
+ * be loaded with ImporterPLY::Open, that will also report any error.
+ */
+bool loadBinaryPLY(
+		const QString& fileName,
+		CMeshO& m,
+		int mask,
+		vcg::CallBackPos* cb = nullptr);
+
+#endif // LOAD_PLY_BINARY_H
@@ -155,12 +155,118 @@ std::vector<MeshModel*> loadNVM(
 	return meshList;
 }
 
+namespace {
+
+/**
+ * @brief A layer entry of the MeshGroup of a MeshLab project, parsed before
+ * loading the meshes.
+ */
+struct MLPLayer
+{
+	QString filename;
+	QString label;
+	bool visible = true;
+	int idInFile = -1;
+	bool hasTransform = false;
+	Matrix44m transform;
+	bool hasRenderingData = false;
+	MLRenderingData renderingData;
+};
+
+MLPLayer parseMLPLayer(const QDomNode& mesh, bool binary)
+{
+	MLPLayer layer;
+	layer.filename = mesh.attributes().namedItem("filename").nodeValue();
+	layer.label = mesh.attributes().namedItem("label").nodeValue();
+	if (mesh.attributes().contains("visible"))
+		layer.visible = (mesh.attributes().namedItem("visible").nodeValue().toInt() == 1);
+	if (mesh.attributes().contains("idInFile")){
+		layer.idInFile = mesh.attributes().namedItem("idInFile").nodeValue().toInt();
+	}
+
+	QDomNode tr = mesh.firstChildElement("MLMatrix44");
+
+	if (!tr.isNull()) {
+		if (tr.childNodes().size() == 1) {
+			layer.hasTransform = true;
+			layer.transform.SetIdentity();
+			if (!binary) {
+				QStringList rows = tr.firstChild().nodeValue().split("\n", QString::SkipEmptyParts);
+				int i = 0;
+				for (const QString& row : qAsConst(rows)){
+					if (rows.size() > 0) {
+						QStringList values = row.split(" ", QString::SkipEmptyParts);
+						int j = 0;
+						for (const QString& value : qAsConst(values)) {
+							if (i < 4 && j < 4) {
+								layer.transform[i][j] = value.toFloat();
+								j++;
+							}
+						}
+						i++;
+					}
+				}
+			}
+			else {
+				QString str = tr.firstChild().nodeValue();
+				QByteArray value = QByteArray::fromBase64(str.toLocal8Bit());
+				memcpy(layer.transform.V(), value.data(), sizeof(Matrix44m::ScalarType) * 16);
+			}
+		}
+	}
+
+	QDomNode renderingOpt = mesh.firstChildElement("RenderingOption");
+	if (!renderingOpt.isNull())
+	{
+		QString value = renderingOpt.firstChild().nodeValue();
+		MLRenderingData::GLOptionsType opt;
+		if (renderingOpt.attributes().contains("pointSize"))
+			opt._perpoint_pointsize = renderingOpt.attributes().namedItem("pointSize").nodeValue().toFloat();
+		if (renderingOpt.attributes().contains("wireWidth"))
+			opt._perwire_wirewidth = renderingOpt.attributes().namedItem("wireWidth").nodeValue().toFloat();
+		if (renderingOpt.attributes().contains("boxColor"))
+		{
+			QStringList values = renderingOpt.attributes().namedItem("boxColor").nodeValue().split(" ", QString::SkipEmptyParts);
+			opt._perbbox_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+		}
+		if (renderingOpt.attributes().contains("pointColor"))
+		{
+			QStringList values = renderingOpt.attributes().namedItem("pointColor").nodeValue().split(" ", QString::SkipEmptyParts);
+			opt._perpoint_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+		}
+		if (renderingOpt.attributes().contains("wireColor"))
+		{
+			QStringList values = renderingOpt.attributes().namedItem("wireColor").nodeValue().split(" ", QString::SkipEmptyParts);
+			opt._perwire_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+		}
+		if (renderingOpt.attributes().contains("solidColor"))
+		{
+			QStringList values = renderingOpt.attributes().namedItem("solidColor").nodeValue().split(" ", QString::SkipEmptyParts);
+			opt._persolid_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+		}
+		layer.renderingData.set(opt);
+		layer.hasRenderingData = layer.renderingData.deserialize(value.toStdString());
+	}
+	return layer;
+}
+
+} // namespace
+
+/**
+ * @brief Loads a MeshLab project (MLP or MLB).
+ *
+ * All the layer entries are parsed first; then the mesh files are loaded
+ * all together (concurrently, when their formats allow it) into MeshModels
+ * that are created following the order of the layers. Transforms, labels
+ * and rendering options are attached afterwards. If a mesh file cannot be
+ * loaded, none of the meshes of the project is kept.
+ */
 std::vector<MeshModel*> loadMLP(
 		const QString& filename,
 		MeshDocument& md,
 		std::vector<MLRenderingData>& rendOpt,
 		std::vector<std::string>& unloadedImgList,
-		vcg::CallBackPos*)
+		vcg::CallBackPos* cb)
 {
 	std::vector<MeshModel*> meshList;
 	unloadedImgList.clear();
@@ -183,149 +289,103 @@ std::vector<MeshModel*> loadMLP(
 
 	node = root.firstChild();
 
-	QDir tmpDir = QDir::current();
-	QDir::setCurrent(qfInfo.absoluteDir().absolutePath());
-	//Devices
+	std::vector<MLPLayer> layers;
+	std::vector<QDomNode> rasterGroups;
 	while (!node.isNull()) {
 		if (QString::compare(node.nodeName(), "MeshGroup") == 0) {
-			QDomNode mesh;
-			QString filen, label;
-			mesh = node.firstChild();
+			QDomNode mesh = node.firstChild();
 			while (!mesh.isNull()) {
-				//return true;
-				filen = mesh.attributes().namedItem("filename").nodeValue();
-				label = mesh.attributes().namedItem("label").nodeValue();
-				bool visible = true;
-				if (mesh.attributes().contains("visible"))
-					visible = (mesh.attributes().namedItem("visible").nodeValue().toInt() == 1);
-				//MeshModel* mm = md.addNewMesh(filen, label);
-
-				//mm->visible = visible;
-
-				int idInFile = -1;
-				if (mesh.attributes().contains("idInFile")){
-					idInFile = mesh.attributes().namedItem("idInFile").nodeValue().toInt();
-				}
-				if (idInFile <= 0){
-					//load the file just if it is the first layer contained
-					//in the file (or it is the only one)
-					try {
-						auto tmp = meshlab::loadMeshWithStandardParameters(filen, md);
-						for (auto m : tmp){
-							m->setVisible(visible);
-							m->setLabel(label);
-						}
-						meshList.insert(meshList.end(), tmp.begin(), tmp.end());
-					}
-					catch(const MLException& e) {
-						for (MeshModel* mm : meshList)
-							md.delMesh(mm->id());
-						throw MLException(filen + " mesh file not found.");
-					}
-				}
+				layers.push_back(parseMLPLayer(mesh, binary));
+				mesh = mesh.nextSibling();
+			}
+		}
+		// READ IN POINT CORRESPONDECES INCOMPLETO!!
+		else if (QString::compare(node.nodeName(), "RasterGroup") == 0) {
+			rasterGroups.push_back(node);
+		}
+		node = node.nextSibling();
+	}
 
-				QDomNode tr = mesh.firstChildElement("MLMatrix44");
-
-				if (!tr.isNull()) {
-					vcg::Matrix44f trm;
-					if (tr.childNodes().size() == 1) {
-						if (!binary) {
-							QStringList rows = tr.firstChild().nodeValue().split("\n", QString::SkipEmptyParts);
-							int i = 0;
-							for (const QString& row : qAsConst(rows)){
-								if (rows.size() > 0) {
-									QStringList values = row.split(" ", QString::SkipEmptyParts);
-									int j = 0;
-									for (const QString& value : qAsConst(values)) {
-										if (i < 4 && j < 4) {
-											md.mm()->cm.Tr[i][j] = value.toFloat();
-											j++;
-										}
-									}
-									i++;
-								}
-							}
-						}
-						else {
-							QString str = tr.firstChild().nodeValue();
-							QByteArray value = QByteArray::fromBase64(str.toLocal8Bit());
-							memcpy(md.mm()->cm.Tr.V(), value.data(), sizeof(Matrix44m::ScalarType) * 16);
-						}
-					}
-				}
+	QDir tmpDir = QDir::current();
+	QDir::setCurrent(qfInfo.absoluteDir().absolutePath());
 
-				QDomNode renderingOpt = mesh.firstChildElement("RenderingOption");
-				if (!renderingOpt.isNull())
-				{
-					QString value = renderingOpt.firstChild().nodeValue();
-					MLRenderingData::GLOptionsType opt;
-					if (renderingOpt.attributes().contains("pointSize"))
-						opt._perpoint_pointsize = renderingOpt.attributes().namedItem("pointSize").nodeValue().toFloat();
-					if (renderingOpt.attributes().contains("wireWidth"))
-						opt._perwire_wirewidth = renderingOpt.attributes().namedItem("wireWidth").nodeValue().toFloat();
-					if (renderingOpt.attributes().contains("boxColor"))
-					{
-						QStringList values = renderingOpt.attributes().namedItem("boxColor").nodeValue().split(" ", QString::SkipEmptyParts);
-						opt._perbbox_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
-					}
-					if (renderingOpt.attributes().contains("pointColor"))
-					{
-						QStringList values = renderingOpt.attributes().namedItem("pointColor").nodeValue().split(" ", QString::SkipEmptyParts);
-						opt._perpoint_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
-					}
-					if (renderingOpt.attributes().contains("wireColor"))
-					{
-						QStringList values = renderingOpt.attributes().namedItem("wireColor").nodeValue().split(" ", QString::SkipEmptyParts);
-						opt._perwire_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
-					}
-					if (renderingOpt.attributes().contains("solidColor"))
-					{
-						QStringList values = renderingOpt.attributes().namedItem("solidColor").nodeValue().split(" ", QString::SkipEmptyParts);
-						opt._persolid_fixed_color = vcg::Color4b(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
-					}
-					MLRenderingData data;
-					data.set(opt);
-					if (data.deserialize(value.toStdString()))
-						rendOpt.push_back(data);
-				}
+	// a file is loaded just for the first layer contained in the file (or
+	// if it is the only one)
+	QStringList files;
+	for (const MLPLayer& layer : layers) {
+		if (layer.idInFile <= 0)
+			files.push_back(layer.filename);
+	}
 
-				mesh = mesh.nextSibling();
+	std::vector<std::list<MeshModel*>> fileMeshes;
+	int failedFile = -1;
+	try {
+		fileMeshes = meshlab::loadMeshesWithStandardParameters(files, md, cb, &failedFile);
+	}
+	catch(const MLException& e) {
+		QDir::setCurrent(tmpDir.absolutePath());
+		if (failedFile >= 0)
+			throw MLException(files[failedFile] + " mesh file not found.");
+		throw MLException(QString::fromLocal8Bit(e.what()));
+	}
+
+	int currentFile = -1;
+	for (const MLPLayer& layer : layers) {
+		MeshModel* mm = nullptr;
+		if (layer.idInFile <= 0) {
+			++currentFile;
+			for (MeshModel* m : fileMeshes[currentFile]){
+				m->setVisible(layer.visible);
+				m->setLabel(layer.label);
 			}
+			meshList.insert(meshList.end(), fileMeshes[currentFile].begin(), fileMeshes[currentFile].end());
+			if (!fileMeshes[currentFile].empty())
+				mm = fileMeshes[currentFile].front();
 		}
-		// READ IN POINT CORRESPONDECES INCOMPLETO!!
-		else if (QString::compare(node.nodeName(), "RasterGroup") == 0)
+		else if (currentFile >= 0 && layer.idInFile < (int) fileMeshes[currentFile].size()) {
+			// other layers contained in the last loaded file
+			mm = *std::next(fileMeshes[currentFile].begin(), layer.idInFile);
+			mm->setVisible(layer.visible);
+			mm->setLabel(layer.label);
+		}
+
+		if (mm != nullptr && layer.hasTransform)
+			mm->cm.Tr = layer.transform;
+		if (layer.hasRenderingData)
+			rendOpt.push_back(layer.renderingData);
+	}
+
+	for (const QDomNode& group : rasterGroups)
+	{
+		QDomNode raster;
+		raster = group.firstChild();
+		while (!raster.isNull())
 		{
-			QDomNode raster;
-			raster = node.firstChild();
-			while (!raster.isNull())
+			//return true;
+			md.addNewRaster();
+			QString labelRaster = raster.attributes().namedItem("label").nodeValue();
+			md.rm()->setLabel(labelRaster);
+			QDomNode sh = raster.firstChild();
+			ReadShotFromQDomNode(md.rm()->shot, sh);
+
+			QDomElement el = raster.firstChildElement("Plane");
+			while (!el.isNull())
 			{
-				//return true;
-				md.addNewRaster();
-				QString labelRaster = raster.attributes().namedItem("label").nodeValue();
-				md.rm()->setLabel(labelRaster);
-				QDomNode sh = raster.firstChild();
-				ReadShotFromQDomNode(md.rm()->shot, sh);
-
-				QDomElement el = raster.firstChildElement("Plane");
-				while (!el.isNull())
-				{
-					QString filen = el.attribute("fileName");
-					QFileInfo fi(filen);
-					QString nm = fi.absoluteFilePath();
-					QImage img(":/img/dummy.png");
-					try {
-						img = meshlab::loadImage(nm);
-					}
-					catch(const MLException& e){
-						unloadedImgList.push_back(nm.toStdString());
-					}
-					md.rm()->addPlane(new RasterPlane(img, nm, RasterPlane::RGBA));
-					el = node.nextSiblingElement("Plane");
+				QString filen = el.attribute("fileName");
+				QFileInfo fi(filen);
+				QString nm = fi.absoluteFilePath();
+				QImage img(":/img/dummy.png");
+				try {
+					img = meshlab::loadImage(nm);
 				}
-				raster = raster.nextSibling();
+				catch(const MLException& e){
+					unloadedImgList.push_back(nm.toStdString());
+				}
+				md.rm()->addPlane(new RasterPlane(img, nm, RasterPlane::RGBA));
+				el = group.nextSiblingElement("Plane");
 			}
+			raster = raster.nextSibling();
 		}
-		node = node.nextSibling();
 	}
 
 	QDir::setCurrent(tmpDir.absolutePath());
@@ -0,0 +1,522 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "load_text_mesh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <string>
+
+#include <QFile>
+
+#include <common/utilities/text_parsing.h>
+#include <wrap/io_trimesh/import_obj.h>
+#include <wrap/io_trimesh/io_mask.h>
+
+using namespace vcg;
+using meshlab::TextChunk;
+
+namespace {
+
+/**
+ * @brief the whole content of a file, memory mapped
+ */
+struct MappedTextFile
+{
+	QFile file;
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	explicit MappedTextFile(const QString& fileName) : file(fileName)
+	{
+		if (file.open(QIODevice::ReadOnly) && file.size() > 0) {
+			begin = (const char*) file.map(0, file.size());
+			if (begin != nullptr)
+				end = begin + file.size();
+		}
+	}
+
+	bool isValid() const { return begin != nullptr; }
+};
+
+/**
+ * @brief the elements of a chunk, and the position of its first ones in the
+ * vectors of the mesh (tn and nn are the OBJ texture coords and normals)
+ */
+struct ChunkCount
+{
+	int vn = 0;
+	int fn = 0;
+	int tn = 0;
+	int nn = 0;
+	int firstVert = 0;
+	int firstFace = 0;
+	int firstTex = 0;
+	int firstNorm = 0;
+};
+
+/**
+ * @brief prefix sum of the counts of the chunks. Returns false if the mesh
+ * would be too large.
+ */
+bool computeChunkOffsets(std::vector<ChunkCount>& counts, int& vn, int& fn, int& tn, int& nn)
+{
+	long long v = 0, f = 0, t = 0, n = 0;
+	const long long maxCount = std::numeric_limits<int>::max();
+	for (ChunkCount& c : counts) {
+		c.firstVert = (int) v;
+		c.firstFace = (int) f;
+		c.firstTex = (int) t;
+		c.firstNorm = (int) n;
+		v += c.vn;
+		f += c.fn;
+		t += c.tn;
+		n += c.nn;
+		if (v > maxCount || f > maxCount || t > maxCount || n > maxCount)
+			return false;
+	}
+	vn = (int) v;
+	fn = (int) f;
+	tn = (int) t;
+	nn = (int) n;
+	return true;
+}
+
+bool computeChunkOffsets(std::vector<ChunkCount>& counts, int& vn, int& fn)
+{
+	int tn, nn;
+	return computeChunkOffsets(counts, vn, fn, tn, nn);
+}
+
+/**
+ * @brief parses the three coordinates of a vertex, that must be the only
+ * content of the rest of the line
+ */
+inline bool parseVertex(const char*& p, const char* end, CVertexO& v)
+{
+	double x, y, z;
+	if (!meshlab::parseDouble(p, end, x) || !meshlab::parseDouble(p, end, y) ||
+		!meshlab::parseDouble(p, end, z) || !meshlab::isEndOfLine(p, end))
+		return false;
+	v.P() = Point3m(x, y, z);
+	return true;
+}
+
+/**
+ * @brief the types of the lines of an OBJ file
+ */
+enum class ObjLine
+{
+	EMPTY,
+	VERTEX,
+	TEXCOORD,
+	NORMAL,
+	FACE,
+	USEMTL,
+	MTLLIB,
+	IGNORED,
+	UNSUPPORTED
+};
+
+/**
+ * @brief reads the keyword of the OBJ line starting at p, leaving p after it
+ */
+inline ObjLine objLineType(const char*& p, const char* end)
+{
+	p = meshlab::skipBlanks(p, end);
+	if (p == end || *p == '\n' || *p == '#')
+		return ObjLine::EMPTY;
+	const char* keyword = p;
+	while (p < end && !meshlab::isBlank(*p) && *p != '\n')
+		++p;
+	const std::ptrdiff_t len = p - keyword;
+	if (len == 1) {
+		switch (*keyword) {
+		case 'v': return ObjLine::VERTEX;
+		case 'f': return ObjLine::FACE;
+		// groups, objects and smoothing groups are not used by ImporterOBJ
+		case 'g':
+		case 'o':
+		case 's': return ObjLine::IGNORED;
+		}
+	}
+	else if (len == 2 && keyword[0] == 'v') {
+		if (keyword[1] == 't')
+			return ObjLine::TEXCOORD;
+		if (keyword[1] == 'n')
+			return ObjLine::NORMAL;
+	}
+	else if (len == 6) {
+		if (std::equal(keyword, p, "usemtl"))
+			return ObjLine::USEMTL;
+		if (std::equal(keyword, p, "mtllib"))
+			return ObjLine::MTLLIB;
+	}
+	return ObjLine::UNSUPPORTED;
+}
+
+/**
+ * @brief reads the single name that follows usemtl/mtllib. Returns false if
+ * it is missing or contains blanks.
+ */
+inline bool objLineName(const char* p, const char* end, std::string& name)
+{
+	p = meshlab::skipBlanks(p, end);
+	const char* s = p;
+	while (p < end && !meshlab::isBlank(*p) && *p != '\n')
+		++p;
+	if (p == s || !meshlab::isEndOfLine(p, end))
+		return false;
+	name.assign(s, p);
+	return true;
+}
+
+/**
+ * @brief a usemtl or mtllib line of a chunk; material is the index of the
+ * material selected by a usemtl, resolved after the first pass
+ */
+struct ObjMaterialLine
+{
+	ObjLine type;
+	std::string name;
+	int material = 0;
+};
+
+/**
+ * @brief parses the optional texture and normal references of a face
+ * corner (v/vt/vn, v//vn, v/vt), that are 0 if missing
+ */
+inline bool parseCornerRefs(const char*& p, const char* end, long long& tex, long long& norm)
+{
+	tex = norm = 0;
+	if (p == end || *p != '/')
+		return true;
+	++p;
+	if (p < end && *p != '/' && (!meshlab::parseInt(p, end, tex) || tex == 0))
+		return false;
+	if (p == end || *p != '/')
+		return true;
+	++p;
+	return meshlab::parseInt(p, end, norm) && norm != 0;
+}
+
+} // namespace
+
+bool loadTextOBJ(const QString& fileName, CMeshO& m, int& mask)
+{
+	MappedTextFile f(fileName);
+	if (!f.isValid())
+		return false;
+
+	std::vector<TextChunk> chunks = meshlab::splitTextInChunks(f.begin, f.end);
+	std::vector<ChunkCount> counts(chunks.size());
+	std::vector<std::vector<ObjMaterialLine>> materialLines(chunks.size());
+	std::atomic<bool> unsupported(false);
+
+	// first pass: count the elements of each chunk
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		const char* end = chunks[c].end;
+		for (const char* p = chunks[c].begin; p < end && !unsupported; p = meshlab::nextLine(p, end)) {
+			ObjLine type = objLineType(p, end);
+			switch (type) {
+			case ObjLine::VERTEX: ++counts[c].vn; break;
+			case ObjLine::TEXCOORD: ++counts[c].tn; break;
+			case ObjLine::NORMAL: ++counts[c].nn; break;
+			case ObjLine::FACE: ++counts[c].fn; break;
+			case ObjLine::USEMTL:
+			case ObjLine::MTLLIB: {
+				ObjMaterialLine line;
+				line.type = type;
+				if (objLineName(p, end, line.name))
+					materialLines[c].push_back(line);
+				else
+					unsupported = true;
+				break;
+			}
+			case ObjLine::UNSUPPORTED: unsupported = true; break;
+			default: break;
+			}
+		}
+	}
+	int vn, fn, tn, nn;
+	if (unsupported || !computeChunkOffsets(counts, vn, fn, tn, nn))
+		return false;
+
+	// materials are resolved serially, in file order, as done by ImporterOBJ:
+	// the first one is the default material, used before any usemtl
+	std::vector<tri::io::Material> materials(1);
+	materials[0].index = (unsigned int) (-1);
+	std::vector<Color4b> materialColors(1, Color4b::LightGray);
+	std::vector<std::string> textures;
+	std::vector<int> chunkMaterial(chunks.size());
+	bool useMaterials = false;
+	int current = 0;
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		chunkMaterial[c] = current;
+		for (ObjMaterialLine& line : materialLines[c]) {
+			if (line.type == ObjLine::MTLLIB) {
+				// a missing library is reported by ImporterOBJ
+				if (!tri::io::ImporterOBJ<CMeshO>::LoadMaterials(line.name.c_str(), materials, textures))
+					return false;
+				while (materialColors.size() < materials.size()) {
+					const tri::io::Material& mat = materials[materialColors.size()];
+					materialColors.push_back(Color4b(
+						(unsigned char) (mat.Kd[0] * 255.0),
+						(unsigned char) (mat.Kd[1] * 255.0),
+						(unsigned char) (mat.Kd[2] * 255.0),
+						(unsigned char) (mat.Tr * 255.0)));
+				}
+			}
+			else {
+				useMaterials = true;
+				auto it = std::find_if(
+					materials.begin(), materials.end(), [&](const tri::io::Material& mat) {
+						return mat.materialName == line.name;
+					});
+				// unknown materials are left to ImporterOBJ
+				if (it == materials.end())
+					return false;
+				current = line.material = it - materials.begin();
+			}
+		}
+	}
+
+	m.Clear();
+	if (vn > 0)
+		tri::Allocator<CMeshO>::AddVertices(m, vn);
+	if (fn > 0)
+		tri::Allocator<CMeshO>::AddFaces(m, fn);
+
+	// per face corner texture coord index and per face material, assigned
+	// after all the texture coords have been read
+	std::vector<int> cornerTex(tn > 0 ? fn * 3 : 0);
+	std::vector<int> faceMaterial(useMaterials ? fn : 0);
+	std::vector<TexCoord2f> texCoords(tn);
+
+	// second pass: parse the elements in their final position
+	std::atomic<bool> invalid(false);
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		const char* end = chunks[c].end;
+		int vi = counts[c].firstVert;
+		int fi = counts[c].firstFace;
+		int ti = counts[c].firstTex;
+		int ni = counts[c].firstNorm;
+		int material = chunkMaterial[c];
+		auto materialLine = materialLines[c].begin();
+		for (const char* p = chunks[c].begin; p < end && !invalid; p = meshlab::nextLine(p, end)) {
+			ObjLine type = objLineType(p, end);
+			if (type == ObjLine::VERTEX) {
+				if (!parseVertex(p, end, m.vert[vi++]))
+					invalid = true;
+			}
+			else if (type == ObjLine::TEXCOORD) {
+				double u, v, w;
+				if (!meshlab::parseDouble(p, end, u) || !meshlab::parseDouble(p, end, v) ||
+					(!meshlab::isEndOfLine(p, end) &&
+					 (!meshlab::parseDouble(p, end, w) || !meshlab::isEndOfLine(p, end))))
+					invalid = true;
+				else
+					texCoords[ti++] = TexCoord2f((float) u, (float) v);
+			}
+			else if (type == ObjLine::NORMAL) {
+				// CMeshO has no wedge normals: they are just validated, and
+				// the vertex normals are computed after loading
+				double x, y, z;
+				if (!meshlab::parseDouble(p, end, x) || !meshlab::parseDouble(p, end, y) ||
+					!meshlab::parseDouble(p, end, z) || !meshlab::isEndOfLine(p, end))
+					invalid = true;
+				++ni;
+			}
+			else if (type == ObjLine::USEMTL) {
+				material = (materialLine++)->material;
+			}
+			else if (type == ObjLine::MTLLIB) {
+				++materialLine;
+			}
+			else if (type == ObjLine::FACE) {
+				CFaceO& face = m.face[fi];
+				for (int k = 0; k < 3 && !invalid; ++k) {
+					long long ind, tex, norm;
+					if (!meshlab::parseInt(p, end, ind) || !parseCornerRefs(p, end, tex, norm)) {
+						invalid = true;
+						break;
+					}
+					// negative indices are relative to the elements read so far
+					ind = ind < 0 ? vi + ind : ind - 1;
+					tex = tex < 0 ? ti + tex : tex - 1;
+					norm = norm < 0 ? ni + norm : norm - 1;
+					// texture and normal references must be given for all the
+					// corners when the file has them, as ImporterOBJ expects
+					if (ind < 0 || ind >= vn || (tn > 0 ? tex < 0 || tex >= tn : tex != -1) ||
+						(nn > 0 ? norm < 0 || norm >= nn : norm != -1)) {
+						invalid = true;
+					}
+					else {
+						face.V(k) = &m.vert[ind];
+						if (tn > 0)
+							cornerTex[fi * 3 + k] = (int) tex;
+					}
+				}
+				if (!meshlab::isEndOfLine(p, end))
+					invalid = true; // polygons
+				if (useMaterials)
+					faceMaterial[fi] = material;
+				++fi;
+			}
+		}
+	}
+	if (invalid) {
+		m.Clear();
+		return false;
+	}
+
+	mask = tri::io::Mask::IOM_VERTCOORD | tri::io::Mask::IOM_FACEINDEX;
+	if (tn > 0)
+		mask |= tri::io::Mask::IOM_WEDGTEXCOORD;
+	if (nn > 0)
+		mask |= tri::io::Mask::IOM_WEDGNORMAL;
+	if (useMaterials)
+		mask |= tri::io::Mask::IOM_FACECOLOR;
+
+	// third pass: wedge texture coords and face colors of the materials
+	if (tn > 0)
+		m.face.EnableWedgeTexCoord();
+	if (useMaterials)
+		m.face.EnableColor();
+	if (tn > 0 || useMaterials) {
+		#pragma omp parallel for schedule(static)
+		for (int i = 0; i < fn; ++i) {
+			CFaceO& face = m.face[i];
+			const int material = useMaterials ? faceMaterial[i] : 0;
+			if (tn > 0) {
+				for (int k = 0; k < 3; ++k) {
+					face.WT(k) = texCoords[cornerTex[i * 3 + k]];
+					face.WT(k).N() = (short) materials[material].index;
+				}
+			}
+			if (useMaterials)
+				face.C() = materialColors[material];
+		}
+	}
+	m.textures = textures;
+	return true;
+}
+
+bool loadTextOFF(const QString& fileName, CMeshO& m, int& mask)
+{
+	MappedTextFile f(fileName);
+	if (!f.isValid())
+		return false;
+
+	// header: "OFF" and the number of vertices, faces and edges
+	const char* p = f.begin;
+	auto nextDataLine = [&]() {
+		while (p < f.end) {
+			const char* s = meshlab::skipBlanks(p, f.end);
+			if (s < f.end && *s != '\n' && *s != '#')
+				break;
+			p = meshlab::nextLine(p, f.end);
+		}
+		p = meshlab::skipBlanks(p, f.end);
+	};
+	nextDataLine();
+	if (f.end - p < 3 || std::string(p, 3) != "OFF" || !meshlab::isEndOfLine(p + 3, f.end))
+		return false; // COFF, NOFF, binary OFF...
+	p = meshlab::nextLine(p, f.end);
+	nextDataLine();
+	long long hvn, hfn, hen;
+	if (!meshlab::parseInt(p, f.end, hvn) || !meshlab::parseInt(p, f.end, hfn) ||
+		!meshlab::parseInt(p, f.end, hen) || !meshlab::isEndOfLine(p, f.end))
+		return false;
+	if (hvn < 0 || hfn < 0 || hvn > std::numeric_limits<int>::max() ||
+		hfn > std::numeric_limits<int>::max())
+		return false;
+	const int vn = (int) hvn;
+	const int fn = (int) hfn;
+	p = meshlab::nextLine(p, f.end);
+
+	// first pass: count the data lines of each chunk (stored as vertices)
+	std::vector<TextChunk> chunks = meshlab::splitTextInChunks(p, f.end);
+	std::vector<ChunkCount> counts(chunks.size());
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		const char* end = chunks[c].end;
+		for (const char* q = chunks[c].begin; q < end; q = meshlab::nextLine(q, end)) {
+			const char* s = meshlab::skipBlanks(q, end);
+			if (s < end && *s != '\n' && *s != '#')
+				++counts[c].vn;
+		}
+	}
+	int nLines, unused;
+	if (!computeChunkOffsets(counts, nLines, unused) || (long long) nLines != hvn + hfn)
+		return false; // edges or other data that is not handled here
+
+	m.Clear();
+	if (vn > 0)
+		tri::Allocator<CMeshO>::AddVertices(m, vn);
+	if (fn > 0)
+		tri::Allocator<CMeshO>::AddFaces(m, fn);
+
+	// second pass: the first vn lines are vertices, the next fn are faces
+	std::atomic<bool> invalid(false);
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		const char* end = chunks[c].end;
+		int line = counts[c].firstVert;
+		for (const char* q = chunks[c].begin; q < end && !invalid; q = meshlab::nextLine(q, end)) {
+			const char* s = meshlab::skipBlanks(q, end);
+			if (s == end || *s == '\n' || *s == '#')
+				continue;
+			if (line < vn) {
+				if (!parseVertex(s, end, m.vert[line]))
+					invalid = true;
+			}
+			else {
+				CFaceO& face = m.face[line - vn];
+				long long n;
+				if (!meshlab::parseInt(s, end, n) || n != 3) {
+					invalid = true; // polygons
+				}
+				for (int k = 0; k < 3 && !invalid; ++k) {
+					long long ind;
+					if (!meshlab::parseInt(s, end, ind) || ind < 0 || ind >= vn)
+						invalid = true;
+					else
+						face.V(k) = &m.vert[ind];
+				}
+				if (!invalid && !meshlab::isEndOfLine(s, end))
+					invalid = true; // face colors
+			}
+			++line;
+		}
+	}
+	if (invalid) {
+		m.Clear();
+		return false;
+	}
+	mask = tri::io::Mask::IOM_VERTCOORD | tri::io::Mask::IOM_FACEINDEX;
+	return true;
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef LOAD_TEXT_MESH_H
+#define LOAD_TEXT_MESH_H
+
+#include <common/ml_document/cmesh.h>
+
+/**
+ * Fast paths for large ascii OBJ and OFF triangle meshes: the file is memory
+ * mapped and split in chunks at line boundaries. A first parallel pass counts
+ * the vertices and faces of each chunk; after a prefix sum, that gives to
+ * each chunk the position of its elements (and the base for the negative OBJ
+ * indices), the chunks are parsed in parallel directly into the
+ * preallocated vectors of the mesh.
+ *
+ * Only triangle meshes are handled. OFF files must contain just coordinates
+ * and faces; OBJ files may also have texture coords and normals referenced
+ * by all the face corners (v/vt/vn), and materials: the usemtl/mtllib lines
+ * are resolved serially between the two passes, as ImporterOBJ does, and
+ * give the wedge texture index and the face color. The returned mask tells
+ * which components have been loaded (the caller must enable them in the
+ * MeshModel). When a file contains anything else (vertex colors, polygons,
+ * unknown materials, wrong indices...) the functions return false, leaving
+ * the mesh empty, and the file should be loaded by ImporterOBJ/ImporterOFF,
+ * producing also the same error messages.
+ */
+
+bool loadTextOBJ(const QString& fileName, CMeshO& m, int& mask);
+
+bool loadTextOFF(const QString& fileName, CMeshO& m, int& mask);
+
+#endif // LOAD_TEXT_MESH_H
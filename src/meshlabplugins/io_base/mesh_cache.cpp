@@ -0,0 +1,603 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "mesh_cache.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include <QFile>
+
+#include <common/mlexception.h>
+#include <common/utilities/live_elements.h>
+#include <wrap/io_trimesh/io_mask.h>
+
+using namespace vcg;
+using meshlab::LiveElements;
+
+namespace {
+
+const char     MAGIC[8]   = {'M', 'L', 'C', 'A', 'C', 'H', 'E', '\0'};
+const uint32_t VERSION    = 1;
+const uint32_t ENDIAN_TAG = 0x01020304;
+const qint64   ALIGNMENT  = 64;
+
+enum ColumnType : uint32_t {
+	VERTEX_COORD = 1,
+	VERTEX_NORMAL,
+	VERTEX_COLOR,
+	VERTEX_QUALITY,
+	VERTEX_TEXCOORD,
+	VERTEX_FLAGS,
+	FACE_INDEX = 16,
+	FACE_NORMAL,
+	FACE_COLOR,
+	FACE_QUALITY,
+	FACE_FLAGS,
+	FACE_WEDGE_TEXCOORD,
+	FACE_FF_ADJACENCY,
+	VERTEX_SCALAR_ATTRIBUTE = 32,
+	VERTEX_POINT_ATTRIBUTE,
+	FACE_SCALAR_ATTRIBUTE,
+	FACE_POINT_ATTRIBUTE,
+	TEXTURE_NAMES = 48,
+	TRANSFORM
+};
+
+struct FileHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t endianTag;
+	uint32_t scalarSize;
+	uint32_t columnCount;
+	uint64_t vertexCount;
+	uint64_t faceCount;
+	uint8_t  reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64, "unexpected padding in FileHeader");
+
+struct ColumnEntry
+{
+	uint32_t type;
+	uint32_t compressed; // 0: raw, 1: qCompress (zlib)
+	uint64_t offset;     // from the beginning of the file, aligned to ALIGNMENT
+	uint64_t storedSize;
+	uint64_t size;       // uncompressed
+	char     name[96];   // name of the custom attribute, null terminated
+};
+static_assert(sizeof(ColumnEntry) == 128, "unexpected padding in ColumnEntry");
+
+struct TexCoordRecord
+{
+	float   u;
+	float   v;
+	int32_t n;
+};
+
+struct FaceIndexRecord
+{
+	uint32_t v[3];
+};
+
+struct AdjacencyRecord
+{
+	int32_t f[3]; // -1 for null pointers
+	int8_t  e[3];
+	int8_t  unused;
+};
+
+/**
+ * @brief what is known of each column type: if it stores a record for each
+ * vertex or face (recordSize > 0), and the io mask bit of the component
+ */
+struct ColumnInfo
+{
+	uint32_t    type;
+	bool        perFace;
+	std::size_t recordSize;
+	int         mask;
+};
+
+const ColumnInfo COLUMN_INFO[] = {
+	{VERTEX_COORD, false, sizeof(Point3m), tri::io::Mask::IOM_VERTCOORD},
+	{VERTEX_NORMAL, false, sizeof(Point3m), tri::io::Mask::IOM_VERTNORMAL},
+	{VERTEX_COLOR, false, sizeof(Color4b), tri::io::Mask::IOM_VERTCOLOR},
+	{VERTEX_QUALITY, false, sizeof(Scalarm), tri::io::Mask::IOM_VERTQUALITY},
+	{VERTEX_TEXCOORD, false, sizeof(TexCoordRecord), tri::io::Mask::IOM_VERTTEXCOORD},
+	{VERTEX_FLAGS, false, sizeof(int32_t), tri::io::Mask::IOM_VERTFLAGS},
+	{FACE_INDEX, true, sizeof(FaceIndexRecord), tri::io::Mask::IOM_FACEINDEX},
+	{FACE_NORMAL, true, sizeof(Point3m), tri::io::Mask::IOM_FACENORMAL},
+	{FACE_COLOR, true, sizeof(Color4b), tri::io::Mask::IOM_FACECOLOR},
+	{FACE_QUALITY, true, sizeof(Scalarm), tri::io::Mask::IOM_FACEQUALITY},
+	{FACE_FLAGS, true, sizeof(int32_t), tri::io::Mask::IOM_FACEFLAGS},
+	{FACE_WEDGE_TEXCOORD, true, 3 * sizeof(TexCoordRecord), tri::io::Mask::IOM_WEDGTEXCOORD},
+	{FACE_FF_ADJACENCY, true, sizeof(AdjacencyRecord), 0},
+	{VERTEX_SCALAR_ATTRIBUTE, false, sizeof(Scalarm), 0},
+	{VERTEX_POINT_ATTRIBUTE, false, sizeof(Point3m), 0},
+	{FACE_SCALAR_ATTRIBUTE, true, sizeof(Scalarm), 0},
+	{FACE_POINT_ATTRIBUTE, true, sizeof(Point3m), 0},
+	{TEXTURE_NAMES, false, 0, 0},
+	{TRANSFORM, false, 0, 0}};
+
+const ColumnInfo* findColumnInfo(uint32_t type)
+{
+	for (const ColumnInfo& info : COLUMN_INFO)
+		if (info.type == type)
+			return &info;
+	return nullptr;
+}
+
+/**
+ * @brief builds, in parallel, a column with a record for each live element;
+ * f(i, record) fills the record of the element with index i in the container
+ */
+template <typename Record, typename Function>
+std::vector<char> makeColumn(const LiveElements& el, Function f)
+{
+	std::vector<char> data(sizeof(Record) * (std::size_t) el.size());
+	Record* records = reinterpret_cast<Record*>(data.data());
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < el.size(); ++k)
+		f(el.index(k), records[k]);
+	return data;
+}
+
+/**
+ * @brief copies, in parallel, the n records of a column into the mesh;
+ * f(i, record) stores the record of the i-th element
+ */
+template <typename Record, typename Function>
+void readColumn(const char* data, int n, Function f)
+{
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < n; ++i) {
+		Record r;
+		std::memcpy(&r, data + (std::size_t) i * sizeof(Record), sizeof(Record));
+		f(i, r);
+	}
+}
+
+struct OutputColumn
+{
+	ColumnType type;
+	std::string name;
+	std::function<std::vector<char>()> data;
+};
+
+void writeBlock(QFile& file, const char* data, qint64 size)
+{
+	if (size > 0 && file.write(data, size) != size)
+		throw MLException("Error while writing " + file.fileName() + ": " + file.errorString());
+}
+
+[[noreturn]] void invalidFile(const QString& fileName, const QString& details)
+{
+	throw MLException("Invalid mesh cache file " + fileName + ": " + details);
+}
+
+} // namespace
+
+void saveMeshCache(
+		const QString& fileName,
+		MeshModel& m,
+		int mask,
+		bool compress,
+		CallBackPos* cb)
+{
+	CMeshO& cm = m.cm;
+	const LiveElements verts(cm.vert, cm.vn);
+	const LiveElements faces(cm.face, cm.fn);
+
+	// the columns are built one at a time while writing, to avoid keeping a
+	// copy of the whole mesh in memory
+	std::vector<OutputColumn> columns;
+	auto add = [&](ColumnType type, std::function<std::vector<char>()> data, const std::string& name = std::string()) {
+		columns.push_back({type, name, data});
+	};
+
+	add(VERTEX_COORD, [&]() {
+		return makeColumn<Point3m>(verts, [&](int i, Point3m& r) { r = cm.vert[i].cP(); });
+	});
+	if (mask & tri::io::Mask::IOM_VERTNORMAL) {
+		add(VERTEX_NORMAL, [&]() {
+			return makeColumn<Point3m>(verts, [&](int i, Point3m& r) { r = cm.vert[i].cN(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_VERTCOLOR) && m.hasDataMask(MeshModel::MM_VERTCOLOR)) {
+		add(VERTEX_COLOR, [&]() {
+			return makeColumn<Color4b>(verts, [&](int i, Color4b& r) { r = cm.vert[i].cC(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_VERTQUALITY) && m.hasDataMask(MeshModel::MM_VERTQUALITY)) {
+		add(VERTEX_QUALITY, [&]() {
+			return makeColumn<Scalarm>(verts, [&](int i, Scalarm& r) { r = cm.vert[i].cQ(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_VERTTEXCOORD) && m.hasDataMask(MeshModel::MM_VERTTEXCOORD)) {
+		add(VERTEX_TEXCOORD, [&]() {
+			return makeColumn<TexCoordRecord>(verts, [&](int i, TexCoordRecord& r) {
+				const CVertexO& v = cm.vert[i];
+				r = {v.cT().U(), v.cT().V(), v.cT().N()};
+			});
+		});
+	}
+	if (mask & tri::io::Mask::IOM_VERTFLAGS) {
+		add(VERTEX_FLAGS, [&]() {
+			return makeColumn<int32_t>(verts, [&](int i, int32_t& r) { r = cm.vert[i].cFlags(); });
+		});
+	}
+
+	if (cm.fn > 0) {
+		add(FACE_INDEX, [&]() {
+			return makeColumn<FaceIndexRecord>(faces, [&](int i, FaceIndexRecord& r) {
+				for (int k = 0; k < 3; ++k)
+					r.v[k] = verts.savedIndex(tri::Index(cm, cm.face[i].cV(k)));
+			});
+		});
+	}
+	if (mask & tri::io::Mask::IOM_FACENORMAL) {
+		add(FACE_NORMAL, [&]() {
+			return makeColumn<Point3m>(faces, [&](int i, Point3m& r) { r = cm.face[i].cN(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_FACECOLOR) && m.hasDataMask(MeshModel::MM_FACECOLOR)) {
+		add(FACE_COLOR, [&]() {
+			return makeColumn<Color4b>(faces, [&](int i, Color4b& r) { r = cm.face[i].cC(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_FACEQUALITY) && m.hasDataMask(MeshModel::MM_FACEQUALITY)) {
+		add(FACE_QUALITY, [&]() {
+			return makeColumn<Scalarm>(faces, [&](int i, Scalarm& r) { r = cm.face[i].cQ(); });
+		});
+	}
+	if (mask & tri::io::Mask::IOM_FACEFLAGS) {
+		add(FACE_FLAGS, [&]() {
+			return makeColumn<int32_t>(faces, [&](int i, int32_t& r) { r = cm.face[i].cFlags(); });
+		});
+	}
+	if ((mask & tri::io::Mask::IOM_WEDGTEXCOORD) && m.hasDataMask(MeshModel::MM_WEDGTEXCOORD)) {
+		typedef std::array<TexCoordRecord, 3> WedgeRecord;
+		add(FACE_WEDGE_TEXCOORD, [&]() {
+			return makeColumn<WedgeRecord>(faces, [&](int i, WedgeRecord& r) {
+				const CFaceO& f = cm.face[i];
+				for (int k = 0; k < 3; ++k)
+					r[k] = {f.cWT(k).U(), f.cWT(k).V(), f.cWT(k).N()};
+			});
+		});
+	}
+	if (cm.fn > 0 && m.isFaceFaceTopologyUpToDate()) {
+		add(FACE_FF_ADJACENCY, [&]() {
+			return makeColumn<AdjacencyRecord>(faces, [&](int i, AdjacencyRecord& r) {
+				const CFaceO& f = cm.face[i];
+				for (int k = 0; k < 3; ++k) {
+					const CFaceO* adj = f.cFFp(k);
+					r.f[k] = adj == nullptr ? -1 : faces.savedIndex(tri::Index(cm, adj));
+					r.e[k] = (int8_t) f.cFFi(k);
+				}
+				r.unused = 0;
+			});
+		});
+	}
+
+	// custom attributes with names that do not fit in the directory are not saved
+	std::vector<std::string> names;
+	tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Scalarm>(cm, names);
+	for (const std::string& name : names) {
+		if (name.size() < sizeof(ColumnEntry::name)) {
+			add(VERTEX_SCALAR_ATTRIBUTE, [&cm, &verts, name]() {
+				auto h = tri::Allocator<CMeshO>::FindPerVertexAttribute<Scalarm>(cm, name);
+				return makeColumn<Scalarm>(verts, [&](int i, Scalarm& r) { r = h[&cm.vert[i]]; });
+			}, name);
+		}
+	}
+	tri::Allocator<CMeshO>::GetAllPerVertexAttribute<Point3m>(cm, names);
+	for (const std::string& name : names) {
+		if (name.size() < sizeof(ColumnEntry::name)) {
+			add(VERTEX_POINT_ATTRIBUTE, [&cm, &verts, name]() {
+				auto h = tri::Allocator<CMeshO>::FindPerVertexAttribute<Point3m>(cm, name);
+				return makeColumn<Point3m>(verts, [&](int i, Point3m& r) { r = h[&cm.vert[i]]; });
+			}, name);
+		}
+	}
+	tri::Allocator<CMeshO>::GetAllPerFaceAttribute<Scalarm>(cm, names);
+	for (const std::string& name : names) {
+		if (name.size() < sizeof(ColumnEntry::name)) {
+			add(FACE_SCALAR_ATTRIBUTE, [&cm, &faces, name]() {
+				auto h = tri::Allocator<CMeshO>::FindPerFaceAttribute<Scalarm>(cm, name);
+				return makeColumn<Scalarm>(faces, [&](int i, Scalarm& r) { r = h[&cm.face[i]]; });
+			}, name);
+		}
+	}
+	tri::Allocator<CMeshO>::GetAllPerFaceAttribute<Point3m>(cm, names);
+	for (const std::string& name : names) {
+		if (name.size() < sizeof(ColumnEntry::name)) {
+			add(FACE_POINT_ATTRIBUTE, [&cm, &faces, name]() {
+				auto h = tri::Allocator<CMeshO>::FindPerFaceAttribute<Point3m>(cm, name);
+				return makeColumn<Point3m>(faces, [&](int i, Point3m& r) { r = h[&cm.face[i]]; });
+			}, name);
+		}
+	}
+
+	if (!cm.textures.empty()) {
+		add(TEXTURE_NAMES, [&]() {
+			std::vector<char> data;
+			for (const std::string& t : cm.textures)
+				data.insert(data.end(), t.c_str(), t.c_str() + t.size() + 1);
+			return data;
+		});
+	}
+	add(TRANSFORM, [&]() {
+		std::vector<char> data(16 * sizeof(Scalarm));
+		Scalarm* tr = reinterpret_cast<Scalarm*>(data.data());
+		for (int i = 0; i < 16; ++i)
+			tr[i] = cm.Tr.ElementAt(i / 4, i % 4);
+		return data;
+	});
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		throw MLException("Unable to open " + fileName + " for writing: " + file.errorString());
+
+	FileHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version     = VERSION;
+	header.endianTag   = ENDIAN_TAG;
+	header.scalarSize  = sizeof(Scalarm);
+	header.columnCount = (uint32_t) columns.size();
+	header.vertexCount = cm.vn;
+	header.faceCount   = cm.fn;
+
+	// the directory is written again at the end, when the offsets are known
+	std::vector<ColumnEntry> directory(columns.size(), ColumnEntry());
+	writeBlock(file, (const char*) &header, sizeof(FileHeader));
+	writeBlock(file, (const char*) directory.data(), directory.size() * sizeof(ColumnEntry));
+
+	const std::vector<char> padding(ALIGNMENT, 0);
+	for (std::size_t i = 0; i < columns.size(); ++i) {
+		if (cb != nullptr)
+			cb((int) (100 * i / columns.size()), "Saving mesh cache...");
+		std::vector<char> data = columns[i].data();
+		ColumnEntry& e = directory[i];
+		e.type = columns[i].type;
+		std::strncpy(e.name, columns[i].name.c_str(), sizeof(e.name) - 1);
+		e.size = data.size();
+
+		QByteArray compressed;
+		if (compress && !data.empty() && data.size() < (std::size_t) std::numeric_limits<int>::max())
+			compressed = qCompress((const uchar*) data.data(), (int) data.size(), 1);
+		e.compressed = !compressed.isEmpty() && (std::size_t) compressed.size() < data.size();
+		e.storedSize = e.compressed ? compressed.size() : data.size();
+
+		qint64 pos = file.pos();
+		qint64 offset = (pos + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		writeBlock(file, padding.data(), offset - pos);
+		e.offset = offset;
+		writeBlock(file, e.compressed ? compressed.constData() : data.data(), e.storedSize);
+	}
+
+	if (!file.seek(0))
+		throw MLException("Error while writing " + fileName + ": " + file.errorString());
+	writeBlock(file, (const char*) &header, sizeof(FileHeader));
+	writeBlock(file, (const char*) directory.data(), directory.size() * sizeof(ColumnEntry));
+	file.close();
+}
+
+int loadMeshCache(const QString& fileName, MeshModel& m, CallBackPos* cb)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		throw MLException("Unable to open " + fileName + ": " + file.errorString());
+	const uint64_t fileSize = file.size();
+	if (fileSize < sizeof(FileHeader))
+		invalidFile(fileName, "truncated header");
+	const char* base = (const char*) file.map(0, fileSize);
+	if (base == nullptr)
+		throw MLException("Unable to map " + fileName + " in memory: " + file.errorString());
+
+	FileHeader header;
+	std::memcpy(&header, base, sizeof(FileHeader));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+		invalidFile(fileName, "wrong magic number");
+	if (header.version != VERSION)
+		invalidFile(fileName, "unsupported version " + QString::number(header.version));
+	if (header.endianTag != ENDIAN_TAG || header.scalarSize != sizeof(Scalarm))
+		invalidFile(fileName, "saved on a platform with different endianness or scalar type");
+	if (header.vertexCount > (uint64_t) std::numeric_limits<int>::max() ||
+		header.faceCount > (uint64_t) std::numeric_limits<int>::max())
+		invalidFile(fileName, "too many elements");
+	if (header.columnCount > (fileSize - sizeof(FileHeader)) / sizeof(ColumnEntry))
+		invalidFile(fileName, "truncated directory");
+	const int vn = (int) header.vertexCount;
+	const int fn = (int) header.faceCount;
+
+	std::vector<ColumnEntry> directory(header.columnCount);
+	std::memcpy(directory.data(), base + sizeof(FileHeader), directory.size() * sizeof(ColumnEntry));
+
+	int mask = 0;
+	for (ColumnEntry& e : directory) {
+		e.name[sizeof(e.name) - 1] = '\0';
+		const ColumnInfo* info = findColumnInfo(e.type);
+		if (info == nullptr)
+			continue; // written by a newer version: ignored
+		if (e.offset > fileSize || e.storedSize > fileSize - e.offset)
+			invalidFile(fileName, "truncated column");
+		if (e.compressed > 1 || (!e.compressed && e.storedSize != e.size) ||
+			(e.compressed && e.storedSize > (uint64_t) std::numeric_limits<int>::max()))
+			invalidFile(fileName, "wrong column size");
+		if (info->recordSize > 0 && e.size != info->recordSize * (uint64_t) (info->perFace ? fn : vn))
+			invalidFile(fileName, "wrong column size");
+		if (e.type == TRANSFORM && e.size != 16 * sizeof(Scalarm))
+			invalidFile(fileName, "wrong column size");
+		mask |= info->mask;
+	}
+	if (!(mask & tri::io::Mask::IOM_VERTCOORD) || (fn > 0 && !(mask & tri::io::Mask::IOM_FACEINDEX)))
+		invalidFile(fileName, "missing coordinates or faces");
+
+	// the compressed columns are inflated in parallel before filling the mesh
+	std::vector<QByteArray> inflated(directory.size());
+	std::atomic<bool> corrupted(false);
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) directory.size(); ++i) {
+		const ColumnEntry& e = directory[i];
+		if (e.compressed && findColumnInfo(e.type) != nullptr) {
+			inflated[i] = qUncompress((const uchar*) base + e.offset, (int) e.storedSize);
+			if ((uint64_t) inflated[i].size() != e.size)
+				corrupted = true;
+		}
+	}
+	if (corrupted)
+		invalidFile(fileName, "corrupted compressed column");
+
+	if (cb != nullptr)
+		cb(10, "Loading mesh cache...");
+
+	m.enable(mask);
+	CMeshO& cm = m.cm;
+	if (vn > 0)
+		tri::Allocator<CMeshO>::AddVertices(cm, vn);
+	if (fn > 0)
+		tri::Allocator<CMeshO>::AddFaces(cm, fn);
+
+	std::atomic<bool> invalid(false);
+	bool hasAdjacency = false;
+	for (std::size_t c = 0; c < directory.size(); ++c) {
+		const ColumnEntry& e = directory[c];
+		const char* data = e.compressed ? inflated[c].constData() : base + e.offset;
+		switch (e.type) {
+		case VERTEX_COORD:
+			readColumn<Point3m>(data, vn, [&](int i, const Point3m& r) { cm.vert[i].P() = r; });
+			break;
+		case VERTEX_NORMAL:
+			readColumn<Point3m>(data, vn, [&](int i, const Point3m& r) { cm.vert[i].N() = r; });
+			break;
+		case VERTEX_COLOR:
+			readColumn<Color4b>(data, vn, [&](int i, const Color4b& r) { cm.vert[i].C() = r; });
+			break;
+		case VERTEX_QUALITY:
+			readColumn<Scalarm>(data, vn, [&](int i, const Scalarm& r) { cm.vert[i].Q() = r; });
+			break;
+		case VERTEX_TEXCOORD:
+			readColumn<TexCoordRecord>(data, vn, [&](int i, const TexCoordRecord& r) {
+				cm.vert[i].T().U() = r.u;
+				cm.vert[i].T().V() = r.v;
+				cm.vert[i].T().N() = r.n;
+			});
+			break;
+		case VERTEX_FLAGS:
+			readColumn<int32_t>(data, vn, [&](int i, int32_t r) {
+				cm.vert[i].Flags() = r & ~CVertexO::DELETED;
+			});
+			break;
+		case FACE_INDEX:
+			readColumn<FaceIndexRecord>(data, fn, [&](int i, const FaceIndexRecord& r) {
+				for (int k = 0; k < 3; ++k) {
+					if (r.v[k] >= (uint32_t) vn)
+						invalid = true;
+					else
+						cm.face[i].V(k) = &cm.vert[r.v[k]];
+				}
+			});
+			break;
+		case FACE_NORMAL:
+			readColumn<Point3m>(data, fn, [&](int i, const Point3m& r) { cm.face[i].N() = r; });
+			break;
+		case FACE_COLOR:
+			readColumn<Color4b>(data, fn, [&](int i, const Color4b& r) { cm.face[i].C() = r; });
+			break;
+		case FACE_QUALITY:
+			readColumn<Scalarm>(data, fn, [&](int i, const Scalarm& r) { cm.face[i].Q() = r; });
+			break;
+		case FACE_FLAGS:
+			readColumn<int32_t>(data, fn, [&](int i, int32_t r) {
+				cm.face[i].Flags() = r & ~CFaceO::DELETED;
+			});
+			break;
+		case FACE_WEDGE_TEXCOORD:
+			readColumn<std::array<TexCoordRecord, 3>>(data, fn, [&](int i, const std::array<TexCoordRecord, 3>& r) {
+				for (int k = 0; k < 3; ++k) {
+					cm.face[i].WT(k).U() = r[k].u;
+					cm.face[i].WT(k).V() = r[k].v;
+					cm.face[i].WT(k).N() = r[k].n;
+				}
+			});
+			break;
+		case FACE_FF_ADJACENCY:
+			cm.face.EnableFFAdjacency();
+			hasAdjacency = true;
+			readColumn<AdjacencyRecord>(data, fn, [&](int i, const AdjacencyRecord& r) {
+				for (int k = 0; k < 3; ++k) {
+					if (r.f[k] < -1 || r.f[k] >= fn || r.e[k] < 0 || r.e[k] > 2) {
+						invalid = true;
+					}
+					else {
+						cm.face[i].FFp(k) = r.f[k] < 0 ? nullptr : &cm.face[r.f[k]];
+						cm.face[i].FFi(k) = r.e[k];
+					}
+				}
+			});
+			break;
+		case VERTEX_SCALAR_ATTRIBUTE: {
+			auto h = tri::Allocator<CMeshO>::GetPerVertexAttribute<Scalarm>(cm, e.name);
+			readColumn<Scalarm>(data, vn, [&](int i, const Scalarm& r) { h[&cm.vert[i]] = r; });
+		} break;
+		case VERTEX_POINT_ATTRIBUTE: {
+			auto h = tri::Allocator<CMeshO>::GetPerVertexAttribute<Point3m>(cm, e.name);
+			readColumn<Point3m>(data, vn, [&](int i, const Point3m& r) { h[&cm.vert[i]] = r; });
+		} break;
+		case FACE_SCALAR_ATTRIBUTE: {
+			auto h = tri::Allocator<CMeshO>::GetPerFaceAttribute<Scalarm>(cm, e.name);
+			readColumn<Scalarm>(data, fn, [&](int i, const Scalarm& r) { h[&cm.face[i]] = r; });
+		} break;
+		case FACE_POINT_ATTRIBUTE: {
+			auto h = tri::Allocator<CMeshO>::GetPerFaceAttribute<Point3m>(cm, e.name);
+			readColumn<Point3m>(data, fn, [&](int i, const Point3m& r) { h[&cm.face[i]] = r; });
+		} break;
+		case TEXTURE_NAMES:
+			for (const char* p = data; p < data + e.size; p += cm.textures.back().size() + 1)
+				cm.textures.push_back(std::string(p, strnlen(p, data + e.size - p)));
+			break;
+		case TRANSFORM: {
+			Scalarm tr[16];
+			std::memcpy(tr, data, sizeof(tr));
+			for (int k = 0; k < 16; ++k)
+				cm.Tr.ElementAt(k / 4, k % 4) = tr[k];
+		} break;
+		default: break;
+		}
+		if (cb != nullptr)
+			cb(10 + (int) (89 * (c + 1) / directory.size()), "Loading mesh cache...");
+	}
+	if (invalid) {
+		cm.Clear();
+		invalidFile(fileName, "wrong vertex or face indices");
+	}
+	if (hasAdjacency)
+		m.setFaceFaceTopologyUpToDate();
+	return mask;
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <common/ml_document/mesh_model.h>
+#include <wrap/callback.h>
+
+/**
+ * MeshLab Mesh Cache (MLC): a native binary format meant to reload large
+ * meshes as fast as possible.
+ *
+ * The file is a 64 bytes header (magic, version, endianness and size of the
+ * Scalarm type, number of vertices and faces) followed by a directory of
+ * columns; each column stores a single component of all the vertices or
+ * faces (coords, normals, colors, quality, flags, texture coords, indices,
+ * FF adjacency, custom Scalarm/Point3m attributes) as a packed array that
+ * starts at a 64 bytes aligned offset. Columns can optionally be compressed
+ * with zlib.
+ *
+ * When loading, the file is memory mapped and the uncompressed columns are
+ * copied in parallel directly into the mesh, without any parsing. The FF
+ * adjacency, saved when it is up to date, is restored and marked as valid,
+ * so that filters that need it will not recompute it.
+ *
+ * Files written on machines with different endianness or with a different
+ * Scalarm type are rejected.
+ */
+
+void saveMeshCache(
+		const QString& fileName,
+		MeshModel& m,
+		int mask,
+		bool compress,
+		vcg::CallBackPos* cb = nullptr);
+
+/**
+ * @brief Loads the mesh cache in the given (empty) mesh, enabling the
+ * components stored in the file, and returns the corresponding io mask.
+ * Throws MLException if the file is not valid.
+ */
+int loadMeshCache(
+		const QString& fileName,
+		MeshModel& m,
+		vcg::CallBackPos* cb = nullptr);
+
+#endif // MESH_CACHE_H
@@ -22,12 +22,22 @@
 ****************************************************************************/
 #include <QUuid>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <external/e57/include/E57SimpleReader.h>
 #include <external/e57/include/E57SimpleWriter.h>
 
+#include <common/ml_document/mesh_document.h>
+
 #include "io_e57.h"
 
 #define E57_FILE_EXTENSION      "E57"
@@ -38,6 +48,11 @@
 #define LOADING_MESH        "Loading mesh..."
 #define DONE_LOADING        "Done!"
 
+#define SAVING_MESH         "Saving mesh..."
+
+#define DEFAULT_READ_BUFFER_SIZE (1 << 20)
+#define WRITE_BLOCK_SIZE         (1 << 20)
+
 /**
  * [Macro] Throw MLException in case of failure using E57 functions.
  */
@@ -66,6 +81,33 @@ static inline std::string filenameToString(const QString& fileName) noexcept;
  */
 static inline QString formatImageFilename(const std::string& fileName, const char* format) noexcept;
 
+/**
+ * Convert a block of spherical coordinates (range, elevation, azimuth) to cartesian coordinates.
+ * The loop has no branches, so that it can be vectorized by the compiler.
+ */
+static void sphericalToCartesian(const Scalarm* range, const Scalarm* elevation, const Scalarm* azimuth,
+                                 std::size_t size, Scalarm* x, Scalarm* y, Scalarm* z) noexcept;
+
+/**
+ * Rescale in place a block of values of a color channel from the [minimum, maximum]
+ * limits declared in the scan header to the [0, 255] range used by the meshes.
+ */
+static void normalizeColors(uint8_t* channel, std::size_t size, double minimum, double maximum) noexcept;
+
+/**
+ * Gather the intensities of the valid points of a block in the contiguous quality buffer,
+ * converted to the scalar type of the meshes.
+ */
+static void intensityToQuality(const float* intensity, const uint32_t* validPoints, std::size_t count,
+                               Scalarm* quality) noexcept;
+
+/**
+ * Write in validPoints the indices of the points of the block whose invalid state is 0
+ * (all the points if invalidState is null).
+ * @return The number of valid points
+ */
+static std::size_t selectValidPoints(const int8_t* invalidState, std::size_t size, uint32_t* validPoints) noexcept;
+
 unsigned int E57IOPlugin::numberMeshesContainedInFile(const QString& format, const QString& fileName, const RichParameterList&) const {
 
     unsigned int count;
@@ -91,6 +133,19 @@ void E57IOPlugin::open(const QString &formatName, const QString &fileName, MeshM
 {
 }
 
+RichParameterList E57IOPlugin::initPreOpenParameter(const QString& format) const
+{
+    RichParameterList parlst;
+    if (format.toUpper() == tr(E57_FILE_EXTENSION)) {
+        parlst.addParam(RichInt(
+            "readBufferSize", DEFAULT_READ_BUFFER_SIZE, "Read buffer size (points)",
+            "Number of points decoded at each read of a scan. Scans are loaded concurrently, "
+            "each one with its own buffer: bigger buffers make the reads faster, smaller ones "
+            "reduce the memory used while loading."));
+    }
+    return parlst;
+}
+
 void E57IOPlugin::open(const QString &formatName, const QString &fileName, const std::list<MeshModel*>& meshModelList,
                        std::list<int>& maskList, const RichParameterList& par, vcg::CallBackPos* cb) {
 
@@ -116,59 +171,122 @@ void E57IOPlugin::open(const QString &formatName, const QString &fileName, const
 
     UPDATE_PROGRESS(cb, 1, START_LOADING);
 
-    // Read clouds...
-    int scanIndex = 0;
-    bool columnIndex = false;
+    std::vector<MeshModel*> meshes(meshModelList.begin(), meshModelList.end());
+    const int scanCount = static_cast<int>(meshes.size());
 
-    for (auto meshModel: meshModelList) {
+    int64_t readBufferSize = DEFAULT_READ_BUFFER_SIZE;
+    if (par.hasParameter("readBufferSize") && par.getInt("readBufferSize") > 0)
+        readBufferSize = par.getInt("readBufferSize");
 
-        int mask = 0;
-        e57::Data3D scanHeader{};
+    // Read the headers of the scans...
+    std::vector<e57::Data3D> scanHeaders(scanCount);
+    std::vector<int64_t> scanSizes(scanCount, 0);
+    bool columnIndex = false;
 
-        int64_t rows = 0, cols = 0;
-        int64_t numberPointSize = 0, numberGroupSize = 0, numberCountSize = 0;
+    for (int scanIndex = 0; scanIndex < scanCount; scanIndex++) {
 
-        UPDATE_PROGRESS(cb, (scanIndex * data3DCount) / 100, LOADING_MESH);
+        int64_t rows = 0, cols = 0;
+        int64_t numberGroupSize = 0, numberCountSize = 0;
 
-        // read 3D data
-        E57_WRAPPER(e57FileReader.ReadData3D(scanIndex, scanHeader), "Error while reading 3D from file!");
+        try {
+            // read 3D data
+            E57_WRAPPER(e57FileReader.ReadData3D(scanIndex, scanHeaders[scanIndex]), "Error while reading 3D from file!");
 
-        // read scan's size information
-        E57_WRAPPER(e57FileReader.GetData3DSizes(
-                scanIndex, rows, cols, numberPointSize, numberGroupSize, numberCountSize, columnIndex
-        ), "Error while reading scan information!");
+            // read scan's size information
+            E57_WRAPPER(e57FileReader.GetData3DSizes(
+                    scanIndex, rows, cols, scanSizes[scanIndex], numberGroupSize, numberCountSize, columnIndex
+            ), "Error while reading scan information!");
+        }
+        catch (const std::exception& e) {
+            e57FileReader.Close();
+            throw MLException{e.what()};
+        }
 
         // If the name is not empty then set a name for the mesh.
-        if (!scanHeader.name.empty()) {
-            meshModel->setLabel(QString::fromStdString(scanHeader.name));
+        if (!scanHeaders[scanIndex].name.empty()) {
+            meshes[scanIndex]->setLabel(QString::fromStdString(scanHeaders[scanIndex].name));
+        }
+    }
+
+    // ...and then load the points of the scans concurrently, each thread using its own reader.
+    // The readers are opened here, one after the other, because opening a file initializes
+    // the (not thread safe) XML parser.
+    int threadCount = 1;
+#ifdef _OPENMP
+    threadCount = std::max(1, std::min(omp_get_max_threads(), scanCount));
+#endif
+
+    std::vector<std::unique_ptr<e57::Reader>> readers;
+    readers.reserve(threadCount);
+    readers.emplace_back();
+    try {
+        for (int i = 1; i < threadCount; i++) {
+            std::unique_ptr<e57::Reader> reader{new e57::Reader{filenameToString(fileName)}};
+            if (!reader->IsOpen())
+                break;
+            readers.push_back(std::move(reader));
         }
+    }
+    catch (const std::exception&) {
+        // the scans will be loaded by fewer threads
+    }
+    threadCount = static_cast<int>(readers.size());
+
+    std::vector<int> masks(scanCount, 0);
+    std::vector<QString> errors(scanCount);
+    std::atomic<int> loadedScans{0};
+
+    #pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+    for (int scanIndex = 0; scanIndex < scanCount; scanIndex++) {
+
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        const e57::Reader& reader = (thread == 0) ? e57FileReader : *readers[thread];
+        MeshModel* meshModel = meshes[scanIndex];
 
         try {
 
-            if (numberPointSize != 0) {
+            if (scanSizes[scanIndex] != 0) {
 
                 // Does the mesh have an imageMetaAndImage from which to extract colors?
-                std::pair<e57::Image2D, QImage> imageMetaAndImage = extractMeshImage(e57FileReader, scanIndex, false);
+                std::pair<e57::Image2D, QImage> imageMetaAndImage = extractMeshImage(reader, scanIndex, false);
 
                 // Read points from file and load them inside the MeshLab's mesh.
-                loadMesh(*meshModel, mask, scanIndex, numberPointSize, e57FileReader, scanHeader, imageMetaAndImage, par);
+                size_t buffSize = static_cast<size_t>(std::min(readBufferSize, scanSizes[scanIndex]));
+                loadMesh(*meshModel, masks[scanIndex], scanIndex, buffSize, reader, scanHeaders[scanIndex], imageMetaAndImage, par);
 
                 // Once the mesh is loaded apply a transformation matrix to translate and rotate the points.
-                translatedAndRotateMesh(meshModel, scanHeader);
+                translatedAndRotateMesh(meshModel, scanHeaders[scanIndex]);
             }
+        }
+        catch (const std::exception& e) {
+            errors[scanIndex] = QString{e.what()};
+        }
 
-            // Put the modified mask into the mask list.
-            maskList.push_back(mask);
+        int loaded = ++loadedScans;
 
-            // Increase the scanIndex to get info about the next mesh to parse from the file.
-            scanIndex++;
+        // the callback can be called only by the thread that called open
+        if (thread == 0) {
+            UPDATE_PROGRESS(cb, (loaded * 100) / scanCount, LOADING_MESH);
         }
-        catch (const std::exception& e) {
-            E57_WRAPPER(e57FileReader.Close(), "Error while closing the E57 file!");
-            throw MLException{e.what()};
+    }
+
+    for (int i = 1; i < threadCount; i++) {
+        readers[i]->Close();
+    }
+
+    for (const QString& error : errors) {
+        if (!error.isEmpty()) {
+            e57FileReader.Close();
+            throw MLException{error};
         }
     }
 
+    // Put the modified masks into the mask list.
+    maskList.insert(maskList.end(), masks.begin(), masks.end());
+
     UPDATE_PROGRESS(cb, 100, DONE_LOADING);
     E57_WRAPPER(e57FileReader.Close(), "Error while closing the E57 file!");
 }
@@ -239,31 +357,105 @@ void E57IOPlugin::save(const QString& formatName, const QString& fileName, MeshM
                        const RichParameterList&, vcg::CallBackPos* cb)
 {
 
-    using Mask = vcg::tri::io::Mask;
+    if (formatName.toUpper() != tr(E57_FILE_EXTENSION)) {
+        wrongSaveFormat(formatName);
+    }
 
-    vcg::tri::Allocator<CMeshO>::CompactEveryVector(m.cm);
+    e57::Writer fileWriter{filenameToString(fileName)};
+
+    E57_WRAPPER(fileWriter.IsOpen(), "Error while opening E57 file for writing!");
+
+    try {
+        writeScan(fileWriter, m, mask, cb, 0, 100);
+    }
+    catch (const std::exception&) {
+        fileWriter.Close();
+        throw;
+    }
+
+    E57_WRAPPER(fileWriter.Close(), "Error while closing the E57 file during save process!");
+}
+
+std::list<FileFormat> E57IOPlugin::exportProjectFormats() const
+{
+    return {FileFormat(E57_FILE_DESCRIPTION, tr(E57_FILE_EXTENSION))};
+}
+
+void E57IOPlugin::saveProject(const QString& formatName, const QString& fileName, const MeshDocument& md,
+                              bool onlyVisibleMeshes, const std::vector<MLRenderingData>&, vcg::CallBackPos* cb)
+{
+
+    using Mask = vcg::tri::io::Mask;
 
     if (formatName.toUpper() != tr(E57_FILE_EXTENSION)) {
         wrongSaveFormat(formatName);
     }
 
-    std::int64_t scanIndex;
-    const std::size_t totalPoints = m.cm.vert.size();
-    const std::string filePath = filenameToString(fileName);
+    // every layer becomes a scan of the file
+    std::vector<const MeshModel*> meshes;
+    for (const MeshModel& m : md.meshIterator()) {
+        if (!onlyVisibleMeshes || m.isVisible()) {
+            meshes.push_back(&m);
+        }
+    }
 
-    // create a new uuid for the file that will be saved
-    e57::Data3D scanHeader{};
-    e57::Writer fileWriter{filePath};
+    e57::Writer fileWriter{filenameToString(fileName)};
 
     E57_WRAPPER(fileWriter.IsOpen(), "Error while opening E57 file for writing!");
 
+    try {
+        for (std::size_t i = 0; i < meshes.size(); i++) {
+
+            const MeshModel& m = *meshes[i];
+
+            // save all the per vertex attributes available in the layer
+            int mask = 0;
+            if (m.hasDataMask(MeshModel::MM_VERTNORMAL)) {
+                mask |= Mask::IOM_VERTNORMAL;
+            }
+            if (m.hasDataMask(MeshModel::MM_VERTCOLOR)) {
+                mask |= Mask::IOM_VERTCOLOR;
+            }
+            if (m.hasDataMask(MeshModel::MM_VERTQUALITY)) {
+                mask |= Mask::IOM_VERTQUALITY;
+            }
+
+            writeScan(fileWriter, m, mask, cb,
+                      static_cast<int>((i * 100) / meshes.size()), static_cast<int>(((i + 1) * 100) / meshes.size()));
+        }
+    }
+    catch (const std::exception&) {
+        fileWriter.Close();
+        throw;
+    }
+
+    E57_WRAPPER(fileWriter.Close(), "Error while closing the E57 file during save process!");
+}
+
+void E57IOPlugin::writeScan(e57::Writer& fileWriter, const MeshModel& m, int mask, vcg::CallBackPos* cb,
+                            int firstPercentage, int lastPercentage) const
+{
+
+    using Mask = vcg::tri::io::Mask;
+
+    const CMeshO& cm = m.cm;
+    const std::size_t totalPoints = static_cast<std::size_t>(cm.vn);
+    const std::size_t blockSize = std::max<std::size_t>(1, std::min<std::size_t>(WRITE_BLOCK_SIZE, totalPoints));
+
+    // create a new uuid for the scan that will be saved
+    e57::Data3D scanHeader{};
+
     scanHeader.guid = QUuid::createUuid().toString(QUuid::WithBraces).toStdString();
     scanHeader.pointsSize = static_cast<int64_t>(totalPoints);
 
+    if (!m.label().isEmpty()) {
+        scanHeader.name = m.label().toStdString();
+    }
+
     e57::Translation translation;
     e57::Quaternion quaternion;
 
-    Point4m translationColumn = m.cm.Tr.GetColumn4(3);
+    Point4m translationColumn = cm.Tr.GetColumn4(3);
     translation.x = translationColumn.X();
     translation.y = translationColumn.Y();
     translation.z = translationColumn.Z();
@@ -271,7 +463,7 @@ void E57IOPlugin::save(const QString& formatName, const QString& fileName, MeshM
 
     vcg::Quaternion<Scalarm> q;
 
-    Matrix44m transformMatrixCopy = m.cm.Tr;
+    Matrix44m transformMatrixCopy = cm.Tr;
     transformMatrixCopy[3][0] = 0;
     transformMatrixCopy[3][1] = 0;
     transformMatrixCopy[3][2] = 0;
@@ -308,64 +500,109 @@ void E57IOPlugin::save(const QString& formatName, const QString& fileName, MeshM
     }
     if ((mask & Mask::IOM_VERTQUALITY) != 0) {
         float min = std::numeric_limits<float>::max();
-        float max = std::numeric_limits<float>::min();
-        for (size_t i = 0; i < m.cm.vert.size(); ++i) {
-            if (m.cm.vert[i].Q() < min)
-                min = m.cm.vert[i].Q();
-            if (m.cm.vert[i].Q() > max)
-                max = m.cm.vert[i].Q();
+        float max = std::numeric_limits<float>::lowest();
+        for (const CVertexO& v : cm.vert) {
+            if (!v.IsD()) {
+                min = std::min(min, static_cast<float>(v.cQ()));
+                max = std::max(max, static_cast<float>(v.cQ()));
+            }
         }
         scanHeader.intensityLimits.intensityMinimum = min;
         scanHeader.intensityLimits.intensityMaximum = max;
         scanHeader.pointFields.intensityField = true;
     }
 
-    scanIndex = fileWriter.NewData3D(scanHeader);
+    int64_t scanIndex = fileWriter.NewData3D(scanHeader);
 
-    vcg::tri::io::E57Data3DPoints data3DPoints{totalPoints, scanHeader};
+    // the points are written in blocks of (at most) blockSize points
+    vcg::tri::io::E57Data3DPoints data3DPoints{blockSize, scanHeader};
     e57::Data3DPointsData_t<Scalarm>& pointsData = data3DPoints.points();
 
-    e57::CompressedVectorWriter dataWriter = fileWriter.SetUpData3DPointsData(scanIndex, totalPoints, pointsData);
+    e57::CompressedVectorWriter dataWriter = fileWriter.SetUpData3DPointsData(scanIndex, blockSize, pointsData);
+
+    const bool colors = data3DPoints.areColorsAvailable();
+    const bool normals = data3DPoints.areNormalsAvailable();
+    const bool quality = data3DPoints.isQualityAvailable();
+
+    auto fillPoint = [&](std::size_t i, const CVertexO& v) {
+
+        pointsData.cartesianX[i] = v.cP().X();
+        pointsData.cartesianY[i] = v.cP().Y();
+        pointsData.cartesianZ[i] = v.cP().Z();
+
+        if (colors) {
+            pointsData.colorRed[i] = static_cast<uint8_t>(v.cC().X());
+            pointsData.colorGreen[i] = static_cast<uint8_t>(v.cC().Y());
+            pointsData.colorBlue[i] = static_cast<uint8_t>(v.cC().Z());
+        }
+
+        if (normals) {
+            pointsData.normalX[i] = v.cN().X();
+            pointsData.normalY[i] = v.cN().Y();
+            pointsData.normalZ[i] = v.cN().Z();
+        }
+
+        if (quality) {
+            pointsData.intensity[i] = v.cQ();
+        }
+    };
 
     try {
 
-        CMeshO::VertContainer& vertices = m.cm.vert;
+        // without deleted vertices, the i-th point is the i-th vertex; otherwise the live vertices
+        // of each block are collected first, so that the blocks are always filled in parallel
+        const bool compact = cm.vert.size() == totalPoints;
+        std::vector<const CVertexO*> blockVertices;
+        if (!compact) {
+            blockVertices.reserve(std::min(blockSize, totalPoints));
+        }
 
-        for (std::size_t i = 0; i < totalPoints; i++) {
+        std::size_t written = 0;
+        std::size_t vertexIndex = 0;
 
-            pointsData.cartesianX[i] = vertices[i].P().X();
-            pointsData.cartesianY[i] = vertices[i].P().Y();
-            pointsData.cartesianZ[i] = vertices[i].P().Z();
+        while (written < totalPoints) {
 
-            if (data3DPoints.areColorsAvailable()) {
-                pointsData.colorRed[i] = static_cast<uint8_t>(vertices[i].C().X());
-                pointsData.colorGreen[i] = static_cast<uint8_t>(vertices[i].C().Y());
-                pointsData.colorBlue[i] = static_cast<uint8_t>(vertices[i].C().Z());
-            }
+            std::size_t count = 0;
+
+            if (compact) {
+                count = std::min(blockSize, totalPoints - written);
+                const CVertexO* block = cm.vert.data() + written;
 
-            if (data3DPoints.areNormalsAvailable()) {
-                pointsData.normalX[i] = vertices[i].N().X();
-                pointsData.normalY[i] = vertices[i].N().Y();
-                pointsData.normalZ[i] = vertices[i].N().Z();
+                #pragma omp parallel for schedule(static)
+                for (int64_t i = 0; i < static_cast<int64_t>(count); i++) {
+                    fillPoint(static_cast<std::size_t>(i), block[i]);
+                }
             }
+            else {
+                blockVertices.clear();
+                for (; vertexIndex < cm.vert.size() && blockVertices.size() < blockSize; vertexIndex++) {
+                    if (!cm.vert[vertexIndex].IsD()) {
+                        blockVertices.push_back(&cm.vert[vertexIndex]);
+                    }
+                }
+                count = blockVertices.size();
 
-            if (data3DPoints.isQualityAvailable()) {
-                pointsData.intensity[i] = vertices[i].Q();
+                #pragma omp parallel for schedule(static)
+                for (int64_t i = 0; i < static_cast<int64_t>(count); i++) {
+                    fillPoint(static_cast<std::size_t>(i), *blockVertices[i]);
+                }
             }
-        }
 
-        // write the mesh data
-        dataWriter.write(totalPoints);
+            // write the block
+            dataWriter.write(count);
+            written += count;
+
+            UPDATE_PROGRESS(cb, firstPercentage + static_cast<int>(((lastPercentage - firstPercentage) * written) / totalPoints),
+                            SAVING_MESH);
+        }
 
     }
     catch (const e57::E57Exception& e) {
         dataWriter.close();
-        E57_WRAPPER(fileWriter.Close(), "Error while closing the E57 file during save process!");
         throw MLException{QString{"E57 Exception: %1.\nError Code: %2"}.arg(QString::fromStdString(e.context()), e.errorCode())};
     }
 
     dataWriter.close();
-    E57_WRAPPER(fileWriter.Close(), "Error while closing the E57 file during save process!");
 }
 
 /*
@@ -441,68 +678,83 @@ void E57IOPlugin::loadMesh(MeshModel &m, int &mask, int scanIndex, size_t buffSi
 
         e57::Data3DPointsData_t<Scalarm>& pointsData = data3DPoints.points();
 
+        const bool cartesian = data3DPoints.areCoordinatesAvailable();
+        const bool spherical = !cartesian && data3DPoints.areSphericalCoordinatesAvailable();
+        const int8_t* invalidState = cartesian ? pointsData.cartesianInvalidState : pointsData.sphericalInvalidState;
+
+        // spherical coordinates are converted in these buffers
+        std::vector<Scalarm> x, y, z;
+        if (spherical) {
+            x.resize(buffSize); y.resize(buffSize); z.resize(buffSize);
+        }
+        const Scalarm* px = cartesian ? pointsData.cartesianX : x.data();
+        const Scalarm* py = cartesian ? pointsData.cartesianY : y.data();
+        const Scalarm* pz = cartesian ? pointsData.cartesianZ : z.data();
+
+        std::vector<uint32_t> validPoints(buffSize);
+        std::vector<Scalarm> quality;
+        if (data3DPoints.isQualityAvailable()) {
+            quality.resize(buffSize);
+        }
+
         while ((size = dataReader.read()) > 0) {
 
-            for (std::size_t i = 0; i < size; i++) {
+            if (!cartesian && !spherical) {
+                continue;
+            }
 
-                Point3m coordinates;
+            if (spherical) {
+                sphericalToCartesian(pointsData.sphericalRange, pointsData.sphericalElevation, pointsData.sphericalAzimuth,
+                                     size, x.data(), y.data(), z.data());
+            }
 
-                if (data3DPoints.areCoordinatesAvailable()) {
+            if (data3DPoints.areColorsAvailable()) {
+                const e57::ColorLimits& limits = scanHeader.colorLimits;
+                normalizeColors(pointsData.colorRed, size, limits.colorRedMinimum, limits.colorRedMaximum);
+                normalizeColors(pointsData.colorGreen, size, limits.colorGreenMinimum, limits.colorGreenMaximum);
+                normalizeColors(pointsData.colorBlue, size, limits.colorBlueMinimum, limits.colorBlueMaximum);
+            }
 
-                    if (pointsData.cartesianInvalidState == nullptr || pointsData.cartesianInvalidState[i] == 0) {
-                        coordinates[0] = pointsData.cartesianX[i];
-                        coordinates[1] = pointsData.cartesianY[i];
-                        coordinates[2] = pointsData.cartesianZ[i];
-                    }
-                    else {
-                        continue;
-                    }
-                }
-                else if (data3DPoints.areSphericalCoordinatesAvailable()) {
-                    if (pointsData.sphericalInvalidState == nullptr || pointsData.sphericalInvalidState[i] == 0) {
+            const size_t validCount = selectValidPoints(invalidState, size, validPoints.data());
+            if (validCount == 0) {
+                continue;
+            }
 
-                        auto range = pointsData.sphericalRange[i];
-                        auto phi = pointsData.sphericalElevation[i];
-                        auto theta = pointsData.sphericalAzimuth[i];
+            if (data3DPoints.isQualityAvailable()) {
+                intensityToQuality(pointsData.intensity, validPoints.data(), validCount, quality.data());
+            }
 
-                        coordinates[0] = range * std::cos(phi) * std::cos(theta);
-                        coordinates[1] = range * std::cos(phi) * std::sin(theta);
-                        coordinates[2] = range * std::sin(phi);
+            // all the valid points of the read are added at once
+            VertexIterator vi = vcg::tri::Allocator<CMeshO>::AddVertices(m.cm, validCount);
 
-                    }
-                    else {
-                        continue;
-                    }
-                }
-                else {
-                    continue;
-                }
+            for (std::size_t k = 0; k < validCount; k++, ++vi) {
+
+                const uint32_t i = validPoints[k];
 
-                auto vertex = vcg::tri::Allocator<CMeshO>::AddVertex(m.cm, coordinates);
+                vi->P() = Point3m{px[i], py[i], pz[i]};
 
                 // Set the normals.
                 if (data3DPoints.areNormalsAvailable()) {
-                    vertex->N()[0] = pointsData.normalX[i];
-                    vertex->N()[1] = pointsData.normalY[i];
-                    vertex->N()[2] = pointsData.normalZ[i];
+                    vi->N()[0] = pointsData.normalX[i];
+                    vi->N()[1] = pointsData.normalY[i];
+                    vi->N()[2] = pointsData.normalZ[i];
                 }
 
                 // Set the quality.
                 if (data3DPoints.isQualityAvailable()) {
-                    vertex->Q() = pointsData.intensity[i];
+                    vi->Q() = quality[k];
                 }
 
                 // Set the point color.
                 if (data3DPoints.areColorsAvailable()) {
-                    vertex->C()[0] = pointsData.colorRed[i];
-                    vertex->C()[1] = pointsData.colorGreen[i];
-                    vertex->C()[2] = pointsData.colorBlue[i];
-                    vertex->C()[3] = 0xFF;
+                    vi->C()[0] = pointsData.colorRed[i];
+                    vi->C()[1] = pointsData.colorGreen[i];
+                    vi->C()[2] = pointsData.colorBlue[i];
+                    vi->C()[3] = 0xFF;
                 }
                 else {
                     // TODO: extract colors from the image?
                 }
-
             }
         }
 
@@ -529,6 +781,64 @@ void E57IOPlugin::loadMesh(MeshModel &m, int &mask, int scanIndex, size_t buffSi
     dataReader.close();
 }
 
+static void sphericalToCartesian(const Scalarm* range, const Scalarm* elevation, const Scalarm* azimuth,
+                                 std::size_t size, Scalarm* x, Scalarm* y, Scalarm* z) noexcept {
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < size; i++) {
+        const Scalarm horizontal = range[i] * std::cos(elevation[i]);
+        x[i] = horizontal * std::cos(azimuth[i]);
+        y[i] = horizontal * std::sin(azimuth[i]);
+        z[i] = range[i] * std::sin(elevation[i]);
+    }
+}
+
+static void normalizeColors(uint8_t* channel, std::size_t size, double minimum, double maximum) noexcept {
+
+    // nothing to do when the limits are unknown or are already the full byte range
+    if (maximum <= minimum || (minimum == 0. && maximum == 255.)) {
+        return;
+    }
+
+    const float offset = static_cast<float>(minimum);
+    const float scale = static_cast<float>(255. / (maximum - minimum));
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < size; i++) {
+        float value = (static_cast<float>(channel[i]) - offset) * scale + 0.5f;
+        value = value < 0.f ? 0.f : (value > 255.f ? 255.f : value);
+        channel[i] = static_cast<uint8_t>(value);
+    }
+}
+
+static void intensityToQuality(const float* intensity, const uint32_t* validPoints, std::size_t count,
+                               Scalarm* quality) noexcept {
+
+    #pragma omp simd
+    for (std::size_t k = 0; k < count; k++) {
+        quality[k] = static_cast<Scalarm>(intensity[validPoints[k]]);
+    }
+}
+
+static std::size_t selectValidPoints(const int8_t* invalidState, std::size_t size, uint32_t* validPoints) noexcept {
+
+    std::size_t count = 0;
+
+    if (invalidState == nullptr) {
+        for (std::size_t i = 0; i < size; i++) {
+            validPoints[i] = static_cast<uint32_t>(i);
+        }
+        return size;
+    }
+
+    // branch-free compaction: the index is always written, but the counter moves only for the valid points
+    for (std::size_t i = 0; i < size; i++) {
+        validPoints[count] = static_cast<uint32_t>(i);
+        count += (invalidState[i] == 0);
+    }
+    return count;
+}
+
 static inline std::string filenameToString(const QString& fileName) noexcept {
     return QFile::encodeName(fileName).toStdString();
 }
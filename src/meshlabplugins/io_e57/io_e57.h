@@ -29,6 +29,7 @@
 #include <common/ml_document/mesh_model.h>
 #include <external/e57/include/E57Format.h>
 #include <E57SimpleReader.h>
+#include <E57SimpleWriter.h>
 
 typedef typename CMeshO::VertexIterator VertexIterator;
 
@@ -191,6 +192,8 @@ public:
 
 	virtual void exportMaskCapability(const QString &format, int &capability, int &defaultBits) const;
 
+	RichParameterList initPreOpenParameter(const QString& format) const;
+
 	unsigned int numberMeshesContainedInFile(const QString& format, const QString& fileName, const RichParameterList& preParams) const;
 
 	void open(const QString &formatName, const QString &fileName, MeshModel &m,
@@ -201,6 +204,11 @@ public:
 	void save(const QString &formatName, const QString &fileName, MeshModel &m, const int mask,
            const RichParameterList&, vcg::CallBackPos *cb);
 
+	std::list<FileFormat> exportProjectFormats() const;
+
+	void saveProject(const QString &formatName, const QString &fileName, const MeshDocument &md,
+           bool onlyVisibleMeshes, const std::vector<MLRenderingData>& rendOpt, vcg::CallBackPos *cb = 0);
+
 
 private:
 
@@ -217,7 +225,7 @@ private:
      * @param m The mesh to display
      * @param mask
      * @param scanIndex Data block index given by the NewData3D
-     * @param buffSize Dimension for buffer size
+     * @param buffSize Number of points decoded at each read of the scan
      * @param fileReader The file reader object used to scan the file
      * @param cb Callback to update the progressbar contained in MeshLab
      */
@@ -225,6 +233,19 @@ private:
                   const e57::Reader &fileReader, e57::Data3D &scanHeader,
                   std::pair<e57::Image2D, QImage> image, const RichParameterList &par);
 
+    /***
+     * Write the vertices of a mesh as a new scan of the E57 file, streaming them in blocks of fixed size.
+     * The transform matrix of the mesh is stored as the pose of the scan.
+     * @param fileWriter The writer of the E57 file
+     * @param m The mesh to write
+     * @param mask The vertex attributes to write (normals, colors and quality)
+     * @param cb Callback to update the progressbar contained in MeshLab
+     * @param firstPercentage The progress when the scan starts
+     * @param lastPercentage The progress when the scan is done
+     */
+    void writeScan(e57::Writer &fileWriter, const MeshModel &m, int mask, vcg::CallBackPos *cb,
+                   int firstPercentage, int lastPercentage) const;
+
     /***
      * Read the transform matrix inside the e57::Data3D and apply it to the mesh
      * @param meshModel The mesh to apply the transform matrix
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <wrap/callback.h>
 #include <wrap/io_trimesh/io_mask.h>
+#include <common/utilities/text_formatting.h>
 
 namespace vcg {
 namespace tri {
@@ -51,34 +52,31 @@ class ExporterXYZ
 
   static int Save(const SaveMeshType &m, const char * filename, int mask=0 )
   {
-    bool savenormals = false;
-
-    vcg::face::Pos<FaceType> he;
-    vcg::face::Pos<FaceType> hei;
-
     FILE * fpout = fopen(filename,"w");
 		if(fpout==NULL)	return 1; // 1 is the error code for cant'open, see the ErrorMsg function
 
-
-    if(mask & io::Mask::IOM_VERTNORMAL)
-      savenormals = true;
-				
-		//vertices
-		VertexPointer  vp;
-		VertexIterator vi;
-		for(vi=m.vert.begin(); vi!=m.vert.end(); ++vi)
-		{
-		  vp=&(*vi);
-
-      if( ! vp->IsD() )
-      {
-        fprintf(fpout,"%f %f %f " ,vp->P()[0],vp->P()[1],vp->P()[2]);
-        if(savenormals)
-          fprintf(fpout,"%f %f %f " ,vp->N()[0],vp->N()[1],vp->N()[2]);
-
-        fprintf(fpout,"\n");
-      }
-    }
+    const bool savenormals = (mask & io::Mask::IOM_VERTNORMAL) != 0;
+
+		// vertices: the rows are formatted in parallel, with the same output of printf("%f")
+		meshlab::formatRowsInParallel(
+			m.vert.size(),
+			[&](std::size_t i, meshlab::TextBuffer& row) {
+				const VertexType& v = m.vert[i];
+				if (v.IsD())
+					return;
+				for (int k = 0; k < 3; ++k) {
+					row.appendFixed(v.cP()[k], 6);
+					row.append(' ');
+				}
+				if (savenormals) {
+					for (int k = 0; k < 3; ++k) {
+						row.appendFixed(v.cN()[k], 6);
+						row.append(' ');
+					}
+				}
+				row.append('\n');
+			},
+			[&](const char* data, std::size_t size) { fwrite(data, 1, size, fpout); });
 
     fclose(fpout);
 
@@ -23,9 +23,17 @@
 
 #include "gltf_loader.h"
 
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <map>
 #include <regex>
 #include <common/mlexception.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace gltf {
 
 /**
@@ -58,6 +66,13 @@ unsigned int getNumberMeshes(
  * @brief Loads all the meshes referred in the scene of the gltf file into
  * the list of meshes.
  *
+ * The node hierarchy is traversed once, computing the transformation of each
+ * referred mesh; then, for each primitive, materials and textures are
+ * processed and the number of vertices and faces is read, so that the
+ * vertices and faces of every mesh can be allocated at once. Finally, all the
+ * primitives (of all the meshes) are loaded concurrently, each one in its own
+ * range of the vertices and faces of its mesh.
+ *
  * @param meshModelList
  * @param maskList
  * @param model
@@ -69,24 +84,75 @@ void loadMeshes(
 		bool loadInSingleLayer,
 		vcg::CallBackPos* cb)
 {
-	CallBackProgress progress(100.0/meshModelList.size());
 	maskList.resize(meshModelList.size(), 0);
-	std::list<MeshModel*>::const_iterator meshit = meshModelList.begin();
-	std::list<int>::iterator maskit = maskList.begin();
+
+	std::vector<internal::MeshInstance> instances;
 	for (unsigned int s = 0; s < model.scenes.size(); ++s){
 		const tinygltf::Scene& scene = model.scenes[s];
 		for (unsigned int n = 0; n < scene.nodes.size(); ++n){
-			internal::loadMeshesWhileTraversingNodes(
-						model,
-						meshit,
-						maskit,
-						Matrix44m::Identity(),
-						scene.nodes[n],
-						loadInSingleLayer,
-						cb,
-						progress);
+			internal::getMeshInstances(model, Matrix44m::Identity(), scene.nodes[n], instances);
+		}
+	}
+
+	//materials, textures and sizes of all the primitives
+	std::vector<internal::PrimitiveJob> jobs;
+	std::list<MeshModel*>::const_iterator meshit = meshModelList.begin();
+	std::list<int>::iterator maskit = maskList.begin();
+	for (const internal::MeshInstance& instance : instances) {
+		if (meshit == meshModelList.end())
+			break;
+		MeshModel& m = **meshit;
+		const tinygltf::Mesh& tm = model.meshes[instance.mesh];
+		if (!tm.name.empty())
+			m.setLabel(QString::fromStdString(tm.name));
+		for (const tinygltf::Primitive& p : tm.primitives){
+			jobs.push_back(internal::prepareMeshPrimitive(
+					m, *maskit, model, p, loadInSingleLayer, instance.transf));
+		}
+		if (!loadInSingleLayer) {
+			m.cm.Tr = instance.transf;
+			++meshit;
+			++maskit;
 		}
 	}
+	if (cb)
+		cb(10, "Allocating meshes");
+
+	//allocation of the vertices and faces of each mesh: each primitive gets
+	//its own range
+	std::map<MeshModel*, std::pair<size_t, size_t>> newElements;
+	for (internal::PrimitiveJob& job : jobs) {
+		std::pair<size_t, size_t>& n = newElements[job.m];
+		job.firstVertex = job.m->cm.vert.size() + n.first;
+		job.firstFace = job.m->cm.face.size() + n.second;
+		n.first += job.attributes[internal::POSITION].count;
+		n.second += job.faceNumber;
+	}
+	for (const auto& n : newElements) {
+		if (n.second.first > 0)
+			vcg::tri::Allocator<CMeshO>::AddVertices(n.first->cm, n.second.first);
+		if (n.second.second > 0)
+			vcg::tri::Allocator<CMeshO>::AddFaces(n.first->cm, n.second.second);
+	}
+
+	std::atomic<int> loadedJobs(0);
+	std::atomic<bool> validIndices(true);
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) jobs.size(); ++i) {
+		if (!internal::loadMeshPrimitive(jobs[i]))
+			validIndices = false;
+		int loaded = ++loadedJobs;
+#ifdef _OPENMP
+		//the callback can be called only by the thread that called the function
+		if (cb && omp_get_thread_num() == 0)
+#else
+		if (cb)
+#endif
+			cb(10 + (90 * loaded) / jobs.size(), "Loading primitives");
+	}
+	if (!validIndices)
+		throw MLException("Invalid vertex index in gltf file.");
+
 	if (cb)
 		cb(100, "GLTF File loaded");
 }
@@ -122,58 +188,31 @@ unsigned int getNumberMeshes(
 }
 
 /**
- * @brief Recursive function that loads a mesh if the current node contains one,
+ * @brief Recursive function that appends to the instances vector the mesh
+ * of the current node (if any) together with its transformation matrix,
  * and then calls itself on the children of the node.
  *
  * @param model
- * @param currentMesh
- * @param currentMask
- * @param currentMatrix
+ * @param currentMatrix: the transformation of the parent node
  * @param currentNode
+ * @param instances
  */
-void loadMeshesWhileTraversingNodes(
+void getMeshInstances(
 		const tinygltf::Model& model,
-		std::list<MeshModel*>::const_iterator& currentMesh,
-		std::list<int>::iterator& currentMask,
 		Matrix44m currentMatrix,
 		unsigned int currentNode,
-		bool loadInSingleLayer,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress)
+		std::vector<MeshInstance>& instances)
 {
 	currentMatrix = currentMatrix * getCurrentNodeTrMatrix(model, currentNode);
 	if (model.nodes[currentNode].mesh >= 0) {
-
-		int meshid = model.nodes[currentNode].mesh;
-		loadMesh(
-				**currentMesh,
-				*currentMask,
-				model.meshes[meshid],
-				model,
-				loadInSingleLayer,
-				currentMatrix,
-				cb,
-				progress);
-		if (!loadInSingleLayer) {
-			(*currentMesh)->cm.Tr = currentMatrix;
-			++currentMesh;
-			++currentMask;
-		}
+		instances.push_back({model.nodes[currentNode].mesh, currentMatrix});
 	}
 
 	//for each child
 	for (int c : model.nodes[currentNode].children){
 		if (c>=0){ //if it is valid
 			//visit child
-			loadMeshesWhileTraversingNodes(
-						model,
-						currentMesh,
-						currentMask,
-						currentMatrix,
-						c,
-						loadInSingleLayer,
-						cb,
-						progress);
+			getMeshInstances(model, currentMatrix, c, instances);
 		}
 	}
 }
@@ -240,68 +279,34 @@ Matrix44m getCurrentNodeTrMatrix(
 }
 
 /**
- * @brief loads a mesh from gltf file.
- * It merges all the primitives in the loaded mesh.
+ * @brief prepares the loading of the given primitive into the mesh: loads
+ * the material and its texture, enables the attributes of the primitive in
+ * the mesh and gets the accessors of the attributes.
+ * This function is not thread safe, since it modifies the mesh.
  *
- * @param m: the mesh that will contain the loaded mesh
- * @param tm: tinygltf structure of the mesh to load
- * @param model: tinygltf file
- */
-void loadMesh(
-		MeshModel& m,
-		int& mask,
-		const tinygltf::Mesh& tm,
-		const tinygltf::Model& model,
-		bool loadInSingleLayer,
-		const Matrix44m& transf,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress)
-{
-	if (!tm.name.empty())
-		m.setLabel(QString::fromStdString(tm.name));
-
-	double oldStep = progress.step();
-	progress.setStep(oldStep / tm.primitives.size());
-
-	//for each primitive, load it into the mesh
-	for (const tinygltf::Primitive& p : tm.primitives){
-		internal::loadMeshPrimitive(
-					m,
-					mask,
-					model,
-					p,
-					loadInSingleLayer,
-					transf,
-					cb,
-					progress);
-	}
-	if (cb)
-		cb(progress.progress(), "Loaded all primitives for current mesh.");
-	progress.setStep(oldStep);
-}
-
-/**
- * @brief loads the given primitive into the mesh
  * @param m
+ * @param mask
  * @param model
  * @param p
+ * @return the job that will load the primitive (without the position of its
+ * elements in the mesh)
  */
-void loadMeshPrimitive(
+PrimitiveJob prepareMeshPrimitive(
 		MeshModel& m,
 		int& mask,
 		const tinygltf::Model& model,
 		const tinygltf::Primitive& p,
 		bool loadInSingleLayer,
-		const Matrix44m& transf,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress)
+		const Matrix44m& transf)
 {
-	double oldStep = progress.step();
-	progress.setStep(oldStep/GLTF_ATTR_STR.size()+1);
+	PrimitiveJob job;
+	job.m = &m;
+	job.transf = transf;
+	//if all the meshes are loaded in a single layer, I need to apply
+	//the transformation matrix to the loaded coordinates
+	job.applyTransf = loadInSingleLayer;
 
 	int textureImg = -1; //id of the texture associated to the material
-	bool vCol = false; //used if a material has a base color for all the primitive
-	vcg::Color4b col; //the base color, to be set to all the vertices
 
 	if (p.material >= 0) { //if the primitive has a material
 		const tinygltf::Material& mat = model.materials[p.material];
@@ -314,10 +319,10 @@ void loadMeshPrimitive(
 		}
 		it = mat.values.find("baseColorFactor");
 		if (it != mat.values.end()) { //vertex base color, the same for a primitive
-			vCol = true;
+			job.hasBaseColor = true;
 			const std::vector<double>& vc = it->second.number_array;
 			for (unsigned int i = 0; i < 4; i++)
-				col[i] = vc[i] * 255.0;
+				job.baseColor[i] = vc[i] * 255.0;
 		}
 	}
 	if (textureImg != -1) { //if we found a texture
@@ -348,315 +353,327 @@ void loadMeshPrimitive(
 		//set the id of the texture: we need it when set uv coords
 		textureImg = m.cm.textures.size()-1;
 	}
-	//vector of vertex pointers added to the mesh
-	//this vector is modified only when adding vertex position attributes
-	std::vector<CMeshO::VertexPointer> ivp;
-
-	//load vertex position attribute, sets also the ivp vector
-	if (cb)
-		cb(progress.progress(), "Loading vertex coordinates");
-	loadAttribute(m, ivp, model, p, POSITION);
-	progress.increment();
+	job.textureId = textureImg;
 
-	//if all the meshes are loaded in a single layer, I need to apply
-	//the transformation matrix to the loaded coordinates
-	if (loadInSingleLayer){
-		for (CMeshO::VertexPointer p : ivp){
-			p->P() = transf * p->P();
-		}
-	}
+	if (!getAccessorData(model, p, POSITION, job.attributes[POSITION]))
+		throw MLException("File has not 'Position' attribute");
 
 	//if the mesh has a base color, set it to vertex colors
-	if (vCol) {
+	if (job.hasBaseColor) {
 		mask |= vcg::tri::io::Mask::IOM_VERTCOLOR;
 		m.enable(vcg::tri::io::Mask::IOM_VERTCOLOR);
-		for (auto v : ivp)
-			v->C() = col;
 	}
-
-	if (cb)
-		cb(progress.progress(), "Loading vertex normals");
-	//load all the other vertex attributes (ivp is not modified by these calls)
-	bool res = loadAttribute(m, ivp, model, p, NORMAL);
-	if (res) {
+	if (getAccessorData(model, p, NORMAL, job.attributes[NORMAL]))
 		mask |= vcg::tri::io::Mask::IOM_VERTNORMAL;
-		//if all the meshes are loaded in a single layer, I need to apply
-		//the transformation matrix to the loaded coordinates
-		if (loadInSingleLayer){
-			Matrix33m mat33(transf,3);
-			for (CMeshO::VertexPointer p : ivp){
-				p->N() = mat33 * p->N();
-			}
-		}
-	}
-	progress.increment();
-
-	if (cb)
-		cb(progress.progress(), "Loading vertex colors");
-	res = loadAttribute(m, ivp, model, p, COLOR_0);
-	if (res)
+	if (getAccessorData(model, p, COLOR_0, job.attributes[COLOR_0])) {
 		mask |= vcg::tri::io::Mask::IOM_VERTCOLOR;
-	progress.increment();
-	if (cb)
-		cb(progress.progress(), "Loading vertex texcoords");
-	res = loadAttribute(m, ivp, model, p, TEXCOORD_0, textureImg);
-	if (res)
+		m.enable(vcg::tri::io::Mask::IOM_VERTCOLOR);
+	}
+	if (getAccessorData(model, p, TEXCOORD_0, job.attributes[TEXCOORD_0])) {
 		mask |= vcg::tri::io::Mask::IOM_VERTTEXCOORD;
-	progress.increment();
-
-
-	//load triangles
-	if (cb)
-		cb(progress.progress(), "Loading triangle indices");
-	loadAttribute(m, ivp, model, p, INDICES);
-	progress.increment();
+		m.enable(vcg::tri::io::Mask::IOM_VERTTEXCOORD);
+	}
 
-	if (cb)
-		cb(progress.progress(), "Loaded all attributes of current mesh");
+	//if the mode is GL_TRIANGLES and we have triangle indices
+	if (getAccessorData(model, p, INDICES, job.attributes[INDICES]))
+		job.faceNumber = job.attributes[INDICES].count / 3;
+	//otherwise the mesh is not indexed, and triplets of contiguous vertices
+	//generate triangles
+	else
+		job.faceNumber = job.attributes[POSITION].count / 3;
 
-	progress.setStep(oldStep);
+	return job;
 }
 
 /**
- * @brief loads the attribute attr from the primitive p contained in the
- * gltf model. If the attribute is vertex position, sets also vertex pointers
- * vector ivp. For all the other parameters, ivp is a const input.
- *
- * If the primitive does not contain the primitive p, nothing is done.
- * Howerver, id the attribute is POSITION, then a MLException will be thrown.
+ * @brief loads the attributes of the primitive in the range of vertices and
+ * faces reserved for it. Different primitives can be loaded concurrently.
  *
+ * @param job
+ * @return false if the primitive contains invalid indices
+ */
+bool loadMeshPrimitive(
+		const PrimitiveJob& job)
+{
+	for (unsigned int attr = POSITION; attr <= INDICES; ++attr) {
+		const AccessorData& acc = job.attributes[attr];
+		//the base color is overwritten by the color attribute
+		if (attr == COLOR_0 && job.hasBaseColor) {
+			CMeshO::VertexIterator vi = job.m->cm.vert.begin() + job.firstVertex;
+			for (size_t i = 0; i < job.attributes[POSITION].count; ++i, ++vi)
+				vi->C() = job.baseColor;
+		}
+		bool valid = true;
+		switch (acc.componentType) {
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			valid = populateAttr<float>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+			valid = populateAttr<double>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+			valid = populateAttr<int8_t>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			valid = populateAttr<uint8_t>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+			valid = populateAttr<int16_t>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			valid = populateAttr<uint16_t>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+			valid = populateAttr<uint32_t>((GLTF_ATTR_TYPE) attr, job, acc); break;
+		default:
+			//attribute not present; for indices, it means that the mesh is
+			//not indexed (managed when passing an empty accessor)
+			if (attr == INDICES)
+				valid = populateTriangles<uint8_t>(job, acc);
+		}
+		if (!valid)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief gets the data of the accessor of the attribute attr of the
+ * primitive p. For the INDICES attribute, the accessor is returned only if
+ * the primitive is made of indexed triangles.
  *
- * @param m
- * @param ivp
  * @param model
  * @param p
  * @param attr
- * @param textID: id of the texture in case of the attr is TEXCOORD_0
- * @return true if the attribute has been loaded
+ * @param accessorData
+ * @return false if the primitive does not contain the attribute, or if the
+ * accessor is not valid
  */
-bool loadAttribute(
-		MeshModel& m,
-		std::vector<CMeshO::VertexPointer>& ivp,
+bool getAccessorData(
 		const tinygltf::Model& model,
 		const tinygltf::Primitive& p,
 		GLTF_ATTR_TYPE attr,
-		int textID)
+		AccessorData& accessorData)
 {
-	bool attrLoaded = false;
-	const tinygltf::Accessor* accessor = nullptr;
-
-	//get the accessor associated to the attribute
+	int accessorId = -1;
 	if (attr != INDICES) {
 		auto it = p.attributes.find(GLTF_ATTR_STR[attr]);
-
-		if (it != p.attributes.end()) { //accessor found
-			accessor = &model.accessors[it->second];
-		}
-		else if (attr == POSITION) { //if we were looking for POSITION and didn't find any
-			throw MLException("File has not 'Position' attribute");
-		}
+		if (it != p.attributes.end())
+			accessorId = it->second;
 	}
-	else { //if the attribute is triangle indices
-
-		//if the mode is GL_TRIANGLES and we have triangle indices
-		if (p.mode == 4 && p.indices >= 0 &&
-				(unsigned int)p.indices < model.accessors.size()) {
-			accessor = &model.accessors[p.indices];
-		}
+	else if (p.mode == TINYGLTF_MODE_TRIANGLES) {
+		accessorId = p.indices;
 	}
+	if (accessorId < 0 || (unsigned int) accessorId >= model.accessors.size())
+		return false;
+
+	const tinygltf::Accessor& accessor = model.accessors[accessorId];
+	if (accessor.bufferView < 0 || (unsigned int) accessor.bufferView >= model.bufferViews.size())
+		return false;
+	//bufferview: contains infos on how to access buffer with the accessor
+	const tinygltf::BufferView& bw = model.bufferViews[accessor.bufferView];
+	//data of the whole buffer (vector of bytes);
+	//may contain also other data not associated to our attribute
+	const std::vector<unsigned char>& data = model.buffers[bw.buffer].data;
+
+	int stride = accessor.ByteStride(bw);
+	int nComponents = tinygltf::GetNumComponentsInType(accessor.type);
+	int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	if (stride <= 0 || nComponents <= 0 || componentSize <= 0)
+		return false;
+
+	//the last element must be inside the buffer
+	size_t offset = bw.byteOffset + accessor.byteOffset;
+	if (accessor.count > 0 &&
+			offset + (accessor.count - 1) * stride + nComponents * componentSize > data.size())
+		return false;
+
+	accessorData.data = data.data() + offset;
+	accessorData.stride = stride;
+	accessorData.count = accessor.count;
+	accessorData.componentType = accessor.componentType;
+	accessorData.nComponents = nComponents;
+	accessorData.normalized = accessor.normalized;
+	return true;
+}
 
-	//if we found an accessor of the attribute
-	if (accessor) {
-		//bufferview: contains infos on how to access buffer with the accessor
-		const tinygltf::BufferView& posbw = model.bufferViews[accessor->bufferView];
-
-		//data of the whole buffer (vector of bytes);
-		//may contain also other data not associated to our attribute
-		const std::vector<unsigned char>& posdata = model.buffers[posbw.buffer].data;
-
-		//offset where the data of the attribute starts
-		unsigned int posOffset = posbw.byteOffset + accessor->byteOffset;
-		//hack:
-		//if the attribute is a color, textid is used to tell the size of the
-		//color (3 or 4 components)
-		if (attr == COLOR_0){
-			if (accessor->type == TINYGLTF_TYPE_VEC3)
-				textID = 3;
-			else if (accessor->type == TINYGLTF_TYPE_VEC4)
-				textID = 4;
-		}
+/**
+ * @brief reads the component c of the element i of the accessor.
+ * The data of a gltf buffer is not aligned, so it is copied.
+ */
+template <typename Scalar>
+inline Scalar component(
+		const AccessorData& acc,
+		size_t i,
+		int c)
+{
+	Scalar s;
+	std::memcpy(&s, acc.data + i * acc.stride + c * sizeof(Scalar), sizeof(Scalar));
+	return s;
+}
 
-		//if data is float
-		if (accessor->componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-			//get the starting point of the data as float pointer
-			const float* posArray = (const float*) (posdata.data() + posOffset);
-			populateAttr(attr, m, ivp, posArray, accessor->count, textID);
-			attrLoaded = true;
-		}
-		//if data is double
-		else if (accessor->componentType == TINYGLTF_COMPONENT_TYPE_DOUBLE) {
-			//get the starting point of the data as double pointer
-			const double* posArray = (const double*) (posdata.data() + posOffset);
-			populateAttr(attr, m, ivp, posArray, accessor->count, textID);
-			attrLoaded = true;
-		}
-		//if data is ubyte
-		else if (accessor->componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-			//get the starting point of the data as uchar pointer
-			const unsigned char* triArray = (const unsigned char*) (posdata.data() + posOffset);
-			populateAttr(attr, m, ivp, triArray, accessor->count, textID);
-			attrLoaded = true;
-		}
-		//if data is ushort
-		else if (accessor->componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-			//get the starting point of the data as ushort pointer
-			const unsigned short* triArray = (const unsigned short*) (posdata.data() + posOffset);
-			populateAttr(attr, m, ivp, triArray, accessor->count, textID);
-			attrLoaded = true;
-		}
-		//if data is uint
-		else if (accessor->componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-			//get the starting point of the data as uint pointer
-			const unsigned int* triArray = (const unsigned int*) (posdata.data() + posOffset);
-			populateAttr(attr, m, ivp, triArray, accessor->count, textID);
-			attrLoaded = true;
-		}
-	}
-	//if accessor not found and attribute is indices, it means that
-	//the mesh is not indexed, and triplets of contiguous vertices
-	//generate triangles
-	else if (attr == INDICES) {
-		//this case is managed when passing nullptr as data
-		populateAttr<unsigned char>(attr, m, ivp, nullptr, 0);
-		attrLoaded = true;
-	}
-	return attrLoaded;
+/**
+ * @brief converts a component to a Scalarm: normalized integers are mapped
+ * to [0, 1] (unsigned) or [-1, 1] (signed), as specified by gltf.
+ */
+template <typename Scalar>
+inline Scalarm toScalar(
+		Scalar s,
+		bool normalized)
+{
+	if (std::is_floating_point<Scalar>::value || !normalized)
+		return s;
+	Scalarm v = Scalarm(s) / std::numeric_limits<Scalar>::max();
+	return v < -1 ? -1 : v;
 }
 
 /**
- * @brief given the attribute and the pointer to the data,
+ * @brief given the attribute and the accessor of its data,
  * it calls the appropriate functions that put the data into the mesh
  * appropriately
  * @param attr
- * @param m
- * @param ivp: modified only if attr
- * @param array: plain vector containing the data
- * @param number: number of elements contained in the data
- * @param textID:
- *     if attr is texcoord, it is the texture id
- *     if attr is color, tells if color has 3 or 4 components
+ * @param job
+ * @param acc
+ * @return false if attr is INDICES and there are invalid indices
  */
 template <typename Scalar>
-void populateAttr(
+bool populateAttr(
 		GLTF_ATTR_TYPE attr,
-		MeshModel&m,
-		std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* array,
-		unsigned int number,
-		int textID)
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
 	switch (attr) {
 	case POSITION:
-		populateVertices(m, ivp, array, number); break;
+		populateVertices<Scalar>(job, acc); break;
 	case NORMAL:
-		populateVNormals(ivp, array, number); break;
+		populateVNormals<Scalar>(job, acc); break;
 	case COLOR_0:
-		populateVColors(ivp, array, number, textID); break;
-		break;
+		populateVColors<Scalar>(job, acc); break;
 	case TEXCOORD_0:
-		m.enable(vcg::tri::io::Mask::IOM_VERTTEXCOORD);
-		populateVTextCoords(ivp, array, number, textID); break;
-		break;
+		populateVTextCoords<Scalar>(job, acc); break;
 	case INDICES:
-		populateTriangles(m, ivp, array, number/3); break;
+		return populateTriangles<Scalar>(job, acc);
 	}
+	return true;
 }
 
 template <typename Scalar>
 void populateVertices(
-		MeshModel&m,
-		std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* posArray,
-		unsigned int vertNumber)
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
-	ivp.clear();
-	ivp.resize(vertNumber);
-	CMeshO::VertexIterator vi =
-			vcg::tri::Allocator<CMeshO>::AddVertices(m.cm, vertNumber);
-	for (unsigned int i = 0; i < vertNumber*3; i+= 3, ++vi){
-		ivp[i/3] = &*vi;
-		vi->P() = CMeshO::CoordType(posArray[i], posArray[i+1], posArray[i+2]);
+	CMeshO::VertexIterator vi = job.m->cm.vert.begin() + job.firstVertex;
+	//same layout of the coordinates of the mesh: bulk copy of each element
+	if (std::is_same<Scalar, Scalarm>::value && acc.nComponents == 3) {
+		for (size_t i = 0; i < acc.count; ++i, ++vi)
+			std::memcpy(&vi->P()[0], acc.data + i * acc.stride, 3 * sizeof(Scalarm));
+	}
+	else {
+		for (size_t i = 0; i < acc.count; ++i, ++vi) {
+			vi->P() = CMeshO::CoordType(
+					toScalar(component<Scalar>(acc, i, 0), acc.normalized),
+					toScalar(component<Scalar>(acc, i, 1), acc.normalized),
+					toScalar(component<Scalar>(acc, i, 2), acc.normalized));
+		}
+	}
+	if (job.applyTransf) {
+		vi = job.m->cm.vert.begin() + job.firstVertex;
+		for (size_t i = 0; i < acc.count; ++i, ++vi)
+			vi->P() = job.transf * vi->P();
 	}
 }
 
 template <typename Scalar>
 void populateVNormals(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* normArray,
-		unsigned int vertNumber)
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
-	for (unsigned int i = 0; i < vertNumber*3; i+= 3){
-		ivp[i/3]->N() = CMeshO::CoordType(normArray[i], normArray[i+1], normArray[i+2]);
+	//normals cannot be more than the vertices of the primitive
+	const size_t n = std::min(acc.count, job.attributes[POSITION].count);
+	CMeshO::VertexIterator vi = job.m->cm.vert.begin() + job.firstVertex;
+	if (std::is_same<Scalar, Scalarm>::value && acc.nComponents == 3) {
+		for (size_t i = 0; i < n; ++i, ++vi)
+			std::memcpy(&vi->N()[0], acc.data + i * acc.stride, 3 * sizeof(Scalarm));
+	}
+	else {
+		for (size_t i = 0; i < n; ++i, ++vi) {
+			vi->N() = CMeshO::CoordType(
+					toScalar(component<Scalar>(acc, i, 0), acc.normalized),
+					toScalar(component<Scalar>(acc, i, 1), acc.normalized),
+					toScalar(component<Scalar>(acc, i, 2), acc.normalized));
+		}
+	}
+	if (job.applyTransf) {
+		Matrix33m mat33(job.transf,3);
+		vi = job.m->cm.vert.begin() + job.firstVertex;
+		for (size_t i = 0; i < n; ++i, ++vi)
+			vi->N() = mat33 * vi->N();
 	}
 }
 
 template <typename Scalar>
 void populateVColors(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* colorArray,
-		unsigned int vertNumber,
-		int nElemns)
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
-	for (unsigned int i = 0; i < vertNumber*nElemns; i+= nElemns){
-		if (!std::is_floating_point<Scalar>::value) {
-			int alpha = nElemns == 4 ? colorArray[i+3] : 255;
-			ivp[i/nElemns]->C() = vcg::Color4b(colorArray[i], colorArray[i+1], colorArray[i+2], alpha);
+	const size_t n = std::min(acc.count, job.attributes[POSITION].count);
+	const int nElemns = acc.nComponents;
+	CMeshO::VertexIterator vi = job.m->cm.vert.begin() + job.firstVertex;
+	if (std::is_same<Scalar, uint8_t>::value) {
+		for (size_t i = 0; i < n; ++i, ++vi) {
+			const unsigned char* c = acc.data + i * acc.stride;
+			vi->C() = vcg::Color4b(c[0], c[1], c[2], nElemns == 4 ? c[3] : 255);
 		}
-		else {
-			int alpha = nElemns == 4 ? colorArray[i+3] * 255 : 255;
-			ivp[i/nElemns]->C() = vcg::Color4b(colorArray[i] * 255, colorArray[i+1]*255, colorArray[i+2]*255, alpha);
+	}
+	else {
+		//integer colors are always normalized
+		auto toByte = [&](size_t i, int c) {
+			Scalarm v = toScalar(component<Scalar>(acc, i, c), true);
+			return (unsigned char) std::round(std::min<Scalarm>(std::max<Scalarm>(v, 0), 1) * 255);
+		};
+		for (size_t i = 0; i < n; ++i, ++vi) {
+			vi->C() = vcg::Color4b(
+					toByte(i, 0), toByte(i, 1), toByte(i, 2), nElemns == 4 ? toByte(i, 3) : 255);
 		}
 	}
 }
 
 template <typename Scalar>
 void populateVTextCoords(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* textCoordArray,
-		unsigned int vertNumber,
-		int textID)
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
-	for (unsigned int i = 0; i < vertNumber*2; i+= 2) {
-		ivp[i/2]->T() = CMeshO::VertexType::TexCoordType(textCoordArray[i], 1-textCoordArray[i+1]);
-		ivp[i/2]->T().N() = textID;
+	const size_t n = std::min(acc.count, job.attributes[POSITION].count);
+	CMeshO::VertexIterator vi = job.m->cm.vert.begin() + job.firstVertex;
+	for (size_t i = 0; i < n; ++i, ++vi) {
+		vi->T() = CMeshO::VertexType::TexCoordType(
+				toScalar(component<Scalar>(acc, i, 0), acc.normalized),
+				1-toScalar(component<Scalar>(acc, i, 1), acc.normalized));
+		vi->T().N() = job.textureId;
 	}
 }
 
 template <typename Scalar>
-void populateTriangles(
-		MeshModel&m,
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* triArray,
-		unsigned int triNumber)
+bool populateTriangles(
+		const PrimitiveJob& job,
+		const AccessorData& acc)
 {
-	if (triArray != nullptr) {
-		CMeshO::FaceIterator fi =
-				vcg::tri::Allocator<CMeshO>::AddFaces(m.cm, triNumber);
-		for (unsigned int i = 0; i < triNumber*3; i+=3, ++fi) {
-			fi->V(0) = ivp[triArray[i]];
-			fi->V(1) = ivp[triArray[i+1]];
-			fi->V(2) = ivp[triArray[i+2]];
+	CMeshO& cm = job.m->cm;
+	const size_t vn = job.attributes[POSITION].count;
+	CMeshO::VertexPointer vp = &cm.vert[job.firstVertex];
+	CMeshO::FaceIterator fi = cm.face.begin() + job.firstFace;
+	if (acc.data != nullptr) {
+		for (size_t i = 0; i < job.faceNumber; ++i, ++fi) {
+			for (int k = 0; k < 3; ++k) {
+				size_t ind = component<Scalar>(acc, i * 3 + k, 0);
+				if (ind >= vn)
+					return false;
+				fi->V(k) = vp + ind;
+			}
 		}
 	}
 	else {
-		CMeshO::FaceIterator fi =
-				vcg::tri::Allocator<CMeshO>::AddFaces(m.cm, ivp.size()/3);
-		for (unsigned int i = 0; i < ivp.size(); i+=3, ++fi) {
-			fi->V(0) = ivp[i];
-			fi->V(1) = ivp[i+1];
-			fi->V(2) = ivp[i+2];
+		for (size_t i = 0; i < job.faceNumber; ++i, ++fi) {
+			fi->V(0) = vp + i * 3;
+			fi->V(1) = vp + i * 3 + 1;
+			fi->V(2) = vp + i * 3 + 2;
 		}
 	}
+	return true;
 }
 
 } //namespace gltf::internal
@@ -25,7 +25,6 @@
 #define GLTF_LOADER_H
 
 #include "tinygltf_include.h"
-#include "callback_progress.h"
 
 #include <common/ml_document/mesh_model.h>
 
@@ -46,94 +45,109 @@ namespace internal {
 enum GLTF_ATTR_TYPE {POSITION, NORMAL, COLOR_0, TEXCOORD_0, INDICES};
 const std::array<std::string, 4> GLTF_ATTR_STR {"POSITION", "NORMAL", "COLOR_0", "TEXCOORD_0"};
 
+/**
+ * @brief a mesh referred by a node of the scene, with the transformation
+ * matrix accumulated along the node hierarchy
+ */
+struct MeshInstance
+{
+	int mesh;
+	Matrix44m transf;
+};
+
+/**
+ * @brief the data of an accessor, ready to be read: the element i starts at
+ * data + i * stride
+ */
+struct AccessorData
+{
+	const unsigned char* data = nullptr;
+	size_t stride = 0;
+	size_t count = 0;
+	int componentType = -1;
+	int nComponents = 0;
+	bool normalized = false;
+};
+
+/**
+ * @brief a primitive to be loaded in a range of the (preallocated) vertices
+ * and faces of a mesh
+ */
+struct PrimitiveJob
+{
+	MeshModel* m = nullptr;
+	Matrix44m transf;
+	bool applyTransf = false;
+	int textureId = -1;
+	bool hasBaseColor = false;
+	vcg::Color4b baseColor;
+	std::array<AccessorData, 5> attributes; // indexed by GLTF_ATTR_TYPE
+	size_t firstVertex = 0;
+	size_t firstFace = 0;
+	size_t faceNumber = 0;
+};
+
 unsigned int getNumberMeshes(
 		const tinygltf::Model& model,
 		unsigned int node);
 
-void loadMeshesWhileTraversingNodes(
+void getMeshInstances(
 		const tinygltf::Model& model,
-		std::list<MeshModel*>::const_iterator& currentMesh,
-		std::list<int>::iterator& currentMask,
 		Matrix44m currentMatrix,
 		unsigned int currentNode,
-		bool loadInSingleLayer,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress);
+		std::vector<MeshInstance>& instances);
 
 Matrix44m getCurrentNodeTrMatrix(
 		const tinygltf::Model& model,
 		unsigned int currentNode);
 
-void loadMesh(
-		MeshModel& m,
-		int& mask,
-		const tinygltf::Mesh& tm,
-		const tinygltf::Model& model,
-		bool loadInSingleLayer,
-		const Matrix44m& transf,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress);
-
-void loadMeshPrimitive(
+PrimitiveJob prepareMeshPrimitive(
 		MeshModel& m,
 		int& mask,
 		const tinygltf::Model& model,
 		const tinygltf::Primitive& p,
 		bool loadInSingleLayer,
-		const Matrix44m& transf,
-		vcg::CallBackPos* cb,
-		CallBackProgress& progress);
+		const Matrix44m& transf);
 
-bool loadAttribute(
-		MeshModel& m,
-		std::vector<CMeshO::VertexPointer>& ivp,
+bool loadMeshPrimitive(
+		const PrimitiveJob& job);
+
+bool getAccessorData(
 		const tinygltf::Model& model,
 		const tinygltf::Primitive& p,
 		GLTF_ATTR_TYPE attr,
-		int textID = -1);
+		AccessorData& accessorData);
 
 template <typename Scalar>
-void populateAttr(
+bool populateAttr(
 		GLTF_ATTR_TYPE attr,
-		MeshModel&m,
-		std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* array,
-		unsigned int number,
-		int textID = -1);
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 
 template <typename Scalar>
 void populateVertices(
-		MeshModel& m,
-		std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* posArray,
-		unsigned int vertNumber);
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 
 template <typename Scalar>
 void populateVNormals(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* normArray,
-		unsigned int vertNumber);
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 
 template <typename Scalar>
 void populateVColors(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* colorArray,
-		unsigned int vertNumber,
-		int nElemns);
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 
 template <typename Scalar>
 void populateVTextCoords(
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* textCoordArray,
-		unsigned int vertNumber,
-		int textID);
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 
 template <typename Scalar>
-void populateTriangles(
-		MeshModel&m,
-		const std::vector<CMeshO::VertexPointer>& ivp,
-		const Scalar* triArray,
-		unsigned int triNumber);
+bool populateTriangles(
+		const PrimitiveJob& job,
+		const AccessorData& acc);
 }
 
 }
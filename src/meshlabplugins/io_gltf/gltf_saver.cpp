@@ -0,0 +1,760 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "gltf_saver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QBuffer>
+#include <QFileInfo>
+
+#include <common/mlexception.h>
+
+#include "tinygltf_include.h"
+
+namespace gltf {
+
+namespace {
+
+const unsigned int INVALID_INDEX = std::numeric_limits<unsigned int>::max();
+
+/**
+ * @brief a primitive of the saved mesh
+ */
+struct Chunk
+{
+	//indices (in the compacted mesh) of the vertices of the primitive,
+	//in the order in which they are stored
+	std::vector<unsigned int> vertices;
+	//triangles of the primitive, as indices in the vertices vector
+	std::vector<unsigned int> indices;
+};
+
+/**
+ * @brief byte offsets of the attributes in an interleaved vertex
+ * (-1 if the attribute is not saved)
+ */
+struct VertexLayout
+{
+	int position = 0;
+	int normal = -1;
+	int texCoord = -1;
+	int color = -1;
+	int stride = 0;
+	bool quantize = false;
+	bool quantizeTexCoord = false;
+};
+
+/**
+ * @brief Appends a buffer view of the given size to the (single) buffer of
+ * the model, and returns the pointer to its data, that must be filled before
+ * adding other buffer views. Buffer views are 4 bytes aligned.
+ */
+unsigned char* addBufferView(
+		tinygltf::Model& model,
+		size_t size,
+		int stride,
+		int target,
+		int& bufferView)
+{
+	std::vector<unsigned char>& data = model.buffers[0].data;
+	tinygltf::BufferView view;
+	view.buffer = 0;
+	view.byteOffset = data.size();
+	view.byteLength = size;
+	view.byteStride = stride;
+	view.target = target;
+	data.resize((data.size() + size + 3) & ~size_t(3), 0);
+	model.bufferViews.push_back(view);
+	bufferView = model.bufferViews.size() - 1;
+	return data.data() + view.byteOffset;
+}
+
+int addAccessor(
+		tinygltf::Model& model,
+		int bufferView,
+		int byteOffset,
+		int componentType,
+		bool normalized,
+		int type,
+		size_t count,
+		const std::vector<double>& minValues = std::vector<double>(),
+		const std::vector<double>& maxValues = std::vector<double>())
+{
+	tinygltf::Accessor accessor;
+	accessor.bufferView = bufferView;
+	accessor.byteOffset = byteOffset;
+	accessor.componentType = componentType;
+	accessor.normalized = normalized;
+	accessor.type = type;
+	accessor.count = count;
+	accessor.minValues = minValues;
+	accessor.maxValues = maxValues;
+	model.accessors.push_back(accessor);
+	return model.accessors.size() - 1;
+}
+
+/**
+ * @brief splits the (optimized) triangles in primitives that use at most
+ * maxVertices vertices. The vertices of each primitive are numbered in order
+ * of first use, that is the best order for vertex fetching.
+ */
+std::vector<Chunk> splitInChunks(
+		const std::vector<unsigned int>& indices,
+		unsigned int vertexNumber,
+		size_t maxVertices)
+{
+	std::vector<Chunk> chunks(1);
+	std::vector<unsigned int> owner(vertexNumber, INVALID_INDEX);
+	std::vector<unsigned int> local(vertexNumber);
+	for (size_t t = 0; t < indices.size(); t += 3) {
+		unsigned int chunkId = chunks.size() - 1;
+		int newVertices = 0;
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[t+k];
+			bool repeated = (k > 0 && indices[t] == v) || (k > 1 && indices[t+1] == v);
+			if (owner[v] != chunkId && !repeated)
+				++newVertices;
+		}
+		if (chunks.back().vertices.size() + newVertices > maxVertices) {
+			chunks.emplace_back();
+			++chunkId;
+		}
+		Chunk& c = chunks.back();
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[t+k];
+			if (owner[v] != chunkId) {
+				owner[v] = chunkId;
+				local[v] = c.vertices.size();
+				c.vertices.push_back(v);
+			}
+			c.indices.push_back(local[v]);
+		}
+	}
+	return chunks;
+}
+
+/**
+ * @brief Forsyth's vertex score: vertices in the cache and with few remaining
+ * triangles are preferred.
+ */
+inline float vertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+	const int cacheSize = 32;
+	if (remainingTriangles == 0)
+		return -1;
+	float score = 0;
+	if (cachePosition >= 0) {
+		//the vertices of the last triangle get a fixed score, so that the
+		//same triangle strip direction is not preferred
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = std::pow(1.0f - (cachePosition - 3) / float(cacheSize - 3), 1.5f);
+	}
+	return score + 2.0f / std::sqrt((float) remainingTriangles);
+}
+
+} //namespace
+
+/**
+ * @brief Saves the mesh in a binary glTF (.glb) file.
+ *
+ * Triangles are reordered for the post transform vertex cache and then for
+ * overdraw; the vertex attributes are interleaved in a single buffer view per
+ * primitive, and, if quantize is true, they are stored with the integer types
+ * allowed by KHR_mesh_quantization (the dequantization of the positions is
+ * stored in the node matrix).
+ * If shortIndices is true, large meshes are split in primitives of at most
+ * 65536 vertices, that can be indexed with 16 bit indices.
+ * When wedge texture coordinates are saved, the vertices are duplicated on
+ * the texture seams.
+ */
+void saveMesh(
+		const QString& fileName,
+		const MeshModel& m,
+		int mask,
+		bool quantize,
+		bool shortIndices,
+		vcg::CallBackPos* cb)
+{
+	using vcg::tri::io::Mask;
+	const CMeshO& cm = m.cm;
+
+	const bool saveNormals = mask & Mask::IOM_VERTNORMAL;
+	const bool saveColors =
+			(mask & Mask::IOM_VERTCOLOR) && m.hasDataMask(MeshModel::MM_VERTCOLOR);
+	//wedge texture coordinates are preferred, since glTF has a single set
+	const bool saveWedgeTexCoords =
+			(mask & Mask::IOM_WEDGTEXCOORD) && m.hasDataMask(MeshModel::MM_WEDGTEXCOORD);
+	const bool saveTexCoords = saveWedgeTexCoords ||
+			((mask & Mask::IOM_VERTTEXCOORD) && m.hasDataMask(MeshModel::MM_VERTTEXCOORD));
+
+	//compact indices of the saved vertices and of the triangles, and the
+	//texture coordinates of the saved vertices
+	std::vector<unsigned int> vertexIds;
+	std::vector<unsigned int> indices;
+	std::vector<vcg::TexCoord2<Scalarm>> texCoords;
+	vertexIds.reserve(cm.vn);
+	indices.reserve(cm.fn * 3);
+	if (!saveWedgeTexCoords) {
+		std::vector<unsigned int> remap(cm.vert.size(), INVALID_INDEX);
+		for (unsigned int i = 0; i < cm.vert.size(); ++i) {
+			if (!cm.vert[i].IsD()) {
+				remap[i] = vertexIds.size();
+				vertexIds.push_back(i);
+				if (saveTexCoords)
+					texCoords.emplace_back(cm.vert[i].cT().U(), cm.vert[i].cT().V());
+			}
+		}
+		for (const CFaceO& f : cm.face) {
+			if (!f.IsD()) {
+				for (int k = 0; k < 3; ++k)
+					indices.push_back(remap[vcg::tri::Index(cm, f.cV(k))]);
+			}
+		}
+	}
+	else {
+		//vertices are split on the texture seams: a vertex is saved once for
+		//each distinct wedge texture coordinate of its faces
+		std::vector<unsigned int> firstCopy(cm.vert.size(), INVALID_INDEX);
+		std::vector<unsigned int> nextCopy;
+		for (const CFaceO& f : cm.face) {
+			if (f.IsD())
+				continue;
+			for (int k = 0; k < 3; ++k) {
+				const unsigned int vi = vcg::tri::Index(cm, f.cV(k));
+				const Scalarm tu = f.cWT(k).U();
+				const Scalarm tv = f.cWT(k).V();
+				unsigned int id = firstCopy[vi];
+				while (id != INVALID_INDEX && (texCoords[id].U() != tu || texCoords[id].V() != tv))
+					id = nextCopy[id];
+				if (id == INVALID_INDEX) {
+					id = vertexIds.size();
+					vertexIds.push_back(vi);
+					texCoords.emplace_back(tu, tv);
+					nextCopy.push_back(firstCopy[vi]);
+					firstCopy[vi] = id;
+				}
+				indices.push_back(id);
+			}
+		}
+		//unreferenced vertices are kept, as done without wedge coordinates
+		for (unsigned int i = 0; i < cm.vert.size(); ++i) {
+			if (!cm.vert[i].IsD() && firstCopy[i] == INVALID_INDEX) {
+				vertexIds.push_back(i);
+				texCoords.emplace_back(0, 0);
+			}
+		}
+	}
+	const unsigned int vertexNumber = vertexIds.size();
+	if (vertexNumber == 0)
+		throw MLException("Cannot save an empty mesh in a glTF file.");
+
+	std::vector<Point3m> positions(vertexNumber);
+	vcg::Box3<Scalarm> box;
+	for (unsigned int i = 0; i < vertexNumber; ++i) {
+		positions[i] = cm.vert[vertexIds[i]].cP();
+		box.Add(positions[i]);
+	}
+
+	std::vector<Chunk> chunks;
+	if (!indices.empty()) {
+		if (cb)
+			cb(10, "Optimizing triangle order for vertex cache");
+		indices = internal::optimizeVertexCache(indices, vertexNumber);
+		if (cb)
+			cb(30, "Optimizing triangle order for overdraw");
+		indices = internal::optimizeOverdraw(indices, positions);
+		chunks = splitInChunks(
+					indices,
+					vertexNumber,
+					shortIndices ? 65536 : std::numeric_limits<unsigned int>::max());
+		indices.clear();
+		indices.shrink_to_fit();
+	}
+	else { //point cloud: a single primitive, without indices
+		chunks.resize(1);
+		chunks[0].vertices.resize(vertexNumber);
+		for (unsigned int i = 0; i < vertexNumber; ++i)
+			chunks[0].vertices[i] = i;
+	}
+
+	//layout of the interleaved vertices; all the attributes are 4 bytes aligned
+	VertexLayout layout;
+	layout.quantize = quantize;
+	layout.stride = quantize ? 8 : 12;
+	if (saveNormals) {
+		layout.normal = layout.stride;
+		layout.stride += quantize ? 4 : 12;
+	}
+	if (saveTexCoords) {
+		//texture coordinates can be stored as normalized integers only if
+		//they are in the [0, 1] range
+		layout.quantizeTexCoord = quantize;
+		for (unsigned int i = 0; i < vertexNumber && layout.quantizeTexCoord; ++i) {
+			const vcg::TexCoord2<Scalarm>& t = texCoords[i];
+			if (t.U() < 0 || t.U() > 1 || t.V() < 0 || t.V() > 1)
+				layout.quantizeTexCoord = false;
+		}
+		layout.texCoord = layout.stride;
+		layout.stride += layout.quantizeTexCoord ? 4 : 8;
+	}
+	if (saveColors) {
+		layout.color = layout.stride;
+		layout.stride += 4;
+	}
+
+	//positions are quantized on a uniform grid over the bounding box
+	const Point3m origin = box.min;
+	Scalarm step = std::max({box.DimX(), box.DimY(), box.DimZ()}) / 65535;
+	if (!(step > 0))
+		step = 1;
+	auto quantizePosition = [&](Scalarm v, int axis) {
+		return (uint16_t) std::min<double>(65535.0, std::round((v - origin[axis]) / step));
+	};
+
+	tinygltf::Model model;
+	model.asset.version = "2.0";
+	model.asset.generator = "MeshLab";
+	model.buffers.resize(1);
+	if (quantize) {
+		model.extensionsUsed.push_back("KHR_mesh_quantization");
+		model.extensionsRequired.push_back("KHR_mesh_quantization");
+	}
+
+	size_t bufferSize = 0;
+	for (const Chunk& c : chunks)
+		bufferSize += c.vertices.size() * layout.stride + c.indices.size() * 4 + 8;
+	model.buffers[0].data.reserve(bufferSize);
+
+	//texture: only the first texture of the mesh is saved
+	int material = -1;
+	if (saveTexCoords && !cm.textures.empty()) {
+		const QString textureName = QString::fromStdString(cm.textures[0]);
+		QImage img = m.getTexture(cm.textures[0]);
+		if (!img.isNull()) {
+			const QString suffix = QFileInfo(textureName).suffix().toLower();
+			const bool jpeg = suffix == "jpg" || suffix == "jpeg";
+			QByteArray bytes;
+			QBuffer qbuffer(&bytes);
+			qbuffer.open(QIODevice::WriteOnly);
+			img.save(&qbuffer, jpeg ? "JPG" : "PNG");
+
+			tinygltf::Image image;
+			unsigned char* data = addBufferView(model, bytes.size(), 0, 0, image.bufferView);
+			std::memcpy(data, bytes.constData(), bytes.size());
+			image.mimeType = jpeg ? "image/jpeg" : "image/png";
+			image.name = QFileInfo(textureName).completeBaseName().toStdString();
+			model.images.push_back(image);
+
+			tinygltf::Texture texture;
+			texture.source = 0;
+			model.textures.push_back(texture);
+
+			tinygltf::Material mat;
+			mat.pbrMetallicRoughness.baseColorTexture.index = 0;
+			mat.pbrMetallicRoughness.metallicFactor = 0;
+			model.materials.push_back(mat);
+			material = 0;
+		}
+	}
+
+	tinygltf::Mesh mesh;
+	mesh.name = m.label().toStdString();
+	for (unsigned int ci = 0; ci < chunks.size(); ++ci) {
+		const Chunk& c = chunks[ci];
+		const int vn = c.vertices.size();
+		if (cb)
+			cb(40 + (50 * ci) / chunks.size(), "Writing vertex attributes");
+
+		int vertexView;
+		unsigned char* data = addBufferView(
+					model, (size_t) vn * layout.stride, layout.stride,
+					TINYGLTF_TARGET_ARRAY_BUFFER, vertexView);
+
+		#pragma omp parallel for schedule(static)
+		for (int i = 0; i < vn; ++i) {
+			const CVertexO& v = cm.vert[vertexIds[c.vertices[i]]];
+			unsigned char* out = data + (size_t) i * layout.stride;
+			if (layout.quantize) {
+				uint16_t p[4] = {
+					quantizePosition(v.cP()[0], 0),
+					quantizePosition(v.cP()[1], 1),
+					quantizePosition(v.cP()[2], 2),
+					0};
+				std::memcpy(out + layout.position, p, sizeof(p));
+			}
+			else {
+				float p[3] = {(float) v.cP()[0], (float) v.cP()[1], (float) v.cP()[2]};
+				std::memcpy(out + layout.position, p, sizeof(p));
+			}
+			if (layout.normal >= 0) {
+				//null (or not finite) normals cannot be normalized: +Z is saved instead
+				Point3m n = v.cN();
+				const Scalarm sqNorm = n.SquaredNorm();
+				if (sqNorm > 0 && std::isfinite(sqNorm))
+					n.Normalize();
+				else
+					n = Point3m(0, 0, 1);
+				if (layout.quantize) {
+					int8_t qn[4] = {
+						(int8_t) std::round(n[0] * 127),
+						(int8_t) std::round(n[1] * 127),
+						(int8_t) std::round(n[2] * 127),
+						0};
+					std::memcpy(out + layout.normal, qn, sizeof(qn));
+				}
+				else {
+					float fn[3] = {(float) n[0], (float) n[1], (float) n[2]};
+					std::memcpy(out + layout.normal, fn, sizeof(fn));
+				}
+			}
+			if (layout.texCoord >= 0) {
+				//glTF texture coordinates have the origin on the top left corner
+				const vcg::TexCoord2<Scalarm>& vt = texCoords[c.vertices[i]];
+				const Scalarm tu = vt.U();
+				const Scalarm tv = 1 - vt.V();
+				if (layout.quantizeTexCoord) {
+					uint16_t t[2] = {
+						(uint16_t) std::round(tu * 65535),
+						(uint16_t) std::round(tv * 65535)};
+					std::memcpy(out + layout.texCoord, t, sizeof(t));
+				}
+				else {
+					float t[2] = {(float) tu, (float) tv};
+					std::memcpy(out + layout.texCoord, t, sizeof(t));
+				}
+			}
+			if (layout.color >= 0) {
+				std::memcpy(out + layout.color, &v.cC()[0], 4);
+			}
+		}
+
+		//bounding box of the positions, required by the specification
+		vcg::Box3<Scalarm> chunkBox;
+		for (unsigned int vi : c.vertices)
+			chunkBox.Add(positions[vi]);
+		std::vector<double> minPos(3), maxPos(3);
+		for (int k = 0; k < 3; ++k) {
+			if (quantize) {
+				minPos[k] = quantizePosition(chunkBox.min[k], k);
+				maxPos[k] = quantizePosition(chunkBox.max[k], k);
+			}
+			else {
+				minPos[k] = (float) chunkBox.min[k];
+				maxPos[k] = (float) chunkBox.max[k];
+			}
+		}
+
+		tinygltf::Primitive primitive;
+		primitive.attributes["POSITION"] = addAccessor(
+					model, vertexView, layout.position,
+					quantize ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_FLOAT,
+					false, TINYGLTF_TYPE_VEC3, vn, minPos, maxPos);
+		if (layout.normal >= 0) {
+			primitive.attributes["NORMAL"] = addAccessor(
+						model, vertexView, layout.normal,
+						quantize ? TINYGLTF_COMPONENT_TYPE_BYTE : TINYGLTF_COMPONENT_TYPE_FLOAT,
+						quantize, TINYGLTF_TYPE_VEC3, vn);
+		}
+		if (layout.texCoord >= 0) {
+			primitive.attributes["TEXCOORD_0"] = addAccessor(
+						model, vertexView, layout.texCoord,
+						layout.quantizeTexCoord ?
+							TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_FLOAT,
+						layout.quantizeTexCoord, TINYGLTF_TYPE_VEC2, vn);
+		}
+		if (layout.color >= 0) {
+			primitive.attributes["COLOR_0"] = addAccessor(
+						model, vertexView, layout.color,
+						TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+						true, TINYGLTF_TYPE_VEC4, vn);
+		}
+
+		if (!c.indices.empty()) {
+			const bool shortType = vn <= 65536;
+			const size_t indexSize = shortType ? 2 : 4;
+			int indexView;
+			unsigned char* idata = addBufferView(
+						model, c.indices.size() * indexSize, 0,
+						TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER, indexView);
+			if (shortType) {
+				uint16_t* sdata = (uint16_t*) idata;
+				for (size_t i = 0; i < c.indices.size(); ++i)
+					sdata[i] = c.indices[i];
+			}
+			else {
+				std::memcpy(idata, c.indices.data(), c.indices.size() * indexSize);
+			}
+			primitive.indices = addAccessor(
+						model, indexView, 0,
+						shortType ?
+							TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+						false, TINYGLTF_TYPE_SCALAR, c.indices.size());
+			primitive.mode = TINYGLTF_MODE_TRIANGLES;
+		}
+		else {
+			primitive.mode = TINYGLTF_MODE_POINTS;
+		}
+		primitive.material = material;
+		mesh.primitives.push_back(primitive);
+	}
+	model.meshes.push_back(mesh);
+
+	//node matrix: mesh transformation and dequantization of the positions
+	Matrix44m transf = cm.Tr;
+	if (quantize) {
+		Matrix44m dequant;
+		dequant.SetScale(step, step, step);
+		dequant.ElementAt(0, 3) = origin[0];
+		dequant.ElementAt(1, 3) = origin[1];
+		dequant.ElementAt(2, 3) = origin[2];
+		transf = transf * dequant;
+	}
+	tinygltf::Node node;
+	node.mesh = 0;
+	if (transf != Matrix44m::Identity()) {
+		//gltf matrices are stored in column major order
+		node.matrix.resize(16);
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				node.matrix[c * 4 + r] = transf.ElementAt(r, c);
+	}
+	model.nodes.push_back(node);
+
+	tinygltf::Scene scene;
+	scene.nodes.push_back(0);
+	model.scenes.push_back(scene);
+	model.defaultScene = 0;
+
+	if (cb)
+		cb(90, "Writing glTF file");
+	tinygltf::TinyGLTF writer;
+	if (!writer.WriteGltfSceneToFile(&model, QFile::encodeName(fileName).toStdString(), true, true, false, true))
+		throw MLException("Failed writing glTF file " + fileName);
+	if (cb)
+		cb(100, "GLB File saved");
+}
+
+namespace internal {
+
+/**
+ * @brief Reorders the triangles to improve the hit rate of the post
+ * transform vertex cache, using the linear speed algorithm of Tom Forsyth:
+ * the next triangle is the one with the best score among the triangles of
+ * the vertices in the (simulated, LRU) cache.
+ *
+ * @param indices: three vertex indices for each triangle
+ * @param vertexNumber: the number of vertices referred by indices
+ * @return the reordered indices
+ */
+std::vector<unsigned int> optimizeVertexCache(
+		const std::vector<unsigned int>& indices,
+		unsigned int vertexNumber)
+{
+	const unsigned int cacheSize = 32;
+	const size_t triNumber = indices.size() / 3;
+
+	//triangles adjacent to each vertex; the first remaining[v] ones have not
+	//been emitted yet
+	std::vector<size_t> adjOffset(vertexNumber + 1, 0);
+	for (unsigned int v : indices)
+		++adjOffset[v + 1];
+	for (unsigned int v = 0; v < vertexNumber; ++v)
+		adjOffset[v + 1] += adjOffset[v];
+	std::vector<unsigned int> remaining(vertexNumber, 0);
+	std::vector<unsigned int> adjTriangles(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) {
+		unsigned int v = indices[i];
+		adjTriangles[adjOffset[v] + remaining[v]++] = i / 3;
+	}
+
+	std::vector<int> cachePosition(vertexNumber, -1);
+	std::vector<float> score(vertexNumber);
+	for (unsigned int v = 0; v < vertexNumber; ++v)
+		score[v] = vertexScore(-1, remaining[v]);
+
+	std::vector<bool> emitted(triNumber, false);
+	std::vector<unsigned int> cache, newCache;
+	cache.reserve(cacheSize + 3);
+	newCache.reserve(cacheSize + 3);
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	size_t nextInput = 0; //used when there are no candidates in the cache
+	long long best = -1;
+	for (size_t n = 0; n < triNumber; ++n) {
+		if (best < 0) {
+			while (emitted[nextInput])
+				++nextInput;
+			best = nextInput;
+		}
+		const unsigned int* tri = &indices[best * 3];
+		emitted[best] = true;
+		result.insert(result.end(), tri, tri + 3);
+
+		//remove the triangle from the remaining ones of its vertices
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = tri[k];
+			unsigned int* adj = &adjTriangles[adjOffset[v]];
+			for (unsigned int j = 0; j < remaining[v]; ++j) {
+				if (adj[j] == best) {
+					std::swap(adj[j], adj[remaining[v] - 1]);
+					--remaining[v];
+					break;
+				}
+			}
+		}
+
+		//the vertices of the triangle go on top of the cache
+		newCache.assign(tri, tri + 3);
+		for (unsigned int v : cache) {
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache.push_back(v);
+		}
+
+		//update the scores of the vertices in the cache (and of the ones
+		//that exit from it), then choose the best triangle in the cache
+		for (unsigned int i = 0; i < newCache.size(); ++i) {
+			unsigned int v = newCache[i];
+			cachePosition[v] = i < cacheSize ? i : -1;
+			score[v] = vertexScore(cachePosition[v], remaining[v]);
+		}
+		best = -1;
+		float bestScore = -1;
+		for (unsigned int i = 0; i < newCache.size() && i < cacheSize; ++i) {
+			unsigned int v = newCache[i];
+			const unsigned int* adj = &adjTriangles[adjOffset[v]];
+			for (unsigned int j = 0; j < remaining[v]; ++j) {
+				const unsigned int* t = &indices[adj[j] * 3];
+				float s = score[t[0]] + score[t[1]] + score[t[2]];
+				if (s > bestScore) {
+					bestScore = s;
+					best = adj[j];
+				}
+			}
+		}
+		if (newCache.size() > cacheSize)
+			newCache.resize(cacheSize);
+		std::swap(cache, newCache);
+	}
+	return result;
+}
+
+/**
+ * @brief Reorders the clusters of triangles produced by optimizeVertexCache
+ * to reduce overdraw, following Sander et al. "Fast Triangle Reordering for
+ * Vertex Locality and Reduced Overdraw": the triangles are split in clusters
+ * where the cache optimized order restarts (a triangle with no vertex in the
+ * simulated cache), and the clusters that face outwards the mesh are drawn
+ * first, since they are more likely to occlude the other ones.
+ * The order of the triangles inside each cluster is kept.
+ *
+ * @param indices: three vertex indices for each triangle
+ * @param positions: the positions of the vertices
+ * @return the reordered indices
+ */
+std::vector<unsigned int> optimizeOverdraw(
+		const std::vector<unsigned int>& indices,
+		const std::vector<Point3m>& positions)
+{
+	const unsigned int cacheSize = 16;
+	const size_t triNumber = indices.size() / 3;
+
+	//clusters, as the index of their first triangle
+	std::vector<size_t> clusters;
+	std::vector<size_t> cacheTime(positions.size(), 0);
+	size_t time = cacheSize + 1;
+	for (size_t t = 0; t < triNumber; ++t) {
+		int misses = 0;
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[t * 3 + k];
+			if (time - cacheTime[v] > cacheSize) {
+				cacheTime[v] = time++;
+				++misses;
+			}
+		}
+		if (misses == 3 || t == 0)
+			clusters.push_back(t);
+	}
+	clusters.push_back(triNumber);
+
+	Point3m meshCentroid(0, 0, 0);
+	Scalarm meshArea = 0;
+	std::vector<Scalarm> sortKey(clusters.size() - 1);
+	std::vector<Point3m> clusterCentroid(clusters.size() - 1, Point3m(0, 0, 0));
+	std::vector<Point3m> clusterNormal(clusters.size() - 1, Point3m(0, 0, 0));
+	std::vector<Scalarm> clusterArea(clusters.size() - 1, 0);
+
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (int c = 0; c < (int) clusters.size() - 1; ++c) {
+		for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			const Point3m& p0 = positions[indices[t * 3]];
+			const Point3m& p1 = positions[indices[t * 3 + 1]];
+			const Point3m& p2 = positions[indices[t * 3 + 2]];
+			Point3m n = (p1 - p0) ^ (p2 - p0);
+			Scalarm area = n.Norm();
+			clusterCentroid[c] += (p0 + p1 + p2) * (area / 3);
+			clusterNormal[c] += n;
+			clusterArea[c] += area;
+		}
+	}
+	for (size_t c = 0; c < clusterArea.size(); ++c) {
+		meshCentroid += clusterCentroid[c];
+		meshArea += clusterArea[c];
+	}
+	if (meshArea > 0)
+		meshCentroid /= meshArea;
+
+	for (size_t c = 0; c < sortKey.size(); ++c) {
+		if (clusterArea[c] > 0)
+			clusterCentroid[c] /= clusterArea[c];
+		clusterNormal[c].Normalize();
+		sortKey[c] = (clusterCentroid[c] - meshCentroid) * clusterNormal[c];
+	}
+
+	std::vector<unsigned int> order(sortKey.size());
+	for (unsigned int c = 0; c < order.size(); ++c)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+		return sortKey[a] > sortKey[b];
+	});
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	for (unsigned int c : order) {
+		result.insert(
+					result.end(),
+					indices.begin() + clusters[c] * 3,
+					indices.begin() + clusters[c + 1] * 3);
+	}
+	return result;
+}
+
+} //namespace gltf::internal
+} //namespace gltf
@@ -21,21 +21,33 @@
 *                                                                           *
 ****************************************************************************/
 
-#ifndef CALLBACK_PROGRESS_H
-#define CALLBACK_PROGRESS_H
-
-class CallBackProgress {
-public:
-	CallBackProgress(double step = 1) : p(0), s(step) {}
-	double progress() const {return p;}
-	double step() const {return s;}
-	void reset() {p = 0;}
-	void setStep(double step) {s = step;}
-	void increment() {p += s;}
-
-private:
-	double p;
-	double s;
-};
-
-#endif // CALLBACK_PROGRESS_H
+#ifndef GLTF_SAVER_H
+#define GLTF_SAVER_H
+
+#include <common/ml_document/mesh_model.h>
+
+namespace gltf {
+
+void saveMesh(
+		const QString& fileName,
+		const MeshModel& m,
+		int mask,
+		bool quantize,
+		bool shortIndices,
+		vcg::CallBackPos* cb = nullptr);
+
+namespace internal {
+
+std::vector<unsigned int> optimizeVertexCache(
+		const std::vector<unsigned int>& indices,
+		unsigned int vertexNumber);
+
+std::vector<unsigned int> optimizeOverdraw(
+		const std::vector<unsigned int>& indices,
+		const std::vector<Point3m>& positions);
+
+}
+
+}
+
+#endif // GLTF_SAVER_H
@@ -26,6 +26,7 @@
 #include "io_gltf.h"
 
 #include "gltf_loader.h"
+#include "gltf_saver.h"
 
 QString IOglTFPlugin::pluginName() const
 {
@@ -45,7 +46,9 @@ std::list<FileFormat> IOglTFPlugin::importFormats() const
 */
 std::list<FileFormat> IOglTFPlugin::exportFormats() const
 {
-	return {};
+	return {
+		FileFormat("Binary GL Transmission Format 2.0", tr("GLB")),
+	};
 }
 
 /*
@@ -53,10 +56,18 @@ std::list<FileFormat> IOglTFPlugin::exportFormats() const
 	otherwise it returns 0 if the file format is unknown
 */
 void IOglTFPlugin::exportMaskCapability(
-		const QString&,
+		const QString& format,
 		int &capability,
 		int &defaultBits) const
 {
+	if (format.toUpper() == tr("GLB")) {
+		capability = defaultBits =
+				vcg::tri::io::Mask::IOM_VERTNORMAL |
+				vcg::tri::io::Mask::IOM_VERTCOLOR |
+				vcg::tri::io::Mask::IOM_VERTTEXCOORD |
+				vcg::tri::io::Mask::IOM_WEDGTEXCOORD;
+		return;
+	}
 	capability=defaultBits=0;
 	return;
 }
@@ -74,6 +85,28 @@ RichParameterList IOglTFPlugin::initPreOpenParameter(
 	return parameters;
 }
 
+RichParameterList IOglTFPlugin::initSaveParameter(
+		const QString& format,
+		const MeshModel&) const
+{
+	RichParameterList parameters;
+	if (format.toUpper() == tr("GLB")) {
+		parameters.addParam(RichBool(
+				"quantize", true, "Quantize attributes",
+				"Store positions, normals and texture coordinates as integers "
+				"(KHR_mesh_quantization extension), producing smaller files that "
+				"are faster to decode. Positions are quantized with 16 bits on "
+				"the bounding box of the mesh."));
+		parameters.addParam(RichBool(
+				"short_indices", true, "16 bit indices",
+				"If checked, meshes with more than 65536 vertices are split in "
+				"primitives indexed with 16 bit integers (the vertices on the "
+				"borders of the primitives are duplicated). Otherwise a single "
+				"primitive indexed with 32 bit integers is saved."));
+	}
+	return parameters;
+}
+
 unsigned int IOglTFPlugin::numberMeshesContainedInFile(
 		const QString& format,
 		const QString& fileName,
@@ -150,13 +183,24 @@ void IOglTFPlugin::open(
 
 void IOglTFPlugin::save(
 		const QString& fileFormat,
-		const QString&,
-		MeshModel&,
-		const int ,
-		const RichParameterList&,
-		vcg::CallBackPos*)
+		const QString& fileName,
+		MeshModel& m,
+		const int mask,
+		const RichParameterList& params,
+		vcg::CallBackPos* cb)
 {
-	wrongSaveFormat(fileFormat);
+	if (fileFormat.toUpper() == tr("GLB")) {
+		gltf::saveMesh(
+				fileName,
+				m,
+				mask,
+				params.getBool("quantize"),
+				params.getBool("short_indices"),
+				cb);
+	}
+	else {
+		wrongSaveFormat(fileFormat);
+	}
 }
 
 MESHLAB_PLUGIN_NAME_EXPORTER(IOglTFPlugin)
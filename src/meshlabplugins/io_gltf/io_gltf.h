@@ -47,6 +47,10 @@ public:
 	RichParameterList initPreOpenParameter(
 			const QString& format) const;
 
+	RichParameterList initSaveParameter(
+			const QString& format,
+			const MeshModel& m) const;
+
 	unsigned int numberMeshesContainedInFile(
 			const QString& format,
 			const QString& fileName,
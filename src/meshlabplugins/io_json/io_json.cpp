@@ -30,6 +30,41 @@
 #include <QString>
 #include <QFile>
 
+#include <common/utilities/text_formatting.h>
+
+namespace {
+
+const std::size_t maxValuesPerLine = 10; // must be > 0
+
+/**
+ * @brief writes the lines of a JSON array with the components of count
+ * elements (maxValuesPerLine elements per line); format(i, buffer) writes
+ * the i-th value of the array. The lines are formatted in parallel.
+ */
+template <typename Format>
+void writeValues(std::ofstream& os, std::size_t count, std::size_t components, Format format)
+{
+	const std::size_t lines = (count + maxValuesPerLine - 1) / maxValuesPerLine;
+	meshlab::formatRowsInParallel(
+		lines,
+		[&](std::size_t line, meshlab::TextBuffer& out) {
+			const std::size_t begin = line * maxValuesPerLine;
+			const std::size_t end = std::min(begin + maxValuesPerLine, count);
+			out.append("        ");
+			for (std::size_t i = begin * components; i < end * components; ++i) {
+				if (i > begin * components)
+					out.append(", ");
+				format(i, out);
+			}
+			if (end < count)
+				out.append(',');
+			out.append('\n');
+		},
+		[&](const char* data, std::size_t size) { os.write(data, size); });
+}
+
+} // namespace
+
 JSONIOPlugin::JSONIOPlugin(void) : IOPlugin()
 {
 	;
@@ -56,8 +91,6 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 		vcg::tri::Allocator<CMeshO>::CompactVertexVector(m.cm);
 		vcg::tri::Allocator<CMeshO>::CompactFaceVector(m.cm);
 
-		const size_t maxValuesPerLine = 10; // must be > 0
-
 		const bool hasPerVertexPosition = true;
 		const bool hasPerVertexNormal   = ((mask & vcg::tri::io::Mask::IOM_VERTNORMAL)   != 0) && m.hasDataMask(MeshModel::MM_VERTNORMAL);
 		const bool hasPerVertexColor    = ((mask & vcg::tri::io::Mask::IOM_VERTCOLOR)    != 0) && m.hasDataMask(MeshModel::MM_VERTCOLOR);
@@ -98,31 +131,10 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 			os << "      \"values\"     :" << std::endl;
 			os << "      [" << std::endl;
 
-			size_t it = 0;
-			const size_t sz = cm.vert.size();
-			while (it < sz)
-			{
-				const size_t n = std::min(it + maxValuesPerLine, sz);
-				if (n > 0)
-				{
-					os << "        ";
-					{
-						const CMeshO::VertexType::CoordType & p = cm.vert[it].cP();
-						os << p[0] << ", " << p[1] << ", " << p[2];
-						it++;
-					}
-					for (; it<n; ++it)
-					{
-						const CMeshO::VertexType::CoordType & p = cm.vert[it].cP();
-						os << ", " << p[0] << ", " << p[1] << ", " << p[2];
-					}
-					if (it <= (sz - 1))
-					{
-						os << ",";
-					}
-					os << std::endl;
-				}
-			}
+			writeValues(os, cm.vert.size(), 3, [&](std::size_t i, meshlab::TextBuffer& out) {
+				// the shortest text that is read back as the same float32 value
+				out.appendShortest((float) cm.vert[i / 3].cP()[i % 3]);
+			});
 
 			os << "      ]" << std::endl;
 			os << "    }";
@@ -145,31 +157,9 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 			os << "      \"values\"     :" << std::endl;
 			os << "      [" << std::endl;
 
-			size_t it = 0;
-			const size_t sz = cm.vert.size();
-			while (it < sz)
-			{
-				const size_t n = std::min(it + maxValuesPerLine, sz);
-				if (n > 0)
-				{
-					os << "        ";
-					{
-						const CMeshO::VertexType::NormalType & n = cm.vert[it].cN();
-						os << n[0] << ", " << n[1] << ", " << n[2];
-						it++;
-					}
-					for (; it<n; ++it)
-					{
-						const CMeshO::VertexType::NormalType & n = cm.vert[it].cN();
-						os << ", " << n[0] << ", " << n[1] << ", " << n[2];
-					}
-					if (it <= (sz - 1))
-					{
-						os << ",";
-					}
-					os << std::endl;
-				}
-			}
+			writeValues(os, cm.vert.size(), 3, [&](std::size_t i, meshlab::TextBuffer& out) {
+				out.appendShortest((float) cm.vert[i / 3].cN()[i % 3]);
+			});
 
 			os << "      ]" << std::endl;
 			os << "    }";
@@ -192,31 +182,9 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 			os << "      \"values\"     :" << std::endl;
 			os << "      [" << std::endl;
 
-			size_t it = 0;
-			const size_t sz = cm.vert.size();
-			while (it < sz)
-			{
-				const size_t n = std::min(it + maxValuesPerLine, sz);
-				if (n > 0)
-				{
-					os << "        ";
-					{
-						const CMeshO::VertexType::ColorType & c = cm.vert[it].cC();
-						os << int(c[0]) << ", " << int(c[1]) << ", " << int(c[2]) << ", " << int(c[3]);
-						it++;
-					}
-					for (; it<n; ++it)
-					{
-						const CMeshO::VertexType::ColorType & c = cm.vert[it].cC();
-						os << ", " << int(c[0]) << ", " << int(c[1]) << ", " << int(c[2]) << ", " << int(c[3]);
-					}
-					if (it <= (sz - 1))
-					{
-						os << ",";
-					}
-					os << std::endl;
-				}
-			}
+			writeValues(os, cm.vert.size(), 4, [&](std::size_t i, meshlab::TextBuffer& out) {
+				out.appendInt(cm.vert[i / 4].cC()[i % 4]);
+			});
 
 			os << "      ]" << std::endl;
 			os << "    }";
@@ -239,31 +207,9 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 			os << "      \"values\"     :" << std::endl;
 			os << "      [" << std::endl;
 
-			size_t it = 0;
-			const size_t sz = cm.vert.size();
-			while (it < sz)
-			{
-				const size_t n = std::min(it + maxValuesPerLine, sz);
-				if (n > 0)
-				{
-					os << "        ";
-					{
-						const CMeshO::VertexType::TexCoordType & t = cm.vert[it].cT();
-						os << t.P()[0] << ", " << t.P()[1];
-						it++;
-					}
-					for (; it<n; ++it)
-					{
-						const CMeshO::VertexType::TexCoordType & t = cm.vert[it].cT();
-						os << ", " << t.P()[0] << ", " << t.P()[1];
-					}
-					if (it <= (sz - 1))
-					{
-						os << ",";
-					}
-					os << std::endl;
-				}
-			}
+			writeValues(os, cm.vert.size(), 2, [&](std::size_t i, meshlab::TextBuffer& out) {
+				out.appendShortest((float) cm.vert[i / 2].cT().P()[i % 2]);
+			});
 
 			os << "      ]" << std::endl;
 			os << "    }";
@@ -292,38 +238,11 @@ void JSONIOPlugin::save(const QString & formatName,const QString & fileName, Mes
 			os << "      \"indices\"   :" << std::endl;
 			os << "      [" << std::endl;
 			{
+				// the vectors have been compacted: faces are the first fn ones
 				const CMeshO::VertexType * v0 = &(m.cm.vert[0]);
-
-				size_t k = 0;
-				size_t c = 0;
-				const size_t sz = cm.fn;
-				while (c < sz)
-				{
-					const size_t n = std::min(c + maxValuesPerLine, sz);
-					if (n > 0)
-					{
-						os << "        ";
-						{
-							while (cm.face[k].IsD()) k++;
-							const CMeshO::FaceType & f = cm.face[k];
-							os << int(f.cV(0) - v0) << ", " << int(f.cV(1) - v0) << ", " << int(f.cV(2) - v0);
-							c++;
-							k++;
-						}
-						for (; c<n; ++c)
-						{
-							while (cm.face[k].IsD()) k++;
-							const CMeshO::FaceType & f = cm.face[k];
-							os << ", " << int(f.cV(0) - v0) << ", " << int(f.cV(1) - v0) << ", " << int(f.cV(2) - v0);
-							k++;
-						}
-						if (c <= (sz - 1))
-						{
-							os << ",";
-						}
-						os << std::endl;
-					}
-				}
+				writeValues(os, cm.fn, 3, [&](std::size_t i, meshlab::TextBuffer& out) {
+					out.appendInt(int(cm.face[i / 3].cV(i % 3) - v0));
+				});
 			}
 			os << "      ]" << std::endl;
 			os << "    }" << std::endl;
@@ -33,12 +33,162 @@
 
 #include <vcg/complex/append.h>
 #include <vcg/complex/algorithms/create/platonic.h>
-#include <vcg/complex/algorithms/create/marching_cubes.h>
-#include <vcg/complex/algorithms/create/mc_trivial_walker.h>
+
+#include <common/utilities/sparse_volume.h>
 
 using namespace std;
 using namespace vcg;
-typedef vcg::SimpleVoxel<MESHLAB_SCALAR> SimpleVoxelm;
+
+namespace {
+
+/**
+ * @brief the voxel size of the jointed spheres and metaball surfaces: the one
+ * of the selected level of detail, or the custom surface resolution
+ */
+double surfaceVoxelSize(const RichParameterList& parlst)
+{
+	static const double LOD_VOXEL_SIZE[] = {0, 1.0, 0.5, 0.25, 0.125};
+	int lod = parlst.getEnum("surfacelod");
+	if (lod > 0 && lod < 5)
+		return LOD_VOXEL_SIZE[lod];
+	return parlst.getFloat("voxelsize");
+}
+
+/**
+ * @brief an empty volume covering the bounding box of the atoms enlarged by
+ * 5A, that is returned in rbb
+ */
+meshlab::SparseVolume initAtomVolume(const std::vector<Point3m>& atomPos, double step, float background, Box3m& rbb)
+{
+	rbb.SetNull();
+	for (const Point3m& p : atomPos)
+		rbb.Add(p);
+	if (rbb.IsNull())
+		rbb.Set(Point3m(0, 0, 0));
+	rbb.Offset(5);
+	Point3i siz = Point3i::Construct((rbb.max-rbb.min)*(1.0/step));
+	return meshlab::SparseVolume(siz, background);
+}
+
+/**
+ * @brief Splats the atoms in the volume: each voxel at position
+ * origin + step * (i, j, k) whose coordinates are all within cutoff from the
+ * ones of an atom is updated to splat(value, atomIndex, squaredDistance).
+ * Only the voxels of the bounding box of each atom are visited, in parallel
+ * over slabs of blocks along z; the atoms are applied to every voxel in index
+ * order, so the result does not depend on the number of threads.
+ */
+template <typename Splat>
+void splatAtoms(
+	meshlab::SparseVolume&      volume,
+	const std::vector<Point3m>& atomPos,
+	const Point3m&              origin,
+	double                      step,
+	float                       cutoff,
+	Splat                       splat)
+{
+	const int B = meshlab::SparseVolume::BLOCK_SIZE;
+	const Point3i siz = volume.size();
+
+	// voxel range of the bounding box of every atom
+	std::vector<Point3i> lo(atomPos.size()), hi(atomPos.size());
+	std::vector<std::vector<int>> slabAtoms(volume.blockCount()[2]);
+	for (size_t a = 0; a < atomPos.size(); ++a) {
+		bool empty = false;
+		for (int c = 0; c < 3; ++c) {
+			lo[a][c] = std::max(0, (int) floor((atomPos[a][c] - cutoff - origin[c]) / step));
+			hi[a][c] = std::min(siz[c] - 1, (int) ceil((atomPos[a][c] + cutoff - origin[c]) / step));
+			empty = empty || lo[a][c] > hi[a][c];
+		}
+		if (!empty) {
+			for (int bz = lo[a][2] / B; bz <= hi[a][2] / B; ++bz)
+				slabAtoms[bz].push_back((int) a);
+		}
+	}
+
+	// every slab of blocks is written by a single thread
+	#pragma omp parallel for schedule(dynamic)
+	for (int bz = 0; bz < (int) slabAtoms.size(); ++bz) {
+		for (int a : slabAtoms[bz]) {
+			const Point3m& p = atomPos[a];
+			for (int k = std::max(lo[a][2], bz * B); k <= std::min(hi[a][2], bz * B + B - 1); ++k) {
+				const float zpos = origin[2] + step * k;
+				if (fabs(zpos - p[2]) > cutoff)
+					continue;
+				for (int j = lo[a][1]; j <= hi[a][1]; ++j) {
+					const float ypos = origin[1] + step * j;
+					if (fabs(ypos - p[1]) > cutoff)
+						continue;
+					for (int i = lo[a][0]; i <= hi[a][0]; ++i) {
+						const float xpos = origin[0] + step * i;
+						if (fabs(xpos - p[0]) > cutoff)
+							continue;
+						const double dx = xpos - p[0];
+						const double dy = ypos - p[1];
+						const double dz = zpos - p[2];
+						float& v = volume.value(i, j, k);
+						v = splat(v, a, dx * dx + dy * dy + dz * dz);
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief colors each vertex with the average color of the atoms within 5A,
+ * weighted by their squared distance over the radius (clamped to 2). The
+ * atoms are binned in a grid of 5A cells, so only the 27 cells around each
+ * vertex are visited.
+ */
+void colorByNearAtoms(CMeshO& m, const std::vector<Point3m>& atomPos, const std::vector<Color4b>& atomCol, const std::vector<float>& atomRad)
+{
+	const float cutoff = 5.0f;
+	Box3m abb;
+	for (const Point3m& p : atomPos)
+		abb.Add(p);
+	if (abb.IsNull())
+		return;
+	Point3i gsiz;
+	for (int c = 0; c < 3; ++c)
+		gsiz[c] = int((abb.max[c] - abb.min[c]) / cutoff) + 1;
+	auto cellOf = [&](const Point3m& p, int c) {
+		return std::max(0, std::min(gsiz[c] - 1, int(std::floor((p[c] - abb.min[c]) / cutoff))));
+	};
+	std::vector<std::vector<int>> cells((size_t) gsiz[0] * gsiz[1] * gsiz[2]);
+	for (size_t atomIndex = 0; atomIndex < atomPos.size(); ++atomIndex) {
+		const Point3m& p = atomPos[atomIndex];
+		cells[((size_t) cellOf(p, 2) * gsiz[1] + cellOf(p, 1)) * gsiz[0] + cellOf(p, 0)].push_back((int) atomIndex);
+	}
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int vind = 0; vind < (int) m.vert.size(); ++vind) {
+		const Point3m& p = m.vert[vind].P();
+		double ww = 0, rr = 0, gg = 0, bb = 0;
+		for (int z = std::max(0, cellOf(p, 2) - 1); z <= std::min(gsiz[2] - 1, cellOf(p, 2) + 1); ++z)
+			for (int y = std::max(0, cellOf(p, 1) - 1); y <= std::min(gsiz[1] - 1, cellOf(p, 1) + 1); ++y)
+				for (int x = std::max(0, cellOf(p, 0) - 1); x <= std::min(gsiz[0] - 1, cellOf(p, 0) + 1); ++x)
+					for (int atomIndex : cells[((size_t) z * gsiz[1] + y) * gsiz[0] + x]) {
+						const Point3m& a = atomPos[atomIndex];
+						if (fabs(p[0] - a[0]) > cutoff || fabs(p[1] - a[1]) > cutoff || fabs(p[2] - a[2]) > cutoff)
+							continue;
+						float r2 = (p - a).SquaredNorm() / atomRad[atomIndex];
+						r2 = std::min(2.0f, r2);
+						ww += r2;
+						rr += r2 * atomCol[atomIndex].X();
+						gg += r2 * atomCol[atomIndex].Y();
+						bb += r2 * atomCol[atomIndex].Z();
+					}
+		if (ww > 0) {
+			m.vert[vind].C().X() = rr/ww;
+			m.vert[vind].C().Y() = gg/ww;
+			m.vert[vind].C().Z() = bb/ww;
+		}
+	}
+}
+
+} // namespace
+
 // initialize importing parameters
 RichParameterList PDBIOPlugin::initPreOpenParameter(const QString &formatName) const
 {
@@ -50,7 +200,8 @@ RichParameterList PDBIOPlugin::initPreOpenParameter(const QString &formatName) c
 		parlst.addParam(RichBool("justspheres",true,"SURFACE: Atoms as Spheres","Atoms are created as intersecting spheres, no interpolation surface is built. Overrides all subsequential surface parameters"));
 		parlst.addParam(RichBool("interpspheres",false,"SURFACE: Atoms as Jointed Spheres","Atoms are created as spheres, joining surface is built. Overrides all subsequential surface parameters"));
 		parlst.addParam(RichBool("metaballs",false,"SURFACE: Atoms as Metaballs","Atoms are created as blobby interpolation surface, refer to BLINN Metaballs article. Overrides all subsequential surface parameters"));
-		parlst.addParam(RichFloat("voxelsize",0.25,"Surface Resolution","is used by Jointed Spheres and Metaball"));
+		parlst.addParam(RichEnum("surfacelod",0,QStringList() << "Custom (Surface Resolution)" << "Draft (1A voxels)" << "Low (0.5A voxels)" << "Medium (0.25A voxels)" << "High (0.125A voxels)","Surface Level of Detail","Voxel size used by Jointed Spheres and Metaball. Custom uses the Surface Resolution value"));
+		parlst.addParam(RichFloat("voxelsize",0.25,"Surface Resolution","Voxel size, is used by Jointed Spheres and Metaball when the Surface Level of Detail is Custom"));
 		parlst.addParam(RichFloat("blobby",2.0,"Blobbyness factor","is used by Metaball"));
 		/*
 		parlst.addParam(RichInt("meshindex",0,"Index of Range Map to be Imported","PTX files may contain more than one range map. 0 is the first range map. If the number if higher than the actual mesh number, the import will fail");
@@ -237,66 +388,17 @@ bool PDBIOPlugin::parsePDB(const std::string &filename, CMeshO &m, const RichPar
 
 	if(parlst.getBool("interpspheres") && !surfacecreated)  	// jointed spheres marching cube 
 	{
-		SimpleVolume<SimpleVoxelm> 	volume;
-	
-		typedef vcg::tri::TrivialWalker<CMeshO, SimpleVolume<SimpleVoxelm> >	MyWalker;
-		typedef vcg::tri::MarchingCubes<CMeshO, MyWalker>	MyMarchingCubes;
-		MyWalker walker;
-		
+		// each voxel is the minimum, over the atoms within 3A, of the squared
+		// distance from the atom minus its radius
 		Box3m rbb;
-		// calculating an enlarged bbox
-		rbb.min[0]=rbb.min[1]=rbb.min[2]= 100000;
-		rbb.max[0]=rbb.max[1]=rbb.max[2]=-100000;
-		for (size_t atomIndex = 0; atomIndex < atomNumber; ++atomIndex)
-		{
-			if(atomPos[atomIndex].X() < rbb.min[0])			rbb.min[0]=atomPos[atomIndex].X();
-			if(atomPos[atomIndex].X() > rbb.max[0])			rbb.max[0]=atomPos[atomIndex].X();
-			if(atomPos[atomIndex].Y() < rbb.min[1])			rbb.min[1]=atomPos[atomIndex].Y();
-			if(atomPos[atomIndex].Y() > rbb.max[1])			rbb.max[1]=atomPos[atomIndex].Y();
-			if(atomPos[atomIndex].Z() < rbb.min[2])			rbb.min[2]=atomPos[atomIndex].Z();
-			if(atomPos[atomIndex].Z() > rbb.max[2])			rbb.max[2]=atomPos[atomIndex].Z();
-		}
-		rbb.min[0]-=5;		rbb.min[1]-=5;		rbb.min[2]-=5;
-		rbb.max[0]+=5;		rbb.max[1]+=5;		rbb.max[2]+=5;
-
-		// defining resolution
-		double step = parlst.getFloat("voxelsize");
-		Point3i siz= Point3i::Construct((rbb.max-rbb.min)*(1.0/step));
-					
-		volume.Init(siz,rbb);
-		float xpos,ypos,zpos;
-		for(double i=0;i<siz[0];i++)
-			for(double j=0;j<siz[1];j++)
-				for(double k=0;k<siz[2];k++)
-				{
-					xpos = rbb.min[0]+step*i;
-					ypos = rbb.min[1]+step*j;
-					zpos = rbb.min[2]+step*k;
-
-					volume.Val(i,j,k)=10000;
-					for (size_t atomIndex = 0; atomIndex < atomNumber; ++atomIndex)
-					{
-						if(! (fabs(xpos-atomPos[atomIndex].X())>3.0f) )
-							if(! (fabs(ypos-atomPos[atomIndex].Y())>3.0f) )
-								if(! (fabs(zpos-atomPos[atomIndex].Z())>3.0f) )
-								{
-									float val = pow((double)(xpos-atomPos[atomIndex].X()),2.0) +
-															pow((double)(ypos-atomPos[atomIndex].Y()),2.0) +
-														pow((double)(zpos-atomPos[atomIndex].Z()),2.0) - atomRad[atomIndex];
-									if(val < volume.Val(i,j,k))
-										volume.Val(i,j,k) = val;
-								}
-					}
-				}
-		
+		double step = surfaceVoxelSize(parlst);
+		meshlab::SparseVolume volume = initAtomVolume(atomPos, step, 10000, rbb);
+		splatAtoms(volume, atomPos, rbb.min, step, 3.0f, [&](float v, int atomIndex, double r2) {
+			return std::min(v, float(r2 - atomRad[atomIndex]));
+		});
+
 		// MARCHING CUBES
-		MyMarchingCubes	mc(m, walker);
-		walker.BuildMesh<MyMarchingCubes>(m, volume, mc, 0);
-		Matrix44m tr; tr.SetIdentity(); tr.SetTranslate(rbb.min[0],rbb.min[1],rbb.min[2]);
-		Matrix44m sc; sc.SetIdentity(); sc.SetScale(step,step,step);
-		tr=tr*sc;
-		
-		tri::UpdatePosition<CMeshO>::Matrix(m,tr);
+		meshlab::extractIsosurface(m, volume, 0, rbb.min, Point3m(step, step, step), cb);
 		tri::UpdateNormal<CMeshO>::PerVertexNormalizedPerFace(m);
 		tri::UpdateBounding<CMeshO>::Box(m);					// updates bounding box		
 	
@@ -306,121 +408,22 @@ bool PDBIOPlugin::parsePDB(const std::string &filename, CMeshO &m, const RichPar
 
 	if(parlst.getBool("metaballs") && !surfacecreated)  	// metaballs marching cube 
 	{
-		SimpleVolume<SimpleVoxelm> 	volume;
-	
-		typedef vcg::tri::TrivialWalker<CMeshO, SimpleVolume<SimpleVoxelm> >	MyWalker;
-		typedef vcg::tri::MarchingCubes<CMeshO, MyWalker>	MyMarchingCubes;
-		MyWalker walker;
-		
+		// each voxel is the sum of the blobby contributions of the atoms within 5A
 		Box3m rbb;
-		// calculating an enlarged bbox
-		rbb.min[0]=rbb.min[1]=rbb.min[2]= 100000;
-		rbb.max[0]=rbb.max[1]=rbb.max[2]=-100000;
-		for (size_t atomIndex = 0; atomIndex < atomNumber; ++atomIndex)
-		{
-			if(atomPos[atomIndex].X() < rbb.min[0])			rbb.min[0]=atomPos[atomIndex].X();
-			if(atomPos[atomIndex].X() > rbb.max[0])			rbb.max[0]=atomPos[atomIndex].X();
-			if(atomPos[atomIndex].Y() < rbb.min[1])			rbb.min[1]=atomPos[atomIndex].Y();
-			if(atomPos[atomIndex].Y() > rbb.max[1])			rbb.max[1]=atomPos[atomIndex].Y();
-			if(atomPos[atomIndex].Z() < rbb.min[2])			rbb.min[2]=atomPos[atomIndex].Z();
-			if(atomPos[atomIndex].Z() > rbb.max[2])			rbb.max[2]=atomPos[atomIndex].Z();
-		}
-		rbb.min[0]-=5;		rbb.min[1]-=5;		rbb.min[2]-=5;
-		rbb.max[0]+=5;		rbb.max[1]+=5;		rbb.max[2]+=5;
-
-		// defining resolution
-		double step = parlst.getFloat("voxelsize");
+		double step = surfaceVoxelSize(parlst);
 		float blobby = -parlst.getFloat("blobby");
-		Point3i siz= Point3i::Construct((rbb.max-rbb.min)*(1.0/step));
-					
-
-//	Log("Filling a Volume of %i %i %i",siz[0],siz[1],siz[2]);
-		volume.Init(siz,rbb);
-		float xpos,ypos,zpos;
-		for(double i=0;i<siz[0];i++)
-			for(double j=0;j<siz[1];j++)
-				for(double k=0;k<siz[2];k++)
-				{
-					xpos = rbb.min[0]+step*i;
-					ypos = rbb.min[1]+step*j;
-					zpos = rbb.min[2]+step*k;
-
-					volume.Val(i,j,k)=0.0;
-					for (size_t atomIndex = 0; atomIndex < atomNumber; ++atomIndex)
-					{
-						if(! (fabs(xpos-atomPos[atomIndex].X())>5.0f) )
-							if(! (fabs(ypos-atomPos[atomIndex].Y())>5.0f) )
-								if(! (fabs(zpos-atomPos[atomIndex].Z())>5.0f) )
-								{
-									float r2 = (pow((double)(xpos-atomPos[atomIndex].X()),2.0) +
-														  pow((double)(ypos-atomPos[atomIndex].Y()),2.0) +
-													  pow((double)(zpos-atomPos[atomIndex].Z()),2.0));
-									float val = exp((blobby/atomRad[atomIndex])*r2 - blobby);
-
-									volume.Val(i,j,k) += val;
-								}
-					}
-				}
-		
-		// MARCHING CUBES
-		MyMarchingCubes	mc(m, walker);
-		walker.BuildMesh<MyMarchingCubes>(m, volume, mc, 1);
-		Matrix44m tr; tr.SetIdentity(); tr.SetTranslate(rbb.min[0],rbb.min[1],rbb.min[2]);
-		Matrix44m sc; sc.SetIdentity(); sc.SetScale(step,step,step);
-		tr=tr*sc;
-		
-		//tri::io::ExporterPLY<CMeshO>::Save(m,"./pippo.ply");
+		meshlab::SparseVolume volume = initAtomVolume(atomPos, step, 0, rbb);
+		splatAtoms(volume, atomPos, rbb.min, step, 5.0f, [&](float v, int atomIndex, double r2) {
+			return v + float(exp((blobby / atomRad[atomIndex]) * float(r2) - blobby));
+		});
 
-		tri::UpdatePosition<CMeshO>::Matrix(m,tr);
+		// MARCHING CUBES
+		meshlab::extractIsosurface(m, volume, 1, rbb.min, Point3m(step, step, step), cb);
 		tri::Clean<CMeshO>::FlipMesh(m);
 		tri::UpdateNormal<CMeshO>::PerVertexNormalizedPerFace(m);
 		tri::UpdateBounding<CMeshO>::Box(m);					// updates bounding box		
 
-		//------------------------------------------------
-
-		double ww;
-		double rr;
-		double gg;
-		double bb;
-		for(int vind=0; vind<m.vn ; vind++)
-		{
-			xpos = m.vert[vind].P().X();
-			ypos = m.vert[vind].P().Y(); 
-			zpos = m.vert[vind].P().Z(); 				
-			ww=rr=gg=bb=0;
-			
-			for (size_t atomIndex = 0; atomIndex < atomNumber; ++atomIndex)
-			{
-				if(! (fabs(xpos-atomPos[atomIndex].X())>5.0f) )
-				{
-					if(! (fabs(ypos-atomPos[atomIndex].Y())>5.0f) )
-					{
-						if(! (fabs(zpos-atomPos[atomIndex].Z())>5.0f) )
-						{
-							float r2 = (pow((double)(xpos-atomPos[atomIndex].X()),2.0) + 
-												  pow((double)(ypos-atomPos[atomIndex].Y()),2.0) + 
-								    		  pow((double)(zpos-atomPos[atomIndex].Z()),2.0));
-							r2 = r2 / atomRad[atomIndex];
-							r2 = min(2.0f,r2);
-
-							ww += r2;
-							rr += r2 * atomCol[atomIndex].X();
-							gg += r2 * atomCol[atomIndex].Y();
-							bb += r2 * atomCol[atomIndex].Z();
-
-						}
-					}
-				}
-
-				m.vert[vind].C().X() = rr/ww;
-				m.vert[vind].C().Y() = gg/ww;
-				m.vert[vind].C().Z() = bb/ww;
-			}
-
-
-		}
-
-		//------------------------------------------------
+		colorByNearAtoms(m, atomPos, atomCol, atomRad);
 
 		surfacecreated = true;
 	}
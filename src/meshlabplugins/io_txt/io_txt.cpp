@@ -22,8 +22,17 @@
 ****************************************************************************/
 #include <Qt>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QElapsedTimer>
+
 #include "io_txt.h"
 
+#include <common/utilities/text_parsing.h>
+
 //#include <wrap/io_trimesh/export.h>
 
 using namespace vcg;
@@ -79,14 +88,23 @@ void TxtIOPlugin::open(const QString &formatName, const QString &fileName, MeshM
 
 		m.enable(mask);
 
+		QElapsedTimer t;
+		t.start();
 		if (!parseTXT(fileName, m.cm, rowToSkip, dataSeparator, dataFormat, rgbMode, onError))
 			throw MLException("Error while opening TXT file.");
+		double sec = std::max(t.elapsed(), (qint64) 1) / 1000.0;
+		log("Loaded %d points in %.3f sec (%.0f points/s)", m.cm.vn, sec, m.cm.vn / sec);
 	}
 	else {
 		wrongOpenFormat(formatName);
 	}
 }
 
+bool TxtIOPlugin::supportsConcurrentOpen(const QString& formatName) const
+{
+	return formatName.toUpper() == tr("TXT");
+}
+
 void TxtIOPlugin::save(const QString & formatName, const QString & /*fileName*/, MeshModel & /*m*/, const int /*mask*/, const RichParameterList &, vcg::CallBackPos * /*cb*/)
 {
 	wrongSaveFormat(formatName);
@@ -124,496 +142,198 @@ void TxtIOPlugin::exportMaskCapability(const QString & /*format*/, int &capabili
 }
  
 
-bool parseTXT(QString filename, CMeshO &m, int rowToSkip, int dataSeparator, int dataFormat, int rgbMode, int onError)
+namespace {
+
+enum TxtField { X = 0, Y, Z, QUALITY, RED, GREEN, BLUE, NX, NY, NZ };
+
+/**
+ * @brief the columns of each of the "strformat" point formats, in the same
+ * order of the enum parameter
+ */
+const std::vector<std::vector<TxtField>>& txtFormats()
 {
-    QFile impFile(filename);
-    int ii;
-
-    if(impFile.open(QIODevice::ReadOnly))
-    {
-        QString freshLine;
-        QStringList tokenizedLine;
-        QString separator;
-        float XX,YY,ZZ;
-        float NX,NY,NZ;
-        float RR,GG,BB;
-        float Qual;
-        bool parseOK[10];
-
-        //skipping first rowToSkip lines,because it's the header
-        for(ii=0; ii<rowToSkip; ii++)
-        {
-            if(!impFile.atEnd())
-                freshLine = QString(impFile.readLine()).simplified();
-            else
-            {
-                impFile.close();
-                return false;
-            }
-        }
-
-        switch(dataSeparator)
-        {
-            case 0: separator = ";"; break;
-            case 1: separator = ","; break;
-            case 2: separator = " "; break;
-        }
-
-        //now, the data
-        while(!impFile.atEnd())
-        {
-            // reading and tokenizing
-            freshLine = QString(impFile.readLine()).simplified();
-            tokenizedLine = freshLine.split(separator, Qt::SkipEmptyParts);
-
-            switch(dataFormat)
-            {
-                case 0: // X Y Z
-                    {
-                        // number of token mismatch
-						if (tokenizedLine.size()<3)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							if (parseOK[0] && parseOK[1] && parseOK[2])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 1: // X Y Z Reflectance
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<4)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							Qual = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 2: // X Y Z Reflectance R G B
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<7)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							Qual = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							RR = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							GG = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							BB = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4] && parseOK[5] && parseOK[6])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 3: // X Y Z Reflectance Nx Ny Nz
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<7)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							Qual = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							NX = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							NY = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							NZ = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4] && parseOK[5] && parseOK[6])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 4: // X Y Z Reflectance R G B Nx Ny Nz
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							Qual = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							RR = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							GG = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							BB = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							NX = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							NY = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							NZ = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 5: // X Y Z Reflectance Nx Ny Nz R G B
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							Qual = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							NX = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							NY = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							NZ = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							RR = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							GG = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							BB = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 6: // X Y Z R G B
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<6)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							RR = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							GG = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							BB = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4] && parseOK[5])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 7: // X Y Z R G B Reflectance
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<7)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							RR = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							GG = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							BB = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							Qual = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4] && parseOK[5] && parseOK[6])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 8: // X Y Z R G B Reflectance Nx Ny Nz
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							RR = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							GG = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							BB = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							Qual = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							NX = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							NY = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							NZ = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 9: // X Y Z R G B Nx Ny Nz Reflectance
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							RR = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							GG = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							BB = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							NX = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							NY = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							NZ = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							Qual = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 10: // X Y Z Nx Ny Nz
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<6)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							NX = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							NY = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							NZ = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4] && parseOK[5])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 11: // X Y Z Nx Ny Nz R G B Reflectance
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							NX = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							NY = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							NZ = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							RR = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							GG = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							BB = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							Qual = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-                case 12: // X Y Z Nx Ny Nz Reflectance R G B
-                    {
-                        // number of token mismatch
-                        if(tokenizedLine.size()<10)
-						{
-							if (onError == 1){ impFile.close(); return true; }
-						}
-						else
-						{
-							XX = tokenizedLine.at(0).toFloat(&(parseOK[0]));
-							YY = tokenizedLine.at(1).toFloat(&(parseOK[1]));
-							ZZ = tokenizedLine.at(2).toFloat(&(parseOK[2]));
-							NX = tokenizedLine.at(3).toFloat(&(parseOK[3]));
-							NY = tokenizedLine.at(4).toFloat(&(parseOK[4]));
-							NZ = tokenizedLine.at(5).toFloat(&(parseOK[5]));
-							Qual = tokenizedLine.at(6).toFloat(&(parseOK[6]));
-							RR = tokenizedLine.at(7).toFloat(&(parseOK[7]));
-							GG = tokenizedLine.at(8).toFloat(&(parseOK[8]));
-							BB = tokenizedLine.at(9).toFloat(&(parseOK[9]));
-
-							if (rgbMode == 1) //[0.0-1.0]
-							{
-								RR *= 255; GG *= 255; BB *= 255;
-							}
-							if (parseOK[0] && parseOK[1] && parseOK[2] && parseOK[3] && parseOK[4]
-								&& parseOK[5] && parseOK[6] && parseOK[7] && parseOK[8] && parseOK[9])    // no parsing error
-							{
-								CMeshO::VertexIterator vi = tri::Allocator<CMeshO>::AddVertices(m, 1);
-								(*vi).P().Import(Point3f(XX, YY, ZZ));
-								(*vi).Q() = Qual;
-								(*vi).C() = Color4b(RR, GG, BB, 255);
-								(*vi).N().Import(Point3f(NX, NY, NZ));
-							}
-							else
-								if (onError == 1){ impFile.close(); return true; }
-						}
-                    }
-                    break;
-
-            }
-
-
-        }
-
-        impFile.close();
-        return true;
-    }
-    else
-        return false;
+	static const std::vector<std::vector<TxtField>> formats = {
+		{X, Y, Z},
+		{X, Y, Z, QUALITY},
+		{X, Y, Z, QUALITY, RED, GREEN, BLUE},
+		{X, Y, Z, QUALITY, NX, NY, NZ},
+		{X, Y, Z, QUALITY, RED, GREEN, BLUE, NX, NY, NZ},
+		{X, Y, Z, QUALITY, NX, NY, NZ, RED, GREEN, BLUE},
+		{X, Y, Z, RED, GREEN, BLUE},
+		{X, Y, Z, RED, GREEN, BLUE, QUALITY},
+		{X, Y, Z, RED, GREEN, BLUE, QUALITY, NX, NY, NZ},
+		{X, Y, Z, RED, GREEN, BLUE, NX, NY, NZ, QUALITY},
+		{X, Y, Z, NX, NY, NZ},
+		{X, Y, Z, NX, NY, NZ, RED, GREEN, BLUE, QUALITY},
+		{X, Y, Z, NX, NY, NZ, QUALITY, RED, GREEN, BLUE}};
+	return formats;
+}
 
+/**
+ * @brief parses a float token [p, end), that may be surrounded by blanks,
+ * with the same rules of QString::toFloat
+ */
+inline bool parseFloatToken(const char* p, const char* end, float& value)
+{
+	double v;
+	if (!meshlab::parseDouble(p, end, v) || meshlab::skipBlanks(p, end) != end)
+		return false;
+	value = (float) v;
+	// out of the float range
+	return !(std::isinf(value) && !std::isinf(v));
 }
 
+/**
+ * @brief Tokenizes the line [p, end) as QString::simplified followed by
+ * QString::split(separator, Qt::SkipEmptyParts), without allocations, and
+ * parses the given columns (extra tokens are ignored).
+ * Returns false if there are too few tokens or a token is not a number.
+ */
+bool parseTxtLine(
+		const char* p,
+		const char* end,
+		char separator,
+		const std::vector<TxtField>& columns,
+		float* values)
+{
+	// simplified() removes leading and trailing blanks
+	p = meshlab::skipBlanks(p, end);
+	while (end > p && meshlab::isBlank(*(end - 1)))
+		--end;
+
+	for (TxtField field : columns) {
+		const char* tokenEnd;
+		if (separator == ' ') {
+			p = meshlab::skipBlanks(p, end);
+			tokenEnd = p;
+			while (tokenEnd < end && !meshlab::isBlank(*tokenEnd))
+				++tokenEnd;
+		}
+		else {
+			// empty parts are skipped
+			while (p < end && *p == separator)
+				++p;
+			tokenEnd = p;
+			while (tokenEnd < end && *tokenEnd != separator)
+				++tokenEnd;
+		}
+		if (p == end || !parseFloatToken(p, tokenEnd, values[field]))
+			return false;
+		p = tokenEnd;
+	}
+	return true;
+}
+
+} // namespace
+
+/**
+ * @brief Loads the points of a TXT file. The file is memory mapped and, after
+ * the header rows, split in chunks of lines that are parsed in parallel;
+ * cm.vert is sized once with the number of lines, and the vertices of the
+ * lines that cannot be parsed are removed at the end ('skip' mode), or all
+ * the ones that follow the first of them ('stop' mode).
+ */
+bool parseTXT(QString filename, CMeshO &m, int rowToSkip, int dataSeparator, int dataFormat, int rgbMode, int onError)
+{
+	QFile impFile(filename);
+	if (!impFile.open(QIODevice::ReadOnly))
+		return false;
+
+	const char* begin = nullptr;
+	if (impFile.size() > 0) {
+		begin = (const char*) impFile.map(0, impFile.size());
+		if (begin == nullptr)
+			return false;
+	}
+	const char* end = begin + impFile.size();
+
+	//skipping first rowToSkip lines,because it's the header
+	const char* p = begin;
+	for (int ii = 0; ii < rowToSkip; ii++) {
+		if (p == end)
+			return false;
+		p = meshlab::nextLine(p, end);
+	}
+	if (p == end)
+		return true;
+
+	char separator = ' ';
+	switch (dataSeparator) {
+	case 0: separator = ';'; break;
+	case 1: separator = ','; break;
+	case 2: separator = ' '; break;
+	}
+	if (dataFormat < 0 || dataFormat >= (int) txtFormats().size())
+		return false;
+	const std::vector<TxtField>& columns = txtFormats()[dataFormat];
+	auto hasField = [&](TxtField f) {
+		return std::find(columns.begin(), columns.end(), f) != columns.end();
+	};
+	const bool hasQuality = hasField(QUALITY);
+	const bool hasColor = hasField(RED);
+	const bool hasNormal = hasField(NX);
+
+	// quick newline count, to size the vertex vector once
+	std::vector<meshlab::TextChunk> chunks = meshlab::splitTextInChunks(p, end);
+	std::vector<long long> firstLine(chunks.size() + 1, 0);
+	#pragma omp parallel for schedule(static)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		long long n = std::count(chunks[c].begin, chunks[c].end, '\n');
+		// the last line could be without newline
+		if (chunks[c].end == end && *(end - 1) != '\n')
+			++n;
+		firstLine[c + 1] = n;
+	}
+	for (unsigned int c = 0; c < chunks.size(); ++c)
+		firstLine[c + 1] += firstLine[c];
+	const long long nLines = firstLine.back();
+	if (m.vert.size() + nLines > (size_t) std::numeric_limits<int>::max())
+		return false;
+
+	const size_t base = m.vert.size();
+	tri::Allocator<CMeshO>::AddVertices(m, (size_t) nLines);
+	std::vector<char> parsed(nLines, 0);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int) chunks.size(); ++c) {
+		long long line = firstLine[c];
+		const char* chunkEnd = chunks[c].end;
+		for (const char* q = chunks[c].begin; q < chunkEnd; ++line) {
+			const char* lineEnd = (const char*) std::memchr(q, '\n', chunkEnd - q);
+			if (lineEnd == nullptr)
+				lineEnd = chunkEnd;
+			float values[10];
+			if (parseTxtLine(q, lineEnd, separator, columns, values)) {
+				CVertexO& v = m.vert[base + line];
+				v.P().Import(Point3f(values[X], values[Y], values[Z]));
+				if (hasQuality)
+					v.Q() = values[QUALITY];
+				if (hasColor) {
+					float rr = values[RED], gg = values[GREEN], bb = values[BLUE];
+					if (rgbMode == 1) //[0.0-1.0]
+					{
+						rr *= 255; gg *= 255; bb *= 255;
+					}
+					v.C() = Color4b(rr, gg, bb, 255);
+				}
+				if (hasNormal)
+					v.N().Import(Point3f(values[NX], values[NY], values[NZ]));
+				parsed[line] = 1;
+			}
+			q = lineEnd < chunkEnd ? lineEnd + 1 : chunkEnd;
+		}
+	}
+
+	// remove the points of the lines that have not been parsed
+	long long firstError = std::find(parsed.begin(), parsed.end(), 0) - parsed.begin();
+	if (firstError < nLines) {
+		for (long long i = firstError; i < nLines; ++i) {
+			if (onError == 1 || !parsed[i]) // stop at the first error, or skip
+				tri::Allocator<CMeshO>::DeleteVertex(m, m.vert[base + i]);
+		}
+		tri::Allocator<CMeshO>::CompactVertexVector(m);
+	}
+	return true;
+}
 
- 
- 
 MESHLAB_PLUGIN_NAME_EXPORTER(TxtIOPlugin)
@@ -43,6 +43,7 @@ public:
 	RichParameterList initPreOpenParameter(const QString &/*format*/) const;
 
 	void open(const QString &formatName, const QString &fileName, MeshModel &m, int& mask, const RichParameterList &, vcg::CallBackPos *cb=0);
+	bool supportsConcurrentOpen(const QString& formatName) const;
 	void save(const QString &formatName, const QString &fileName, MeshModel &m, const int mask, const RichParameterList &, vcg::CallBackPos *cb);
 };
 
@@ -0,0 +1,405 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "idtf_scene.h"
+
+#include <algorithm>
+#include <string>
+
+#include <QImage>
+
+#include <common/utilities/live_elements.h>
+#include <wrap/io_trimesh/io_mask.h>
+
+using namespace vcg;
+using meshlab::LiveElements;
+using meshlab::TextBuffer;
+using IDTFConverter::TextureImage;
+
+namespace {
+
+/**
+ * @brief appends the point as (-x, z, y): the same change of axes used for
+ * the camera parameters of the LaTeX file, since U3D viewers expect the z
+ * axis to point up.
+ */
+void appendPoint(TextBuffer& b, const Point3m& p)
+{
+	b.appendShortest((float) -p.X());
+	b.append(' ');
+	b.appendShortest((float) p.Z());
+	b.append(' ');
+	b.appendShortest((float) p.Y());
+	b.append('\n');
+}
+
+void appendColor(TextBuffer& b, const Color4b& c)
+{
+	for (int i = 0; i < 4; ++i) {
+		if (i > 0)
+			b.append(' ');
+		b.appendShortest(c[i] / 255.0f);
+	}
+	b.append('\n');
+}
+
+template <typename TexCoord>
+void appendTexCoord(TextBuffer& b, const TexCoord& t)
+{
+	b.appendShortest((float) t.U());
+	b.append(' ');
+	b.appendShortest((float) t.V());
+	b.append(" 0 0\n");
+}
+
+void appendIndices(TextBuffer& b, long long i0, long long i1, long long i2)
+{
+	b.appendInt(i0);
+	b.append(' ');
+	b.appendInt(i1);
+	b.append(' ');
+	b.appendInt(i2);
+	b.append('\n');
+}
+
+void appendName(TextBuffer& b, const char* prefix, int index)
+{
+	b.append('"');
+	b.append(prefix, std::char_traits<char>::length(prefix));
+	b.appendInt(index);
+	b.append("\"\n");
+}
+
+/**
+ * @brief the RGB pixels of the image, with the rows going from the bottom to
+ * the top, as they are read from a TGA file by the converter
+ */
+TextureImage decodeTexture(const QImage& image, const std::string& path)
+{
+	const QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+	TextureImage t;
+	t.path = path;
+	t.width = rgb.width();
+	t.height = rgb.height();
+	t.channels = 3;
+	const std::size_t rowSize = (std::size_t) t.width * t.channels;
+	t.pixels.resize(rowSize * t.height);
+	for (int y = 0; y < rgb.height(); ++y) {
+		const uchar* row = rgb.constScanLine(rgb.height() - 1 - y);
+		std::copy(row, row + rowSize, t.pixels.begin() + y * rowSize);
+	}
+	return t;
+}
+
+} // namespace
+
+void buildIDTFScene(
+		const MeshModel& m,
+		int mask,
+		TextBuffer& scene,
+		std::vector<TextureImage>& textures)
+{
+	const CMeshO& cm = m.cm;
+	const int vn = cm.vn;
+	const int fn = cm.fn;
+	// the elements are written as in the compacted mesh
+	const LiveElements liveVert(cm.vert, vn);
+	const LiveElements liveFace(cm.face, fn);
+	auto face = [&](std::size_t k) -> const CFaceO& { return cm.face[liveFace.index(k)]; };
+	auto vert = [&](std::size_t k) -> const CVertexO& { return cm.vert[liveVert.index(k)]; };
+
+	const bool vertNormal = (mask & tri::io::Mask::IOM_VERTNORMAL);
+	const bool vertColor = (mask & tri::io::Mask::IOM_VERTCOLOR) && tri::HasPerVertexColor(cm);
+	const bool faceColor =
+		!vertColor && (mask & tri::io::Mask::IOM_FACECOLOR) && tri::HasPerFaceColor(cm);
+	const bool wedgeTex =
+		(mask & tri::io::Mask::IOM_WEDGTEXCOORD) && tri::HasPerWedgeTexCoord(cm);
+	const bool vertTex =
+		!wedgeTex && (mask & tri::io::Mask::IOM_VERTTEXCOORD) && tri::HasPerVertexTexCoord(cm);
+
+	// a shading for each texture that has an image, and a last one without
+	// textures
+	std::vector<int> textureShading(cm.textures.size(), -1);
+	textures.clear();
+	if (wedgeTex || vertTex) {
+		for (std::size_t i = 0; i < cm.textures.size(); ++i) {
+			QImage image = m.getTexture(cm.textures[i]);
+			if (!image.isNull()) {
+				textureShading[i] = (int) textures.size();
+				textures.push_back(decodeTexture(image, "texture" + std::to_string(i)));
+			}
+		}
+	}
+	const int texturedCount = (int) textures.size();
+	const int shadingCount = texturedCount + 1;
+	const bool texCoords = texturedCount > 0;
+	auto faceShading = [&](const CFaceO& f) {
+		const int t = wedgeTex ? f.cWT(0).N() : f.cV(0)->cT().N();
+		if (t >= 0 && t < (int) textureShading.size() && textureShading[t] >= 0)
+			return textureShading[t];
+		return texturedCount;
+	};
+
+	// the lists of numbers are formatted in parallel, appending the chunks to
+	// the scene in order
+	auto appendToScene = [&](const char* data, std::size_t size) { scene.append(data, size); };
+	auto appendFaceVertices = [&](std::size_t i, TextBuffer& b) {
+		const CFaceO& f = face(i);
+		appendIndices(
+			b,
+			liveVert.savedIndex(tri::Index(cm, f.cV(0))),
+			liveVert.savedIndex(tri::Index(cm, f.cV(1))),
+			liveVert.savedIndex(tri::Index(cm, f.cV(2))));
+	};
+
+	scene.clear();
+	scene.append("FILE_FORMAT \"IDTF\"\nFORMAT_VERSION 100\n\n");
+
+	scene.append(
+		"NODE \"MODEL\" {\n"
+		"NODE_NAME \"Mesh\"\n"
+		"PARENT_LIST {\n"
+		"PARENT_COUNT 1\n"
+		"PARENT 0 {\n"
+		"PARENT_NAME \"<NULL>\"\n"
+		"PARENT_TM {\n"
+		"1 0 0 0\n"
+		"0 1 0 0\n"
+		"0 0 1 0\n"
+		"0 0 0 1\n"
+		"}\n"
+		"}\n"
+		"}\n"
+		"RESOURCE_NAME \"MeshResource\"\n"
+		"}\n\n");
+
+	// shaders, all using the same material
+	scene.append("RESOURCE_LIST \"SHADER\" {\nRESOURCE_COUNT ");
+	scene.appendInt(shadingCount);
+	scene.append('\n');
+	for (int s = 0; s < shadingCount; ++s) {
+		scene.append("RESOURCE ");
+		scene.appendInt(s);
+		scene.append(" {\nRESOURCE_NAME ");
+		appendName(scene, "Shader", s);
+		if (vertColor || faceColor)
+			scene.append("ATTRIBUTE_USE_VERTEX_COLOR \"TRUE\"\n");
+		scene.append("SHADER_MATERIAL_NAME \"Material\"\n");
+		if (s < texturedCount) {
+			scene.append(
+				"SHADER_ACTIVE_TEXTURE_COUNT 1\n"
+				"SHADER_TEXTURE_LAYER_LIST {\n"
+				"TEXTURE_LAYER 0 {\n"
+				"TEXTURE_NAME ");
+			appendName(scene, "Texture", s);
+			scene.append("}\n}\n");
+		}
+		else {
+			scene.append("SHADER_ACTIVE_TEXTURE_COUNT 0\n");
+		}
+		scene.append("}\n");
+	}
+	scene.append("}\n\n");
+
+	// white diffuse color, so that colors and textures are not darkened
+	scene.append(
+		"RESOURCE_LIST \"MATERIAL\" {\n"
+		"RESOURCE_COUNT 1\n"
+		"RESOURCE 0 {\n"
+		"RESOURCE_NAME \"Material\"\n"
+		"MATERIAL_AMBIENT 0.2 0.2 0.2\n");
+	if (vertColor || faceColor || texCoords)
+		scene.append("MATERIAL_DIFFUSE 1 1 1\n");
+	else
+		scene.append("MATERIAL_DIFFUSE 0.8 0.8 0.8\n");
+	scene.append(
+		"MATERIAL_SPECULAR 0 0 0\n"
+		"MATERIAL_EMISSIVE 0 0 0\n"
+		"MATERIAL_REFLECTIVITY 0\n"
+		"MATERIAL_OPACITY 1\n"
+		"}\n"
+		"}\n\n");
+
+	// the paths of the textures are the keys of their images, not files
+	if (texturedCount > 0) {
+		scene.append("RESOURCE_LIST \"TEXTURE\" {\nRESOURCE_COUNT ");
+		scene.appendInt(texturedCount);
+		scene.append('\n');
+		for (int t = 0; t < texturedCount; ++t) {
+			scene.append("RESOURCE ");
+			scene.appendInt(t);
+			scene.append(" {\nRESOURCE_NAME ");
+			appendName(scene, "Texture", t);
+			scene.append("TEXTURE_IMAGE_TYPE \"RGB\"\nTEXTURE_PATH \"");
+			scene.append(textures[t].path.data(), textures[t].path.size());
+			scene.append("\"\n}\n");
+		}
+		scene.append("}\n\n");
+	}
+
+	const int texCoordCount = !texCoords ? 0 : wedgeTex ? 3 * fn : vn;
+	scene.append(
+		"RESOURCE_LIST \"MODEL\" {\n"
+		"RESOURCE_COUNT 1\n"
+		"RESOURCE 0 {\n"
+		"RESOURCE_NAME \"MeshResource\"\n"
+		"MODEL_TYPE \"MESH\"\n"
+		"MESH {\n"
+		"FACE_COUNT ");
+	scene.appendInt(fn);
+	scene.append("\nMODEL_POSITION_COUNT ");
+	scene.appendInt(vn);
+	scene.append("\nMODEL_NORMAL_COUNT ");
+	scene.appendInt(vertNormal ? vn : 0);
+	scene.append("\nMODEL_DIFFUSE_COLOR_COUNT ");
+	scene.appendInt(vertColor ? vn : faceColor ? fn : 0);
+	scene.append("\nMODEL_SPECULAR_COLOR_COUNT 0\nMODEL_TEXTURE_COORD_COUNT ");
+	scene.appendInt(texCoordCount);
+	scene.append("\nMODEL_BONE_COUNT 0\nMODEL_SHADING_COUNT ");
+	scene.appendInt(shadingCount);
+	scene.append("\nMODEL_SHADING_DESCRIPTION_LIST {\n");
+	for (int s = 0; s < shadingCount; ++s) {
+		scene.append("SHADING_DESCRIPTION ");
+		scene.appendInt(s);
+		if (s < texturedCount)
+			scene.append(
+				" {\nTEXTURE_LAYER_COUNT 1\n"
+				"TEXTURE_COORD_DIMENSION_LIST {\nTEXTURE_LAYER 0 DIMENSION: 2\n}\n");
+		else
+			scene.append(" {\nTEXTURE_LAYER_COUNT 0\n");
+		scene.append("SHADER_ID ");
+		scene.appendInt(s);
+		scene.append("\n}\n");
+	}
+	scene.append("}\n");
+
+	if (fn > 0) {
+		scene.append("MESH_FACE_POSITION_LIST {\n");
+		meshlab::formatRowsInParallel(fn, appendFaceVertices, appendToScene);
+		scene.append("}\n");
+		if (vertNormal) {
+			scene.append("MESH_FACE_NORMAL_LIST {\n");
+			meshlab::formatRowsInParallel(fn, appendFaceVertices, appendToScene);
+			scene.append("}\n");
+		}
+		scene.append("MESH_FACE_SHADING_LIST {\n");
+		meshlab::formatRowsInParallel(
+			fn,
+			[&](std::size_t i, TextBuffer& b) {
+				b.appendInt(faceShading(face(i)));
+				b.append('\n');
+			},
+			appendToScene);
+		scene.append("}\n");
+		if (texCoords) {
+			scene.append("MESH_FACE_TEXTURE_COORD_LIST {\n");
+			meshlab::formatRowsInParallel(
+				fn,
+				[&](std::size_t i, TextBuffer& b) {
+					b.append("FACE ");
+					b.appendInt(i);
+					b.append(" {\n");
+					if (faceShading(face(i)) < texturedCount) {
+						b.append("TEXTURE_LAYER 0 TEX_COORD: ");
+						if (wedgeTex)
+							appendIndices(b, 3 * i, 3 * i + 1, 3 * i + 2);
+						else
+							appendFaceVertices(i, b);
+					}
+					b.append("}\n");
+				},
+				appendToScene);
+			scene.append("}\n");
+		}
+		if (vertColor) {
+			scene.append("MESH_FACE_DIFFUSE_COLOR_LIST {\n");
+			meshlab::formatRowsInParallel(fn, appendFaceVertices, appendToScene);
+			scene.append("}\n");
+		}
+		else if (faceColor) {
+			scene.append("MESH_FACE_DIFFUSE_COLOR_LIST {\n");
+			meshlab::formatRowsInParallel(
+				fn,
+				[&](std::size_t i, TextBuffer& b) { appendIndices(b, i, i, i); },
+				appendToScene);
+			scene.append("}\n");
+		}
+	}
+
+	if (vn > 0) {
+		scene.append("MODEL_POSITION_LIST {\n");
+		meshlab::formatRowsInParallel(
+			vn,
+			[&](std::size_t i, TextBuffer& b) { appendPoint(b, vert(i).cP()); },
+			appendToScene);
+		scene.append("}\n");
+		if (vertNormal) {
+			scene.append("MODEL_NORMAL_LIST {\n");
+			meshlab::formatRowsInParallel(
+				vn,
+				[&](std::size_t i, TextBuffer& b) { appendPoint(b, vert(i).cN()); },
+				appendToScene);
+			scene.append("}\n");
+		}
+	}
+	if (vertColor || faceColor) {
+		scene.append("MODEL_DIFFUSE_COLOR_LIST {\n");
+		meshlab::formatRowsInParallel(
+			vertColor ? vn : fn,
+			[&](std::size_t i, TextBuffer& b) {
+				appendColor(b, vertColor ? vert(i).cC() : face(i).cC());
+			},
+			appendToScene);
+		scene.append("}\n");
+	}
+	if (texCoords) {
+		scene.append("MODEL_TEXTURE_COORD_LIST {\n");
+		meshlab::formatRowsInParallel(
+			texCoordCount,
+			[&](std::size_t i, TextBuffer& b) {
+				if (wedgeTex)
+					appendTexCoord(b, face(i / 3).cWT(i % 3));
+				else
+					appendTexCoord(b, vert(i).cT());
+			},
+			appendToScene);
+		scene.append("}\n");
+	}
+	scene.append("}\n}\n}\n\n");
+
+	scene.append(
+		"MODIFIER \"SHADING\" {\n"
+		"MODIFIER_NAME \"Mesh\"\n"
+		"PARAMETERS {\n"
+		"SHADER_LIST_COUNT ");
+	scene.appendInt(shadingCount);
+	scene.append("\nSHADER_LIST_LIST {\n");
+	for (int s = 0; s < shadingCount; ++s) {
+		scene.append("SHADER_LIST ");
+		scene.appendInt(s);
+		scene.append(" {\nSHADER_COUNT 1\nSHADER_NAME_LIST {\nSHADER 0 NAME: ");
+		appendName(scene, "Shader", s);
+		scene.append("}\n}\n");
+	}
+	scene.append("}\n}\n}\n");
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef IDTF_SCENE_H
+#define IDTF_SCENE_H
+
+#include <vector>
+
+#include <common/ml_document/mesh_model.h>
+#include <common/utilities/text_formatting.h>
+
+#include "Converter.h"
+
+/**
+ * @brief Writes in scene the IDTF text of the mesh (that must have been
+ * compacted), with the components in mask, to be converted to U3D with
+ * IDTFConverter::IDTFSceneToU3d.
+ *
+ * The textures are not referenced as TGA files: their images are taken from
+ * the (already decoded) textures of the mesh model and added to textures,
+ * with the TEXTURE_PATH used in the scene. Faces whose texture has no image
+ * are exported without texture.
+ */
+void buildIDTFScene(
+		const MeshModel& m,
+		int mask,
+		meshlab::TextBuffer& scene,
+		std::vector<IDTFConverter::TextureImage>& textures);
+
+#endif // IDTF_SCENE_H
@@ -27,6 +27,7 @@
 #include <Qt>
 
 #include "io_u3d.h"
+#include "idtf_scene.h"
 
 #include <wrap/io_trimesh/export.h>
 #include <wrap/io_trimesh/export_idtf.h>
@@ -70,51 +71,40 @@ void U3DIOPlugin::save(
 	string filename = QFile::encodeName(fileName).constData();
 	std::string ex = formatName.toUtf8().data();
 
-	
-	QStringList textures_to_be_restored;
-	QStringList lst = 
-			vcg::tri::io::ExporterIDTF<CMeshO>::convertInTGATextures(
-				m.cm, QDir::tempPath(), textures_to_be_restored);
 	if(formatName.toUpper() == tr("U3D")) {
 		vcg::tri::io::u3dparametersclasses::Movie15Parameters<CMeshO> _param;
 		_param._campar =
 				new vcg::tri::io::u3dparametersclasses::Movie15Parameters<CMeshO>::CameraParameters(
 					m.cm.bbox.Center(),m.cm.bbox.Diag());
 		saveParameters(par, _param);
-		QSettings settings;
-		
-		//tmp idtf
-		QString tmp(QDir::tempPath());
-		QString curr = QDir::currentPath();
-		QStringList out_trim;
-		vcg::tri::io::QtUtilityFunctions::splitFilePath(fileName,out_trim);
-		tmp = tmp + "/" +
-				vcg::tri::io::QtUtilityFunctions::fileNameFromTrimmedPath(out_trim) + ".idtf";
-		vcg::tri::io::ExporterIDTF<CMeshO>::Save(m.cm,qPrintable(tmp),mask);
+
+		// the idtf scene and the decoded textures are passed to the
+		// converter in memory, without temporary files
+		meshlab::TextBuffer scene;
+		std::vector<IDTFConverter::TextureImage> textures;
+		buildIDTFScene(m, mask, scene, textures);
 
 		//conversion from idtf to u3d
 		int resCode = 0;
-		bool result = IDTFConverter::IDTFToU3d(tmp.toStdString(), filename, resCode, _param.positionQuality);
+		bool result = IDTFConverter::IDTFSceneToU3d(
+					scene.data(), scene.size(), textures, filename, resCode, _param.positionQuality);
 
 		if(result==false) {
+			delete _param._campar;
 			throw MLException("Error saving " + QString::fromStdString(filename) + ": \n" + vcg::tri::io::ExporterU3D<CMeshO>::ErrorMsg(resCode) + " (" + QString::number(resCode) + ")");
 		}
-		
+
 		//saving latex:
-		QDir::setCurrent(curr);
 		QString lat (fileName);
 		QStringList l = lat.split(".");
 		saveLatex(l[0], _param);
-		QDir dir(QDir::tempPath());
-		dir.remove(tmp);
 
-		vcg::tri::io::ExporterIDTF<CMeshO>::removeConvertedTGATextures(lst);
-		vcg::tri::io::ExporterIDTF<CMeshO>::restoreConvertedTextures(
-					m.cm,
-					textures_to_be_restored);
 		delete _param._campar;
 	}
 	else if(formatName.toUpper() == tr("IDTF")) {
+		QStringList textures_to_be_restored;
+		vcg::tri::io::ExporterIDTF<CMeshO>::convertInTGATextures(
+					m.cm, QDir::tempPath(), textures_to_be_restored);
 		tri::io::ExporterIDTF<CMeshO>::Save(m.cm,filename.c_str(),mask);
 		vcg::tri::io::ExporterIDTF<CMeshO>::restoreConvertedTextures(
 					m.cm,
@@ -27,6 +27,7 @@
 
 #include "import_x3d.h"
 #include "export_x3d.h"
+#include "load_x3d_stream.h"
 
 using namespace std;
 using namespace vcg;
@@ -45,6 +46,16 @@ void IoX3DPlugin::open(const QString &formatName, const QString &fileName, MeshM
 	vcg::tri::io::AdditionalInfoX3D* info = NULL;
 	if(formatName.toUpper() == tr("X3D") || formatName.toUpper() == tr("X3DV") || formatName.toUpper() == tr("WRL"))
 	{
+		// large files made only of indexed geometries are loaded without
+		// building the DOM of the whole document
+		if (formatName.toUpper() == tr("X3D") && loadStreamingX3D(fileName, m, mask, cb))
+		{
+			vcg::tri::UpdateBounding<CMeshO>::Box(m.cm);
+			vcg::tri::UpdateNormal<CMeshO>::PerVertexPerFace(m.cm);
+			if (cb != NULL)	(*cb)(99, "Done");
+			return;
+		}
+
 		int result;
 		if (formatName.toUpper() == tr("X3D"))
 			result = vcg::tri::io::ImporterX3D<CMeshO>::LoadMask(filename.c_str(), info);
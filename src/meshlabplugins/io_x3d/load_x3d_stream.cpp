@@ -0,0 +1,694 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "load_x3d_stream.h"
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QFile>
+#include <QXmlStreamReader>
+
+#include <common/utilities/text_parsing.h>
+#include <wrap/gl/glu_tesselator.h>
+#include <wrap/io_trimesh/io_mask.h>
+
+using namespace vcg;
+
+namespace {
+
+inline bool isListSeparator(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+}
+
+inline bool parseListValue(const char*& p, const char* end, float& value)
+{
+	double v;
+	if (!meshlab::parseDouble(p, end, v))
+		return false;
+	value = (float) v;
+	return true;
+}
+
+inline bool parseListValue(const char*& p, const char* end, double& value)
+{
+	return meshlab::parseDouble(p, end, value);
+}
+
+inline bool parseListValue(const char*& p, const char* end, int& value)
+{
+	long long v;
+	if (!meshlab::parseInt(p, end, v) || v < std::numeric_limits<int>::min() ||
+		v > std::numeric_limits<int>::max())
+		return false;
+	value = (int) v;
+	return true;
+}
+
+/**
+ * @brief parses the content of a multiple value field (numbers separated by
+ * blanks or commas), replacing the content of values
+ */
+template <typename T>
+bool parseList(const QStringRef& text, std::vector<T>& values)
+{
+	const QByteArray bytes = text.toLatin1();
+	const char* p = bytes.constData();
+	const char* end = p + bytes.size();
+
+	// count the values first, so that the vector is allocated only once
+	std::size_t n = 0;
+	for (const char* q = p; q < end; ++q)
+		if (!isListSeparator(*q) && (q == p || isListSeparator(q[-1])))
+			++n;
+	values.clear();
+	values.reserve(n);
+	for (;;) {
+		while (p < end && isListSeparator(*p))
+			++p;
+		if (p == end)
+			return true;
+		T v;
+		if (!parseListValue(p, end, v) || (p < end && !isListSeparator(*p)))
+			return false;
+		values.push_back(v);
+	}
+}
+
+/**
+ * @brief the colors of a Color or ColorRGBA node
+ */
+struct ColorList
+{
+	std::vector<float> values;
+	int components = 3;
+};
+
+/**
+ * @brief an IndexedFaceSet or an IndexedTriangleSet, with the arrays of its
+ * Coordinate and Color nodes, that may be shared with other geometries
+ */
+struct Geometry
+{
+	bool triangleSet = false;
+	bool ccw = true;
+	bool colorPerVertex = true;
+	std::vector<int> coordIndex; // the "index" field of IndexedTriangleSet
+	std::vector<int> colorIndex;
+	std::shared_ptr<const std::vector<Scalarm>> coords;
+	std::shared_ptr<const ColorList> colors;
+};
+
+/**
+ * @brief the color of the last Material node, that (as in ImporterX3D) is the
+ * default vertex color also of the following Shapes without a Material
+ */
+struct MaterialColor
+{
+	bool defined = false;
+	Color4b color = Color4b(Color4b::White);
+};
+
+/**
+ * @brief a DEF'd grouping node or Shape: the vertices and the faces it added
+ * to the mesh, that are copied each time the node is USE'd, and the transform
+ * of its parent when they were added
+ */
+struct DefinedNode
+{
+	QString tag;
+	Matrix44m parentGlobal;
+	std::size_t vertBegin, vertEnd;
+	std::size_t faceBegin, faceEnd;
+};
+
+/**
+ * @brief an open element of the scene
+ */
+struct SceneNode
+{
+	QString tag;
+	QString def;
+	Matrix44m local;  // the transform of the node itself
+	Matrix44m global; // the transform from the node to the scene
+	std::size_t vertBegin = 0; // the mesh size when the node was opened
+	std::size_t faceBegin = 0;
+};
+
+inline bool isUnsupportedNode(const QStringRef& tag)
+{
+	return tag == QLatin1String("Inline") || tag == QLatin1String("ProtoDeclare") ||
+		   tag == QLatin1String("ExternProtoDeclare") || tag == QLatin1String("ProtoInstance") ||
+		   tag == QLatin1String("Switch") || tag == QLatin1String("LOD");
+}
+
+inline bool isGeometryNode(const QString& tag)
+{
+	return tag == QLatin1String("IndexedFaceSet") || tag == QLatin1String("IndexedTriangleSet");
+}
+
+class StreamingX3DLoader
+{
+public:
+	StreamingX3DLoader(QFile& file, MeshModel& m, vcg::CallBackPos* cb) :
+			xml(&file), fileSize(file.size()), m(m), cb(cb)
+	{
+	}
+
+	bool load(int& mask)
+	{
+		bool rootFound = false;
+		int scenes = 0;
+		int tokens = 0;
+		while (!xml.atEnd()) {
+			const QXmlStreamReader::TokenType token = xml.readNext();
+			if (token == QXmlStreamReader::StartElement) {
+				if (!rootFound) {
+					if (xml.name() != QLatin1String("X3D"))
+						return false;
+					rootFound = true;
+				}
+				else if (!stack.empty()) {
+					if (!startElement())
+						return false;
+				}
+				else if (xml.name() == QLatin1String("Scene")) {
+					if (++scenes > 1)
+						return false;
+					SceneNode scene;
+					scene.tag = xml.name().toString();
+					scene.local.SetIdentity();
+					scene.global.SetIdentity();
+					stack.push_back(scene);
+				}
+			}
+			else if (token == QXmlStreamReader::EndElement && !stack.empty()) {
+				if (!endElement())
+					return false;
+			}
+			if (cb != nullptr && fileSize > 0 && ++tokens % 4096 == 0)
+				(*cb)((int) (90 * xml.device()->pos() / fileSize), "Loading X3D Object...");
+		}
+		if (xml.hasError() || scenes != 1 || m.cm.vert.empty())
+			return false;
+
+		mask = tri::io::Mask::IOM_VERTCOORD | tri::io::Mask::IOM_FACEINDEX;
+		if (hasVertexColor)
+			mask |= tri::io::Mask::IOM_VERTCOLOR;
+		if (hasFaceColor)
+			mask |= tri::io::Mask::IOM_FACECOLOR;
+		return true;
+	}
+
+private:
+	bool startElement()
+	{
+		const QStringRef name = xml.name();
+		if (isUnsupportedNode(name))
+			return false;
+		const QXmlStreamAttributes attributes = xml.attributes();
+		const QString use = attributes.value(QLatin1String("USE")).toString();
+		const SceneNode& parent = stack.back();
+
+		if (parent.tag == QLatin1String("Shape")) {
+			if (name == QLatin1String("Appearance"))
+				return startAppearance(use, attributes);
+			if (isGeometryNode(name.toString()))
+				return startGeometry(use, attributes);
+			if (name.startsWith(QLatin1String("Metadata"))) {
+				xml.skipCurrentElement();
+				return true;
+			}
+			return false; // other geometries
+		}
+		if (parent.tag == QLatin1String("Appearance")) {
+			if (name.contains(QLatin1String("Texture")))
+				return false;
+			if (name == QLatin1String("Material") && !readMaterial(use, attributes))
+				return false;
+			xml.skipCurrentElement();
+			return true;
+		}
+		if (isGeometryNode(parent.tag) && geometry) {
+			if (name == QLatin1String("Coordinate")) {
+				if (!readCoordinate(use, attributes))
+					return false;
+			}
+			else if (name == QLatin1String("Color") || name == QLatin1String("ColorRGBA")) {
+				if (!readColor(name == QLatin1String("Color") ? 3 : 4, use, attributes))
+					return false;
+			}
+			else if (
+				name != QLatin1String("Normal") && name != QLatin1String("TextureCoordinate") &&
+				!name.startsWith(QLatin1String("Metadata"))) {
+				return false;
+			}
+			xml.skipCurrentElement();
+			return true;
+		}
+
+		// Shape, Transform or any other node: its children are traversed
+		if (!use.isEmpty()) {
+			auto it = definedNodes.find(use);
+			if (it == definedNodes.end() || it->second.tag != name ||
+				!copyDefinedNode(it->second, parent.global))
+				return false;
+			xml.skipCurrentElement();
+			return true;
+		}
+		SceneNode node;
+		node.tag = name.toString();
+		node.def = attributes.value(QLatin1String("DEF")).toString();
+		if (node.tag == QLatin1String("Transform")) {
+			if (!transformMatrix(attributes, node.local))
+				return false;
+		}
+		else {
+			node.local.SetIdentity();
+		}
+		node.global = parent.global * node.local;
+		node.vertBegin = m.cm.vert.size();
+		node.faceBegin = m.cm.face.size();
+		stack.push_back(node);
+		return true;
+	}
+
+	bool endElement()
+	{
+		SceneNode node = stack.back();
+		stack.pop_back();
+		if (isGeometryNode(node.tag)) {
+			std::shared_ptr<const Geometry> g = geometry;
+			geometry.reset();
+			if (!node.def.isEmpty())
+				definedGeometries[node.def] = g;
+			return addNewInstance(g);
+		}
+		if (node.tag == QLatin1String("Appearance")) {
+			if (!node.def.isEmpty())
+				definedAppearances[node.def] = material;
+		}
+		else if (!node.def.isEmpty()) {
+			definedNodes[node.def] = DefinedNode {
+				node.tag,
+				stack.back().global,
+				node.vertBegin,
+				m.cm.vert.size(),
+				node.faceBegin,
+				m.cm.face.size()};
+		}
+		return true;
+	}
+
+	bool startAppearance(const QString& use, const QXmlStreamAttributes& attributes)
+	{
+		if (!use.isEmpty()) {
+			auto it = definedAppearances.find(use);
+			if (it == definedAppearances.end())
+				return false;
+			material = it->second;
+			xml.skipCurrentElement();
+			return true;
+		}
+		SceneNode node;
+		node.tag = QStringLiteral("Appearance");
+		node.def = attributes.value(QLatin1String("DEF")).toString();
+		node.local.SetIdentity();
+		node.global = stack.back().global;
+		stack.push_back(node);
+		return true;
+	}
+
+	bool readMaterial(const QString& use, const QXmlStreamAttributes& attributes)
+	{
+		if (!use.isEmpty()) {
+			auto it = definedMaterials.find(use);
+			if (it == definedMaterials.end())
+				return false;
+			material = it->second;
+			return true;
+		}
+		std::vector<float> diffuse;
+		if (!parseList(attributes.value(QLatin1String("diffuseColor")), diffuse))
+			return false;
+		material.defined = diffuse.size() >= 3;
+		if (material.defined) {
+			std::vector<float> transparency;
+			if (!parseList(attributes.value(QLatin1String("transparency")), transparency))
+				return false;
+			const float alpha = 1.0f - (transparency.empty() ? 0.0f : transparency[0]);
+			material.color.Import(Color4f(diffuse[0], diffuse[1], diffuse[2], alpha));
+		}
+		const QString def = attributes.value(QLatin1String("DEF")).toString();
+		if (!def.isEmpty())
+			definedMaterials[def] = material;
+		return true;
+	}
+
+	bool startGeometry(const QString& use, const QXmlStreamAttributes& attributes)
+	{
+		const QString tag = xml.name().toString();
+		if (!use.isEmpty()) {
+			auto it = definedGeometries.find(use);
+			if (it == definedGeometries.end() || it->second->triangleSet != (tag == QLatin1String("IndexedTriangleSet")))
+				return false;
+			xml.skipCurrentElement();
+			return addNewInstance(it->second);
+		}
+		std::shared_ptr<Geometry> g = std::make_shared<Geometry>();
+		g->triangleSet = tag == QLatin1String("IndexedTriangleSet");
+		g->ccw = attributes.value(QLatin1String("ccw")) != QLatin1String("false");
+		g->colorPerVertex = attributes.value(QLatin1String("colorPerVertex")) != QLatin1String("false");
+		if (g->triangleSet) {
+			if (!parseList(attributes.value(QLatin1String("index")), g->coordIndex))
+				return false;
+		}
+		else {
+			if (!parseList(attributes.value(QLatin1String("coordIndex")), g->coordIndex) ||
+				!parseList(attributes.value(QLatin1String("colorIndex")), g->colorIndex))
+				return false;
+		}
+		geometry = g;
+
+		SceneNode node;
+		node.tag = tag;
+		node.def = attributes.value(QLatin1String("DEF")).toString();
+		node.local.SetIdentity();
+		node.global = stack.back().global;
+		stack.push_back(node);
+		return true;
+	}
+
+	bool readCoordinate(const QString& use, const QXmlStreamAttributes& attributes)
+	{
+		if (!use.isEmpty()) {
+			auto it = definedCoords.find(use);
+			if (it == definedCoords.end())
+				return false;
+			geometry->coords = it->second;
+			return true;
+		}
+		std::shared_ptr<std::vector<Scalarm>> coords = std::make_shared<std::vector<Scalarm>>();
+		if (!parseList(attributes.value(QLatin1String("point")), *coords))
+			return false;
+		geometry->coords = coords;
+		const QString def = attributes.value(QLatin1String("DEF")).toString();
+		if (!def.isEmpty())
+			definedCoords[def] = coords;
+		return true;
+	}
+
+	bool readColor(int components, const QString& use, const QXmlStreamAttributes& attributes)
+	{
+		if (!use.isEmpty()) {
+			auto it = definedColors.find(use);
+			if (it == definedColors.end() || it->second->components != components)
+				return false;
+			geometry->colors = it->second;
+			return true;
+		}
+		std::shared_ptr<ColorList> colors = std::make_shared<ColorList>();
+		colors->components = components;
+		if (!parseList(attributes.value(QLatin1String("color")), colors->values))
+			return false;
+		geometry->colors = colors;
+		const QString def = attributes.value(QLatin1String("DEF")).toString();
+		if (!def.isEmpty())
+			definedColors[def] = colors;
+		return true;
+	}
+
+	/**
+	 * @brief the transform of a Transform node: T * C * R * SR * S * -SR * -C
+	 */
+	static bool transformMatrix(const QXmlStreamAttributes& attributes, Matrix44m& t)
+	{
+		std::vector<Scalarm> translation, center, rotation, scaleOrientation, scale;
+		if (!parseList(attributes.value(QLatin1String("translation")), translation) ||
+			!parseList(attributes.value(QLatin1String("center")), center) ||
+			!parseList(attributes.value(QLatin1String("rotation")), rotation) ||
+			!parseList(attributes.value(QLatin1String("scaleOrientation")), scaleOrientation) ||
+			!parseList(attributes.value(QLatin1String("scale")), scale))
+			return false;
+		Matrix44m tmp;
+		t.SetIdentity();
+		if (translation.size() == 3)
+			t.SetTranslate(translation[0], translation[1], translation[2]);
+		if (center.size() == 3)
+			t *= tmp.SetTranslate(center[0], center[1], center[2]);
+		if (rotation.size() == 4)
+			t *= tmp.SetRotateRad(rotation[3], Point3m(rotation[0], rotation[1], rotation[2]));
+		if (scaleOrientation.size() == 4) {
+			const Point3m axis(scaleOrientation[0], scaleOrientation[1], scaleOrientation[2]);
+			t *= tmp.SetRotateRad(scaleOrientation[3], axis);
+		}
+		if (scale.size() == 3)
+			t *= tmp.SetScale(scale[0], scale[1], scale[2]);
+		if (scaleOrientation.size() == 4) {
+			const Point3m axis(scaleOrientation[0], scaleOrientation[1], scaleOrientation[2]);
+			t *= tmp.SetRotateRad(-scaleOrientation[3], axis);
+		}
+		if (center.size() == 3)
+			t *= tmp.SetTranslate(-center[0], -center[1], -center[2]);
+		return true;
+	}
+
+	/**
+	 * @brief adds again the vertices and the faces of a DEF'd node, moved from
+	 * the transform of the parent of the DEF to the one of the parent of the
+	 * USE, so that the source arrays of the node do not need to be kept
+	 */
+	bool copyDefinedNode(const DefinedNode& node, const Matrix44m& parentGlobal)
+	{
+		if (node.parentGlobal.Determinant() == 0)
+			return false;
+		const Matrix44m transform = parentGlobal * Inverse(node.parentGlobal);
+		const std::size_t nVertex = node.vertEnd - node.vertBegin;
+		const std::size_t nFace = node.faceEnd - node.faceBegin;
+		const std::size_t offset = m.cm.vert.size();
+		const std::size_t offsetFace = m.cm.face.size();
+		if (nVertex > 0)
+			tri::Allocator<CMeshO>::AddVertices(m.cm, nVertex);
+		if (nFace > 0)
+			tri::Allocator<CMeshO>::AddFaces(m.cm, nFace);
+		for (std::size_t i = 0; i < nVertex; ++i) {
+			const CVertexO& src = m.cm.vert[node.vertBegin + i];
+			CVertexO& v = m.cm.vert[offset + i];
+			v.ImportData(src);
+			const Point4m q = transform * Point4m(src.cP()[0], src.cP()[1], src.cP()[2], 1);
+			v.P() = Point3m(q[0], q[1], q[2]);
+		}
+		for (std::size_t i = 0; i < nFace; ++i) {
+			const CFaceO& src = m.cm.face[node.faceBegin + i];
+			CFaceO& f = m.cm.face[offsetFace + i];
+			f.ImportData(src);
+			for (int k = 0; k < 3; ++k)
+				f.V(k) = &m.cm.vert[offset + (tri::Index(m.cm, src.cV(k)) - node.vertBegin)];
+		}
+		return true;
+	}
+
+	/**
+	 * @brief adds a geometry found in the file: as in ImporterX3D, after a
+	 * geometry with colors the last material color is no more used
+	 */
+	bool addNewInstance(const std::shared_ptr<const Geometry>& g)
+	{
+		if (!addGeometry(*g, stack.back().global, material))
+			return false;
+		if (g->colors && !g->colors->values.empty())
+			material.defined = false;
+		return true;
+	}
+
+	void enableVertexColor()
+	{
+		if (hasVertexColor)
+			return;
+		m.enable(tri::io::Mask::IOM_VERTCOLOR);
+		for (CVertexO& v : m.cm.vert)
+			v.C() = Color4b(Color4b::White);
+		hasVertexColor = true;
+	}
+
+	void enableFaceColor()
+	{
+		if (hasFaceColor)
+			return;
+		m.enable(tri::io::Mask::IOM_FACECOLOR);
+		for (CFaceO& f : m.cm.face)
+			f.C() = Color4b(Color4b::White);
+		hasFaceColor = true;
+	}
+
+	/**
+	 * @brief gets the color of the given index from the list, if it exists
+	 */
+	static bool getColor(const ColorList* colors, int index, Color4b& color)
+	{
+		if (colors == nullptr || index < 0 ||
+			(std::size_t) (index + 1) * colors->components > colors->values.size())
+			return false;
+		const float* c = colors->values.data() + (std::size_t) index * colors->components;
+		color.Import(Color4f(c[0], c[1], c[2], colors->components == 4 ? c[3] : 1.0f));
+		return true;
+	}
+
+	/**
+	 * @brief adds the vertices and the (triangulated) faces of the geometry to
+	 * the mesh, with the same rules of ImporterX3D
+	 */
+	bool addGeometry(const Geometry& g, const Matrix44m& transform, const MaterialColor& materialColor)
+	{
+		if (!g.coords || g.coords->size() < 3 || g.coordIndex.empty())
+			return true; // nothing to load, as in ImporterX3D
+		const ColorList* colors = g.colors && !g.colors->values.empty() ? g.colors.get() : nullptr;
+		// a color list takes the place of the material color
+		const bool useMaterial = materialColor.defined && colors == nullptr;
+		// as in ImporterX3D, per vertex colors are taken by vertex index also
+		// when a colorIndex is given: it would index the per wedge colors,
+		// that CMeshO does not have
+		const bool vertexColors = colors != nullptr && (g.triangleSet || g.colorPerVertex);
+		const bool faceColors = colors != nullptr && !g.triangleSet && !g.colorPerVertex;
+		if (vertexColors || useMaterial)
+			enableVertexColor();
+		if (faceColors)
+			enableFaceColor();
+
+		// vertices
+		const int nVertex = (int) (g.coords->size() / 3);
+		const int offset = (int) m.cm.vert.size();
+		const Color4b defColor = useMaterial ? materialColor.color : Color4b(Color4b::White);
+		tri::Allocator<CMeshO>::AddVertices(m.cm, nVertex);
+		const Scalarm* p = g.coords->data();
+		for (int i = 0; i < nVertex; ++i) {
+			CVertexO& v = m.cm.vert[offset + i];
+			const Point4m q = transform * Point4m(p[3 * i], p[3 * i + 1], p[3 * i + 2], 1);
+			v.P() = Point3m(q[0], q[1], q[2]);
+			if (hasVertexColor && !(vertexColors && getColor(colors, i, v.C())))
+				v.C() = defColor;
+		}
+
+		// faces: each entry holds the position in coordIndex of a corner and
+		// the number of the polygon it belongs to
+		std::vector<std::pair<int, int>> corners;
+		const int nIndex = (int) g.coordIndex.size();
+		if (g.triangleSet) {
+			corners.reserve(nIndex - nIndex % 3);
+			for (int i = 0; i + 2 < nIndex; i += 3)
+				for (int k = 0; k < 3; ++k)
+					corners.emplace_back(i + k, i / 3);
+		}
+		else {
+			corners.reserve(nIndex);
+			std::vector<std::vector<Point3m>> polygon(1);
+			std::vector<int> triangles;
+			int polygonNumber = 0;
+			for (int begin = 0; begin < nIndex; ++polygonNumber) {
+				int end = begin;
+				while (end < nIndex && g.coordIndex[end] != -1)
+					++end;
+				const int size = end - begin;
+				if (size < 3)
+					return false;
+				for (int i = begin; i < end; ++i)
+					if (g.coordIndex[i] < 0 || g.coordIndex[i] >= nVertex)
+						return false;
+				if (size == 3) {
+					for (int k = 0; k < 3; ++k)
+						corners.emplace_back(begin + k, polygonNumber);
+				}
+				else {
+					polygon[0].clear();
+					for (int i = begin; i < end; ++i)
+						polygon[0].push_back(m.cm.vert[offset + g.coordIndex[i]].cP());
+					triangles.clear();
+					glu_tesselator::tesselate<Point3m>(polygon, triangles);
+					for (int t : triangles)
+						corners.emplace_back(begin + t, polygonNumber);
+				}
+				begin = end + 1;
+			}
+		}
+
+		const int nFace = (int) (corners.size() / 3);
+		const int offsetFace = (int) m.cm.face.size();
+		if (nFace > 0)
+			tri::Allocator<CMeshO>::AddFaces(m.cm, nFace);
+		for (int f = 0; f < nFace; ++f) {
+			CFaceO& face = m.cm.face[offsetFace + f];
+			for (int k = 0; k < 3; ++k) {
+				const int index = g.coordIndex[corners[3 * f + k].first];
+				if (index < 0 || index >= nVertex)
+					return false;
+				face.V(g.ccw ? k : 2 - k) = &m.cm.vert[offset + index];
+			}
+			if (hasFaceColor) {
+				const int polygonNumber = corners[3 * f].second;
+				int colorNumber = polygonNumber;
+				if (polygonNumber < (int) g.colorIndex.size() && g.colorIndex[polygonNumber] > -1)
+					colorNumber = g.colorIndex[polygonNumber];
+				if (!(faceColors && getColor(colors, colorNumber, face.C())))
+					face.C() = Color4b(Color4b::White);
+			}
+		}
+		return true;
+	}
+
+	QXmlStreamReader xml;
+	const qint64 fileSize;
+	MeshModel& m;
+	vcg::CallBackPos* cb;
+
+	std::vector<SceneNode> stack;
+	std::shared_ptr<Geometry> geometry; // the geometry node being read
+	MaterialColor material;
+	bool hasVertexColor = false;
+	bool hasFaceColor = false;
+
+	std::map<QString, DefinedNode> definedNodes;
+	std::map<QString, std::shared_ptr<const Geometry>> definedGeometries;
+	std::map<QString, std::shared_ptr<const std::vector<Scalarm>>> definedCoords;
+	std::map<QString, std::shared_ptr<const ColorList>> definedColors;
+	std::map<QString, MaterialColor> definedMaterials;
+	std::map<QString, MaterialColor> definedAppearances;
+};
+
+} // namespace
+
+bool loadStreamingX3D(const QString& fileName, MeshModel& m, int& mask, vcg::CallBackPos* cb)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	StreamingX3DLoader loader(file, m, cb);
+	if (!loader.load(mask)) {
+		m.cm.Clear();
+		m.clearDataMask(MeshModel::MM_VERTCOLOR | MeshModel::MM_FACECOLOR);
+		return false;
+	}
+	return true;
+}
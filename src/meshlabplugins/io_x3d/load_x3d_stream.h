@@ -0,0 +1,65 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef LOAD_X3D_STREAM_H
+#define LOAD_X3D_STREAM_H
+
+#include <common/ml_document/mesh_model.h>
+#include <wrap/callback.h>
+
+/**
+ * Streaming loader for large X3D (xml encoded) files: the file is read with a
+ * QXmlStreamReader instead of being loaded in a QDomDocument, and every
+ * IndexedFaceSet and IndexedTriangleSet is added to the mesh as soon as its
+ * end tag is reached, transformed by the current stack of Transform nodes.
+ * The number lists of the attributes are parsed directly in vectors of
+ * numbers, that are released after the geometry has been added, so the peak
+ * memory stays close to the size of the final mesh.
+ *
+ * DEF/USE instancing is resolved without copying: a DEF'd Coordinate, Color
+ * or geometry node keeps its parsed arrays in a shared buffer that is reused
+ * by each USE, while a DEF'd grouping node or Shape records only the ranges
+ * of vertices and faces it added to the mesh, that are copied (moved to the
+ * current transform) where the node is USE'd.
+ *
+ * Only scenes made of grouping nodes and Shapes with an optional Material and
+ * IndexedFaceSet/IndexedTriangleSet geometries (with Coordinate, Color and
+ * ColorRGBA; Normal and TextureCoordinate nodes are ignored, since normals
+ * are recomputed and texture coords are used only with textures) are
+ * handled. When the file contains anything else (Inline, prototypes, Switch,
+ * LOD, other geometries, wrong indices...) the function returns false,
+ * leaving the mesh empty, and the file should be loaded by ImporterX3D,
+ * producing also the same error messages.
+ *
+ * Textured files are not streamed: any texture node in an Appearance makes
+ * the function return false, and ImporterX3D loads the texture files, the
+ * texture transforms and generators and the wedge texture coords.
+ */
+
+bool loadStreamingX3D(
+		const QString& fileName,
+		MeshModel& m,
+		int& mask,
+		vcg::CallBackPos* cb = nullptr);
+
+#endif // LOAD_X3D_STREAM_H